@@ -18,28 +18,27 @@ void CApproximateOneToAll::CutHeapTopData( EdgeWindow &EdgeWindowOut )
 {
     for (;;)
     {
-        TypeEdgeWindowsHeap::item_type *pItem = m_EdgeWindowsHeap.cutTop() ;       
+        // the popped off window stays on its edge, only its heap position is cleared
+        const uint32_t dwSelf = m_EdgeWindowsHeap.cutTop() ;
+        Edge *pEdge = m_WindowPool[dwSelf].theWindow.pEdge ;
 
-        uint32_t dwIdxSelf = FLAG_INVALIDDWORD ;
-        for (uint32_t i = 0; i < pItem->m_data.pEdge->WindowsList.size(); ++i)
+        uint32_t dwPrev = FLAG_INVALIDDWORD ;
+        for (uint32_t dwNode = pEdge->dwFirstWindow; dwNode != FLAG_INVALIDDWORD; dwPrev = dwNode, dwNode = m_WindowPool[dwNode].dwNextOnEdge)
         {        
-            if ( !pItem->m_data.pEdge->WindowsList[i].pHeapItem )
+            if ( dwNode == dwSelf )
             {
+                // when searching for a window adjacent to the popped off (from the heap) window, skip the window itself on the edge
                 continue ;
             }
-            
-            if ( pItem->m_data.pEdge->WindowsList[i].pHeapItem == pItem )
+
+            if ( m_WindowPool[dwNode].dwHeapPos == FLAG_INVALIDDWORD )
             {
-                // here we get a byproduct, because we actually need the idx of the popped off window itself
-                dwIdxSelf = i ;
-                
-                // when searching for a window adjacent to the popped off (from the heap) window, skip the window itself on the edge
                 continue ;
             }
             
             // in pWindowLeft and pWindowRight, one is the the popped off window itself, the other one is the possible found adjacent window
-            EdgeWindow *pWindowLeft = &(pItem->m_data) ;
-            EdgeWindow *pWindowRight = &(pItem->m_data.pEdge->WindowsList[i].theWindow) ;
+            EdgeWindow *pWindowLeft = &(m_WindowPool[dwSelf].theWindow) ;
+            EdgeWindow *pWindowRight = &(m_WindowPool[dwNode].theWindow) ;
                     
             if ( (pWindowLeft->b0 == pWindowRight->b1 || pWindowLeft->b1 == pWindowRight->b0) /*&&
                  (pWindowLeft->dwFaceIdxPropagatedFrom == pWindowRight->dwFaceIdxPropagatedFrom)*/ )
@@ -288,30 +287,12 @@ void CApproximateOneToAll::CutHeapTopData( EdgeWindow &EdgeWindowOut )
                 {
                     // allow the merge
 
-                    if ( dwIdxSelf == FLAG_INVALIDDWORD )
-                    {
-                        // the idx of the popped off window is not yet set, so search for it here
-                        // we only need to search from i + 1 (rather than from 0), because the previous ones have already been searched
-
-                        for (uint32_t t = i + 1; t < pItem->m_data.pEdge->WindowsList.size(); ++t)
-                            if ( pItem->m_data.pEdge->WindowsList[t].pHeapItem == pItem )
-                            {
-                                dwIdxSelf = t ;
-
-                                break ;
-                            }
-                    }
-
                     // remove the found adjacent window from the heap and from the edge it is on
-                    m_EdgeWindowsHeap.remove( pItem->m_data.pEdge->WindowsList[i].pHeapItem ) ;
-                    delete pItem->m_data.pEdge->WindowsList[i].pHeapItem ;
-                    pItem->m_data.pEdge->WindowsList.erase(pItem->m_data.pEdge->WindowsList.begin() + i);
-                    if ( dwIdxSelf > i )
-                    {
-                        --dwIdxSelf ;
-                    }
+                    m_EdgeWindowsHeap.remove( dwNode ) ;
+                    UnlinkWindow( pEdge, dwPrev, dwNode ) ;
                     
-                    EdgeWindow *pTheWindow = &(pItem->m_data.pEdge->WindowsList[dwIdxSelf].theWindow) ;
+                    EdgeWindowNode &selfNode = m_WindowPool[dwSelf] ;
+                    EdgeWindow *pTheWindow = &(selfNode.theWindow) ;
                     
                     pTheWindow->b0 = b0pie ;
                     pTheWindow->b1 = b1pie ;
@@ -322,16 +303,10 @@ void CApproximateOneToAll::CutHeapTopData( EdgeWindow &EdgeWindowOut )
                     pTheWindow->ksi = ksi ;
                     pTheWindow->dwPseuSrcVertexIdx = FLAG_INVALIDDWORD;
                     pTheWindow->pPseuSrcVertex = nullptr;
-                    /*pTheWindow->pHeapItem = nullptr ;
 
-                    EdgeWindowOut = *pTheWindow ;
-                    delete pItem ;
-                    return ;*/
-
-                    pItem->m_data.pEdge->WindowsList[dwIdxSelf].pHeapItem =
-                        new TypeEdgeWindowsHeap::item_type( std::min(pTheWindow->d0, pTheWindow->d1)+pTheWindow->dPseuSrcToSrcDistance, *pTheWindow );
-                    m_EdgeWindowsHeap.insert( pItem->m_data.pEdge->WindowsList[dwIdxSelf].pHeapItem ) ;
-                    delete pItem ;
+                    // the merged window goes back to the heap
+                    selfNode.dWeight = std::min(pTheWindow->d0, pTheWindow->d1)+pTheWindow->dPseuSrcToSrcDistance ;
+                    m_EdgeWindowsHeap.insert( dwSelf ) ;
 
                     // continue to pop the next window in heap and test whether any merge is possible                    
                     goto l_outter_while_again ;
@@ -339,26 +314,7 @@ void CApproximateOneToAll::CutHeapTopData( EdgeWindow &EdgeWindowOut )
             }
         }   
 
-        if ( dwIdxSelf == FLAG_INVALIDDWORD )
-        {
-            for (size_t i = 0; i < pItem->m_data.pEdge->WindowsList.size(); ++i)
-            {
-                if ( pItem->m_data.pEdge->WindowsList[i].pHeapItem == pItem )
-                {
-                    pItem->m_data.pEdge->WindowsList[i].pHeapItem = nullptr;
-                    break ;
-                }
-            }
-
-            EdgeWindowOut = pItem->m_data ;
-            delete pItem ;
-            return ;
-        }
-
-        pItem->m_data.pEdge->WindowsList[dwIdxSelf].pHeapItem = nullptr;
-        EdgeWindowOut = pItem->m_data ;
-        delete pItem ;
-
+        EdgeWindowOut = m_WindowPool[dwSelf].theWindow ;
         return ;
 
 l_outter_while_again:
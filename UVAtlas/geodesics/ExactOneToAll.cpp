@@ -15,18 +15,17 @@
 using namespace GeodesicDist;
 
 CExactOneToAll::CExactOneToAll()
+    : m_EdgeWindowsHeap( m_WindowPool )
 {
-    m_EdgeWindowsHeap.SetManageMode( Isochart::AUTOMATIC ) ;
 }
 
 void CExactOneToAll::SetSrcVertexIdx( const uint32_t dwSrcVertexIdx )
 {
     m_dwSrcVertexIdx = dwSrcVertexIdx ;
     
-    while ( !m_EdgeWindowsHeap.empty() )
-    {
-        delete m_EdgeWindowsHeap.cutTop() ;
-    }
+    // drop the windows of the last run, the memory is kept for this one
+    m_EdgeWindowsHeap.clear() ;
+    m_WindowPool.Reset() ;
 
     for (size_t i = 0; i < m_VertexList.size(); ++i)
     {
@@ -40,7 +39,7 @@ void CExactOneToAll::SetSrcVertexIdx( const uint32_t dwSrcVertexIdx )
     {       
         Edge &thisEdge = m_EdgeList[i] ;
 
-        thisEdge.WindowsList.clear() ;
+        thisEdge.dwFirstWindow = thisEdge.dwLastWindow = FLAG_INVALIDDWORD ;
 
         if ( !thisEdge.HasVertexIdx(dwSrcVertexIdx) && 
              (
@@ -77,11 +76,7 @@ void CExactOneToAll::SetSrcVertexIdx( const uint32_t dwSrcVertexIdx )
 void CExactOneToAll::AddWindowToHeapAndEdge( const EdgeWindow &WindowToAdd )
 {
     // add the new window to heap and the edge
-    TypeEdgeWindowsHeap::item_type *pItem = 
-        new TypeEdgeWindowsHeap::item_type(std::min(WindowToAdd.d0, WindowToAdd.d1) + WindowToAdd.dPseuSrcToSrcDistance, WindowToAdd);
-
-    m_EdgeWindowsHeap.insert( pItem ) ;
-    WindowToAdd.pEdge->WindowsList.push_back(Edge::WindowListElement(pItem, WindowToAdd));
+    InsertWindow( WindowToAdd ) ;
 
     // update the geodesic distance on vertices affected by this new window
     WindowToAdd.pMarkFromEdgeVertex->dGeoDistanceToSrc = 
@@ -101,21 +96,54 @@ void CExactOneToAll::AddWindowToHeapAndEdge( const EdgeWindow &WindowToAdd )
     }
 }
 
-// pop off one window from the heap and unreference the corresponding one on the edge
-void CExactOneToAll::CutHeapTopData( EdgeWindow &EdgeWindowOut )
+// allocate a window from the pool, push it into the heap and append it to the windows list of its edge
+// WindowToAdd must not be a window in the pool, the pool may grow here
+uint32_t CExactOneToAll::InsertWindow( const EdgeWindow &WindowToAdd )
 {
-    TypeEdgeWindowsHeap::item_type *pItem = m_EdgeWindowsHeap.cutTop() ;       
+    const uint32_t dwNode = m_WindowPool.Alloc( WindowToAdd ) ;
 
-    for (size_t i = 0; i < pItem->m_data.pEdge->WindowsList.size(); ++i)
-        if ( pItem->m_data.pEdge->WindowsList[i].pHeapItem == pItem )
-        {
-            pItem->m_data.pEdge->WindowsList[i].pHeapItem = nullptr ;
-            break ;
-        }
+    m_EdgeWindowsHeap.insert( dwNode ) ;
+
+    Edge *pEdge = WindowToAdd.pEdge ;
+    if ( pEdge->dwLastWindow == FLAG_INVALIDDWORD )
+    {
+        pEdge->dwFirstWindow = dwNode ;
+    }
+    else
+    {
+        m_WindowPool[pEdge->dwLastWindow].dwNextOnEdge = dwNode ;
+    }
+    pEdge->dwLastWindow = dwNode ;
+
+    return dwNode ;
+}
+
+// remove a window (which is not in the heap) from the windows list of the edge and give it back to the pool
+void CExactOneToAll::UnlinkWindow( Edge *pEdge, const uint32_t dwPrevNode, const uint32_t dwNode )
+{
+    assert( m_WindowPool[dwNode].dwHeapPos == FLAG_INVALIDDWORD ) ;
+
+    const uint32_t dwNextNode = m_WindowPool[dwNode].dwNextOnEdge ;
+    if ( dwPrevNode == FLAG_INVALIDDWORD )
+    {
+        pEdge->dwFirstWindow = dwNextNode ;
+    }
+    else
+    {
+        m_WindowPool[dwPrevNode].dwNextOnEdge = dwNextNode ;
+    }
+    if ( pEdge->dwLastWindow == dwNode )
+    {
+        pEdge->dwLastWindow = dwPrevNode ;
+    }
 
-    EdgeWindowOut = pItem->m_data ;
+    m_WindowPool.Free( dwNode ) ;
+}
 
-    delete pItem ;
+// pop off one window from the heap, the window stays on its edge
+void CExactOneToAll::CutHeapTopData( EdgeWindow &EdgeWindowOut )
+{
+    EdgeWindowOut = m_WindowPool[m_EdgeWindowsHeap.cutTop()].theWindow ;
 }
 
 void CExactOneToAll::Run()
@@ -346,12 +374,12 @@ void CExactOneToAll::InternalRun()
                     uint32_t dwThisShadowVertex = dwThirdPtIdxOnFacePropagateTo ;
                     Vertex *pNextShadowVertex = pShadowEdge->GetAnotherVertex( dwThirdPtIdxOnFacePropagateTo ) ;
 
-                    std::vector<uint32_t> shadowEdges;
-                    std::vector<uint32_t> shadowFaces;
+                    m_ShadowEdges.clear();
+                    m_ShadowFaces.clear();
                     for (;;)
                     {
-                        shadowEdges.push_back(dwShadowEdge);
-                        shadowFaces.push_back(dwShadowFace);
+                        m_ShadowEdges.push_back(dwShadowEdge);
+                        m_ShadowFaces.push_back(dwShadowFace);
 
                         if ( pNextShadowVertex == pThridPtOnFacePropagateTo || 
                              pNextShadowVertex->bShadowBoundary /*||
@@ -375,12 +403,12 @@ void CExactOneToAll::InternalRun()
                          (pNextShadowVertex->bShadowBoundary || pBridgeEdge->IsBoundary())
                        )
                     {
-                        for (size_t v = 0; v < shadowEdges.size(); ++v)
+                        for (size_t v = 0; v < m_ShadowEdges.size(); ++v)
                         {                                                        
                             //EdgeWindow newWindow ;
 
-                            tmpWindow0.SetEdgeIdx( m_EdgeList, shadowEdges[v] ) ;
-                            tmpWindow0.SetFaceIdxPropagatedFrom( m_FaceList, shadowFaces[v] ) ;
+                            tmpWindow0.SetEdgeIdx( m_EdgeList, m_ShadowEdges[v] ) ;
+                            tmpWindow0.SetFaceIdxPropagatedFrom( m_FaceList, m_ShadowFaces[v] ) ;
                             tmpWindow0.SetMarkFromEdgeVertexIdx( m_VertexList, tmpWindow0.pEdge->dwVertexIdx0 ) ;
                             tmpWindow0.SetPseuSrcVertexIdx( m_VertexList, WindowToBePropagated.dwMarkFromEdgeVertexIdx ) ;
                             tmpWindow0.b0 = 0 ;
@@ -474,12 +502,12 @@ void CExactOneToAll::InternalRun()
                     uint32_t dwThisShadowVertex = dwThirdPtIdxOnFacePropagateTo ;
                     Vertex *pNextShadowVertex = pShadowEdge->GetAnotherVertex( dwThirdPtIdxOnFacePropagateTo ) ;
 
-                    std::vector<uint32_t> shadowEdges;
-                    std::vector<uint32_t> shadowFaces;
+                    m_ShadowEdges.clear();
+                    m_ShadowFaces.clear();
                     for (;;)
                     {
-                        shadowEdges.push_back(dwShadowEdge);
-                        shadowFaces.push_back(dwShadowFace);
+                        m_ShadowEdges.push_back(dwShadowEdge);
+                        m_ShadowFaces.push_back(dwShadowFace);
 
                         if ( pNextShadowVertex == pThridPtOnFacePropagateTo || 
                              pNextShadowVertex->bShadowBoundary /*||
@@ -503,12 +531,12 @@ void CExactOneToAll::InternalRun()
                          (pNextShadowVertex->bShadowBoundary || pBridgeEdge->IsBoundary())
                        )
                     {
-                        for (size_t v = 0; v < shadowEdges.size(); ++v)
+                        for (size_t v = 0; v < m_ShadowEdges.size(); ++v)
                         {                                                        
                             //EdgeWindow newWindow ;
 
-                            tmpWindow0.SetEdgeIdx( m_EdgeList, shadowEdges[v] ) ;
-                            tmpWindow0.SetFaceIdxPropagatedFrom( m_FaceList, shadowFaces[v] ) ;
+                            tmpWindow0.SetEdgeIdx( m_EdgeList, m_ShadowEdges[v] ) ;
+                            tmpWindow0.SetFaceIdxPropagatedFrom( m_FaceList, m_ShadowFaces[v] ) ;
                             tmpWindow0.SetMarkFromEdgeVertexIdx( m_VertexList, tmpWindow0.pEdge->dwVertexIdx0 ) ;
                             tmpWindow0.SetPseuSrcVertexIdx( m_VertexList, dwE1 ) ;
                             tmpWindow0.b0 = 0 ;
@@ -542,9 +570,9 @@ void CExactOneToAll::InternalRun()
                     Edge *pEdge ;                    
                     pEdge = m_VertexList[i].edgesAdj[j] ;                    
                         
-                    for (size_t l = 0; l < pEdge->WindowsList.size(); ++l)
+                    for (uint32_t dwNode = pEdge->dwFirstWindow; dwNode != FLAG_INVALIDDWORD; dwNode = m_WindowPool[dwNode].dwNextOnEdge)
                     {
-                        EdgeWindow &theWindow = pEdge->WindowsList[l].theWindow ;                                
+                        EdgeWindow &theWindow = m_WindowPool[dwNode].theWindow ;                                
 
                         if ( theWindow.dwMarkFromEdgeVertexIdx == i )
                         {
@@ -592,121 +620,91 @@ void CExactOneToAll::InternalRun()
 
 void CExactOneToAll::ProcessNewWindow( EdgeWindow *pNewEdgeWindow )
 {
-    std::vector<EdgeWindow> NewWindowsList;
-    NewWindowsList.push_back(*pNewEdgeWindow);
+    m_NewWindowsList.clear();
+    m_NewWindowsList.push_back(*pNewEdgeWindow);
 
     size_t j = 0;
 
-    while ( j < NewWindowsList.size() )
+    while ( j < m_NewWindowsList.size() )
     {
-        pNewEdgeWindow = &NewWindowsList[j] ;
+        pNewEdgeWindow = &m_NewWindowsList[j] ;
 
-        size_t i;
+        Edge *pEdge = pNewEdgeWindow->pEdge ;
         bool bExistingWindowChanged, bNewWindowChanged, bExistingWindowNotAvailable, bNewWindowNotAvailable ;
         EdgeWindow WindowToBeInserted ;
 
         bNewWindowNotAvailable = false ;
 
-        for ( i = 0; i < pNewEdgeWindow->pEdge->WindowsList.size(); ++i )
+        uint32_t dwPrevNode = FLAG_INVALIDDWORD ;
+        uint32_t dwNode = pEdge->dwFirstWindow ;
+        while ( dwNode != FLAG_INVALIDDWORD )
         {        
-            TypeEdgeWindowsHeap::item_type *pExistingWindowItem ;
+            EdgeWindowNode &existingNode = m_WindowPool[dwNode] ;
+            const uint32_t dwNextNode = existingNode.dwNextOnEdge ;
 
             bExistingWindowChanged = false ;
             bNewWindowChanged = false ;
             bExistingWindowNotAvailable = false ;
 
             // get a copy of current window on edge
-            pExistingWindowItem = 
-                new TypeEdgeWindowsHeap::item_type( 
-                std::min(pNewEdgeWindow->pEdge->WindowsList[i].theWindow.d0, pNewEdgeWindow->pEdge->WindowsList[i].theWindow.d1) + pNewEdgeWindow->pEdge->WindowsList[i].theWindow.dPseuSrcToSrcDistance,
-                pNewEdgeWindow->pEdge->WindowsList[i].theWindow 
-                ) ;
+            EdgeWindow ExistingWindow( existingNode.theWindow ) ;
 
             // the copy of current window on edge is then tested with the new window for intersection
             // after this test, the copy is possibly changed
-            IntersectWindow( &pExistingWindowItem->m_data, 
+            IntersectWindow( &ExistingWindow, 
                 pNewEdgeWindow, &bExistingWindowChanged, &bNewWindowChanged, &bExistingWindowNotAvailable, &bNewWindowNotAvailable ) ;        
 
             if ( m_NewExistingWindow.b1 - m_NewExistingWindow.b0 > 0 ) // m_NewExistingWindow is modified in IntersectWindow
                 WindowToBeInserted = m_NewExistingWindow ;
             if ( m_AnotherNewWindow.b1 - m_AnotherNewWindow.b0 > 0 ) // m_AnotherNewWindow is modified in IntersectWindow
             {
-                NewWindowsList.push_back(m_AnotherNewWindow);
+                m_NewWindowsList.push_back(m_AnotherNewWindow);
                 // new allocations may occur in the above add operation, so pNewEdgeWindow must be reset here
-                pNewEdgeWindow = &NewWindowsList[j] ;
+                pNewEdgeWindow = &m_NewWindowsList[j] ;
             }
 
-            bool bDontDelete ;
-            bDontDelete = false ;
-
             // after the intersection operation, if the existing window has been changed, 
             // remove the old one from the heap (if it is in heap) and update the one on edge
+            bool bRemoved = false ;
             if ( bExistingWindowChanged )
             {
                 // whether the window is in heap
-                if ( pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem )
+                const bool bInHeap = ( existingNode.dwHeapPos != FLAG_INVALIDDWORD ) ;
+                if ( bInHeap )
                 {
-                    // get the item in heap and remove it from the heap
-                    TypeEdgeWindowsHeap::item_type *pHeapItem = pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem ;
-
-                    m_EdgeWindowsHeap.remove( pHeapItem ) ;
-                    delete pHeapItem ;
-
-                    // if the existing window still available (b0<b1), we insert the updated one into heap again
-                    // and update the one on edge correspondingly
-                    if ( !bExistingWindowNotAvailable )
-                    {                
-                        pNewEdgeWindow->pEdge->WindowsList[i].theWindow = pExistingWindowItem->m_data ;
-                        pExistingWindowItem->m_weight = std::min(pExistingWindowItem->m_data.d0, pExistingWindowItem->m_data.d1) + pExistingWindowItem->m_data.dPseuSrcToSrcDistance;
-                        m_EdgeWindowsHeap.insert( pExistingWindowItem ) ;
-                        pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem = pExistingWindowItem ;                    
-                        bDontDelete = true ;
-                    } else
+                    m_EdgeWindowsHeap.remove( dwNode ) ;
+                }
+
+                // if the existing window still available (b0<b1), we update the one on edge
+                // and insert it into heap again if it was there
+                if ( !bExistingWindowNotAvailable )
+                {                
+                    existingNode.theWindow = ExistingWindow ;
+                    if ( bInHeap )
                     {
-                        // we set a flag here, that this window on edge is to be removed
-                        pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem = (TypeEdgeWindowsHeap::item_type*)FLAG_INVALID_SIZE_T ;
+                        existingNode.dWeight = std::min(ExistingWindow.d0, ExistingWindow.d1) + ExistingWindow.dPseuSrcToSrcDistance;
+                        m_EdgeWindowsHeap.insert( dwNode ) ;
                     }
                 } else
                 {
-                    // the window is not in heap, so we just update the one on edge
-                    if ( !bExistingWindowNotAvailable )
-                    {
-                        pNewEdgeWindow->pEdge->WindowsList[i].theWindow = pExistingWindowItem->m_data ;
-                    } else
-                        pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem = (TypeEdgeWindowsHeap::item_type*)FLAG_INVALID_SIZE_T ;
-                }                        
+                    // otherwise the window is removed from this edge
+                    UnlinkWindow( pEdge, dwPrevNode, dwNode ) ;
+                    bRemoved = true ;
+                }
             }        
 
-            if ( !bDontDelete )
-                delete pExistingWindowItem ;
+            if ( !bRemoved )
+                dwPrevNode = dwNode ;
+            dwNode = dwNextNode ;
 
             // if the new window is already unavailable during this iteration, we break ;
             if ( bNewWindowNotAvailable )
                 break ;
         }
 
-        i = 0 ;
-        while ( i < pNewEdgeWindow->pEdge->WindowsList.size() )
-        {
-            // test the remove flag set above, and erase the invalidated window from this edge
-            if ( (size_t)(pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem) == FLAG_INVALID_SIZE_T )
-            {
-                pNewEdgeWindow->pEdge->WindowsList.erase(pNewEdgeWindow->pEdge->WindowsList.begin() + i);
-            }
-            else
-            {
-                ++i ;
-            }
-        }
-
         if ( WindowToBeInserted.b1 - WindowToBeInserted.b0 > 0 )
         {
-            TypeEdgeWindowsHeap::item_type *pNewWindowItem = 
-                new TypeEdgeWindowsHeap::item_type(std::min(WindowToBeInserted.d0, WindowToBeInserted.d1)+WindowToBeInserted.dPseuSrcToSrcDistance, WindowToBeInserted);
-
-            m_EdgeWindowsHeap.insert( pNewWindowItem ) ;
-
-            WindowToBeInserted.pEdge->WindowsList.push_back(Edge::WindowListElement(pNewWindowItem, pNewWindowItem->m_data));
+            InsertWindow( WindowToBeInserted ) ;
 
             // update the geodesic distance on vertices affected by this new window
             if ( WindowToBeInserted.b0 < 0.01 )
@@ -735,12 +733,7 @@ void CExactOneToAll::ProcessNewWindow( EdgeWindow *pNewEdgeWindow )
         // add it to the edge and heap
         if ( !bNewWindowNotAvailable/*pNewEdgeWindow->b0 < pNewEdgeWindow->b1*/ )
         {
-            TypeEdgeWindowsHeap::item_type *pNewWindowItem = 
-                new TypeEdgeWindowsHeap::item_type( std::min(pNewEdgeWindow->d0, pNewEdgeWindow->d1)+pNewEdgeWindow->dPseuSrcToSrcDistance, *pNewEdgeWindow );
-
-            m_EdgeWindowsHeap.insert( pNewWindowItem ) ;
-
-            pNewEdgeWindow->pEdge->WindowsList.push_back(Edge::WindowListElement(pNewWindowItem, pNewWindowItem->m_data));
+            InsertWindow( *pNewEdgeWindow ) ;
 
             // update the geodesic distance on vertices affected by this new window
             if ( pNewEdgeWindow->b0 < 0.01 )
@@ -28,7 +28,14 @@ namespace GeodesicDist
         EdgeWindow m_AnotherNewWindow ;
         EdgeWindow m_NewExistingWindow ;
 
-        TypeEdgeWindowsHeap m_EdgeWindowsHeap ;
+        // windows of the current run, the heap and the edges only refer to them by index
+        CEdgeWindowPool m_WindowPool ;
+        CEdgeWindowsHeap m_EdgeWindowsHeap ;
+
+        // scratch lists reused by every window propagation
+        std::vector<EdgeWindow> m_NewWindowsList ;
+        std::vector<uint32_t> m_ShadowEdges ;
+        std::vector<uint32_t> m_ShadowFaces ;
 
         virtual void CutHeapTopData( EdgeWindow &EdgeWindowOut ) ;
         void ProcessNewWindow( EdgeWindow *pNewEdgeWindow ) ;
@@ -43,6 +50,8 @@ namespace GeodesicDist
                                                          std::vector<EdgeWindow> &WindowsOut);
         void InternalRun() ;
         void AddWindowToHeapAndEdge( const EdgeWindow &WindowToAdd ) ;
+        uint32_t InsertWindow( const EdgeWindow &WindowToAdd ) ;
+        void UnlinkWindow( Edge *pEdge, const uint32_t dwPrevNode, const uint32_t dwNode ) ;
 
     public:
         TypeEdgeList m_EdgeList ;
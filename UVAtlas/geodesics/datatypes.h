@@ -9,8 +9,6 @@
 
 #pragma once
 
-#include "minheap.hpp"
-
 namespace GeodesicDist
 {
     const size_t FLAG_INVALID_SIZE_T = size_t(-1) ;     // denote invalid pointer
@@ -92,9 +90,6 @@ namespace GeodesicDist
     // the face list
     typedef std::vector<Face> TypeFaceList;
 
-    // the windows heap, in each iteration, the window with minimal to-source-distance is popped off the heap and propagated
-    typedef CMinHeap<double, EdgeWindow> TypeEdgeWindowsHeap ;
-
     // one window on an edge (see the paper)
     struct EdgeWindow
     {
@@ -160,6 +155,175 @@ namespace GeodesicDist
         }
     } ;
 
+    // one window in CEdgeWindowPool, it is referred by index from the windows heap and from the windows list of its edge
+    struct EdgeWindowNode
+    {
+        EdgeWindow theWindow ;
+        double dWeight ;                                    // the key in the windows heap, min(d0, d1) + dPseuSrcToSrcDistance
+        uint32_t dwHeapPos ;                                // position in the windows heap, FLAG_INVALIDDWORD if not in heap
+        uint32_t dwNextOnEdge ;                             // next window on the same edge (or next free node), FLAG_INVALIDDWORD ends the list
+    } ;
+
+    // all the windows of one run are allocated from this pool, freed nodes are chained and reused,
+    // Reset() drops all the windows but keeps the memory for the next run
+    class CEdgeWindowPool
+    {
+    public:
+        CEdgeWindowPool() : m_dwFreeNode(FLAG_INVALIDDWORD) { }
+
+        // may throw std::bad_alloc, references to other nodes are invalidated
+        uint32_t Alloc( const EdgeWindow &Window )
+        {
+            uint32_t dwNode = m_dwFreeNode ;
+            if ( dwNode != FLAG_INVALIDDWORD )
+            {
+                m_dwFreeNode = m_Nodes[dwNode].dwNextOnEdge ;
+            }
+            else
+            {
+                dwNode = static_cast<uint32_t>(m_Nodes.size()) ;
+                m_Nodes.emplace_back() ;
+            }
+
+            EdgeWindowNode &node = m_Nodes[dwNode] ;
+            node.theWindow = Window ;
+            node.dWeight = std::min(Window.d0, Window.d1) + Window.dPseuSrcToSrcDistance ;
+            node.dwHeapPos = FLAG_INVALIDDWORD ;
+            node.dwNextOnEdge = FLAG_INVALIDDWORD ;
+            return dwNode ;
+        }
+
+        void Free( const uint32_t dwNode )
+        {
+            m_Nodes[dwNode].dwNextOnEdge = m_dwFreeNode ;
+            m_dwFreeNode = dwNode ;
+        }
+
+        void Reset()
+        {
+            m_Nodes.clear() ;
+            m_dwFreeNode = FLAG_INVALIDDWORD ;
+        }
+
+        EdgeWindowNode &operator[]( const uint32_t dwNode ) { return m_Nodes[dwNode] ; }
+
+    private:
+        std::vector<EdgeWindowNode> m_Nodes ;
+        uint32_t m_dwFreeNode ;
+    } ;
+
+    // the windows heap, in each iteration, the window with minimal to-source-distance is popped off the heap and propagated
+    // only node indices are stored, the weight and heap position are kept in the nodes of the pool
+    // (the sifting order is the same as CMinHeap, so windows with equal weight are popped in the same order)
+    class CEdgeWindowsHeap
+    {
+    public:
+        explicit CEdgeWindowsHeap( CEdgeWindowPool &Pool ) : m_Pool(Pool) { }
+
+        bool empty() const { return m_Items.empty() ; }
+
+        void clear() { m_Items.clear() ; }
+
+        // may throw std::bad_alloc
+        void insert( const uint32_t dwNode )
+        {
+            m_Items.push_back( dwNode ) ;
+            m_Pool[dwNode].dwHeapPos = static_cast<uint32_t>(m_Items.size() - 1) ;
+            upheap( m_Items.size() - 1 ) ;
+        }
+
+        uint32_t cutTop()
+        {
+            return removeAt( 0 ) ;
+        }
+
+        void remove( const uint32_t dwNode )
+        {
+            removeAt( m_Pool[dwNode].dwHeapPos ) ;
+        }
+
+    private:
+        uint32_t removeAt( const size_t i )
+        {
+            assert( i < m_Items.size() ) ;
+
+            const size_t last = m_Items.size() - 1 ;
+            const uint32_t dwNode = m_Items[i] ;
+
+            swapnode( i, last ) ;
+            m_Items.pop_back() ;
+            m_Pool[dwNode].dwHeapPos = FLAG_INVALIDDWORD ;
+
+            if ( i < last )
+            {
+                if ( m_Pool[m_Items[i]].dWeight > m_Pool[dwNode].dWeight )
+                {
+                    downheap( i ) ;
+                }
+                else
+                {
+                    upheap( i ) ;
+                }
+            }
+
+            return dwNode ;
+        }
+
+        void swapnode( const size_t i, const size_t j )
+        {
+            if ( i == j )
+                return ;
+
+            std::swap( m_Items[i], m_Items[j] ) ;
+            m_Pool[m_Items[i]].dwHeapPos = static_cast<uint32_t>(i) ;
+            m_Pool[m_Items[j]].dwHeapPos = static_cast<uint32_t>(j) ;
+        }
+
+        void downheap( size_t i )
+        {
+            const size_t size = m_Items.size() ;
+            for (;;)
+            {
+                size_t smaller = i ;
+                double minweight = m_Pool[m_Items[i]].dWeight ;
+
+                const size_t left = (i << 1) + 1 ;
+                const size_t right = left + 1 ;
+                if ( left < size && m_Pool[m_Items[left]].dWeight < minweight )
+                {
+                    smaller = left ;
+                    minweight = m_Pool[m_Items[left]].dWeight ;
+                }
+                if ( right < size && m_Pool[m_Items[right]].dWeight < minweight )
+                {
+                    smaller = right ;
+                }
+
+                if ( smaller == i )
+                    break ;
+
+                swapnode( i, smaller ) ;
+                i = smaller ;
+            }
+        }
+
+        void upheap( size_t i )
+        {
+            while ( i > 0 )
+            {
+                const size_t parent = (i - 1) >> 1 ;
+                if ( !(m_Pool[m_Items[i]].dWeight < m_Pool[m_Items[parent]].dWeight) )
+                    break ;
+
+                swapnode( i, parent ) ;
+                i = parent ;
+            }
+        }
+
+        CEdgeWindowPool &m_Pool ;
+        std::vector<uint32_t> m_Items ;
+    } ;
+
     struct Edge 
     {
         uint32_t dwVertexIdx0;                              // index of one vertex of the edge
@@ -255,22 +419,11 @@ namespace GeodesicDist
             return ( (!pAdjFace0) || (!pAdjFace1) ) ;
         }
     
-        struct WindowListElement
-        {
-            TypeEdgeWindowsHeap::item_type* pHeapItem ;
-            EdgeWindow theWindow ;
-
-            WindowListElement( const TypeEdgeWindowsHeap::item_type * pHeapItem, const EdgeWindow &theWindow )
-            {
-                this->pHeapItem = const_cast<TypeEdgeWindowsHeap::item_type *>(pHeapItem) ;
-                this->theWindow = theWindow ;
-            }
-            WindowListElement() : pHeapItem(nullptr) { }
-        };
-
         // on the edge, there is a windows list, which stores windows that has propagated onto this edge
-        // in addition, it also stores a reference to the same window in the windows heap, so we can modify the one stored in the heap (modification during window intersection)
-        std::vector<WindowListElement> WindowsList;
+        // the list is linked through EdgeWindowNode::dwNextOnEdge, the windows themselves live in CEdgeWindowPool
+        // a window on the list may also be in the windows heap, so we can modify it in place (modification during window intersection)
+        uint32_t dwFirstWindow ;
+        uint32_t dwLastWindow ;
     } ;
 
     struct Face
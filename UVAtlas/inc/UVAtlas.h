@@ -37,25 +37,87 @@ namespace DirectX
     // UVATLAS_IMT_WRAP_U means the texture wraps in the U direction
     // UVATLAS_IMT_WRAP_V means the texture wraps in the V direction
     // UVATLAS_IMT_WRAP_UV means the texture wraps in both directions
+    // UVATLAS_IMT_SUMMED_AREA means UVAtlasComputeIMTFromTexture and UVAtlasComputeIMTFromPerTexelSignal first
+    // build a summed-area table of the IMT of every texel, which takes (width + 1) * height * 24 bytes. The
+    // texels entirely covered by a face are then summed from it in constant time per texel row, and only the
+    // texels on face boundaries are clipped, which is much faster for faces covering many texels. Covered
+    // texels integrate the same bilinear signal in closed form. For texture coordinates in [0, 1] the result
+    // differs from the default by rounding only (about 1e-6 relative). Out of [0, 1] along a wrapped
+    // axis, the default samples at coordinates rounded to float, and the two differ by up to about 1e-5.
+    // UVATLAS_WORKERS(n) and UVATLAS_WORKERS_AUTO can be combined with these flags to compute the IMT
+    // of faces on worker threads. The result is identical to serial computation, and the status
+    // callback is only called from the calling thread.
     enum UVATLAS_IMT
     {
         UVATLAS_IMT_DEFAULT = 0x00,
         UVATLAS_IMT_WRAP_U = 0x01,
         UVATLAS_IMT_WRAP_V = 0x02,
         UVATLAS_IMT_WRAP_UV = 0x03,
-        UVATLAS_IMT_VALIDBITS = 0x03,
+        UVATLAS_IMT_SUMMED_AREA = 0x04,
+        UVATLAS_IMT_VALIDBITS = 0x00FF0007,
     };
 
-    // These options are only valid for UVAtlasCreate and UVAtlasPartition
+    // These options are only valid for UVAtlasCreate and UVAtlasPartition, except the UVATLAS_WORKERS
+    // options which are also valid for the UVAtlasComputeIMT functions
     // UVATLAS_DEFAULT - Meshes with more than 25k faces go through fast, meshes with fewer than 25k faces go through quality
     // UVATLAS_GEODESIC_FAST - Uses approximations to improve charting speed at the cost of added stretch or more charts.
     // UVATLAS_GEODESIC_QUALITY - Provides better quality charts, but requires more time and memory than fast.
+    // UVATLAS_GEODESIC_HEAT - Computes geodesic distances by the heat method. Close to quality, and fast on large meshes.
+    // UVATLAS_BATCH_SPLIT - Splits several of the charts with the largest stretch at once while refining the
+    //                       partition. Much faster for atlases with many charts, results differ from the default.
+    // UVATLAS_WORKERS(n) - Partitions independent charts on n worker threads (n <= 254). By default charts are
+    //                      partitioned serially. Results are deterministic and identical for any n.
+    // UVATLAS_WORKERS_AUTO - Uses one partition worker per hardware thread.
+    // UVATLAS_SOLVER_ITERATIVE - Solves barycentric parameterization by conjugate gradient.
+    // UVATLAS_SOLVER_DIRECT - Solves barycentric parameterization by sparse Cholesky factorization. By default
+    //                         the direct solver is used for charts with many interior vertices.
     enum UVATLAS
     {
         UVATLAS_DEFAULT = 0x00,
         UVATLAS_GEODESIC_FAST = 0x01,
         UVATLAS_GEODESIC_QUALITY = 0x02,
-        UVATLAS_PARTITIONVALIDBITS = 0x03,
+        UVATLAS_SOLVER_ITERATIVE = 0x04,
+        UVATLAS_SOLVER_DIRECT = 0x08,
+        UVATLAS_GEODESIC_HEAT = 0x10,
+        UVATLAS_BATCH_SPLIT = 0x20,
+        UVATLAS_WORKERS_AUTO = 0x00FF0000,
+        UVATLAS_WORKERS_MASK = 0x00FF0000,
+        UVATLAS_PARTITIONVALIDBITS = 0x00FF003F,
+    };
+
+    inline constexpr DWORD UVATLAS_WORKERS(unsigned int n)
+    {
+        return (n < 0xFF ? n : 0xFE) << 16;
+    }
+
+    // Statistics of one UVAtlasCreate call, times are in seconds. Stage times are wall times of
+    // stages which don't overlap, so they add up to at most totalTime. Kernel times (the CpuTime
+    // fields) are summed over the threads running the kernel, and kernels run inside the stages,
+    // so they can add up to more than totalTime.
+    struct UVAtlasStats
+    {
+        double initTime;            // Building the base mesh information and initial charts
+        double partitionTime;       // Partitioning charts and optimizing their stretch
+        double mergeTime;           // Merging small charts
+        double packTime;            // Packing charts into the atlas
+        double totalTime;           // Wall time of the whole call
+        double importanceCpuTime;   // Vertex importance by progressive mesh simplification
+        double geodesicCpuTime;     // Geodesic distances from landmark vertices
+        double eigenCpuTime;        // Isomap eigen decomposition
+        double stretchCpuTime;      // Stretch optimization of charts
+        size_t chartsSplit;         // Charts partitioned into children
+        size_t mergeAttempts;       // Pairs of charts tentatively merged
+        size_t mergeFailures;       // Merge attempts rejected
+        size_t mergeSizeRejects;    // Merge candidates not attempted, the merged chart would be too large
+        size_t mergeBoundRejects;   // Merge candidates not attempted, the stretch would be too large even
+                                    // if the merged chart was parameterized without distortion
+        size_t mergeTopoRejects;    // Merge attempts rejected before parameterization, the merged chart
+                                    // would not be a manifold with one boundary
+        size_t cgIterations;        // Conjugate gradient iterations of all parameterizations
+        size_t geodesicRuns;        // Single source geodesic distance computations
+        size_t packRestarts;        // Packing passes restarted because the charts didn't fit
+        size_t peakAllocatedBytes;  // Peak of the bytes held by geodesic distance tables and isomap
+                                    // matrices, the largest buffers. Other allocations are not counted.
     };
 
     static const float UVATLAS_DEFAULT_CALLBACK_FREQUENCY = 0.0001f;
@@ -125,6 +187,12 @@ namespace DirectX
     //  numChartsOut - A location to store the number of charts created, or if the
     //                 maximum number of charts was too low, this gives the minimum
     //                 number of charts needed to create an atlas.
+    //  statsOut - A location to store the time spent in each stage and the work done,
+    //             for profiling. Only written if the call succeeds.
+    //  timeBudget - Seconds the partitioning may take, 0 for no limit. When the budget
+    //               expires, charts are no longer split and merging stops; the charts
+    //               found so far are then packed and returned, and the call returns
+    //               S_FALSE to report that the stretch target was not reached.
 
     HRESULT __cdecl UVAtlasCreate(
         _In_reads_(nVerts)                  const XMFLOAT3* positions,
@@ -149,7 +217,9 @@ namespace DirectX
         _Inout_opt_ std::vector<uint32_t>*  pvFacePartitioning = nullptr,
         _Inout_opt_ std::vector<uint32_t>*  pvVertexRemapArray = nullptr,
         _Out_opt_                           float *maxStretchOut = nullptr,
-        _Out_opt_                           size_t *numChartsOut = nullptr);
+        _Out_opt_                           size_t *numChartsOut = nullptr,
+        _Out_opt_                           UVAtlasStats *statsOut = nullptr,
+        _In_                                float timeBudget = 0.f);
 
     // This has the same exact arguments as Create, except that it does not perform the
     // final packing step. This method allows one to get a partitioning out, and possibly
@@ -174,6 +244,8 @@ namespace DirectX
     // | |_|_|
     // |_____|
     //
+    // timeBudget bounds the partitioning as in Create, S_FALSE is returned if it expired
+    // before the stretch target was reached.
 
     HRESULT __cdecl UVAtlasPartition(
         _In_reads_(nVerts)          const XMFLOAT3* positions,
@@ -196,7 +268,8 @@ namespace DirectX
         _Inout_opt_                 std::vector<uint32_t>* pvVertexRemapArray,
         _Inout_                     std::vector<uint32_t>& vPartitionResultAdjacency,
         _Out_opt_                   float *maxStretchOut = nullptr,
-        _Out_opt_                   size_t *numChartsOut = nullptr);
+        _Out_opt_                   size_t *numChartsOut = nullptr,
+        _In_                        float timeBudget = 0.f);
 
     // This takes the face partitioning result from Partition and packs it into an
     // atlas of the given size. pPartitionResultAdjacency should be derived from
@@ -239,8 +312,23 @@ namespace DirectX
     // signalDimension  - How many floats per vertex to use in calculating the IMT.
     // signalStride     - The number of bytes per vertex in the array. This must be
     //                    a multiple of sizeof(float)
+    // options          - Combination of one or more UVATLAS_IMT flags.
     // pIMTArray        - An array of 3 * nFaces floats for the result
 
+    HRESULT __cdecl UVAtlasComputeIMTFromPerVertexSignal(
+        _In_reads_(nVerts)                  const XMFLOAT3* positions,
+        _In_                                size_t nVerts,
+        _When_(indexFormat == DXGI_FORMAT_R16_UINT, _In_reads_bytes_(nFaces*sizeof(uint16_t)))
+        _When_(indexFormat != DXGI_FORMAT_R16_UINT, _In_reads_bytes_(nFaces*sizeof(uint32_t))) const void* indices,
+        _In_                                DXGI_FORMAT indexFormat,
+        _In_                                size_t nFaces,
+        _In_reads_(signalStride*nVerts)     const float *pVertexSignal,
+        _In_                                size_t signalDimension,
+        _In_                                size_t signalStride,
+        _In_                                DWORD options,
+        _In_opt_                            std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+        _Out_writes_(nFaces * 3)            float* pIMTArray);
+
     HRESULT __cdecl UVAtlasComputeIMTFromPerVertexSignal(
         _In_reads_(nVerts)                  const XMFLOAT3* positions,
         _In_                                size_t nVerts,
@@ -270,6 +358,8 @@ namespace DirectX
     //                   userData - The userData pointer passed in to ComputeIMTFromSignal
     //                   signalOut - A pointer to where to store the signal data.
     // userData        - A pointer that will be passed in to the callback.
+    // options          - Combination of one or more UVATLAS_IMT flags. If worker threads are
+    //                    requested, signalCallback is called concurrently and must be thread safe.
     // pIMTArray        - An array of 3 * nFaces floats for the result
     HRESULT __cdecl UVAtlasComputeIMTFromSignal(
         _In_reads_(nVerts)                  const XMFLOAT3* positions,
@@ -284,6 +374,59 @@ namespace DirectX
         _In_ std::function<HRESULT __cdecl(const DirectX::XMFLOAT2 *uv, size_t primitiveID, size_t signalDimension, void* userData, float* signalOut)>
                                             signalCallback,
         _In_opt_                            void *userData,
+        _In_                                DWORD options,
+        _In_opt_                            std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+        _Out_writes_(nFaces * 3)            float* pIMTArray);
+
+    HRESULT __cdecl UVAtlasComputeIMTFromSignal(
+        _In_reads_(nVerts)                  const XMFLOAT3* positions,
+        _In_reads_(nVerts)                  const XMFLOAT2* texcoords,
+        _In_                                size_t nVerts,
+        _When_(indexFormat == DXGI_FORMAT_R16_UINT, _In_reads_bytes_(nFaces*sizeof(uint16_t)))
+        _When_(indexFormat != DXGI_FORMAT_R16_UINT, _In_reads_bytes_(nFaces*sizeof(uint32_t))) const void* indices,
+        _In_                                DXGI_FORMAT indexFormat,
+        _In_                                size_t nFaces,
+        _In_                                size_t signalDimension,
+        _In_                                float maxUVDistance,
+        _In_ std::function<HRESULT __cdecl(const DirectX::XMFLOAT2 *uv, size_t primitiveID, size_t signalDimension, void* userData, float* signalOut)>
+                                            signalCallback,
+        _In_opt_                            void *userData,
+        _In_opt_                            std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+        _Out_writes_(nFaces * 3)            float* pIMTArray);
+
+    // Sample point of the batched signal callback of UVAtlasComputeIMTFromSignal
+    struct UVAtlasSignalSample
+    {
+        DirectX::XMFLOAT2 uv;
+        size_t primitiveID;
+    };
+
+    // This function is the same as UVAtlasComputeIMTFromSignal, except that the signal is requested
+    // in batches. The subdivision points of a block of faces are collected first, the callback is
+    // called once for all of them, then their IMT is integrated. Blocks hold up to 64 faces, and
+    // split into several callbacks when the faces are subdivided into very many points.
+    //
+    // signalCallback  - The callback to use to get the signal.
+    //                   samples - The texture coordinates and face IDs to compute the signal at.
+    //                   sampleCount - The number of samples.
+    //                   signalDimension - The number of floats to store per sample.
+    //                   userData - The userData pointer passed in to ComputeIMTFromSignal
+    //                   signalOut - Where to store sampleCount * signalDimension floats, in the
+    //                               order of samples.
+    HRESULT __cdecl UVAtlasComputeIMTFromSignal(
+        _In_reads_(nVerts)                  const XMFLOAT3* positions,
+        _In_reads_(nVerts)                  const XMFLOAT2* texcoords,
+        _In_                                size_t nVerts,
+        _When_(indexFormat == DXGI_FORMAT_R16_UINT, _In_reads_bytes_(nFaces*sizeof(uint16_t)))
+        _When_(indexFormat != DXGI_FORMAT_R16_UINT, _In_reads_bytes_(nFaces*sizeof(uint32_t))) const void* indices,
+        _In_                                DXGI_FORMAT indexFormat,
+        _In_                                size_t nFaces,
+        _In_                                size_t signalDimension,
+        _In_                                float maxUVDistance,
+        _In_ std::function<HRESULT __cdecl(const UVAtlasSignalSample* samples, size_t sampleCount, size_t signalDimension, void* userData, float* signalOut)>
+                                            signalCallback,
+        _In_opt_                            void *userData,
+        _In_                                DWORD options,
         _In_opt_                            std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
         _Out_writes_(nFaces * 3)            float* pIMTArray);
 
@@ -311,6 +454,36 @@ namespace DirectX
         _In_opt_                            std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
         _Out_writes_(nFaces * 3)            float* pIMTArray);
 
+    // This function is the same as UVAtlasComputeIMTFromTexture, for textures in other formats and with
+    // a row pitch. Texels are converted to float as they are sampled, and only the texels covered by
+    // faces are read, so pTexels can point into a memory mapped file (e.g. the texel data of a DDS file)
+    // far larger than the available memory. With UVATLAS_IMT_SUMMED_AREA all the texels are read once.
+    //
+    // pTexels          - The texture to load data from, height rows of rowPitch bytes
+    // texelFormat      - Format of texels, one of DXGI_FORMAT_R32G32B32A32_FLOAT, R32G32B32_FLOAT,
+    //                    R32G32_FLOAT, R32_FLOAT, R16G16B16A16_FLOAT, R16G16_FLOAT, R16_FLOAT,
+    //                    R8G8B8A8_UNORM, B8G8R8A8_UNORM, R8G8_UNORM or R8_UNORM. The signal
+    //                    dimension is the number of channels of the format.
+    // rowPitch         - The number of bytes between rows of texels
+    // options          - Combination of one or more UVATLAS_IMT flags.
+    // pIMTArray        - An array of 3 * nFaces floats for the result
+    HRESULT __cdecl UVAtlasComputeIMTFromTexture(
+        _In_reads_(nVerts)                  const XMFLOAT3* positions,
+        _In_reads_(nVerts)                  const XMFLOAT2* texcoords,
+        _In_                                size_t nVerts,
+        _When_(indexFormat == DXGI_FORMAT_R16_UINT, _In_reads_bytes_(nFaces*sizeof(uint16_t)))
+        _When_(indexFormat != DXGI_FORMAT_R16_UINT, _In_reads_bytes_(nFaces*sizeof(uint32_t))) const void* indices,
+        _In_                                DXGI_FORMAT indexFormat,
+        _In_                                size_t nFaces,
+        _In_reads_bytes_(rowPitch*height)   const void* pTexels,
+        _In_                                DXGI_FORMAT texelFormat,
+        _In_                                size_t width,
+        _In_                                size_t height,
+        _In_                                size_t rowPitch,
+        _In_                                DWORD options,
+        _In_opt_                            std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+        _Out_writes_(nFaces * 3)            float* pIMTArray);
+
     // This function is very similar to UVAtlasComputeIMTFromTexture, but it can
     // calculate higher dimensional values than 4.
     //
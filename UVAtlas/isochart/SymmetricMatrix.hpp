@@ -12,9 +12,16 @@
 // http://www.library.cornell.edu/nr/bookfpdf/f11-1.pdf
 // http://www.library.cornell.edu/nr/bookfpdf/f11-2.pdf
 // http://www.library.cornell.edu/nr/bookfpdf/f11-3.pdf
+//
+// GetLargestEigen implements the thick-restart Lanczos method with full
+// reorthogonalization, see "Thick-Restart Lanczos Method for Large Symmetric
+// Eigenvalue Problems", Kesheng Wu and Horst Simon, SIAM J. Matrix Anal. Appl.
+// 22(2), 2000.
 
 #pragma once
 
+#include <random>
+
 namespace Isochart
 {
     template<class TYPE>
@@ -462,5 +469,251 @@ namespace Isochart
 
             return true;
         }
+
+        // Compute the dwMaxRange largest eigen values and vectors without
+        // decomposing the whole matrix. Only O(dwDimension * dwMaxRange) extra
+        // memory is used, each iteration costs one matrix-vector product.
+        // Iteration stops when the residual of each wanted eigen pair is less
+        // than tolerance * |largest eigen value|. Return false if the iteration
+        // doesn't converge in dwMaxRestart restarts or out of memory, callers
+        // can fall back to GetEigen.
+        _Success_(return) 
+        static bool
+        GetLargestEigen(
+            size_t dwDimension,
+            _In_reads_(dwDimension * dwDimension) const value_type* pMatrix,
+            _Out_writes_(dwMaxRange) value_type* pEigenValue,
+            _Out_writes_(dwDimension*dwMaxRange) value_type* pEigenVector,
+            size_t dwMaxRange,
+            value_type tolerance = 1.0e-5f,
+            size_t dwMaxRestart = 100)
+        {
+            // 1. check argument
+            if (!pMatrix || !pEigenValue || !pEigenVector)
+                return false;
+
+            // Size of the Krylov subspace. When it can hold the whole space,
+            // a full decomposition is cheaper.
+            const size_t dwBasisSize = std::max(2 * dwMaxRange, dwMaxRange + 20);
+            if (dwMaxRange == 0 || dwDimension <= dwBasisSize)
+            {
+                return false;
+            }
+
+            // Ritz vectors kept when restarting.
+            const size_t dwKeepSize = dwMaxRange + (dwBasisSize - dwMaxRange) / 2;
+
+            // 2. allocate memory resouce
+            std::unique_ptr<double[]> tmp(new (std::nothrow) double[
+                (dwBasisSize + 1 + dwKeepSize + 1) * dwDimension
+                + 3 * dwBasisSize * dwBasisSize + dwBasisSize]);
+            if (!tmp)
+                return false;
+
+            double* pBasis = tmp.get();                                         // (dwBasisSize + 1) * dwDimension
+            double* pRitzVector = pBasis + (dwBasisSize + 1) * dwDimension;     // dwKeepSize * dwDimension
+            double* pW = pRitzVector + dwKeepSize * dwDimension;                // dwDimension
+            double* pProjected = pW + dwDimension;                              // dwBasisSize * dwBasisSize
+            double* pScaled = pProjected + dwBasisSize * dwBasisSize;           // dwBasisSize * dwBasisSize
+            double* pRitzCoord = pScaled + dwBasisSize * dwBasisSize;           // dwBasisSize * dwBasisSize
+            double* pRitzValue = pRitzCoord + dwBasisSize * dwBasisSize;        // dwBasisSize
+
+            // 3. Start from a fixed pseudo-random vector, so the result is
+            // repeatable. Constant vectors are not used because isomap
+            // matrices have them in the null space.
+            std::minstd_rand randGenerator(1);
+            auto randomVector = [&](double* v)
+            {
+                for (size_t i = 0; i < dwDimension; i++)
+                {
+                    v[i] = static_cast<double>(randGenerator()) 
+                        / static_cast<double>(std::minstd_rand::max()) - 0.5;
+                }
+            };
+
+            // Orthogonalize v against pBasis[0..dwCount-1] twice, add the
+            // projections to column dwColumn of projected matrix if required.
+            auto orthogonalize = [&](double* v, size_t dwCount, double* pColumn)
+            {
+                for (size_t pass = 0; pass < 2; pass++)
+                {
+                    for (size_t i = 0; i < dwCount; i++)
+                    {
+                        const double* pBase = pBasis + i * dwDimension;
+                        double c = 0;
+                        for (size_t l = 0; l < dwDimension; l++)
+                        {
+                            c += pBase[l] * v[l];
+                        }
+                        for (size_t l = 0; l < dwDimension; l++)
+                        {
+                            v[l] -= c * pBase[l];
+                        }
+                        if (pColumn)
+                        {
+                            pColumn[i] += c;
+                        }
+                    }
+                }
+            };
+
+            auto normalize = [&](double* v) -> double
+            {
+                double norm = 0;
+                for (size_t l = 0; l < dwDimension; l++)
+                {
+                    norm += v[l] * v[l];
+                }
+                norm = sqrt(norm);
+                if (norm > 0)
+                {
+                    for (size_t l = 0; l < dwDimension; l++)
+                    {
+                        v[l] /= norm;
+                    }
+                }
+                return norm;
+            };
+
+            double matrixScale = 0;
+            for (size_t i = 0; i < dwDimension * dwDimension; i++)
+            {
+                matrixScale = std::max(matrixScale, static_cast<double>(fabs(pMatrix[i])));
+            }
+            if (matrixScale == 0)
+            {
+                return false;
+            }
+
+            randomVector(pBasis);
+            normalize(pBasis);
+            memset(pProjected, 0, dwBasisSize * dwBasisSize * sizeof(double));
+
+            size_t dwLocked = 0;
+            for (size_t restart = 0; restart <= dwMaxRestart; restart++)
+            {
+                // 4. Extend the basis to dwBasisSize vectors, compute projection
+                // of matrix onto the basis by the way.
+                double residualNorm = 0;
+                for (size_t j = dwLocked; j < dwBasisSize; j++)
+                {
+                    const double* pV = pBasis + j * dwDimension;
+                    const value_type* pRow = pMatrix;
+                    for (size_t l = 0; l < dwDimension; l++)
+                    {
+                        double total = 0;
+                        for (size_t t = 0; t < dwDimension; t++)
+                        {
+                            total += pRow[t] * pV[t];
+                        }
+                        pW[l] = total;
+                        pRow += dwDimension;
+                    }
+
+                    // Column j of projected matrix. Keep it symmetric.
+                    double* pColumn = pRitzValue;
+                    memset(pColumn, 0, dwBasisSize * sizeof(double));
+                    orthogonalize(pW, j + 1, pColumn);
+                    for (size_t i = 0; i <= j; i++)
+                    {
+                        pProjected[i * dwBasisSize + j] = pColumn[i];
+                        pProjected[j * dwBasisSize + i] = pColumn[i];
+                    }
+
+                    double* pNext = pBasis + (j + 1) * dwDimension;
+                    memcpy(pNext, pW, dwDimension * sizeof(double));
+                    residualNorm = normalize(pNext);
+
+                    // Found an invariant subspace, continue with a new
+                    // direction.
+                    if (j + 1 < dwBasisSize 
+                        && residualNorm <= matrixScale * dwDimension * DBL_EPSILON)
+                    {
+                        randomVector(pNext);
+                        orthogonalize(pNext, j + 1, nullptr);
+                        if (normalize(pNext) == 0)
+                        {
+                            return false;
+                        }
+                    }
+                }
+
+                // 5. Rayleigh-Ritz procedure. GetEigen uses absolute
+                // thresholds, so scale the projected matrix to unit range.
+                for (size_t i = 0; i < dwBasisSize * dwBasisSize; i++)
+                {
+                    pScaled[i] = pProjected[i] / matrixScale;
+                }
+                if (!CSymmetricMatrix<double>::GetEigen(
+                    dwBasisSize, pScaled, 
+                    pRitzValue, pRitzCoord, 
+                    dwBasisSize, 1.0e-12))
+                {
+                    return false;
+                }
+                for (size_t i = 0; i < dwBasisSize; i++)
+                {
+                    pRitzValue[i] *= matrixScale;
+                }
+
+                // 6. Residual of Ritz pair i is |residualNorm * last coordinate|
+                double limit = tolerance * std::max(fabs(pRitzValue[0]), matrixScale * DBL_EPSILON);
+                bool bConverged = true;
+                for (size_t i = 0; i < dwMaxRange && bConverged; i++)
+                {
+                    bConverged = 
+                        fabs(residualNorm * pRitzCoord[i * dwBasisSize + dwBasisSize - 1]) <= limit;
+                }
+
+                // 7. Compute Ritz vectors of the largest Ritz values
+                size_t dwRitzCount = bConverged ? dwMaxRange : dwKeepSize;
+                for (size_t i = 0; i < dwRitzCount; i++)
+                {
+                    const double* pCoord = pRitzCoord + i * dwBasisSize;
+                    double* pRitz = pRitzVector + i * dwDimension;
+                    memset(pRitz, 0, dwDimension * sizeof(double));
+                    for (size_t j = 0; j < dwBasisSize; j++)
+                    {
+                        const double* pV = pBasis + j * dwDimension;
+                        for (size_t l = 0; l < dwDimension; l++)
+                        {
+                            pRitz[l] += pCoord[j] * pV[l];
+                        }
+                    }
+                }
+
+                if (bConverged)
+                {
+                    for (size_t i = 0; i < dwMaxRange; i++)
+                    {
+                        pEigenValue[i] = static_cast<value_type>(pRitzValue[i]);
+                        for (size_t l = 0; l < dwDimension; l++)
+                        {
+                            pEigenVector[i * dwDimension + l] = 
+                                static_cast<value_type>(pRitzVector[i * dwDimension + l]);
+                        }
+                    }
+                    return true;
+                }
+
+                // 8. Restart with the kept Ritz vectors followed by the last 
+                // residual direction. Projected matrix on Ritz vectors is 
+                // diagonal.
+                memcpy(
+                    pBasis + dwKeepSize * dwDimension, 
+                    pBasis + dwBasisSize * dwDimension,
+                    dwDimension * sizeof(double));
+                memcpy(pBasis, pRitzVector, dwKeepSize * dwDimension * sizeof(double));
+
+                memset(pProjected, 0, dwBasisSize * dwBasisSize * sizeof(double));
+                for (size_t i = 0; i < dwKeepSize; i++)
+                {
+                    pProjected[i * dwBasisSize + i] = pRitzValue[i];
+                }
+                dwLocked = dwKeepSize;
+            }
+
+            return false;
+        }
     };
 }
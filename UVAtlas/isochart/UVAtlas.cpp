@@ -11,6 +11,8 @@
 #include "UVAtlas.h"
 #include "isochart.h"
 #include "UVAtlasRepacker.h"
+#include "workerpool.hpp"
+#include "isochartstats.hpp"
 
 using namespace Isochart;
 using namespace DirectX;
@@ -238,6 +240,29 @@ namespace
     }
 
 
+    //---------------------------------------------------------------------------------
+    // Deadline of a partitioning allowed timeBudget seconds from tStart, 0 for no limit.
+    HRESULT GetBudgetDeadline(
+        std::chrono::steady_clock::time_point tStart,
+        float timeBudget,
+        std::chrono::steady_clock::time_point& deadline)
+    {
+        if (!(timeBudget >= 0.f))
+            return E_INVALIDARG;
+
+        deadline = std::chrono::steady_clock::time_point::max();
+        if (timeBudget > 0.f)
+        {
+            auto budget = std::chrono::duration<double>(timeBudget);
+            if (budget < deadline - tStart)
+            {
+                deadline = tStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(budget);
+            }
+        }
+        return S_OK;
+    }
+
+
     //---------------------------------------------------------------------------------
     HRESULT UVAtlasPartitionInt(
         _In_reads_(nVerts)          const XMFLOAT3* positions,
@@ -261,7 +286,9 @@ namespace
         _Inout_                     std::vector<uint32_t>& vPartitionResultAdjacency,
         _Out_opt_                   float *maxStretchOut,
         _Out_opt_                   size_t *numChartsOut,
-        _In_                        unsigned int uStageInfo)
+        _In_                        unsigned int uStageInfo,
+        _In_opt_                    CIsochartStats* pStats,
+        _In_                        std::chrono::steady_clock::time_point deadline)
     {
         if (!positions || !nVerts || !indices || !nFaces)
             return E_INVALIDARG;
@@ -352,10 +379,15 @@ namespace
             statusCallBack,
             callbackFrequency,
             falseEdgeAdjacency,
-            options);
+            options,
+            pStats,
+            deadline);
         if (FAILED(hr))
             return hr;
 
+        // S_FALSE if the deadline stopped partitioning
+        HRESULT hrPartition = hr;
+
         if (DXGI_FORMAT_R16_UINT == indexFormat)
             assert(nFaces * 3 * sizeof(uint16_t) == vOutIndexBuffer.size());
         else
@@ -447,7 +479,7 @@ namespace
 
         std::swap(vPartitionResultAdjacency, vOutAdjacency);
 
-        return S_OK;
+        return hrPartition;
     }
 
 
@@ -462,7 +494,8 @@ namespace
         _In_                    const std::vector<uint32_t>& vPartitionResultAdjacency,
         _In_opt_                LPISOCHARTCALLBACK statusCallback,
         float                   callbackFrequency,
-        _In_                    unsigned int uStageInfo)
+        _In_                    unsigned int uStageInfo,
+        _In_opt_                CIsochartStats* pStats)
     {
         if (!width || !height)
             return E_INVALIDARG;
@@ -544,7 +577,9 @@ namespace
             gutter,
             uStageInfo,
             statusCallback,
-            callbackFrequency);
+            callbackFrequency,
+            5,
+            pStats);
         if (FAILED(hr))
             return hr;
 
@@ -586,8 +621,14 @@ HRESULT __cdecl DirectX::UVAtlasPartition(
     std::vector<uint32_t>* pvVertexRemapArray,
     std::vector<uint32_t>& vPartitionResultAdjacency,
     float *maxStretchOut,
-    size_t *numChartsOut)
+    size_t *numChartsOut,
+    float timeBudget)
 {
+    std::chrono::steady_clock::time_point deadline;
+    HRESULT hr = GetBudgetDeadline(std::chrono::steady_clock::now(), timeBudget, deadline);
+    if (FAILED(hr))
+        return hr;
+
     return UVAtlasPartitionInt(positions,
                                    nVerts,
                                    indices,
@@ -610,7 +651,9 @@ HRESULT __cdecl DirectX::UVAtlasPartition(
                                    numChartsOut,
                                    (maxChartNumber == 0) ?
                                         MAKE_STAGE(2U, 0U, 2U) :
-                                        MAKE_STAGE(3U, 0U, 3U));
+                                        MAKE_STAGE(3U, 0U, 3U),
+                                   nullptr,
+                                   deadline);
 
 }
 
@@ -637,8 +680,8 @@ HRESULT __cdecl DirectX::UVAtlasPack(
                           vPartitionResultAdjacency,
                           statusCallBack,
                           callbackFrequency,
-                          MAKE_STAGE(1, 0, 1)
-                          );
+                          MAKE_STAGE(1, 0, 1),
+                          nullptr);
 }
 
 
@@ -666,12 +709,29 @@ HRESULT __cdecl DirectX::UVAtlasCreate(
     std::vector<uint32_t>* pvFacePartitioning,
     std::vector<uint32_t>* pvVertexRemapArray,
     float *maxStretchOut,
-    size_t *numChartsOut)
+    size_t *numChartsOut,
+    UVAtlasStats *statsOut,
+    float timeBudget)
 {
+    auto tStart = std::chrono::steady_clock::now();
+
+    std::chrono::steady_clock::time_point deadline;
+    HRESULT hr = GetBudgetDeadline(tStart, timeBudget, deadline);
+    if (FAILED(hr))
+        return hr;
+
+    std::unique_ptr<CIsochartStats> stats;
+    if (statsOut)
+    {
+        stats.reset(new (std::nothrow) CIsochartStats);
+        if (!stats)
+            return E_OUTOFMEMORY;
+    }
+
     std::vector<uint32_t> vFacePartitioning;
     std::vector<uint32_t> vAdjacencyOut;
 
-    HRESULT hr = UVAtlasPartitionInt(positions,
+    hr = UVAtlasPartitionInt(positions,
         nVerts,
         indices,
         indexFormat,
@@ -693,10 +753,15 @@ HRESULT __cdecl DirectX::UVAtlasCreate(
         numChartsOut,
         (maxChartNumber == 0) ?
         MAKE_STAGE(3U, 0U, 2U) :
-        MAKE_STAGE(4U, 0U, 3U));
+        MAKE_STAGE(4U, 0U, 3U),
+        stats.get(),
+        deadline);
     if (FAILED(hr))
         return hr;
 
+    // Charts are packed even if the deadline stopped partitioning
+    HRESULT hrPartition = hr;
+
     hr = UVAtlasPackInt(vMeshOutVertexBuffer,
         vMeshOutIndexBuffer,
         indexFormat,
@@ -708,7 +773,8 @@ HRESULT __cdecl DirectX::UVAtlasCreate(
         callbackFrequency,
         (maxChartNumber == 0) ?
         MAKE_STAGE(3U, 2U, 1U) :
-        MAKE_STAGE(4U, 3U, 1U));
+        MAKE_STAGE(4U, 3U, 1U),
+        stats.get());
     if (FAILED(hr))
         return hr;
 
@@ -717,10 +783,150 @@ HRESULT __cdecl DirectX::UVAtlasCreate(
         std::swap(*pvFacePartitioning, vFacePartitioning);
     }
 
-    return S_OK;
+    if (statsOut)
+    {
+        stats->Export(*statsOut);
+        statsOut->totalTime = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - tStart).count();
+    }
+
+    return hrPartition;
 }
 
 
+//-------------------------------------------------------------------------------------
+namespace
+{
+    // Faces handed to a worker at once. Status callback is checked before
+    // each chunk.
+    const size_t IMT_FACE_CHUNK = 64;
+
+    // Samples collected before the batched signal callback is called, unless
+    // a single face is split into more.
+    const size_t IMT_SIGNAL_BATCH = 65536;
+
+    // Face of a batch of UVAtlasComputeIMTFromSignal, with the vertices and
+    // sub-triangles it was split into starting at dwFirstVert and dwFirstSubFace.
+    struct IMTSignalBatchFace
+    {
+        XMFLOAT3 pos[3];
+        XMFLOAT2 uv[3];
+        size_t dwFirstVert;
+        size_t dwFirstSubFace;
+    };
+
+    // Workers requested by the UVATLAS_WORKERS bits of options.
+    size_t GetIMTWorkerCount(DWORD options, size_t nFaces)
+    {
+        return GetIsochartWorkerCount(
+            options,
+            (nFaces + IMT_FACE_CHUNK - 1) / IMT_FACE_CHUNK);
+    }
+
+    // Compute IMT of faces [dwBegin, dwEnd) of each chunk of IMT_FACE_CHUNK
+    // faces by computeChunk(dwWorker, dwBegin, dwEnd) on dwWorkerCount threads.
+    // The IMT of a face only depends on the face, so result is the same for
+    // any worker count. Status callback is only called from the calling
+    // thread, with the faces completed by all workers.
+    template <class TComputeChunk>
+    HRESULT ComputeIMTPerChunk(
+        size_t nFaces,
+        size_t dwWorkerCount,
+        const std::function<HRESULT __cdecl(float percentComplete)>& statusCallBack,
+        TComputeChunk&& computeChunk)
+    {
+        std::atomic<size_t> dwFacesDone(0);
+
+        auto computeStatusChunk = [&](size_t dwWorker, size_t dwChunk) -> HRESULT
+        {
+            if (statusCallBack && dwWorker == 0)
+            {
+                float fPct = dwFacesDone.load() / (float) nFaces;
+                if (FAILED(statusCallBack(fPct)))
+                    return E_ABORT;
+            }
+
+            size_t dwBegin = dwChunk * IMT_FACE_CHUNK;
+            size_t dwEnd = std::min(dwBegin + IMT_FACE_CHUNK, nFaces);
+
+            HRESULT hr = computeChunk(dwWorker, dwBegin, dwEnd);
+            if (FAILED(hr))
+                return hr;
+
+            dwFacesDone += dwEnd - dwBegin;
+            return S_OK;
+        };
+
+        HRESULT hr = ParallelFor(
+            (nFaces + IMT_FACE_CHUNK - 1) / IMT_FACE_CHUNK,
+            dwWorkerCount,
+            computeStatusChunk);
+        if (FAILED(hr))
+            return hr;
+
+        if (statusCallBack)
+        {
+            hr = statusCallBack(1.0f);
+            if (FAILED(hr))
+                return E_ABORT;
+        }
+
+        return S_OK;
+    }
+
+    // Compute IMT of each face by computeFace(dwWorker, face), the same way as
+    // ComputeIMTPerChunk.
+    template <class TComputeFace>
+    HRESULT ComputeIMTPerFace(
+        size_t nFaces,
+        size_t dwWorkerCount,
+        const std::function<HRESULT __cdecl(float percentComplete)>& statusCallBack,
+        TComputeFace&& computeFace)
+    {
+        return ComputeIMTPerChunk(
+            nFaces,
+            dwWorkerCount,
+            statusCallBack,
+            [&](size_t dwWorker, size_t dwBegin, size_t dwEnd) -> HRESULT
+            {
+                for (size_t i = dwBegin; i < dwEnd; i++)
+                {
+                    HRESULT hr = computeFace(dwWorker, i);
+                    if (FAILED(hr))
+                        return hr;
+                }
+                return S_OK;
+            });
+    }
+
+    // Build the summed-area table of texture for UVATLAS_IMT_SUMMED_AREA into
+    // summedArea, and let texture refer to it.
+    HRESULT BuildSummedAreaTable(
+        DWORD options,
+        size_t signalDimension,
+        IMTTEXTUREDESC& texture,
+        std::unique_ptr<double[]>& summedArea)
+    {
+        if (texture.uHeight > (SIZE_MAX / (IMT_DIM * sizeof(double))) / (texture.uWidth + 1))
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+        summedArea.reset(new (std::nothrow) double[(texture.uWidth + 1) * texture.uHeight * IMT_DIM]);
+        if (!summedArea)
+            return E_OUTOFMEMORY;
+
+        HRESULT hr = IMTBuildSummedAreaTable(
+            texture,
+            signalDimension,
+            GetIsochartWorkerCount(options, texture.uHeight),
+            summedArea.get());
+        if (FAILED(hr))
+            return hr;
+
+        texture.pSummedArea = summedArea.get();
+        return S_OK;
+    }
+}
+
 //-------------------------------------------------------------------------------------
 _Use_decl_annotations_
 HRESULT __cdecl DirectX::UVAtlasComputeIMTFromPerVertexSignal(
@@ -732,6 +938,7 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromPerVertexSignal(
     const float *pVertexSignal,
     size_t signalDimension,
     size_t signalStride,
+    DWORD options,
     std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
     float* pIMTArray)
 {
@@ -769,75 +976,83 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromPerVertexSignal(
     if ((uint64_t(signalDimension) * 3) >= UINT32_MAX)
         return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
 
-    std::unique_ptr<float[]> signalData( new (std::nothrow) float[3 * signalDimension] );
-    if (!signalData)
-        return E_OUTOFMEMORY;
-
-    float* pfSignalData = signalData.get();
-
     auto pdwIndexData = reinterpret_cast<const uint32_t*>(indices);
     auto pwIndexData = reinterpret_cast<const uint16_t*>(indices);
 
     float* pfIMTData = pIMTArray;
 
-    HRESULT hr;
+    size_t dwWorkerCount = GetIMTWorkerCount(options, nFaces);
 
-    for (size_t i = 0; i < nFaces; i++)
-    {
-        if (statusCallBack && ((i % 64) == 0))
-        {
-            float fPct = i / (float) nFaces;
-            hr = statusCallBack(fPct);
-            if (FAILED(hr))
-                return E_ABORT;
-        }
+    // Each worker gathers the signal of its face into its own slice.
+    std::unique_ptr<float[]> signalData( new (std::nothrow) float[dwWorkerCount * 3 * signalDimension] );
+    if (!signalData)
+        return E_OUTOFMEMORY;
 
-        XMFLOAT3 pos[3] = {};
-        for (size_t j = 0; j < 3; j++)
+    return ComputeIMTPerFace(
+        nFaces,
+        dwWorkerCount,
+        statusCallBack,
+        [&](size_t dwWorker, size_t i) -> HRESULT
         {
-            uint32_t dwId;
-            if (indexFormat == DXGI_FORMAT_R16_UINT)
-            {
-                dwId = pwIndexData[3*i + j];
-            }
-            else
-            {
-                dwId = pdwIndexData[3*i + j];
-            }
+            float* pfSignalData =
+                signalData.get() + dwWorker * 3 * signalDimension;
 
-            if (dwId >= nVerts)
+            XMFLOAT3 pos[3] = {};
+            for (size_t j = 0; j < 3; j++)
             {
-                DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
-                return E_FAIL;
-            }
+                uint32_t dwId;
+                if (indexFormat == DXGI_FORMAT_R16_UINT)
+                {
+                    dwId = pwIndexData[3*i + j];
+                }
+                else
+                {
+                    dwId = pdwIndexData[3*i + j];
+                }
+
+                if (dwId >= nVerts)
+                {
+                    DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
+                    return E_FAIL;
+                }
+
+                pos[j] = positions[dwId];
 
-            pos[j] = positions[dwId];
+                for( size_t k = 0; k < signalDimension; k++ )
+                {
+                    pfSignalData[ j *signalDimension + k] = pVertexSignal[dwId * (signalStride / sizeof(float)) + k];
+                }
+            }
 
-            for( size_t k = 0; k < signalDimension; k++ )
+            HRESULT hr = IMTFromPerVertexSignal(pos,
+                                                pfSignalData,
+                                                signalDimension,
+                                                reinterpret_cast<FLOAT3*>(pfIMTData + 3 * i) );
+            if( FAILED(hr) )
             {
-                pfSignalData[ j *signalDimension + k] = pVertexSignal[dwId * (signalStride / sizeof(float)) + k];
+                DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
+                return hr;
             }
-        }
 
-        hr = IMTFromPerVertexSignal(pos,
-                                    pfSignalData,
-                                    signalDimension,
-                                    reinterpret_cast<FLOAT3*>(pfIMTData + 3 * i) );
-        if( FAILED(hr) )
-        {
-            DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
-            return hr;
-        }
-    }
-    
-    if (statusCallBack)
-    {
-        hr = statusCallBack(1.0f);
-        if (FAILED(hr))
-            return E_ABORT;
-    }
+            return S_OK;
+        });
+}
 
-    return S_OK;
+_Use_decl_annotations_
+HRESULT __cdecl DirectX::UVAtlasComputeIMTFromPerVertexSignal(
+    const XMFLOAT3* positions,
+    size_t nVerts,
+    const void* indices,
+    DXGI_FORMAT indexFormat,
+    size_t nFaces,
+    const float *pVertexSignal,
+    size_t signalDimension,
+    size_t signalStride,
+    std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+    float* pIMTArray)
+{
+    return UVAtlasComputeIMTFromPerVertexSignal(positions, nVerts, indices, indexFormat, nFaces,
+        pVertexSignal, signalDimension, signalStride, UVATLAS_IMT_DEFAULT, statusCallBack, pIMTArray);
 }
 
 
@@ -854,6 +1069,7 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromSignal(
     float maxUVDistance,
     std::function<HRESULT __cdecl(const DirectX::XMFLOAT2 *uv, size_t primitiveID, size_t signalDimension, void* userData, float* signalOut)> signalCallback,
     void *userData,
+    DWORD options,
     std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
     float* pIMTArray)
 {
@@ -893,341 +1109,336 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromSignal(
 
     float* pfIMTData = pIMTArray;
 
-    HRESULT hr;
-
-    for (size_t i = 0; i < nFaces; i++)
-    {
-        if (statusCallBack && ((i % 64) == 0))
-        {
-            float fPct = i / (float) nFaces;
-            hr = statusCallBack(fPct);
-            if (FAILED(hr))
-                return E_ABORT;
-        }
+    size_t dwWorkerCount = GetIMTWorkerCount(options, nFaces);
 
-        XMFLOAT3 pos[3] = {};
-        XMFLOAT2 uv[3] = {};
-        for (size_t j = 0; j < 3; j++)
+    return ComputeIMTPerFace(
+        nFaces,
+        dwWorkerCount,
+        statusCallBack,
+        [&](size_t, size_t i) -> HRESULT
         {
-            uint32_t dwId;
-            if (indexFormat == DXGI_FORMAT_R16_UINT)
-            {
-                dwId = pwIndexData[3*i + j];
-            }
-            else
+            XMFLOAT3 pos[3] = {};
+            XMFLOAT2 uv[3] = {};
+            for (size_t j = 0; j < 3; j++)
             {
-                dwId = pdwIndexData[3*i + j];
+                uint32_t dwId;
+                if (indexFormat == DXGI_FORMAT_R16_UINT)
+                {
+                    dwId = pwIndexData[3*i + j];
+                }
+                else
+                {
+                    dwId = pdwIndexData[3*i + j];
+                }
+
+                if( dwId >= nVerts )
+                {
+                    DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
+                    return E_FAIL;
+                }
+
+                pos[j] = positions[dwId];
+                uv[j] = texcoords[dwId];
             }
 
-            if( dwId >= nVerts )
+            HRESULT hr = IMTFromTextureMap(pos, uv, 
+                                           8, // max 64k subtesselations
+                                           maxUVDistance,
+                                           i,
+                                           signalDimension,
+                                           signalCallback,
+                                           userData,
+                                           (FLOAT3*)(pfIMTData + 3*i));
+            if ( FAILED(hr) )
             {
-                DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
-                return E_FAIL;
+                DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
+                return hr;
             }
 
-            pos[j] = positions[dwId];
-            uv[j] = texcoords[dwId];
-        }
-
-        hr = IMTFromTextureMap(pos, uv, 
-                               8, // max 64k subtesselations
-                               maxUVDistance,
-                               i,
-                               signalDimension,
-                               signalCallback,
-                               userData,
-                               (FLOAT3*)(pfIMTData + 3*i));
-        if ( FAILED(hr) )
-        {
-            DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
-            return hr;
-        }
-    }
-    
-    if (statusCallBack)
-    {
-        hr = statusCallBack(1.0f);
-        if( FAILED(hr) )
-            return E_ABORT;
-    }
+            return S_OK;
+        });
+}
 
-    return S_OK;
+_Use_decl_annotations_
+HRESULT __cdecl DirectX::UVAtlasComputeIMTFromSignal(
+    const XMFLOAT3* positions,
+    const XMFLOAT2* texcoords,
+    size_t nVerts,
+    const void* indices,
+    DXGI_FORMAT indexFormat,
+    size_t nFaces,
+    size_t signalDimension,
+    float maxUVDistance,
+    std::function<HRESULT __cdecl(const DirectX::XMFLOAT2 *uv, size_t primitiveID, size_t signalDimension, void* userData, float* signalOut)> signalCallback,
+    void *userData,
+    std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+    float* pIMTArray)
+{
+    return UVAtlasComputeIMTFromSignal(positions, texcoords, nVerts, indices, indexFormat, nFaces,
+        signalDimension, maxUVDistance, signalCallback, userData, UVATLAS_IMT_DEFAULT, statusCallBack, pIMTArray);
 }
 
 
 //-------------------------------------------------------------------------------------
-namespace
+_Use_decl_annotations_
+HRESULT __cdecl DirectX::UVAtlasComputeIMTFromSignal(
+    const XMFLOAT3* positions,
+    const XMFLOAT2* texcoords,
+    size_t nVerts,
+    const void* indices,
+    DXGI_FORMAT indexFormat,
+    size_t nFaces,
+    size_t signalDimension,
+    float maxUVDistance,
+    std::function<HRESULT __cdecl(const UVAtlasSignalSample* samples, size_t sampleCount, size_t signalDimension, void* userData, float* signalOut)> signalCallback,
+    void *userData,
+    DWORD options,
+    std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+    float* pIMTArray)
 {
-    struct IMTTextureDesc
-    {
-        const XMFLOAT4 *pTexture;
-        size_t uHeight, uWidth;
-    };
+    if (!positions || !texcoords || !nVerts || !indices || !nFaces || !pIMTArray)
+        return E_INVALIDARG;
 
-    HRESULT __cdecl IMTTextureCbWrapNone(const XMFLOAT2 *uv,
-        size_t uPrimitiveId,
-        size_t uSignalDimension,
-        void *pUserData,
-        float *pfSignalOut)
+    if ( !signalCallback )
     {
-        UNREFERENCED_PARAMETER(uPrimitiveId);
-        UNREFERENCED_PARAMETER(uSignalDimension);
+        DPF(0, "ComputeIMTFromSignal: requires signal computation callback." );
+        return E_INVALIDARG;
+    }
 
-        auto pTexDesc = reinterpret_cast<IMTTextureDesc*>( pUserData );
+    if (signalDimension > UINT32_MAX)
+        return E_INVALIDARG;
 
-        float u = uv->x;
-        float v = uv->y;
+    switch (indexFormat)
+    {
+    case DXGI_FORMAT_R16_UINT:
+        if (nVerts >= UINT16_MAX)
+            return E_INVALIDARG;
+        break;
 
-        if (u < 0.f)
-            u = 0.f;
-        if (u > 1.f)
-            u = 1.f;
+    case DXGI_FORMAT_R32_UINT:
+        if (nVerts >= UINT32_MAX)
+            return E_INVALIDARG;
+        break;
 
-        if (v < 0.f)
-            v = 0.f;
-        if (v > 1.f)
-            v = 1.f;
+    default:
+        return E_INVALIDARG;
+    }
 
-        u = u * pTexDesc->uWidth;
-        v = v * pTexDesc->uHeight;
+    if ((uint64_t(nFaces) * 3) >= UINT32_MAX)
+        return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
 
-        int i = (int) u;
-        int j = (int) v;
-        int i2 = i + 1;
-        int j2 = j + 1;
+    auto pdwIndexData = reinterpret_cast<const uint32_t*>(indices);
+    auto pwIndexData = reinterpret_cast<const uint16_t*>(indices);
 
-        float du = u - i;
-        float dv = v - j;
+    size_t dwWorkerCount = GetIMTWorkerCount(options, nFaces);
 
-        i = std::max(0, std::min<int>(i, int(pTexDesc->uWidth) - 1));
-        i2 = std::max(0, std::min<int>(i2, int(pTexDesc->uWidth) - 1));
-        j = std::max(0, std::min<int>(j, int(pTexDesc->uHeight) - 1));
-        j2 = std::max(0, std::min<int>(j2, int(pTexDesc->uHeight) - 1));
+    return ComputeIMTPerChunk(
+        nFaces,
+        dwWorkerCount,
+        statusCallBack,
+        [&](size_t, size_t dwBegin, size_t dwEnd) -> HRESULT
+        {
+            IMTSignalBatchFace faces[IMT_FACE_CHUNK];
+            std::vector<XMFLOAT2> vertList;
+            std::vector<SUBFACE> subFaceList;
+            std::vector<UVAtlasSignalSample> samples;
+            std::vector<float> signal;
+
+            // Sample signal of split faces [dwFirst, dwLast) at once, then
+            // integrate their IMT.
+            auto integrateBatch = [&](size_t dwFirst, size_t dwLast) -> HRESULT
+            {
+                try
+                {
+                    samples.resize(vertList.size());
+                    signal.resize(vertList.size() * signalDimension);
+                }
+                catch (std::bad_alloc&)
+                {
+                    return E_OUTOFMEMORY;
+                }
 
-        // 
-        // C1 ---- C2  ^          dv
-        //  | .    |   |           |
-        //  |      |   |           |
-        //  |      |   |           |
-        // C3 ---- C4  v, u --->   v
-        //
+                for (size_t i = dwFirst; i < dwLast; i++)
+                {
+                    size_t dwVertEnd = (i + 1 < dwLast) ? faces[i + 1 - dwBegin].dwFirstVert : vertList.size();
+                    for (size_t k = faces[i - dwBegin].dwFirstVert; k < dwVertEnd; k++)
+                    {
+                        samples[k].uv = vertList[k];
+                        samples[k].primitiveID = i;
+                    }
+                }
 
-        XMVECTOR C1, C2, C3, C4, res;
-        C1 = XMLoadFloat4(&pTexDesc->pTexture[j * pTexDesc->uWidth + i]);
-        C2 = XMLoadFloat4(&pTexDesc->pTexture[j * pTexDesc->uWidth + i2]);
-        C3 = XMLoadFloat4(&pTexDesc->pTexture[j2 * pTexDesc->uWidth + i]);
-        C4 = XMLoadFloat4(&pTexDesc->pTexture[j2 * pTexDesc->uWidth + i2]);
+                HRESULT hr = signalCallback(samples.data(), samples.size(), signalDimension, userData, signal.data());
+                if (FAILED(hr))
+                    return hr;
 
-        res = (C1 * (1.f - du) + C2 * du) * (1.f - dv) +
-            (C3 * (1.f - du) + C4 * du) * dv;
+                for (size_t i = dwFirst; i < dwLast; i++)
+                {
+                    const IMTSignalBatchFace& face = faces[i - dwBegin];
+                    size_t dwSubFaceEnd = (i + 1 < dwLast) ? faces[i + 1 - dwBegin].dwFirstSubFace : subFaceList.size();
+
+                    hr = IMTFromSplitFace(face.pos,
+                                          face.uv,
+                                          vertList.data(),
+                                          subFaceList.data() + face.dwFirstSubFace,
+                                          dwSubFaceEnd - face.dwFirstSubFace,
+                                          signal.data(),
+                                          signalDimension,
+                                          (FLOAT3*)(pIMTArray + 3*i));
+                    if ( FAILED(hr) )
+                    {
+                        DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
+                        return hr;
+                    }
+                }
 
-        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(pfSignalOut), res);
+                vertList.clear();
+                subFaceList.clear();
+                return S_OK;
+            };
 
-        return S_OK;
-    }
+            size_t dwFirst = dwBegin;
+            for (size_t i = dwBegin; i < dwEnd; i++)
+            {
+                IMTSignalBatchFace& face = faces[i - dwBegin];
+                for (size_t j = 0; j < 3; j++)
+                {
+                    uint32_t dwId;
+                    if (indexFormat == DXGI_FORMAT_R16_UINT)
+                    {
+                        dwId = pwIndexData[3*i + j];
+                    }
+                    else
+                    {
+                        dwId = pdwIndexData[3*i + j];
+                    }
 
-    HRESULT __cdecl IMTTextureCbWrapU(const XMFLOAT2 *uv,
-        size_t uPrimitiveId,
-        size_t uSignalDimension,
-        void *pUserData,
-        float *pfSignalOut)
-    {
-        UNREFERENCED_PARAMETER(uPrimitiveId);
-        UNREFERENCED_PARAMETER(uSignalDimension);
-
-        auto pTexDesc = reinterpret_cast<IMTTextureDesc*>(pUserData);
-
-        float u = fmodf(uv->x, 1.f);
-        float v = uv->y;
-
-        if (u < 0.f)
-            u += 1.f;
-
-        if (v < 0.f)
-            v = 0.f;
-        if (v > 1.f)
-            v = 1.f;
-
-        u = u * pTexDesc->uWidth;
-        v = v * pTexDesc->uHeight;
-
-        int i = (int) u;
-        int j = (int) v;
-        int i2 = i + 1;
-        int j2 = j + 1;
-
-        float du = u - i;
-        float dv = v - j;
-
-        i = i % pTexDesc->uWidth;
-        i2 = i2 % pTexDesc->uWidth;
-
-        if (i < 0)
-            i += int(pTexDesc->uWidth);
-        if (i2 < 0)
-            i2 += int(pTexDesc->uWidth);
-
-        j = std::max(0, std::min<int>(j, int(pTexDesc->uHeight) - 1));
-        j2 = std::max(0, std::min<int>(j2, int(pTexDesc->uHeight) - 1));
-
-        // 
-        // C1 ---- C2  ^          dv
-        //  | .    |   |           |
-        //  |      |   |           |
-        //  |      |   |           |
-        // C3 ---- C4  v, u --->   v
-        //
-
-        XMVECTOR C1, C2, C3, C4, res;
-        C1 = XMLoadFloat4(&pTexDesc->pTexture[j * pTexDesc->uWidth + i]);
-        C2 = XMLoadFloat4(&pTexDesc->pTexture[j * pTexDesc->uWidth + i2]);
-        C3 = XMLoadFloat4(&pTexDesc->pTexture[j2 * pTexDesc->uWidth + i]);
-        C4 = XMLoadFloat4(&pTexDesc->pTexture[j2 * pTexDesc->uWidth + i2]);
-
-        res = (C1 * (1.f - du) + C2 * du) * (1 - dv) +
-            (C3 * (1.f - du) + C4 * du) * dv;
-
-        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(pfSignalOut), res);
-
-        return S_OK;
-    }
-
-    HRESULT __cdecl IMTTextureCbWrapV(const XMFLOAT2 *uv,
-        size_t uPrimitiveId,
-        size_t uSignalDimension,
-        void *pUserData,
-        float *pfSignalOut)
-    {
-        UNREFERENCED_PARAMETER(uPrimitiveId);
-        UNREFERENCED_PARAMETER(uSignalDimension);
-
-        auto pTexDesc = reinterpret_cast<IMTTextureDesc*>(pUserData);
-
-        float u = uv->x;
-        float v = fmodf(uv->y, 1.f);
-
-        if (u < 0.f)
-            u = 0.f;
-        if (u > 1.f)
-            u = 1.f;
-
-        if (v < 0.f)
-            v += 1.f;
-
-        u = u * pTexDesc->uWidth;
-        v = v * pTexDesc->uHeight;
-
-        int i = (int) u;
-        int j = (int) v;
-        int i2 = i + 1;
-        int j2 = j + 1;
-
-        float du = u - i;
-        float dv = v - j;
-
-        i = std::max(0, std::min<int>(i, int(pTexDesc->uWidth) - 1));
-        i2 = std::max(0, std::min<int>(i2, int(pTexDesc->uWidth) - 1));
+                    if( dwId >= nVerts )
+                    {
+                        DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
+                        return E_FAIL;
+                    }
 
-        j = j % pTexDesc->uHeight;
-        j2 = j2 % pTexDesc->uHeight;
+                    face.pos[j] = positions[dwId];
+                    face.uv[j] = texcoords[dwId];
+                }
 
-        if (j < 0)
-            j += int(pTexDesc->uHeight);
-        if (j2 < 0)
-            j2 += int(pTexDesc->uHeight);
+                face.dwFirstVert = vertList.size();
+                face.dwFirstSubFace = subFaceList.size();
 
-        // 
-        // C1 ---- C2  ^          dv
-        //  | .    |   |           |
-        //  |      |   |           |
-        //  |      |   |           |
-        // C3 ---- C4  v, u --->   v
-        //
+                HRESULT hr = IMTSplitFace(face.pos, face.uv,
+                                          8, // max 64k subtesselations
+                                          maxUVDistance,
+                                          vertList,
+                                          subFaceList);
+                if ( FAILED(hr) )
+                {
+                    DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
+                    return hr;
+                }
 
-        XMVECTOR C1, C2, C3, C4, res;
-        C1 = XMLoadFloat4(&pTexDesc->pTexture[j * pTexDesc->uWidth + i]);
-        C2 = XMLoadFloat4(&pTexDesc->pTexture[j * pTexDesc->uWidth + i2]);
-        C3 = XMLoadFloat4(&pTexDesc->pTexture[j2 * pTexDesc->uWidth + i]);
-        C4 = XMLoadFloat4(&pTexDesc->pTexture[j2 * pTexDesc->uWidth + i2]);
+                if (vertList.size() >= IMT_SIGNAL_BATCH || i + 1 == dwEnd)
+                {
+                    hr = integrateBatch(dwFirst, i + 1);
+                    if (FAILED(hr))
+                        return hr;
 
-        res = (C1 * (1.f - du) + C2 * du) * (1.f - dv) +
-            (C3 * (1.f - du) + C4 * du) * dv;
+                    dwFirst = i + 1;
+                }
+            }
 
-        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(pfSignalOut), res);
+            return S_OK;
+        });
+}
 
-        return S_OK;
-    }
 
-    HRESULT __cdecl IMTTextureCbWrapUV(const XMFLOAT2 *uv,
-        size_t uPrimitiveId,
-        size_t uSignalDimension,
-        void *pUserData,
-        float *pfSignalOut)
+//-------------------------------------------------------------------------------------
+namespace
+{
+    // Compute IMT of each face from the signal of texture, once the inputs of
+    // UVAtlasComputeIMTFromTexture or UVAtlasComputeIMTFromPerTexelSignal are
+    // validated.
+    HRESULT ComputeIMTFromTextureDesc(
+        const XMFLOAT3* positions,
+        const XMFLOAT2* texcoords,
+        size_t nVerts,
+        const void* indices,
+        DXGI_FORMAT indexFormat,
+        size_t nFaces,
+        IMTTEXTUREDESC& texture,
+        size_t signalDimension,
+        DWORD options,
+        const std::function<HRESULT __cdecl(float percentComplete)>& statusCallBack,
+        float* pIMTArray)
     {
-        UNREFERENCED_PARAMETER(uPrimitiveId);
-        UNREFERENCED_PARAMETER(uSignalDimension);
-
-        auto pTexDesc = reinterpret_cast<IMTTextureDesc*>(pUserData);
-
-        float u = fmodf(uv->x, 1.f);
-        float v = fmodf(uv->y, 1.f);
-
-        if (u < 0.f)
-            u += 1.f;
-
-        if (v < 0.f)
-            v += 1.f;
-
-        u = u * pTexDesc->uWidth;
-        v = v * pTexDesc->uHeight;
-
-        int i = (int) u;
-        int j = (int) v;
-        int i2 = i + 1;
-        int j2 = j + 1;
-
-        float du = u - i;
-        float dv = v - j;
+        auto pdwIndexData = reinterpret_cast<const uint32_t*>( indices );
+        auto pwIndexData = reinterpret_cast<const uint16_t*>( indices );
 
-        i = i % pTexDesc->uWidth;
-        i2 = i2 % pTexDesc->uWidth;
+        texture.bWrapU = (options & UVATLAS_IMT_WRAP_U) != 0;
+        texture.bWrapV = (options & UVATLAS_IMT_WRAP_V) != 0;
+        texture.pSummedArea = nullptr;
 
-        if (i < 0)
-            i += int(pTexDesc->uWidth);
-        if (i2 < 0)
-            i2 += int(pTexDesc->uWidth);
-
-        j = j % pTexDesc->uHeight;
-        j2 = j2 % pTexDesc->uHeight;
+        std::unique_ptr<double[]> summedArea;
+        if (options & UVATLAS_IMT_SUMMED_AREA)
+        {
+            HRESULT hr = BuildSummedAreaTable(options, signalDimension, texture, summedArea);
+            if (FAILED(hr))
+            {
+                DPF(0, "UVAtlasComputeIMT: Summed-area table calculation failed.");
+                return hr;
+            }
+        }
 
-        if (j < 0)
-            j += int(pTexDesc->uHeight);
-        if (j2 < 0)
-            j2 += int(pTexDesc->uHeight);
+        size_t dwWorkerCount = GetIMTWorkerCount(options, nFaces);
 
-        // 
-        // C1 ---- C2  ^          dv
-        //  | .    |   |           |
-        //  |      |   |           |
-        //  |      |   |           |
-        // C3 ---- C4  v, u --->   v
-        //
+        return ComputeIMTPerFace(
+            nFaces,
+            dwWorkerCount,
+            statusCallBack,
+            [&](size_t, size_t i) -> HRESULT
+            {
+                XMFLOAT3 pos[3] = {};
+                XMFLOAT2 uv[3] = {};
+                for (size_t j = 0; j < 3; j++)
+                {
+                    uint32_t dwId;
+                    if (indexFormat == DXGI_FORMAT_R16_UINT)
+                    {
+                        dwId = pwIndexData[3*i + j];
+                    }
+                    else
+                    {
+                        dwId = pdwIndexData[3*i + j];
+                    }
 
-        XMVECTOR C1, C2, C3, C4, res;
-        C1 = XMLoadFloat4(&pTexDesc->pTexture[j * pTexDesc->uWidth + i]);
-        C2 = XMLoadFloat4(&pTexDesc->pTexture[j * pTexDesc->uWidth + i2]);
-        C3 = XMLoadFloat4(&pTexDesc->pTexture[j2 * pTexDesc->uWidth + i]);
-        C4 = XMLoadFloat4(&pTexDesc->pTexture[j2 * pTexDesc->uWidth + i2]);
+                    if( dwId >= nVerts )
+                    {
+                        DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
+                        return E_FAIL;
+                    }
 
-        res = (C1 * (1.f - du) + C2 * du) * (1.f - dv) +
-            (C3 * (1.f - du) + C4 * du) * dv;
+                    pos[j] = positions[dwId];
+                    uv[j] = texcoords[dwId];
+                }
 
-        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(pfSignalOut), res);
+                HRESULT hr = IMTFromTextureMapEx(pos,
+                                                 uv,
+                                                 signalDimension,
+                                                 texture,
+                                                 (FLOAT3*)(pIMTArray + 3*i));
+                if (FAILED(hr))
+                {
+                    DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
+                    return hr;
+                }
 
-        return S_OK;
+                return S_OK;
+            });
     }
 }
 
+
+//-------------------------------------------------------------------------------------
 _Use_decl_annotations_
 HRESULT __cdecl DirectX::UVAtlasComputeIMTFromTexture(
     const XMFLOAT3* positions,
@@ -1271,364 +1482,105 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromTexture(
     if ((uint64_t(nFaces) * 3) >= UINT32_MAX)
         return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
 
-    LPIMTSIGNALCALLBACK pSignalCallback = nullptr;
-    if ((options & UVATLAS_IMT_WRAP_UV) == UVATLAS_IMT_WRAP_UV)
-    {
-        pSignalCallback = IMTTextureCbWrapUV;
-    }
-    else if ( options & UVATLAS_IMT_WRAP_U )
-    {
-        pSignalCallback = IMTTextureCbWrapU;
-    }
-    else if( options & UVATLAS_IMT_WRAP_V )
-    {
-        pSignalCallback = IMTTextureCbWrapV;
-    }
-    else
-    {
-        pSignalCallback = IMTTextureCbWrapNone;
-    }
-
-    auto pdwIndexData = reinterpret_cast<const uint32_t*>( indices );
-    auto pwIndexData = reinterpret_cast<const uint16_t*>( indices );
+    IMTTEXTUREDESC TextureDesc;
+    TextureDesc.pTexels     = pTexture;
+    TextureDesc.uWidth      = width;
+    TextureDesc.uHeight     = height;
+    TextureDesc.uRowPitch   = width * 4 * sizeof(float);
+    TextureDesc.uTexelPitch = 4 * sizeof(float);
+    TextureDesc.format      = IMT_TEXEL_FLOAT;
 
-    IMTTextureDesc TextureDesc;
-    TextureDesc.pTexture = reinterpret_cast<const XMFLOAT4*>( pTexture );
-    TextureDesc.uWidth   = width;
-    TextureDesc.uHeight  = height;
-
-    float* pfIMTData = pIMTArray;
-
-    HRESULT hr;
-
-    for ( size_t i = 0; i < nFaces; i++)
-    {
-        if (statusCallBack && ((i % 64) == 0))
-        {
-            float fPct = i / (float) nFaces;
-            hr = statusCallBack(fPct);
-            if (FAILED(hr))
-                return E_ABORT;
-        }
-
-        XMFLOAT3 pos[3] = {};
-        XMFLOAT2 uv[3] = {};
-        for (size_t j = 0; j < 3; j++)
-        {
-            uint32_t dwId;
-            if (indexFormat == DXGI_FORMAT_R16_UINT)
-            {
-                dwId = pwIndexData[3*i + j];
-            }
-            else
-            {
-                dwId = pdwIndexData[3*i + j];
-            }
-
-            if( dwId >= nVerts )
-            {
-                DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
-                return E_FAIL;
-            }
-
-            pos[j] = positions[dwId];
-            uv[j] = texcoords[dwId];
-        }
-
-        hr = IMTFromTextureMapEx(pos,
-                                 uv,
-                                 i,
-                                 4, // dimension 4, rgba, can be zeroes if less than 4
-                                 pSignalCallback,
-                                 &TextureDesc,
-                                 (FLOAT3*)(pfIMTData + 3*i));
-        if (FAILED(hr))
-        {
-            DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
-            return hr;
-        }
-    }
-    
-    if (statusCallBack)
-    {
-        hr = statusCallBack(1.0f);
-        if (FAILED(hr))
-            return E_ABORT;
-    }
-
-    return S_OK;
+    return ComputeIMTFromTextureDesc(positions, texcoords, nVerts, indices, indexFormat, nFaces,
+        TextureDesc, 4 /* dimension 4, rgba, can be zeroes if less than 4 */, options, statusCallBack, pIMTArray);
 }
 
 
 //-------------------------------------------------------------------------------------
-namespace
+_Use_decl_annotations_
+HRESULT __cdecl DirectX::UVAtlasComputeIMTFromTexture(
+    const XMFLOAT3* positions,
+    const XMFLOAT2* texcoords,
+    size_t nVerts,
+    const void* indices,
+    DXGI_FORMAT indexFormat,
+    size_t nFaces,
+    const void* pTexels,
+    DXGI_FORMAT texelFormat,
+    size_t width,
+    size_t height,
+    size_t rowPitch,
+    DWORD options,
+    std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+    float* pIMTArray)
 {
-    struct IMTFloatArrayDesc
-    {
-        const float *pTexture;
-        size_t uHeight, uWidth, uStride;
-    };
-
-    HRESULT __cdecl IMTFloatArrayCbWrapNone(const XMFLOAT2 *uv,
-        size_t uPrimitiveId,
-        size_t uSignalDimension,
-        void *pUserData,
-        float *pfSignalOut)
-    {
-        UNREFERENCED_PARAMETER(uPrimitiveId);
-
-        auto pTexDesc = reinterpret_cast<IMTFloatArrayDesc*>( pUserData );
-
-        float u = uv->x;
-        float v = uv->y;
-
-        if (u < 0.f)
-            u = 0.f;
-        if (u > 1.f)
-            u = 1.f;
-
-        if (v < 0.f)
-            v = 0.f;
-        if (v > 1.f)
-            v = 1.f;
-
-        u = u * pTexDesc->uWidth;
-        v = v * pTexDesc->uHeight;
-
-        int i = (int) u;
-        int j = (int) v;
-        int i2 = i + 1;
-        int j2 = j + 1;
-
-        float du = u - i;
-        float dv = v - j;
-
-        i = std::max(0, std::min<int>(i, int(pTexDesc->uWidth) - 1));
-        i2 = std::max(0, std::min<int>(i2, int(pTexDesc->uWidth) - 1));
-        j = std::max(0, std::min<int>(j, int(pTexDesc->uHeight) - 1));
-        j2 = std::max(0, std::min<int>(j2, int(pTexDesc->uHeight) - 1));
-
-        // 
-        // C1 ---- C2  ^          dv
-        //  | .    |   |           |
-        //  |      |   |           |
-        //  |      |   |           |
-        // C3 ---- C4  v, u --->   v
-        //
-
-        const float *C1 = &pTexDesc->pTexture[(j * pTexDesc->uWidth + i) * pTexDesc->uStride];
-        const float *C2 = &pTexDesc->pTexture[(j * pTexDesc->uWidth + i2) * pTexDesc->uStride];
-        const float *C3 = &pTexDesc->pTexture[(j2 * pTexDesc->uWidth + i) * pTexDesc->uStride];
-        const float *C4 = &pTexDesc->pTexture[(j2 * pTexDesc->uWidth + i2) * pTexDesc->uStride];
+    if (!positions || !texcoords || !nVerts || !indices || !nFaces || !pTexels || !pIMTArray)
+        return E_INVALIDARG;
 
-        for (size_t k = 0; k < uSignalDimension; k++)
-        {
-            pfSignalOut[k] = (C1[k] * (1.f - du) + C2[k] * du) * (1.f - dv) +
-                (C3[k] * (1.f - du) + C4[k] * du) * dv;
-        }
+    if (!width || !height)
+        return E_INVALIDARG;
 
-        return S_OK;
-    }
+    if ((width > UINT32_MAX) || (height > UINT32_MAX))
+        return E_INVALIDARG;
 
-    HRESULT __cdecl IMTFloatArrayCbWrapU(const XMFLOAT2 *uv,
-        size_t uPrimitiveId,
-        size_t uSignalDimension,
-        void *pUserData,
-        float *pfSignalOut)
+    switch (indexFormat)
     {
-        UNREFERENCED_PARAMETER(uPrimitiveId);
-
-        auto pTexDesc = reinterpret_cast<IMTFloatArrayDesc*>(pUserData);
-
-        float u = fmodf(uv->x, 1.f);
-        float v = uv->y;
-
-        if (u < 0.f)
-            u += 1.f;
-
-        if (v < 0.f)
-            v = 0.f;
-        if (v > 1.f)
-            v = 1.f;
-
-        u = u * pTexDesc->uWidth;
-        v = v * pTexDesc->uHeight;
-
-        int i = (int) u;
-        int j = (int) v;
-        int i2 = i + 1;
-        int j2 = j + 1;
-
-        float du = u - i;
-        float dv = v - j;
-
-        i = i % pTexDesc->uWidth;
-        i2 = i2 % pTexDesc->uWidth;
-
-        if (i < 0)
-            i += int(pTexDesc->uWidth);
-        if (i2 < 0)
-            i2 += int(pTexDesc->uWidth);
-
-        j = std::max(0, std::min<int>(j, int(pTexDesc->uHeight) - 1));
-        j2 = std::max(0, std::min<int>(j2, int(pTexDesc->uHeight) - 1));
-
-        // 
-        // C1 ---- C2  ^          dv
-        //  | .    |   |           |
-        //  |      |   |           |
-        //  |      |   |           |
-        // C3 ---- C4  v, u --->   v
-        //
-
-        const float *C1 = &pTexDesc->pTexture[(j * pTexDesc->uWidth + i) * pTexDesc->uStride];
-        const float *C2 = &pTexDesc->pTexture[(j * pTexDesc->uWidth + i2) * pTexDesc->uStride];
-        const float *C3 = &pTexDesc->pTexture[(j2 * pTexDesc->uWidth + i) * pTexDesc->uStride];
-        const float *C4 = &pTexDesc->pTexture[(j2 * pTexDesc->uWidth + i2) * pTexDesc->uStride];
+    case DXGI_FORMAT_R16_UINT:
+        if (nVerts >= UINT16_MAX)
+            return E_INVALIDARG;
+        break;
 
-        for (size_t k = 0; k < uSignalDimension; k++)
-        {
-            pfSignalOut[k] = (C1[k] * (1.f - du) + C2[k] * du) * (1.f - dv) +
-                (C3[k] * (1.f - du) + C4[k] * du) * dv;
-        }
+    case DXGI_FORMAT_R32_UINT:
+        if (nVerts >= UINT32_MAX)
+            return E_INVALIDARG;
+        break;
 
-        return S_OK;
+    default:
+        return E_INVALIDARG;
     }
 
-    HRESULT __cdecl IMTFloatArrayCbWrapV(const XMFLOAT2 *uv,
-        size_t uPrimitiveId,
-        size_t uSignalDimension,
-        void *pUserData,
-        float *pfSignalOut)
-    {
-        UNREFERENCED_PARAMETER(uPrimitiveId);
-
-        auto pTexDesc = reinterpret_cast<IMTFloatArrayDesc*>(pUserData);
-
-        float u = uv->x;
-        float v = fmodf(uv->y, 1.f);
-
-        if (u < 0.f)
-            u = 0.f;
-        if (u > 1.f)
-            u = 1.f;
-
-        if (v < 0.f)
-            v += 1.f;
-
-        u = u * pTexDesc->uWidth;
-        v = v * pTexDesc->uHeight;
-
-        int i = (int) u;
-        int j = (int) v;
-        int i2 = i + 1;
-        int j2 = j + 1;
-
-        float du = u - i;
-        float dv = v - j;
-
-        i = std::max(0, std::min<int>(i, int(pTexDesc->uWidth) - 1));
-        i2 = std::max(0, std::min<int>(i2, int(pTexDesc->uWidth) - 1));
-
-        j = j % pTexDesc->uHeight;
-        j2 = j2 % pTexDesc->uHeight;
-
-        if (j < 0)
-            j += int(pTexDesc->uHeight);
-        if (j2 < 0)
-            j2 += int(pTexDesc->uHeight);
-
-        // 
-        // C1 ---- C2  ^          dv
-        //  | .    |   |           |
-        //  |      |   |           |
-        //  |      |   |           |
-        // C3 ---- C4  v, u --->   v
-        //
-
-        const float *C1 = &pTexDesc->pTexture[(j * pTexDesc->uWidth + i) * pTexDesc->uStride];
-        const float *C2 = &pTexDesc->pTexture[(j * pTexDesc->uWidth + i2) * pTexDesc->uStride];
-        const float *C3 = &pTexDesc->pTexture[(j2 * pTexDesc->uWidth + i) * pTexDesc->uStride];
-        const float *C4 = &pTexDesc->pTexture[(j2 * pTexDesc->uWidth + i2) * pTexDesc->uStride];
+    if ((uint64_t(nFaces) * 3) >= UINT32_MAX)
+        return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
 
-        for (size_t k = 0; k < uSignalDimension; k++)
-        {
-            pfSignalOut[k] = (C1[k] * (1.f - du) + C2[k] * du) * (1.f - dv) +
-                (C3[k] * (1.f - du) + C4[k] * du) * dv;
-        }
+    IMTTEXTUREDESC TextureDesc;
+    size_t channelSize;
+    size_t signalDimension;
+    switch (texelFormat)
+    {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:    TextureDesc.format = IMT_TEXEL_FLOAT;  channelSize = 4; signalDimension = 4; break;
+    case DXGI_FORMAT_R32G32B32_FLOAT:       TextureDesc.format = IMT_TEXEL_FLOAT;  channelSize = 4; signalDimension = 3; break;
+    case DXGI_FORMAT_R32G32_FLOAT:          TextureDesc.format = IMT_TEXEL_FLOAT;  channelSize = 4; signalDimension = 2; break;
+    case DXGI_FORMAT_R32_FLOAT:             TextureDesc.format = IMT_TEXEL_FLOAT;  channelSize = 4; signalDimension = 1; break;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:    TextureDesc.format = IMT_TEXEL_HALF;   channelSize = 2; signalDimension = 4; break;
+    case DXGI_FORMAT_R16G16_FLOAT:          TextureDesc.format = IMT_TEXEL_HALF;   channelSize = 2; signalDimension = 2; break;
+    case DXGI_FORMAT_R16_FLOAT:             TextureDesc.format = IMT_TEXEL_HALF;   channelSize = 2; signalDimension = 1; break;
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:        TextureDesc.format = IMT_TEXEL_UNORM8; channelSize = 1; signalDimension = 4; break;
+    case DXGI_FORMAT_R8G8_UNORM:            TextureDesc.format = IMT_TEXEL_UNORM8; channelSize = 1; signalDimension = 2; break;
+    case DXGI_FORMAT_R8_UNORM:              TextureDesc.format = IMT_TEXEL_UNORM8; channelSize = 1; signalDimension = 1; break;
 
-        return S_OK;
+    default:
+        DPF(0, "UVAtlasComputeIMT: texel format is not supported");
+        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
     }
 
-    HRESULT __cdecl IMTFloatArrayCbWrapUV(const XMFLOAT2 *uv,
-        size_t uPrimitiveId,
-        size_t uSignalDimension,
-        void *pUserData,
-        float *pfSignalOut)
+    if (rowPitch < width * signalDimension * channelSize)
     {
-        UNREFERENCED_PARAMETER(uPrimitiveId);
-
-        auto pTexDesc = reinterpret_cast<IMTFloatArrayDesc*>( pUserData );
-
-        float u = fmodf(uv->x, 1.f);
-        float v = fmodf(uv->y, 1.f);
-
-        if (u < 0.f)
-            u += 1.f;
-
-        if (v < 0.f)
-            v += 1.f;
-
-        u = u * pTexDesc->uWidth;
-        v = v * pTexDesc->uHeight;
-
-        int i = (int) u;
-        int j = (int) v;
-        int i2 = i + 1;
-        int j2 = j + 1;
-
-        float du = u - i;
-        float dv = v - j;
-
-        i = i % pTexDesc->uWidth;
-        i2 = i2 % pTexDesc->uWidth;
-
-        if (i < 0)
-            i += int(pTexDesc->uWidth);
-        if (i2 < 0)
-            i2 += int(pTexDesc->uWidth);
-
-        j = j % pTexDesc->uHeight;
-        j2 = j2 % pTexDesc->uHeight;
-
-        if (j < 0)
-            j += int(pTexDesc->uHeight);
-        if (j2 < 0)
-            j2 += int(pTexDesc->uHeight);
-
-        // 
-        // C1 ---- C2  ^          dv
-        //  | .    |   |           |
-        //  |      |   |           |
-        //  |      |   |           |
-        // C3 ---- C4  v, u --->   v
-        //
+        DPF(0, "UVAtlasComputeIMT: row pitch is smaller than a row of texels");
+        return E_INVALIDARG;
+    }
 
-        const float *C1 = &pTexDesc->pTexture[(j * pTexDesc->uWidth + i) * pTexDesc->uStride];
-        const float *C2 = &pTexDesc->pTexture[(j * pTexDesc->uWidth + i2) * pTexDesc->uStride];
-        const float *C3 = &pTexDesc->pTexture[(j2 * pTexDesc->uWidth + i) * pTexDesc->uStride];
-        const float *C4 = &pTexDesc->pTexture[(j2 * pTexDesc->uWidth + i2) * pTexDesc->uStride];
+    TextureDesc.pTexels     = pTexels;
+    TextureDesc.uWidth      = width;
+    TextureDesc.uHeight     = height;
+    TextureDesc.uRowPitch   = rowPitch;
+    TextureDesc.uTexelPitch = signalDimension * channelSize;
 
-        for (size_t k = 0; k < uSignalDimension; k++)
-        {
-            pfSignalOut[k] = (C1[k] * (1.f - du) + C2[k] * du) * (1.f - dv) +
-                (C3[k] * (1.f - du) + C4[k] * du) * dv;
-        }
-
-        return S_OK;
-    }
+    return ComputeIMTFromTextureDesc(positions, texcoords, nVerts, indices, indexFormat, nFaces,
+        TextureDesc, signalDimension, options, statusCallBack, pIMTArray);
 }
 
+
+//-------------------------------------------------------------------------------------
 _Use_decl_annotations_
 HRESULT __cdecl DirectX::UVAtlasComputeIMTFromPerTexelSignal(
     const XMFLOAT3* positions,
@@ -1680,95 +1632,16 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromPerTexelSignal(
         return E_INVALIDARG;
     }
 
-    const float *pTextureData = pTexelSignal;
-
-    LPIMTSIGNALCALLBACK pSignalCallback = nullptr;
-    if ((options & UVATLAS_IMT_WRAP_UV) == UVATLAS_IMT_WRAP_UV)
-    {
-        pSignalCallback = IMTFloatArrayCbWrapUV;
-    }
-    else if( options & UVATLAS_IMT_WRAP_U )
-    {
-        pSignalCallback = IMTFloatArrayCbWrapU;
-    }
-    else if( options & UVATLAS_IMT_WRAP_V )
-    {
-        pSignalCallback = IMTFloatArrayCbWrapV;
-    }
-    else
-    {
-        pSignalCallback = IMTFloatArrayCbWrapNone;
-    }
-
-    auto pdwIndexData = reinterpret_cast<const uint32_t*>( indices );
-    auto pwIndexData = reinterpret_cast<const uint16_t*>( indices );
+    IMTTEXTUREDESC FloatArrayDesc;
+    FloatArrayDesc.pTexels     = pTexelSignal;
+    FloatArrayDesc.uWidth      = width;
+    FloatArrayDesc.uHeight     = height;
+    FloatArrayDesc.uRowPitch   = width * nComponents * sizeof(float);
+    FloatArrayDesc.uTexelPitch = nComponents * sizeof(float);
+    FloatArrayDesc.format      = IMT_TEXEL_FLOAT;
 
-    IMTFloatArrayDesc FloatArrayDesc;
-    FloatArrayDesc.pTexture = pTextureData;
-    FloatArrayDesc.uWidth   = width;
-    FloatArrayDesc.uHeight  = height;
-    FloatArrayDesc.uStride  = nComponents;
-
-    float* pfIMTData = pIMTArray;
-
-    HRESULT hr;
-
-    for (size_t i = 0; i < nFaces; i++)
-    {
-        if (statusCallBack && ((i % 64) == 0))
-        {
-            float fPct = i / (float) nFaces;
-            hr = statusCallBack(fPct);
-            if (FAILED(hr))
-                return E_ABORT;
-        }
-
-        XMFLOAT3 pos[3] = {};
-        XMFLOAT2 uv[3] = {};
-        for (size_t j = 0; j < 3; j++)
-        {
-            uint32_t dwId;
-            if (indexFormat == DXGI_FORMAT_R16_UINT)
-            {
-                dwId = pwIndexData[3*i + j];
-            }
-            else
-            {
-                dwId = pdwIndexData[3*i + j];
-            }
-
-            if( dwId >= nVerts )
-            {
-                DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
-                return E_FAIL;
-            }
-
-            pos[j] = positions[dwId];
-            uv[j] = texcoords[dwId];
-        }
-
-        hr = IMTFromTextureMapEx(pos,
-                                 uv,
-                                 i,
-                                 signalDimension,
-                                 pSignalCallback,
-                                 &FloatArrayDesc,
-                                 (FLOAT3*)(pfIMTData + 3*i));
-        if (FAILED(hr))
-        {
-            DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
-            return hr;
-        }
-    }
-    
-    if (statusCallBack)
-    {
-        hr = statusCallBack(1.0f);
-        if (FAILED(hr))
-            return E_ABORT;
-    }
-
-    return S_OK;
+    return ComputeIMTFromTextureDesc(positions, texcoords, nVerts, indices, indexFormat, nFaces,
+        FloatArrayDesc, signalDimension, options, statusCallBack, pIMTArray);
 }
 
 
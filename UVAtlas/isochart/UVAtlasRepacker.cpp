@@ -10,12 +10,62 @@
 #include "pch.h"
 
 #include "UVAtlasRepacker.h"
+#include "isochartstats.hpp"
 #include "UVAtlas.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 using namespace DirectX;
 using namespace Isochart;
 using namespace IsochartRepacker;
 
+namespace
+{
+    // Index of the lowest set bit, v must not be 0
+    inline int LowestSetBit(uint64_t v)
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long index;
+        _BitScanForward64(&index, v);
+        return static_cast<int>(index);
+#elif defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanForward(&index, static_cast<unsigned long>(v)))
+            return static_cast<int>(index);
+        _BitScanForward(&index, static_cast<unsigned long>(v >> 32));
+        return static_cast<int>(index) + 32;
+#else
+        return __builtin_ctzll(v);
+#endif
+    }
+
+    // Index of the highest set bit, v must not be 0
+    inline int HighestSetBit(uint64_t v)
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long index;
+        _BitScanReverse64(&index, v);
+        return static_cast<int>(index);
+#elif defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanReverse(&index, static_cast<unsigned long>(v >> 32)))
+            return static_cast<int>(index) + 32;
+        _BitScanReverse(&index, static_cast<unsigned long>(v));
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(v);
+#endif
+    }
+
+    // Mask of the bits below count, 0 < count <= 64
+    inline uint64_t LowBitsMask(int count)
+    {
+        return (count >= 64) ? ~uint64_t(0) : ((uint64_t(1) << count) - 1);
+    }
+}
+
 _Use_decl_annotations_
 HRESULT WINAPI IsochartRepacker::isochartpack2(std::vector<UVAtlasVertex>* pvVertexArray,
                              size_t VertexCount, 
@@ -28,16 +78,20 @@ HRESULT WINAPI IsochartRepacker::isochartpack2(std::vector<UVAtlasVertex>* pvVer
                              unsigned int Stage,
                              LPISOCHARTCALLBACK pCallback, 
                              float Frequency, 
-                             size_t iNumRotate)
+                             size_t iNumRotate,
+                             CIsochartStats* pStats)
 {
     HRESULT hr = S_OK ;
     
     if (Width < 1 || Height < 1 || Gutter < 1 || iNumRotate <= 0)
         return E_INVALIDARG;
 
+    CIsochartStageTimer timer(pStats, ISOCHART_STAGE_PACK);
+
+    size_t dwIterationTimes = 0;
     CUVAtlasRepacker repacker(pvVertexArray, VertexCount, pvIndexFaceArray, 
         FaceCount, pdwAdjacency, iNumRotate, Width, Height, Gutter,
-        nullptr, nullptr, nullptr, nullptr, nullptr);
+        nullptr, nullptr, nullptr, nullptr, &dwIterationTimes);
 
     if ( !repacker.SetCallback( pCallback, Frequency ) )
         return E_INVALIDARG ;
@@ -51,6 +105,8 @@ HRESULT WINAPI IsochartRepacker::isochartpack2(std::vector<UVAtlasVertex>* pvVer
     if ( FAILED(hr = repacker.Repack()) )
         return hr ;
 
+    AddIsochartStatsCount(pStats, ISOCHART_COUNTER_PACK_RESTARTS, dwIterationTimes - 1);
+
     return S_OK;
 }
 
@@ -476,8 +532,7 @@ HRESULT CUVAtlasRepacker::PrepareRepack()
     CleanUp();
 
     // initialize UVAtlas space
-    for (size_t i = 0; i < m_PreparedAtlasHeight; i++)
-        memset((void*)&(m_UVBoard[i][0]), 0, sizeof(uint8_t) * m_PreparedAtlasWidth);
+    m_UVBoard.Clear();
 
     // find the index of the longest chart
     uint32_t index = m_SortedChartIndex[0];
@@ -498,14 +553,9 @@ HRESULT CUVAtlasRepacker::PrepareRepack()
     // needed to resize the array when the changing chart
     try
     {
-        m_currChartUVBoard.resize(size);
-        m_triedUVBoard.resize(size);
-
-        for (size_t j = 0; j < m_currChartUVBoard.size(); j++)
-        {
-            m_currChartUVBoard[j].resize(size);
-            m_triedUVBoard[j].resize(size);
-        }
+        m_currChartUVBoard.Resize(size, size);
+        m_currChartEdgeBoard.Resize(size, size);
+        m_triedUVBoard.Resize(size, size);
 
         for (size_t i = 0; i < 4; i++)
         {
@@ -523,15 +573,13 @@ HRESULT CUVAtlasRepacker::PrepareRepack()
 
     // compute the aspect ratio and chart range after put on the first chart
     m_currAspectRatio = (float)numY / (float)numX;
-    m_fromY = (int)m_UVBoard.size() / 2 - numY / 2;
+    m_fromY = (int)m_PreparedAtlasHeight / 2 - numY / 2;
     m_toY = m_fromY + numY;
-    m_fromX = (int)m_UVBoard[0].size() / 2 - numX / 2;
+    m_fromX = (int)m_PreparedAtlasWidth / 2 - numX / 2;
     m_toX = m_fromX + numX;
 
     // put the longest chart into the atlas first
-    for (int i =  m_fromY; i < m_toY; i++)
-        for (int j =  m_fromX; j < m_toX; j++)
-            m_UVBoard[i][j] = m_currChartUVBoard[i - m_fromY][j - m_fromX];
+    m_UVBoard.OrRotatedRect(m_currChartUVBoard, numX, numY, 0, m_fromX, m_fromY);
 
     // save the first chart's transform matrix
     XMStoreFloat4x4(&m_ResultMatrix[index], XMMatrixTranslation(
@@ -540,7 +588,7 @@ HRESULT CUVAtlasRepacker::PrepareRepack()
         0.0f));
 
     // prepare the space information of UV atlas
-    PrepareSpaceInfo(m_SpaceInfo, m_UVBoard, m_fromX, m_toX, m_fromY, m_toY, false);
+    PrepareSpaceInfo(m_SpaceInfo, m_UVBoard, m_fromX, m_toX, m_fromY, m_toY);
 
     return S_OK ;
 }
@@ -679,11 +727,7 @@ HRESULT CUVAtlasRepacker::Initialize()
         m_PreparedAtlasHeight = INITIAL_SIZE_FACTOR * m_dwAtlasHeight + 2 * m_iGutter;
 
         // initial UVAtlas space
-        m_UVBoard.resize(m_PreparedAtlasHeight);
-        for (size_t i = 0; i < m_PreparedAtlasHeight; i++)
-        {
-            m_UVBoard[i].resize(m_PreparedAtlasWidth);
-        }
+        m_UVBoard.Resize(m_PreparedAtlasWidth, m_PreparedAtlasHeight);
     }
     catch (std::bad_alloc&)
     {
@@ -1216,49 +1260,65 @@ void CUVAtlasRepacker::SortCharts()
         [in]		fromX, toX, fromY, toY
                                 -	the top left corner and bottom right 
                                     corner of uv board.
-        [in]		bNeglectGrows	-	whether to count the edges growed 
-                                    by program
     Return Value:	
 \***************************************************************************/
 void CUVAtlasRepacker::PrepareSpaceInfo(SpaceInfo &spaceInfo, 
-                                        UVBoard &board, int fromX, 
-                                        int toX, int fromY, int toY, 
-                                        bool bNeglectGrows)
+                                        const UVBoard &board, int fromX, 
+                                        int toX, int fromY, int toY)
 {
-    // top
-    for (int i = fromX; i < toX; i++)
-    {
-        int j = fromY;
-        if (bNeglectGrows) while(j < toY && board[j++][i] != 1);
-        else while(j < toY && board[j++][i] == 0);
-        spaceInfo[UV_UPSIDE][i] = j - fromY - 1;
-    }
+    ScanSideSpace(spaceInfo, board, UV_UPSIDE, fromX, toX, fromY, toY);
+    ScanSideSpace(spaceInfo, board, UV_DOWNSIDE, fromX, toX, fromY, toY);
+    ScanSideSpace(spaceInfo, board, UV_LEFTSIDE, fromY, toY, fromX, toX);
+    ScanSideSpace(spaceInfo, board, UV_RIGHTSIDE, fromY, toY, fromX, toX);
+}
 
-    // bottom
-    for (int i = fromX; i < toX; i++)
-    {
-        int j = toY;
-        if (bNeglectGrows) while(j > fromY && board[--j][i] != 1);
-        else while(j > fromY && board[--j][i] == 0);
-        spaceInfo[UV_DOWNSIDE][i] = toY - j - 1;
-    }	
-
-    // left
-    for (int i = fromY; i < toY; i++)
-    {
-        int j = fromX;
-        if (bNeglectGrows) while(j < toX && board[i][j++] != 1);
-        else while(j < toX && board[i][j++] == 0);
-        spaceInfo[UV_LEFTSIDE][i] = j - fromX - 1;
-    }	
-
-    // right
-    for (int i = fromY; i < toY; i++)
+/***************************************************************************\
+    Function Description:
+        Compute the distance between the set texels and one side of a 
+        range of uv board.
+    
+    Arguments:
+        [in/out]	spaceInfo	-	array into which the result will be 
+                                    saved.
+        [in]		board		-	uv board to be scanned.
+        [in]		side		-	the side from which the distance is 
+                                    measured.
+        [in]		from, to	-	the columns (for up and down side) or
+                                    rows (for left and right side) whose 
+                                    distance will be updated.
+        [in]		scanFrom, scanTo
+                                -	the rows (for up and down side) or
+                                    columns (for left and right side) 
+                                    to be scanned.
+    Return Value:	
+\***************************************************************************/
+void CUVAtlasRepacker::ScanSideSpace(SpaceInfo &spaceInfo, 
+                                     const UVBoard &board, int side, 
+                                     int from, int to, 
+                                     int scanFrom, int scanTo)
+{
+    auto& space = spaceInfo[side];
+
+    switch (side)
     {
-        int j = toX;
-        if (bNeglectGrows) while(j > fromX && board[i][--j] != 1);
-        else while(j > fromX && board[i][--j] == 0);
-        spaceInfo[UV_RIGHTSIDE][i] = toX - j - 1;
+    case UV_UPSIDE:
+        board.FindInColumns(from, to, scanFrom, scanTo, false, space.data());
+        for (int i = from; i < to; i++)
+            space[i] -= scanFrom;
+        break;
+    case UV_DOWNSIDE:
+        board.FindInColumns(from, to, scanFrom, scanTo, true, space.data());
+        for (int i = from; i < to; i++)
+            space[i] = scanTo - space[i] - 1;
+        break;
+    case UV_LEFTSIDE:
+        for (int i = from; i < to; i++)
+            space[i] = board.FindInRow(i, scanFrom, scanTo, false) - scanFrom;
+        break;
+    case UV_RIGHTSIDE:
+        for (int i = from; i < to; i++)
+            space[i] = scanTo - board.FindInRow(i, scanFrom, scanTo, true) - 1;
+        break;
     }
 }
 
@@ -1301,8 +1361,8 @@ void CUVAtlasRepacker::PutChart(uint32_t index)
         // then try to put it into the atlas after rotate 0, 90, 180, 270 degrees
         _PositionInfo *pPosInfo = (_PositionInfo*)&(pCInfo->PosInfo[i]);
         DoTessellation(index, i);
-        PrepareSpaceInfo(m_currSpaceInfo, m_currChartUVBoard, 
-            0, pPosInfo->numX, 0, pPosInfo->numY, true);
+        PrepareSpaceInfo(m_currSpaceInfo, m_currChartEdgeBoard, 
+            0, pPosInfo->numX, 0, pPosInfo->numY);
 
         m_currRotate = i;
 
@@ -1379,9 +1439,8 @@ void CUVAtlasRepacker::PutChart(uint32_t index)
 
         // save the best chart position at present
         if (m_triedRotate == i) {
-            for (int j = 0; j < pPosInfo->numY; j++)
-                for (int k = 0; k < pPosInfo->numX; k++)
-                    m_triedUVBoard[j][k] = m_currChartUVBoard[j][k];
+            m_triedUVBoard.CopyRect(m_currChartUVBoard, 
+                pPosInfo->numX, pPosInfo->numY);
         }
     }
 
@@ -1587,45 +1646,28 @@ void CUVAtlasRepacker::PutChartInPosition(uint32_t index)
         pPosInfo->angle);
 
     m_currAspectRatio = m_triedAspectRatio;
+    m_UVBoard.OrRotatedRect(m_triedUVBoard, pPosInfo->numX, pPosInfo->numY,
+        m_triedPutRotation, m_chartFromX, m_chartFromY);
+
     XMMATRIX transMatrix = XMMatrixIdentity();;
     switch (m_triedPutRotation)
     {
     case 0:
-        for (int i = m_chartFromY; i < m_chartToY; i++)
-            for (int j = m_chartFromX; j < m_chartToX; j++)
-                if (m_UVBoard[i][j] != 1 && m_triedUVBoard[i - m_chartFromY][j - m_chartFromX])
-                    m_UVBoard[i][j] = 
-                        m_triedUVBoard[i - m_chartFromY][j - m_chartFromX];
         transMatrix = XMMatrixTranslation(
             m_PixelWidth * m_chartFromX - pPosInfo->basePoint.x,
             m_PixelWidth * m_chartFromY - pPosInfo->basePoint.y, 0.0f);
         break;
     case 90:
-        for (int i = m_chartFromY; i < m_chartToY; i++)
-            for (int j = m_chartFromX; j < m_chartToX; j++)
-                if (m_UVBoard[i][j] != 1 && m_triedUVBoard[m_chartToX - j - 1][i - m_chartFromY])
-                    m_UVBoard[i][j] = 
-                        m_triedUVBoard[m_chartToX - j - 1][i - m_chartFromY];
         transMatrix = XMMatrixTranslation(
             m_PixelWidth * m_chartToX - pPosInfo->basePoint.x,
             m_PixelWidth * m_chartFromY - pPosInfo->basePoint.y, 0.0f);
         break;
     case 180:
-        for (int i = m_chartFromY; i < m_chartToY; i++)
-            for (int j = m_chartFromX; j < m_chartToX; j++)
-                if (m_UVBoard[i][j] != 1 && m_triedUVBoard[m_chartToY - i - 1][m_chartToX - j - 1])
-                    m_UVBoard[i][j] = 
-                        m_triedUVBoard[m_chartToY - i - 1][m_chartToX - j - 1];
         transMatrix = XMMatrixTranslation(
             m_PixelWidth * m_chartToX - pPosInfo->basePoint.x,
             m_PixelWidth * m_chartToY - pPosInfo->basePoint.y, 0.0f);
         break;
     case 270:
-        for (int i = m_chartFromY; i < m_chartToY; i++)
-            for (int j = m_chartFromX; j < m_chartToX; j++)
-                if (m_UVBoard[i][j] != 1 && m_triedUVBoard[j - m_chartFromX][m_chartToY - i - 1])
-                    m_UVBoard[i][j] = 
-                        m_triedUVBoard[j - m_chartFromX][m_chartToY - i - 1];
         transMatrix = XMMatrixTranslation(
             m_PixelWidth * m_chartFromX - pPosInfo->basePoint.x,
             m_PixelWidth * m_chartToY - pPosInfo->basePoint.y, 0.0f);
@@ -1662,21 +1704,9 @@ void CUVAtlasRepacker::UpdateSpaceInfo(int direction)
             for (int i = m_chartToX; i < m_toX; i++)
                 m_SpaceInfo[UV_UPSIDE][i] += m_fromY - m_chartFromY;
         }
-        for (int i = m_chartFromX; i < m_chartToX; i++)
-        {
-            int j = minY;
-            while (j < maxY && m_UVBoard[j++][i] == 0);
-            m_SpaceInfo[UV_UPSIDE][i] = j - minY - 1;
-        }
-        for (int i = m_chartFromY; i < m_chartToY; i++)
-        {
-            int j = minX;
-            while (j < maxX && m_UVBoard[i][j++] == 0);
-            m_SpaceInfo[UV_LEFTSIDE][i] = j - minX - 1;
-            j = maxX;
-            while (j > minX && m_UVBoard[i][--j] == 0);
-            m_SpaceInfo[UV_RIGHTSIDE][i] = maxX - j - 1;
-        }
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_UPSIDE, m_chartFromX, m_chartToX, minY, maxY);
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_LEFTSIDE, m_chartFromY, m_chartToY, minX, maxX);
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_RIGHTSIDE, m_chartFromY, m_chartToY, minX, maxX);
         break;
     case UV_DOWNSIDE:
         if (m_toY < m_chartToY) {
@@ -1685,21 +1715,9 @@ void CUVAtlasRepacker::UpdateSpaceInfo(int direction)
             for (int i = m_chartToX; i < m_toX; i++) 
                 m_SpaceInfo[UV_DOWNSIDE][i] += m_chartToY - m_toY;
         }
-        for (int i = m_chartFromX; i < m_chartToX; i++)
-        {
-            int j = maxY;
-            while (j > minY && m_UVBoard[--j][i] == 0);
-            m_SpaceInfo[UV_DOWNSIDE][i] = maxY - j - 1;
-        }
-        for (int i = m_chartFromY; i < m_chartToY; i++)
-        {
-            int j = minX;
-            while (j < maxX && m_UVBoard[i][j++] == 0);
-            m_SpaceInfo[UV_LEFTSIDE][i] = j - minX - 1;
-            j = maxX;
-            while (j > minX && m_UVBoard[i][--j] == 0);
-            m_SpaceInfo[UV_RIGHTSIDE][i] = maxX - j - 1;
-        }		
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_DOWNSIDE, m_chartFromX, m_chartToX, minY, maxY);
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_LEFTSIDE, m_chartFromY, m_chartToY, minX, maxX);
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_RIGHTSIDE, m_chartFromY, m_chartToY, minX, maxX);
         break;
     case UV_LEFTSIDE:
         if (m_chartFromX < m_fromX) {
@@ -1708,21 +1726,9 @@ void CUVAtlasRepacker::UpdateSpaceInfo(int direction)
             for (int i = m_chartToY; i < m_toY; i++)
                 m_SpaceInfo[UV_LEFTSIDE][i] += m_fromX - m_chartFromX;
         }
-        for (int i = m_chartFromY; i < m_chartToY; i++)
-        {
-            int j = minX;
-            while (j < maxX && m_UVBoard[i][j++] == 0);
-            m_SpaceInfo[UV_LEFTSIDE][i] = j - minX - 1;
-        }
-        for (int i = m_chartFromX; i < m_chartToX; i++)
-        {
-            int j = minY;
-            while (j < maxY && m_UVBoard[j++][i] == 0);
-            m_SpaceInfo[UV_UPSIDE][i] = j - minY - 1;
-            j = maxY;
-            while (j > minY && m_UVBoard[--j][i] == 0);
-            m_SpaceInfo[UV_DOWNSIDE][i] = maxY - j - 1;
-        }	
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_LEFTSIDE, m_chartFromY, m_chartToY, minX, maxX);
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_UPSIDE, m_chartFromX, m_chartToX, minY, maxY);
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_DOWNSIDE, m_chartFromX, m_chartToX, minY, maxY);
         break;
     case UV_RIGHTSIDE:
         if (m_chartToX > m_toX) {
@@ -1731,21 +1737,9 @@ void CUVAtlasRepacker::UpdateSpaceInfo(int direction)
             for (int i = m_chartToY; i < m_toY; i++)
                 m_SpaceInfo[UV_RIGHTSIDE][i] += m_chartToX - m_toX;
         }
-        for (int i = m_chartFromY; i < m_chartToY; i++)
-        {
-            int j = maxX;
-            while (j > minX && m_UVBoard[i][--j] == 0);
-            m_SpaceInfo[UV_RIGHTSIDE][i] = maxX - j - 1;
-        }
-        for (int i = m_chartFromX; i < m_chartToX; i++)
-        {
-            int j = minY;
-            while (j < maxY && m_UVBoard[j++][i] == 0);
-            m_SpaceInfo[UV_UPSIDE][i] = j - minY - 1;
-            j = maxY;
-            while (j > minY && m_UVBoard[--j][i] == 0);
-            m_SpaceInfo[UV_DOWNSIDE][i] = maxY - j - 1;
-        }	
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_RIGHTSIDE, m_chartFromY, m_chartToY, minX, maxX);
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_UPSIDE, m_chartFromX, m_chartToX, minY, maxY);
+        ScanSideSpace(m_SpaceInfo, m_UVBoard, UV_DOWNSIDE, m_chartFromX, m_chartToX, minY, maxY);
         break;
     }
 
@@ -1920,9 +1914,15 @@ bool CUVAtlasRepacker::DoTessellation(uint32_t ChartIndex, size_t AngleIndex)
     XMStoreFloat2(&minP, XMLoadFloat2(&pPosInfo->minPoint) - XMLoadFloat2(&pPosInfo->adjustLen));
 
     // initialize the current chart atlas
-    for (int i = 0; i < numY; i++)
-        for (int j = 0; j < numX; j++) 
-            m_currChartUVBoard[i][j] = 0;
+    m_currChartUVBoard.ClearRect(numX, numY);
+    m_currChartEdgeBoard.ClearRect(numX, numY);
+
+    // texels out of the chart range are never used
+    auto setEdge = [&](int m, int n)
+    {
+        if (m >= 0 && m < numY && n >= 0 && n < numX)
+            m_currChartEdgeBoard.Set(n, m);
+    };
 
     // do tessellation by test the intersection of chart edges and the grids
     int numgrid = 0;
@@ -1944,7 +1944,7 @@ bool CUVAtlasRepacker::DoTessellation(uint32_t ChartIndex, size_t AngleIndex)
         int m, n;
         if (toX - fromX <= 1 && toY - fromY <= 1)
         {
-            m_currChartUVBoard[fromY + m_iGutter][fromX + m_iGutter] = 1;
+            setEdge(fromY + m_iGutter, fromX + m_iGutter);
             numgrid++;
             continue;
         }
@@ -1953,8 +1953,8 @@ bool CUVAtlasRepacker::DoTessellation(uint32_t ChartIndex, size_t AngleIndex)
             n = (int) floorf((p1->x - minP.x) / m_PixelWidth);
             for (m = fromY + 1; m < toY; m++)
             {
-                m_currChartUVBoard[m + m_iGutter][n + m_iGutter] = 1;
-                m_currChartUVBoard[m + m_iGutter - 1][n + m_iGutter] = 1;
+                setEdge(m + m_iGutter, n + m_iGutter);
+                setEdge(m + m_iGutter - 1, n + m_iGutter);
                 numgrid += 2;
             }
             continue;
@@ -1964,8 +1964,8 @@ bool CUVAtlasRepacker::DoTessellation(uint32_t ChartIndex, size_t AngleIndex)
             m = (int) floorf((p1->y - minP.y) / m_PixelWidth);
             for (n = fromX + 1; n < toX; n++)
             {
-                m_currChartUVBoard[m + m_iGutter][n + m_iGutter] = 1;
-                m_currChartUVBoard[m + m_iGutter][n + m_iGutter - 1] = 1;
+                setEdge(m + m_iGutter, n + m_iGutter);
+                setEdge(m + m_iGutter, n + m_iGutter - 1);
                 numgrid += 2;
             }
             continue;		
@@ -1983,8 +1983,8 @@ bool CUVAtlasRepacker::DoTessellation(uint32_t ChartIndex, size_t AngleIndex)
                 y = slope * x + b;
                 m = (int) floorf((y - minP.y) / m_PixelWidth);
 
-                m_currChartUVBoard[m + m_iGutter][n + m_iGutter] = 1;
-                m_currChartUVBoard[m + m_iGutter][n + m_iGutter - 1] = 1;
+                setEdge(m + m_iGutter, n + m_iGutter);
+                setEdge(m + m_iGutter, n + m_iGutter - 1);
                 numgrid += 2;
             }
         }
@@ -1997,8 +1997,8 @@ bool CUVAtlasRepacker::DoTessellation(uint32_t ChartIndex, size_t AngleIndex)
 
                 n = (int) floorf((x - minP.x) / m_PixelWidth);
 
-                m_currChartUVBoard[m + m_iGutter][n + m_iGutter] = 1;
-                m_currChartUVBoard[m + m_iGutter - 1][n + m_iGutter] = 1;
+                setEdge(m + m_iGutter, n + m_iGutter);
+                setEdge(m + m_iGutter - 1, n + m_iGutter);
                 numgrid += 2;
             }
         }
@@ -2029,32 +2029,271 @@ bool CUVAtlasRepacker::DoTessellation(uint32_t ChartIndex, size_t AngleIndex)
 \***************************************************************************/
 void CUVAtlasRepacker::GrowChart(uint32_t chartindex, size_t angleindex, int layer)
 {
-    size_t numY = m_ChartsInfo[chartindex].PosInfo[angleindex].numY;
-    size_t numX = m_ChartsInfo[chartindex].PosInfo[angleindex].numX;
-    for (int i = 0; i < layer; i++)
+    int numY = m_ChartsInfo[chartindex].PosInfo[angleindex].numY;
+    int numX = m_ChartsInfo[chartindex].PosInfo[angleindex].numX;
+
+    m_currChartUVBoard.CopyRect(m_currChartEdgeBoard, numX, numY);
+    m_currChartUVBoard.Grow(numX, numY, layer);
+}
+
+/***************************************************************************\
+    Function Description:
+        Resize the board.
+    
+    Arguments:
+        [in]	width, height	-	Texels of the board in X and Y direction.
+
+    Return Value:	
+\***************************************************************************/
+void UVBoard::Resize(size_t width, size_t height)
+{
+    if (width == m_dwWidth && height == m_dwHeight)
+        return;
+
+    size_t pitch = (width + 63) / 64;
+    m_bits.resize(pitch * height);
+
+    m_dwWidth = width;
+    m_dwHeight = height;
+    m_dwPitch = pitch;
+}
+
+void UVBoard::Clear()
+{
+    std::fill(m_bits.begin(), m_bits.end(), uint64_t(0));
+}
+
+void UVBoard::ClearRect(int width, int height)
+{
+    if (width <= 0)
+        return;
+
+    size_t words = size_t(width + 63) / 64;
+    for (int y = 0; y < height; y++)
+        memset(Row(y), 0, words * sizeof(uint64_t));
+}
+
+void UVBoard::CopyRect(const UVBoard& src, int width, int height)
+{
+    if (width <= 0)
+        return;
+
+    size_t words = size_t(width + 63) / 64;
+    for (int y = 0; y < height; y++)
+        memcpy(Row(y), src.Row(y), words * sizeof(uint64_t));
+}
+
+/***************************************************************************\
+    Function Description:
+        Put the texels of a rotated source board into the board.
+    
+    Arguments:
+        [in]	src				-	The source board.
+        [in]	width, height	-	The range [0, width) x [0, height) of 
+                                    source board to be put.
+        [in]	rotation		-	Degrees the source range is rotated,
+                                    0, 90, 180 or 270.
+        [in]	toX, toY		-	Top left corner of the rotated range
+                                    in the board.
+
+    Return Value:	
+\***************************************************************************/
+void UVBoard::OrRotatedRect(const UVBoard& src, int width, int height,
+                            int rotation, int toX, int toY)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    int words = (width + 63) / 64;
+    uint64_t lastMask = LowBitsMask(width - (words - 1) * 64);
+
+    // Not rotated, shift whole words of source row into place.
+    if (rotation == 0)
     {
-        for (size_t m = 0; m < numY; m++)
+        int shift = toX & 63;
+        for (int y = 0; y < height; y++)
         {
-            for (size_t n = 0; n < numX; n++)
+            const uint64_t* pSrc = src.Row(y);
+            uint64_t* pDest = Row(toY + y) + (toX >> 6);
+            uint64_t carry = 0;
+            for (int w = 0; w < words; w++)
             {
-                if (m_currChartUVBoard[m][n] == i + 1)
+                uint64_t bits = (w == words - 1) ? (pSrc[w] & lastMask) : pSrc[w];
+                if (shift == 0)
                 {
-                    for (int j = -1; j < 2; j++)
-                    {
-                        if ( (ptrdiff_t(m)+j) < 0 || (m+j) >= m_currChartUVBoard.size() )
-                            continue;
+                    pDest[w] |= bits;
+                }
+                else
+                {
+                    pDest[w] |= (bits << shift) | carry;
+                    carry = bits >> (64 - shift);
+                }
+            }
+            if (carry)
+                pDest[words] |= carry;
+        }
+        return;
+    }
 
-                        for (int k = -1; k < 2; k++)
-                        {
-                            if ( (ptrdiff_t(n)+k) < 0 || (n+k) >= m_currChartUVBoard[m+j].size() )
-                                continue;
+    // Rotated, visit the set texels of source. (x, y) in source goes to
+    //	90:		(toX + height - 1 - y, toY + x)
+    //	180:	(toX + width - 1 - x, toY + height - 1 - y)
+    //	270:	(toX + y, toY + width - 1 - x)
+    for (int y = 0; y < height; y++)
+    {
+        const uint64_t* pSrc = src.Row(y);
+        for (int w = 0; w < words; w++)
+        {
+            uint64_t bits = (w == words - 1) ? (pSrc[w] & lastMask) : pSrc[w];
+            while (bits)
+            {
+                int x = w * 64 + LowestSetBit(bits);
+                bits &= bits - 1;
 
-                            if (m_currChartUVBoard[m+j][n+k] == 0)
-                                m_currChartUVBoard[m+j][n+k] = static_cast<uint8_t>( i + 2 );
-                        }
-                    }
+                switch (rotation)
+                {
+                case 90:
+                    Set(toX + height - 1 - y, toY + x);
+                    break;
+                case 180:
+                    Set(toX + width - 1 - x, toY + height - 1 - y);
+                    break;
+                case 270:
+                    Set(toX + y, toY + width - 1 - x);
+                    break;
                 }
             }
         }
     }
 }
+
+/***************************************************************************\
+    Function Description:
+        Grow the set texels by some layers. Each layer adds the 8 neighbours
+        of the set texels, the same as growing from the texels added by 
+        previous layer.
+    
+    Arguments:
+        [in]	width, height	-	The range [0, width) x [0, height) to
+                                    be grown.
+        [in]	layer			-	Layers to grow.
+
+    Return Value:	
+\***************************************************************************/
+void UVBoard::Grow(int width, int height, int layer)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    int words = (width + 63) / 64;
+    uint64_t lastMask = LowBitsMask(width - (words - 1) * 64);
+
+    for (int i = 0; i < layer; i++)
+    {
+        // 1. Grow left and right, carrying bits across words.
+        for (int y = 0; y < height; y++)
+        {
+            uint64_t* pRow = Row(y);
+            uint64_t prev = 0;
+            for (int w = 0; w < words; w++)
+            {
+                uint64_t curr = pRow[w];
+                uint64_t next = (w + 1 < words) ? pRow[w + 1] : 0;
+                pRow[w] = curr | (curr << 1) | (prev >> 63) | 
+                    (curr >> 1) | (next << 63);
+                prev = curr;
+            }
+            pRow[words - 1] &= lastMask;
+        }
+
+        // 2. Grow up and down. Visit rows against the direction of growing,
+        // so each row is merged with the neighbour before it is changed.
+        for (int y = height - 1; y > 0; y--)
+        {
+            uint64_t* pRow = Row(y);
+            const uint64_t* pPrev = Row(y - 1);
+            for (int w = 0; w < words; w++)
+                pRow[w] |= pPrev[w];
+        }
+        for (int y = 0; y + 1 < height; y++)
+        {
+            uint64_t* pRow = Row(y);
+            const uint64_t* pNext = Row(y + 1);
+            for (int w = 0; w < words; w++)
+                pRow[w] |= pNext[w];
+        }
+    }
+}
+
+int UVBoard::FindInRow(int y, int fromX, int toX, bool bReverse) const
+{
+    if (fromX >= toX)
+        return bReverse ? fromX : toX - 1;
+
+    const uint64_t* pRow = Row(y);
+    int first = fromX >> 6;
+    int last = (toX - 1) >> 6;
+    uint64_t firstMask = ~uint64_t(0) << (fromX & 63);
+    uint64_t lastMask = LowBitsMask(((toX - 1) & 63) + 1);
+
+    if (!bReverse)
+    {
+        for (int w = first; w <= last; w++)
+        {
+            uint64_t bits = pRow[w];
+            if (w == first) bits &= firstMask;
+            if (w == last) bits &= lastMask;
+            if (bits)
+                return w * 64 + LowestSetBit(bits);
+        }
+        return toX - 1;
+    }
+
+    for (int w = last; w >= first; w--)
+    {
+        uint64_t bits = pRow[w];
+        if (w == first) bits &= firstMask;
+        if (w == last) bits &= lastMask;
+        if (bits)
+            return w * 64 + HighestSetBit(bits);
+    }
+    return fromX;
+}
+
+void UVBoard::FindInColumns(int fromX, int toX, int fromY, int toY,
+                            bool bReverse, int* pRows) const
+{
+    if (fromX >= toX)
+        return;
+
+    int first = fromX >> 6;
+    int last = (toX - 1) >> 6;
+    int lastRow = bReverse ? fromY : toY - 1;
+
+    // Scan 64 columns together, until each of them finds a texel.
+    for (int w = first; w <= last; w++)
+    {
+        uint64_t pending = ~uint64_t(0);
+        if (w == first) pending &= ~uint64_t(0) << (fromX & 63);
+        if (w == last) pending &= LowBitsMask(((toX - 1) & 63) + 1);
+
+        int step = bReverse ? -1 : 1;
+        for (int y = bReverse ? toY - 1 : fromY; 
+            pending && y >= fromY && y < toY; y += step)
+        {
+            uint64_t hits = Row(y)[w] & pending;
+            pending &= ~hits;
+            while (hits)
+            {
+                pRows[w * 64 + LowestSetBit(hits)] = y;
+                hits &= hits - 1;
+            }
+        }
+
+        while (pending)
+        {
+            pRows[w * 64 + LowestSetBit(pending)] = lastRow;
+            pending &= pending - 1;
+        }
+    }
+}
@@ -75,8 +75,58 @@ struct ChartsInfo {
     ChartsInfo() : maxLength(0.0), valid(false), area(0.0) {} ;    
 };
 
-// 2-dimension matrix to describe the UV atlas
-typedef std::vector<std::vector<uint8_t> > UVBoard;
+// 2-dimension bit matrix to describe the UV atlas, one bit per texel.
+// Rows are packed into 64-bit words, so that searches, copies and growing
+// handle 64 texels at a time.
+class UVBoard
+{
+public:
+    UVBoard() : m_dwWidth(0), m_dwHeight(0), m_dwPitch(0) {}
+
+    // Contents are undefined after resizing.
+    void Resize(size_t width, size_t height);
+    void Clear();
+
+    // Clear the texels of [0, width) x [0, height)
+    void ClearRect(int width, int height);
+
+    void Set(int x, int y)
+    {
+        m_bits[y * m_dwPitch + (x >> 6)] |= uint64_t(1) << (x & 63);
+    }
+
+    // Copy [0, width) x [0, height) of source board.
+    void CopyRect(const UVBoard& src, int width, int height);
+
+    // Set texels of the rectangle whose top left corner is (toX, toY) where
+    // [0, width) x [0, height) of source board, rotated by 0, 90, 180 or 270
+    // degrees, has texels set.
+    void OrRotatedRect(const UVBoard& src, int width, int height,
+        int rotation, int toX, int toY);
+
+    // Grow the set texels of [0, width) x [0, height) by layer texels in
+    // all 8 directions. Texels out of the rectangle are not grown.
+    void Grow(int width, int height, int layer);
+
+    // Column of the first (or last if bReverse) set texel of row y in
+    // [fromX, toX). If there is none, returns the last column scanned.
+    int FindInRow(int y, int fromX, int toX, bool bReverse) const;
+
+    // For each column x in [fromX, toX), pRows[x] is the row of the first
+    // (or last if bReverse) set texel in [fromY, toY). If there is none,
+    // pRows[x] is the last row scanned.
+    void FindInColumns(int fromX, int toX, int fromY, int toY,
+        bool bReverse, int* pRows) const;
+
+private:
+    uint64_t* Row(int y) { return &m_bits[y * m_dwPitch]; }
+    const uint64_t* Row(int y) const { return &m_bits[y * m_dwPitch]; }
+
+    std::vector<uint64_t> m_bits;
+    size_t m_dwWidth;
+    size_t m_dwHeight;
+    size_t m_dwPitch;           // words per row
+};
 
 // distance between chart edges and its corresponding bounding box edges
 typedef std::vector<int> SpaceInfo[4];
@@ -122,6 +172,8 @@ struct UVATLASATTRIBUTERANGE
                                     the	chart into atlas. The default value 
                                     is 5 which means the chart rotates one
                                     time every 90 / 5 degrees.
+        [in]	pStats			-	Optional statistics to add the packing
+                                    time and restarts to.
 
     Return Value:
         If the function succeeds, the return value is S_OK; otherwise, 
@@ -139,7 +191,8 @@ HRESULT WINAPI isochartpack2(_In_                       std::vector<DirectX::UVA
                              _In_                       unsigned int Stage,
                              _In_opt_                   Isochart::LPISOCHARTCALLBACK pCallback = nullptr, 
                              _In_                       float Frequency = 0.01f, 
-                             _In_                       size_t iNumRotate = 5);
+                             _In_                       size_t iNumRotate = 5,
+                             _In_opt_                   Isochart::CIsochartStats* pStats = nullptr);
 
 class CUVAtlasRepacker
 {
@@ -192,8 +245,10 @@ private:
     void Normalize();
     void GrowChart(uint32_t chartindex, size_t angleindex, int layer);
     void CleanUp();
-    void PrepareSpaceInfo(SpaceInfo &spaceInfo, UVBoard &board, int fromX, 
-        int toX, int fromY, int toY, bool bNeglectGrows);
+    void PrepareSpaceInfo(SpaceInfo &spaceInfo, const UVBoard &board, int fromX, 
+        int toX, int fromY, int toY);
+    void ScanSideSpace(SpaceInfo &spaceInfo, const UVBoard &board, int side,
+        int from, int to, int scanFrom, int scanTo);
     HRESULT Initialize();
     void ComputeBoundingBox(std::vector<DirectX::XMFLOAT2>& Vec, DirectX::XMFLOAT2* minV, DirectX::XMFLOAT2* maxV);
     void ComputeFinalAtlasRect();
@@ -288,6 +343,7 @@ private:
 
     UVBoard						m_UVBoard;                  // the main UV board in which we want to pack charts
     UVBoard						m_currChartUVBoard;         // current chart UV board
+    UVBoard						m_currChartEdgeBoard;       // current chart edges, without gutter
 
     std::vector<DirectX::UVAtlasVertex> m_VertexBuffer;
     std::vector<uint32_t>               m_IndexBuffer;
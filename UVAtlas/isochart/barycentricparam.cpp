@@ -171,67 +171,58 @@ HRESULT CIsochartMesh::InitializeBarycentricEquation(
 {
     HRESULT hr = S_OK;
 
-    CSparseMatrix<double> orgA;
-    CVector<double> orgBU, orgBV;
+    std::vector<CSparseMatrix<double>::Triplet> triplets;
 
     // 1. Allocate memory
-    size_t dwOrgADim = m_dwVertNumber - boundTable.size()/2;
+    size_t dwADim = m_dwVertNumber - boundTable.size()/2;
 
     try
     {
-        orgA.resize(dwOrgADim, dwOrgADim);
-        orgBU.resize(dwOrgADim);
-        orgBV.resize(dwOrgADim);
-    }
-    catch (std::bad_alloc&)
-    {
-        return E_OUTOFMEMORY;
-    }
-
-    // 2. Fill the linear equation
-    for (size_t ii=0; ii<m_dwVertNumber; ii++)
-    {
-        if (m_pVerts[ii].bIsBoundary)
-        {
-            continue;
-        }
-    
-        auto& adjacent = m_pVerts[ii].vertAdjacent;
-        double bu = 0, bv = 0;
-
-        orgA.setItem(vertMap[ii], vertMap[ii], double(adjacent.size()));
-        for (size_t jj=0; jj<adjacent.size(); jj++)
+        BU.resize(dwADim);
+        BV.resize(dwADim);
+        triplets.reserve(dwADim + 2*m_dwEdgeNumber);
+
+        // 2. Fill the linear equation. The coefficient matrix is the graph
+        // Laplacian of internal vertices, which is symmetric positive definite,
+        // so it is solved directly instead of the normal equation A^T*A, whose
+        // condition number is squared.
+        for (size_t ii=0; ii<m_dwVertNumber; ii++)
         {
-            uint32_t dwAdj = adjacent[jj];
-            
-            if (m_pVerts[dwAdj].bIsBoundary)
+            if (m_pVerts[ii].bIsBoundary)
             {
-                bu += boundTable[vertMap[dwAdj]*2];
-                bv += boundTable[vertMap[dwAdj]*2+1];
+                continue;
             }
-            else
+        
+            auto& adjacent = m_pVerts[ii].vertAdjacent;
+            double bu = 0, bv = 0;
+
+            triplets.push_back(CSparseMatrix<double>::Triplet(
+                vertMap[ii], vertMap[ii], double(adjacent.size())));
+            for (size_t jj=0; jj<adjacent.size(); jj++)
             {
-                orgA.setItem(vertMap[ii], vertMap[dwAdj], double(-1));	
+                uint32_t dwAdj = adjacent[jj];
+                
+                if (m_pVerts[dwAdj].bIsBoundary)
+                {
+                    bu += boundTable[vertMap[dwAdj]*2];
+                    bv += boundTable[vertMap[dwAdj]*2+1];
+                }
+                else
+                {
+                    triplets.push_back(CSparseMatrix<double>::Triplet(
+                        vertMap[ii], vertMap[dwAdj], double(-1)));
+                }
             }
+            BU[vertMap[ii]] = bu;
+            BV[vertMap[ii]] = bv;
         }
-        orgBU[vertMap[ii]] = bu;
-        orgBV[vertMap[ii]] = bv;
-    }
-
-    // 3. get Symmetric matrix
-    // A' = A^T * A
-    if (!CSparseMatrix<double>::Mat_Trans_MUL_Mat(A, orgA))
-    {
-        return E_OUTOFMEMORY;
     }
-
-    // B' = A^T * b
-    if (!CSparseMatrix<double>::Mat_Trans_Mul_Vec(BU, orgA, orgBU))
+    catch (std::bad_alloc&)
     {
         return E_OUTOFMEMORY;
     }
 
-    if (!CSparseMatrix<double>::Mat_Trans_Mul_Vec(BV, orgA, orgBV))
+    if (!A.build(dwADim, dwADim, triplets))
     {
         return E_OUTOFMEMORY;
     }
@@ -279,6 +270,9 @@ HRESULT CIsochartMesh::BarycentricParameterization(
     size_t dwInternalCount = 0;
     std::vector<double> boundTable;
     CSparseMatrix<double> A;
+    CConjugateGradientSolver<double> solver;
+    CSparseCholeskySolver<double> directSolver;
+    bool bUseDirectSolver = false;
     CVector<double> BU;
     CVector<double> BV;	
     CVector<double> U;
@@ -314,35 +308,77 @@ HRESULT CIsochartMesh::BarycentricParameterization(
             boundTable,
             vertMap));
 
-    // 4. Solve the linear equation set
-    FAILURE_GOTO_END(
-        (false != CSparseMatrix<double>::ConjugateGradient(
-            U,
-            A,
-            BU,
-            BC_MAX_ITERATION,
-            static_cast<double>(1e-8),
-            nIterCount) ? S_OK : E_FAIL));
-    if (nIterCount >= BC_MAX_ITERATION)
+    // 4. Solve the linear equation set. For large system, factorize it once and
+    // use the factor for both U and V. If factorization fails, fall back to
+    // conjugate gradient.
+    switch (m_IsochartEngine.m_dwOptions & _OPTIONMASK_ISOCHART_SOLVER)
     {
-        goto LEnd;
+    case _OPTION_ISOCHART_SOLVER_DIRECT:
+        bUseDirectSolver = true;
+        break;
+    case _OPTION_ISOCHART_SOLVER_ITERATIVE:
+        bUseDirectSolver = false;
+        break;
+    default:
+        bUseDirectSolver = 
+            (dwInternalCount >= BARYCENTRIC_DIRECT_SOLVER_MIN_DIMENSION);
+        break;
     }
 
-    nIterCount = 0;
-    FAILURE_GOTO_END(
-        (false != CSparseMatrix<double>::ConjugateGradient(
-            V,
-            A,
-            BV,
-            BC_MAX_ITERATION,
-            static_cast<double>(1e-8),
-            nIterCount) ? S_OK : E_FAIL));
-    if (nIterCount >= BC_MAX_ITERATION)
+    if (bUseDirectSolver)
     {
-        goto LEnd;
+        if (directSolver.Init(A))
+        {
+            if (!directSolver.Solve(U, BU) || !directSolver.Solve(V, BV))
+            {
+                hr = E_OUTOFMEMORY;
+                goto LEnd;
+            }
+        }
+        else
+        {
+            DPF(1, "Sparse Cholesky factorization failed, use conjugate gradient");
+            bUseDirectSolver = false;
+        }
+    }
+
+    if (!bUseDirectSolver)
+    {
+        if (!solver.Init(A))
+        {
+            hr = E_OUTOFMEMORY;
+            goto LEnd;
+        }
+
+        FAILURE_GOTO_END(
+            (false != solver.Solve(
+                U,
+                BU,
+                BC_MAX_ITERATION,
+                static_cast<double>(1e-8),
+                nIterCount) ? S_OK : E_FAIL));
+        AddIsochartStatsCount(m_baseInfo.pStats, ISOCHART_COUNTER_CG_ITERATIONS, nIterCount);
+        if (nIterCount >= BC_MAX_ITERATION)
+        {
+            goto LEnd;
+        }
+
+        nIterCount = 0;
+        FAILURE_GOTO_END(
+            (false != solver.Solve(
+                V,
+                BV,
+                BC_MAX_ITERATION,
+                static_cast<double>(1e-8),
+                nIterCount) ? S_OK : E_FAIL));
+        AddIsochartStatsCount(m_baseInfo.pStats, ISOCHART_COUNTER_CG_ITERATIONS, nIterCount);
+        if (nIterCount >= BC_MAX_ITERATION)
+        {
+            goto LEnd;
+        }
     }
 
-    // 4. Assign UV coordinates
+    // 5. Assign UV coordinates
     FAILURE_GOTO_END(
         AssignBarycentricResult(
             U, 
@@ -350,7 +386,7 @@ HRESULT CIsochartMesh::BarycentricParameterization(
             boundTable, 
             vertMap));
 
-    // 5. Check Results
+    // 6. Check Results
     FAILURE_GOTO_END(
         CheckLinearEquationParamResult(
             bIsOverLap));
@@ -40,7 +40,9 @@ CBaseMeshInfo::CBaseMeshInfo():
     fExpectMinAvgL2SquaredStretch(FACE_MIN_L2_STRETCH),
     fRatioOfSigToGeo(0),
     bIsFaceAdjacenctArrayReady(false),
-    pdwSplitHint(nullptr)
+    pdwSplitHint(nullptr),
+    pStats(nullptr),
+    deadline(std::chrono::steady_clock::time_point::max())
 {
 }
 
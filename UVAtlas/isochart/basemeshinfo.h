@@ -77,6 +77,17 @@ public:
     bool bIsFaceAdjacenctArrayReady;
 
     const uint32_t* pdwSplitHint;	// specified by user, all the edges can be splitted has the corresponding adjacency -1
+
+    CIsochartStats* pStats;		// Optional statistics collected while partitioning, may be nullptr
+
+    // Charts are no longer split or merged after the deadline, max() for no limit
+    std::chrono::steady_clock::time_point deadline;
+
+    bool IsDeadlinePassed() const
+    {
+        return deadline != std::chrono::steady_clock::time_point::max()
+            && std::chrono::steady_clock::now() >= deadline;
+    }
 private:
     HRESULT CopyAndScaleInputVertices();
 
@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <mutex>
+#include <thread>
 #include "isochart.h"
 
 namespace Isochart
@@ -50,6 +52,14 @@ namespace Isochart
 //	2.1 InitCallbackAdapt(100, 0.65f, 0.35); // Init task C.
 //  2.2 UpdateCallbackAdapt(1)...UpdateCallbackAdapt(1)... // Perform task C 
 //  2.3 FinishWorkAdapt() //Finish task C
+//
+// Threading:
+//	Update and check methods may be called from worker threads. The caller's
+//	callback is only invoked on the thread which called SetCallback or
+//	InitCallBackAdapt. A report requested by a worker thread is deferred to
+//	the next update or check on that thread. Once the callback returns a
+//	failure code, all later updates or checks on any thread return it, so
+//	workers can abort.
 
 class CCallbackSchemer
 {
@@ -57,7 +67,9 @@ public:
     CCallbackSchemer():
         m_pCallback(nullptr),
         m_dwTotalStage(0),
-        m_dwDoneStage(0)
+        m_dwDoneStage(0),
+        m_bPendingReport(false),
+        m_hrCallback(S_OK)
         {}		
 
     void SetCallback(
@@ -85,6 +97,10 @@ public:
     float PercentInAllStage();
 
 private:
+    HRESULT FireCallback(
+        std::unique_lock<std::mutex>& lock,
+        bool bFire,
+        float fPercent);
     
     LPISOCHARTCALLBACK m_pCallback; // Callback function
     float m_fCallbackFrequence;// The frequency to call callback function.
@@ -110,6 +126,11 @@ private:
 
     float m_fPercentOfAllTasks;
 
+    std::mutex m_lock;  // Protect progress when updated by worker threads.
+    std::thread::id m_callbackThread; // The only thread to call m_pCallback
+    bool m_bPendingReport; // A worker thread requested a report.
+    HRESULT m_hrCallback; // Keep the failure code returned by m_pCallback
+
 };
 
 inline void CCallbackSchemer::SetCallback(
@@ -118,6 +139,7 @@ inline void CCallbackSchemer::SetCallback(
 {
     m_pCallback = pCallback;
     m_fCallbackFrequence = Frequency;
+    m_callbackThread = std::this_thread::get_id();
 }
 
 inline void CCallbackSchemer::SetStage(
@@ -144,6 +166,11 @@ inline void CCallbackSchemer::InitCallBackAdapt(
         return;
     }
 
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_callbackThread = std::this_thread::get_id();
+    m_bPendingReport = false;
+    m_hrCallback = S_OK;
+
     // dwTaskWork steps in current sub-task
     m_dwTotalWork = dwTaskWork;
     m_dwWorkDone = 0;
@@ -183,9 +210,10 @@ inline HRESULT CCallbackSchemer::UpdateCallbackDirectly(float fPercent)
     if (fPercent > 1.0f) fPercent = 1.0f;
     if (fPercent < 0.0f) fPercent = 0.0f;
 
+    std::unique_lock<std::mutex> lock(m_lock);
     float fRealPercent = m_fBase+m_fPercentOfAllTasks*fPercent;
     fRealPercent = (m_dwDoneStage * 1.0f)/ m_dwTotalStage + fRealPercent/ m_dwTotalStage;
-    return m_pCallback(fRealPercent);
+    return FireCallback(lock, true, fRealPercent);
 }
 
 inline HRESULT CCallbackSchemer::UpdateCallbackAdapt(size_t dwDone)
@@ -194,7 +222,8 @@ inline HRESULT CCallbackSchemer::UpdateCallbackAdapt(size_t dwDone)
     {
         return S_OK;
     }
-    
+
+    std::unique_lock<std::mutex> lock(m_lock);
     bool bFire = false;
 
     // Has reached to wait point, not update current progress, but still check 
@@ -235,12 +264,7 @@ inline HRESULT CCallbackSchemer::UpdateCallbackAdapt(size_t dwDone)
             }
         }
     }
-    if (bFire)
-    {
-        return m_pCallback(PercentInAllStage());
-    }
-
-    return S_OK;
+    return FireCallback(lock, bFire, PercentInAllStage());
 }
 
 
@@ -252,7 +276,8 @@ inline HRESULT CCallbackSchemer::CheckPointAdapt()
     }
 
     // Not update progress, only check if caller want to abort.
-    return m_pCallback(PercentInAllStage());
+    std::unique_lock<std::mutex> lock(m_lock);
+    return FireCallback(lock, true, PercentInAllStage());
 }
 
 inline HRESULT CCallbackSchemer::FinishWorkAdapt()
@@ -262,9 +287,44 @@ inline HRESULT CCallbackSchemer::FinishWorkAdapt()
         return S_OK;
     }
 
+    std::unique_lock<std::mutex> lock(m_lock);
     m_dwWorkDone = m_dwTotalWork; // Indicate current sub-task has finished.
-    return m_pCallback(
-        PercentInAllStage());		
+    return FireCallback(lock, true, PercentInAllStage());
+}
+
+// Call m_pCallback if required and allowed on current thread. lock must hold
+// m_lock, it's released before calling m_pCallback so that workers are not
+// blocked by the caller's callback.
+inline HRESULT CCallbackSchemer::FireCallback(
+    std::unique_lock<std::mutex>& lock,
+    bool bFire,
+    float fPercent)
+{
+    if (FAILED(m_hrCallback))
+    {
+        return m_hrCallback;
+    }
+
+    if (std::this_thread::get_id() != m_callbackThread)
+    {
+        m_bPendingReport = m_bPendingReport || bFire;
+        return S_OK;
+    }
+
+    if (!bFire && !m_bPendingReport)
+    {
+        return S_OK;
+    }
+    m_bPendingReport = false;
+
+    lock.unlock();
+    HRESULT hr = m_pCallback(fPercent);
+    if (FAILED(hr))
+    {
+        lock.lock();
+        m_hrCallback = hr;
+    }
+    return hr;
 }
 
 }
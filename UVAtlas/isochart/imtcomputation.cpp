@@ -19,12 +19,6 @@ using namespace DirectX;
 
 namespace
 {
-    struct SUBFACE
-    {
-        uint32_t dwVertIdx[3];
-        uint32_t dwDepth;
-    };
-
     static bool IsInZeroRangeDouble(double a)
     {
         return a < 1e-12 && a > -1e-12;
@@ -359,50 +353,16 @@ HRESULT WINAPI Isochart::IMTFromPerVertexSignal(
 
 //-------------------------------------------------------------------------------------
 HRESULT WINAPI
-Isochart::IMTFromTextureMap(
+Isochart::IMTSplitFace(
     const XMFLOAT3* pV3d,	// [In] surface coordinates of face's vertices
     const XMFLOAT2* pUV,	// [In] Texture coordinates of each vertices in the range of 0 to 1.0f
     size_t dwMaxSplitLevel,		// [In] Split into how many levels.
     float fMinVertexUvIDistance,	// [In] smallest vertices distance, in pixel.
-    size_t uPrimitiveId,
-    size_t dwSignalDimension,
-    LPIMTSIGNALCALLBACK pfnGetSignal,
-    void* lpTextureData,
-    FLOAT3* pfIMTArray)	// [Out] Result IMT
+    std::vector<XMFLOAT2>& vertList,
+    std::vector<SUBFACE>& subFaceList)
 {
     HRESULT hr = S_OK;
 
-    if (!CheckIMTFromTextureMapInput(
-        pV3d,
-        pUV,
-        pfnGetSignal,
-        pfIMTArray))
-    {
-        return E_INVALIDARG;		
-    }
-
-    (*pfIMTArray)[0] = (*pfIMTArray)[1] = (*pfIMTArray)[2] = 0;
-
-    // 1. Allocate needed resource
-    std::unique_ptr<float[]> Ss( new (std::nothrow) float[dwSignalDimension] );
-    std::unique_ptr<float[]> St( new (std::nothrow) float[dwSignalDimension] );
-    std::unique_ptr<float[]> pfTriangleSignal( new (std::nothrow) float[dwSignalDimension * 3] );
-    std::unique_ptr<float[]> pfSignalBase;
-
-    if (!Ss || !St || !pfTriangleSignal)
-    {
-        return E_OUTOFMEMORY;
-    }
-
-    // 2. Build a Queue to store all sub-triangle
-    // Actually, using recursing function here seems easier to be understand, however,
-    // to avoid potential stack overflow, just using a queue to simulate the recursing process.
-    double dTotalIMT[3];
-    FLOAT3 tempIMT;
-    std::queue<SUBFACE*> subFaceIdxList;
-    std::vector<SUBFACE*> finalSubFaceIdxList;
-    std::vector<XMFLOAT2> vertList;
-
     double d3dArea = fabs(Cal3DTriangleArea(
         pV3d, pV3d+1, pV3d+2));
     double d2dArea = fabs(Cal2DTriangleArea(
@@ -414,8 +374,13 @@ Isochart::IMTFromTextureMap(
         DPF(0, "IMTFromTextureMap failed due to zero area");
         return E_FAIL;
     }
-    
-    // 2.1 Initialize splitting face queue
+
+    // 1. Build a Queue to store all sub-triangle
+    // Actually, using recursing function here seems easier to be understand, however,
+    // to avoid potential stack overflow, just using a queue to simulate the recursing process.
+    std::queue<SUBFACE*> subFaceIdxList;
+
+    // 1.1 Initialize splitting face queue
     auto pFace = new (std::nothrow) SUBFACE;
     if (!pFace)
     {
@@ -432,15 +397,14 @@ Isochart::IMTFromTextureMap(
         return E_OUTOFMEMORY;
     }
 
-    float* pfSignal = nullptr;
-
     pFace->dwDepth = 0;
     try
     {
+        auto dwFirstVert = static_cast<uint32_t>(vertList.size());
         for (uint32_t ii = 0; ii < 3; ii++)
         {
             vertList.push_back(pUV[ii]);
-            pFace->dwVertIdx[ii] = ii;
+            pFace->dwVertIdx[ii] = dwFirstVert + ii;
         }
     }
     catch (std::bad_alloc&)
@@ -449,7 +413,7 @@ Isochart::IMTFromTextureMap(
         goto LEnd;
     }
 
-    // 3. Split triangle to get sub-triangles for integration IMT.
+    // 2. Split triangle to get sub-triangles for integration IMT.
     do
     {
         assert(!subFaceIdxList.empty());
@@ -481,57 +445,76 @@ Isochart::IMTFromTextureMap(
         {
             try
             {
-                finalSubFaceIdxList.push_back(pCurrFace);
+                subFaceList.push_back(*pCurrFace);
             }
             catch (std::bad_alloc&)
             {
-                delete pCurrFace;
                 hr = E_OUTOFMEMORY;
+            }
+            delete pCurrFace;
+            if (FAILED(hr))
+            {
                 goto LEnd;
             }
         }				
     }while(!subFaceIdxList.empty());
 
-    // 4. Get signal on all vertex.
-    pfSignalBase.reset( new (std::nothrow) float[vertList.size() * dwSignalDimension] );
-    if (!pfSignalBase)
+LEnd:
+    while (!subFaceIdxList.empty())
     {
-        hr = E_OUTOFMEMORY;
-        goto LEnd;
+        pFace = subFaceIdxList.front();
+        subFaceIdxList.pop();
+        delete pFace;
     }
-    
-    pfSignal = pfSignalBase.get();
-    for (size_t ii = 0; ii<vertList.size(); ii++)
-    {		
-        XMFLOAT2 coord = vertList[ii];
-                
-        hr = pfnGetSignal(
-            &coord,
-            uPrimitiveId,
-            dwSignalDimension,
-            lpTextureData,
-            pfSignal);
 
-        if (FAILED(hr))
-        {
-            goto LEnd;
-        }
-        
-        pfSignal += dwSignalDimension;
+    return hr;
+}
+
+
+//-------------------------------------------------------------------------------------
+HRESULT WINAPI
+Isochart::IMTFromSplitFace(
+    const XMFLOAT3* pV3d,	// [In] surface coordinates of face's vertices
+    const XMFLOAT2* pUV,	// [In] Texture coordinates of each vertices in the range of 0 to 1.0f
+    const XMFLOAT2* pVertList,
+    const SUBFACE* pSubFaces,
+    size_t dwSubFaceCount,
+    const float* pfVertSignal,
+    size_t dwSignalDimension,
+    FLOAT3* pfIMTArray)	// [Out] Result IMT
+{
+    (*pfIMTArray)[0] = (*pfIMTArray)[1] = (*pfIMTArray)[2] = 0;
+
+    // 1. Allocate needed resource
+    std::unique_ptr<float[]> Ss( new (std::nothrow) float[dwSignalDimension] );
+    std::unique_ptr<float[]> St( new (std::nothrow) float[dwSignalDimension] );
+    std::unique_ptr<float[]> pfTriangleSignal( new (std::nothrow) float[dwSignalDimension * 3] );
+
+    if (!Ss || !St || !pfTriangleSignal)
+    {
+        return E_OUTOFMEMORY;
     }
 
-    
+    double d3dArea = fabs(Cal3DTriangleArea(
+        pV3d, pV3d+1, pV3d+2));
+    double d2dArea = fabs(Cal2DTriangleArea(
+        pUV, pUV+1, pUV+2));
+
+    // 2. Integrate IMT of all sub-triangles.
+    double dTotalIMT[3];
+    FLOAT3 tempIMT;
+
     dTotalIMT[0] = dTotalIMT[1] = dTotalIMT[2] = 0;
-    for (size_t ii = 0; ii<finalSubFaceIdxList.size(); ii++)
+    for (size_t ii = 0; ii<dwSubFaceCount; ii++)
     {
-        SUBFACE* pCurrFace = finalSubFaceIdxList[ii];
+        const SUBFACE* pCurrFace = pSubFaces + ii;
         // Compute IMT of current face
-        pfSignal = pfTriangleSignal.get();
+        float* pfSignal = pfTriangleSignal.get();
         for (size_t jj = 0; jj<3; jj++)
         {
             memcpy(
                 pfSignal,
-                pfSignalBase.get()+pCurrFace->dwVertIdx[jj],
+                pfVertSignal + pCurrFace->dwVertIdx[jj] * dwSignalDimension,
                 sizeof(float)*dwSignalDimension);
 
             pfSignal += dwSignalDimension;
@@ -540,9 +523,9 @@ Isochart::IMTFromTextureMap(
         float fA = static_cast<float>(d2dArea / (uint64_t(1) << (uint64_t(pCurrFace->dwDepth) << 1) ));
         // Compute IMT using standard parameterization coordinates.
         CalTriangleIMTFromPerVertexSignal(
-            &(vertList[pCurrFace->dwVertIdx[0]]),
-            &(vertList[pCurrFace->dwVertIdx[1]]),
-            &(vertList[pCurrFace->dwVertIdx[2]]),
+            pVertList + pCurrFace->dwVertIdx[0],
+            pVertList + pCurrFace->dwVertIdx[1],
+            pVertList + pCurrFace->dwVertIdx[2],
             fA,
             Ss.get(),
             St.get(),
@@ -554,43 +537,101 @@ Isochart::IMTFromTextureMap(
         dTotalIMT[0] += tempIMT[0]*dIntegratedArea;
         dTotalIMT[1] += tempIMT[1]*dIntegratedArea;
         dTotalIMT[2] += tempIMT[2]*dIntegratedArea;
-        delete pCurrFace;
     }
 
-    
     for (size_t ii = 0; ii<IMT_DIM; ii++)
     {
-        (*pfIMTArray)[ii] = static_cast<float>((*pfIMTArray)[ii] / d3dArea);
+        (*pfIMTArray)[ii] = static_cast<float>(dTotalIMT[ii] / d3dArea);
     }
 
-    // 4. Convert to canonical IMT 
+    // 3. Convert to canonical IMT 
     ConvertToCanonicalIMT(
         (*pfIMTArray), (*pfIMTArray), pV3d, pUV);
 
-    finalSubFaceIdxList.clear();
-
-LEnd:
-    while (!subFaceIdxList.empty())
+    for (size_t ii = 0; ii<3; ii++)
     {
-        pFace = subFaceIdxList.front();
-        subFaceIdxList.pop();
-        delete pFace;
+        if (IsInZeroRange2((*pfIMTArray)[ii]))
+        {
+            (*pfIMTArray)[ii] = 0;
+        }
     }
+    
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+HRESULT WINAPI
+Isochart::IMTFromTextureMap(
+    const XMFLOAT3* pV3d,	// [In] surface coordinates of face's vertices
+    const XMFLOAT2* pUV,	// [In] Texture coordinates of each vertices in the range of 0 to 1.0f
+    size_t dwMaxSplitLevel,		// [In] Split into how many levels.
+    float fMinVertexUvIDistance,	// [In] smallest vertices distance, in pixel.
+    size_t uPrimitiveId,
+    size_t dwSignalDimension,
+    LPIMTSIGNALCALLBACK pfnGetSignal,
+    void* lpTextureData,
+    FLOAT3* pfIMTArray)	// [Out] Result IMT
+{
+    HRESULT hr = S_OK;
 
-    for (size_t ii = 0; ii<finalSubFaceIdxList.size(); ii++)
+    if (!CheckIMTFromTextureMapInput(
+        pV3d,
+        pUV,
+        pfnGetSignal,
+        pfIMTArray))
     {
-        delete finalSubFaceIdxList[ii];
+        return E_INVALIDARG;		
     }
 
-    for (size_t ii = 0; ii<3; ii++)
+    (*pfIMTArray)[0] = (*pfIMTArray)[1] = (*pfIMTArray)[2] = 0;
+
+    // 1. Split triangle to get sub-triangles for integration IMT.
+    std::vector<XMFLOAT2> vertList;
+    std::vector<SUBFACE> subFaceList;
+
+    FAILURE_RETURN(
+        IMTSplitFace(
+            pV3d,
+            pUV,
+            dwMaxSplitLevel,
+            fMinVertexUvIDistance,
+            vertList,
+            subFaceList));
+
+    // 2. Get signal on all vertex.
+    std::unique_ptr<float[]> pfSignalBase( new (std::nothrow) float[vertList.size() * dwSignalDimension] );
+    if (!pfSignalBase)
     {
-        if (IsInZeroRange2((*pfIMTArray)[ii]))
-        {
-            (*pfIMTArray)[ii] = 0;
-        }
+        return E_OUTOFMEMORY;
     }
     
-    return hr;
+    float* pfSignal = pfSignalBase.get();
+    for (size_t ii = 0; ii<vertList.size(); ii++)
+    {		
+        XMFLOAT2 coord = vertList[ii];
+                
+        FAILURE_RETURN(
+            pfnGetSignal(
+                &coord,
+                uPrimitiveId,
+                dwSignalDimension,
+                lpTextureData,
+                pfSignal));
+        
+        pfSignal += dwSignalDimension;
+    }
+
+    // 3. Integrate IMT of sub-triangles.
+    return IMTFromSplitFace(
+        pV3d,
+        pUV,
+        vertList.data(),
+        subFaceList.data(),
+        subFaceList.size(),
+        pfSignalBase.get(),
+        dwSignalDimension,
+        pfIMTArray);
 }
 
 
@@ -1221,6 +1262,199 @@ namespace
         return hr;
     }
 
+    // Texel coordinates of one texture axis for bilinear sampling at t.
+    template<bool bWrap>
+    inline void GetTexelCoordinate(
+        float t,
+        size_t uSize,
+        int& i,
+        int& i2,
+        float& d)
+    {
+        if (bWrap)
+        {
+            t = fmodf(t, 1.f);
+            if (t < 0.f)
+                t += 1.f;
+        }
+        else
+        {
+            if (t < 0.f)
+                t = 0.f;
+            if (t > 1.f)
+                t = 1.f;
+        }
+
+        t = t * uSize;
+
+        i = (int) t;
+        i2 = i + 1;
+        d = t - i;
+
+        if (bWrap)
+        {
+            i = int(size_t(i) % uSize);
+            i2 = int(size_t(i2) % uSize);
+        }
+        else
+        {
+            i = std::max(0, std::min<int>(i, int(uSize) - 1));
+            i2 = std::max(0, std::min<int>(i2, int(uSize) - 1));
+        }
+    }
+
+    // Readers of texel channels for CTextureSampler, one per IMTTEXELFORMAT.
+    // Read returns the channels as floats, converted into pfScratch, which
+    // holds 4 floats, when the format is not float.
+    struct CFloatTexelReader
+    {
+        static const float* Read(const uint8_t* pTexel, size_t, float*)
+        {
+            return reinterpret_cast<const float*>(pTexel);
+        }
+    };
+
+    struct CHalfTexelReader
+    {
+        static const float* Read(const uint8_t* pTexel, size_t dwDimension, float* pfScratch)
+        {
+            auto pHalf = reinterpret_cast<const PackedVector::HALF*>(pTexel);
+            for (size_t k = 0; k < dwDimension; k++)
+            {
+                pfScratch[k] = PackedVector::XMConvertHalfToFloat(pHalf[k]);
+            }
+            return pfScratch;
+        }
+    };
+
+    struct CUNorm8TexelReader
+    {
+        static const float* Read(const uint8_t* pTexel, size_t dwDimension, float* pfScratch)
+        {
+            for (size_t k = 0; k < dwDimension; k++)
+            {
+                pfScratch[k] = pTexel[k] * (1.f / 255.f);
+            }
+            return pfScratch;
+        }
+    };
+
+    // Bilinear sampler of IMTTEXTUREDESC. Wrap modes and texel format are
+    // resolved at compile time, and so is the signal dimension when
+    // FixedDimension is not 0.
+    template<bool bWrapU, bool bWrapV, size_t FixedDimension, class TTexelReader>
+    class CTextureSampler
+    {
+    public:
+        CTextureSampler(
+            const IMTTEXTUREDESC& texture,
+            size_t dwSignalDimension) :
+            m_texture(texture),
+            m_dwSignalDimension(dwSignalDimension)
+        {
+            assert(!FixedDimension || FixedDimension == dwSignalDimension);
+        }
+
+        size_t GetSignalDimension() const
+        {
+            return FixedDimension ? FixedDimension : m_dwSignalDimension;
+        }
+
+        // Sample the signal at the 4 corners of a texel, stored in the order
+        // (x0, y0), (x1, y0), (x0, y1), (x1, y1). Texel coordinates of each
+        // column and row are computed once and shared by 2 corners.
+        void SampleCorners(
+            float x0,
+            float x1,
+            float y0,
+            float y1,
+            float* pfSignalOut) const
+        {
+            int col[2][2], row[2][2];
+            float du[2], dv[2];
+
+            GetTexelCoordinate<bWrapU>(x0, m_texture.uWidth, col[0][0], col[0][1], du[0]);
+            GetTexelCoordinate<bWrapU>(x1, m_texture.uWidth, col[1][0], col[1][1], du[1]);
+            GetTexelCoordinate<bWrapV>(y0, m_texture.uHeight, row[0][0], row[0][1], dv[0]);
+            GetTexelCoordinate<bWrapV>(y1, m_texture.uHeight, row[1][0], row[1][1], dv[1]);
+
+            float scratch[4][4];
+            for (size_t ii = 0; ii < 2; ii++)
+            {
+                for (size_t jj = 0; jj < 2; jj++)
+                {
+                    Blend(
+                        GetTexel(col[jj][0], row[ii][0], scratch[0]),
+                        GetTexel(col[jj][1], row[ii][0], scratch[1]),
+                        GetTexel(col[jj][0], row[ii][1], scratch[2]),
+                        GetTexel(col[jj][1], row[ii][1], scratch[3]),
+                        du[jj],
+                        dv[ii],
+                        pfSignalOut);
+                    pfSignalOut += GetSignalDimension();
+                }
+            }
+        }
+
+    private:
+        const float* GetTexel(int x, int y, float* pfScratch) const
+        {
+            return TTexelReader::Read(
+                static_cast<const uint8_t*>(m_texture.pTexels)
+                + y * m_texture.uRowPitch + x * m_texture.uTexelPitch,
+                GetSignalDimension(),
+                pfScratch);
+        }
+
+        // 
+        // C1 ---- C2  ^          dv
+        //  | .    |   |           |
+        //  |      |   |           |
+        //  |      |   |           |
+        // C3 ---- C4  v, u --->   v
+        //
+        // Channels are blended 4 at a time, in the same order of operations
+        // as the scalar tail.
+        void Blend(
+            const float* C1,
+            const float* C2,
+            const float* C3,
+            const float* C4,
+            float du,
+            float dv,
+            float* pfSignalOut) const
+        {
+            const size_t dwDimension = GetSignalDimension();
+
+            XMVECTOR vDu = XMVectorReplicate(du);
+            XMVECTOR vDu1 = XMVectorReplicate(1.f - du);
+            XMVECTOR vDv = XMVectorReplicate(dv);
+            XMVECTOR vDv1 = XMVectorReplicate(1.f - dv);
+
+            size_t k = 0;
+            for (; k + 4 <= dwDimension; k += 4)
+            {
+                XMVECTOR res =
+                    (XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(C1 + k)) * vDu1
+                    + XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(C2 + k)) * vDu) * vDv1
+                    + (XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(C3 + k)) * vDu1
+                    + XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(C4 + k)) * vDu) * vDv;
+
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(pfSignalOut + k), res);
+            }
+
+            for (; k < dwDimension; k++)
+            {
+                pfSignalOut[k] = (C1[k] * (1.f - du) + C2[k] * du) * (1.f - dv) +
+                    (C3[k] * (1.f - du) + C4[k] * du) * dv;
+            }
+        }
+
+        const IMTTEXTUREDESC& m_texture;
+        size_t m_dwSignalDimension;
+    };
+
+    template<class TSampler>
     static HRESULT ComputeIMTOnPixel(
         double tempIMT [],
         DOUBLEVECTOR2* pUV,
@@ -1231,10 +1465,8 @@ namespace
         size_t dwCol,
         double* rgvVerticalIntersection,
         DOUBLEVECTOR2& leftBottom,
-        size_t uPrimitiveId,
-        size_t dwSignalDimension,
-        LPIMTSIGNALCALLBACK pfnGetSignal,
-        void* lpTextureData,
+        const TSampler& sampler,
+        float* pfSignal,            // Scratch buffer of 4 * signal dimension floats
         double& dPieceArea)
     {
         HRESULT hr = S_OK;
@@ -1356,38 +1588,17 @@ namespace
             return hr;
         }
 
-        XMFLOAT2 c;
-        std::unique_ptr<float[]> signalBase(new (std::nothrow) float[dwSignalDimension*sizeof(float) * 4]);
-        if (!signalBase)
-        {
-            return E_OUTOFMEMORY;
-        }
-
-        float* pfSignal = signalBase.get();
-        for (size_t ii = 0; ii < 2; ii++)
-        {
-            c.y = (float) (corner[ii].y);
-            for (size_t jj = 0; jj < 2; jj++)
-            {
-                c.x = (float) (corner[jj].x);
-                hr = pfnGetSignal(
-                    &c,
-                    uPrimitiveId,
-                    dwSignalDimension,
-                    lpTextureData,
-                    pfSignal);
-                if (FAILED(hr))
-                {
-                    return hr;
-                }
-                pfSignal += dwSignalDimension;
-            }
-        }
+        sampler.SampleCorners(
+            (float) (corner[0].x),
+            (float) (corner[1].x),
+            (float) (corner[0].y),
+            (float) (corner[1].y),
+            pfSignal);
 
         hr = Accumulation(
             corner,
-            signalBase.get(),
-            dwSignalDimension,
+            pfSignal,
+            sampler.GetSignalDimension(),
             above,
             below,
             tempIMT,
@@ -1396,144 +1607,448 @@ namespace
         return hr;
     }
 
-    struct IMTFloatArrayDescIn
+    // IMT of a texel entirely covered by a face. The gradient of the bilinear
+    // signal is linear over the texel, so its products integrate in closed form.
+    static void ComputeIMTOnTexel(
+        const float* pfSignal,
+        size_t dwSignalDimension,
+        double fTexelLengthW,
+        double fTexelLengthH,
+        double IMTResult[])
     {
-        float *pTexture;
-        size_t uHeight, uWidth, uStride;
-    };
-}
+        memset(IMTResult, 0, sizeof(double)*IMT_DIM);
 
+        // Signal of corners in the same order as Accumulation, (a, b) at the
+        // bottom and (c, d) at the top of the texel.
+        for (size_t ii = 0; ii < dwSignalDimension; ii++)
+        {
+            double a = pfSignal[0 * dwSignalDimension + ii];
+            double b = pfSignal[1 * dwSignalDimension + ii];
+            double c = pfSignal[2 * dwSignalDimension + ii];
+            double d = pfSignal[3 * dwSignalDimension + ii];
 
-//-------------------------------------------------------------------------------------
-HRESULT WINAPI
-Isochart::IMTFromTextureMapEx(
-    const XMFLOAT3* pV3d,	// [In] surface coordinates of face's vertices
-    const XMFLOAT2* pUV,	// [In] Texture coordinates of each vertices in the range of 0 to 1.0f
-    size_t uPrimitiveId,
-    size_t dwSignalDimension,
-    LPIMTSIGNALCALLBACK pfnGetSignal,
-    void* lpTextureData,
-    FLOAT3* pfIMTArray)	// [Out] Result IMT
-{
-    HRESULT hr = S_OK;
+            double du0 = b - a, du1 = d - c;
+            double dv0 = c - a, dv1 = d - b;
 
-    uint32_t dwRowLineCount = 0;
-    uint32_t dwColLineCount = 0;
+            IMTResult[0] += (du0*du0 + du0*du1 + du1*du1) / 3;
+            IMTResult[1] += (du0 + du1)*(dv0 + dv1) / 4;
+            IMTResult[2] += (dv0*dv0 + dv0*dv1 + dv1*dv1) / 3;
+        }
 
-    SetAllIMTValue(
-        *pfIMTArray, 0);
+        IMTResult[0] *= fTexelLengthH / fTexelLengthW;
+        IMTResult[2] *= fTexelLengthW / fTexelLengthH;
+    }
 
-    float f3dArea = fabsf(Cal3DTriangleArea(
-        pV3d, pV3d+1, pV3d+2));
+    template<class TSampler>
+    HRESULT BuildSummedAreaRow(
+        const IMTTEXTUREDESC& texture,
+        const TSampler& sampler,
+        size_t dwRow,
+        double* pRow)
+    {
+        const size_t dwSignalDimension = sampler.GetSignalDimension();
 
-    float f2dArea = fabsf(Cal2DTriangleArea(
-        pUV, pUV+1, pUV+2));
+        std::unique_ptr<float[]> signalBase(new (std::nothrow) float[dwSignalDimension * 4]);
+        if (!signalBase)
+        {
+            return E_OUTOFMEMORY;
+        }
 
-    if (IsInZeroRange2(f3dArea) || IsInZeroRange2(f2dArea))
-    {
-        return S_OK;
-    }
+        double fTexelLengthW = (1.0 / texture.uWidth);
+        double fTexelLengthH = (1.0 / texture.uHeight);
 
-    auto pTexDesc = reinterpret_cast<IMTFloatArrayDescIn*>( lpTextureData );
-    DOUBLEVECTOR2 leftBottom = {0.0, 0.0};
+        double y0 = dwRow * fTexelLengthH;
+        double y1 = y0 + fTexelLengthH;
 
-    double fTexelLengthW = (1.0 / pTexDesc->uWidth);
-    double fTexelLengthH = (1.0 / pTexDesc->uHeight);
+        memset(pRow, 0, sizeof(double)*IMT_DIM);
+        for (size_t ii = 0; ii < texture.uWidth; ii++)
+        {
+            double x0 = ii * fTexelLengthW;
+            double x1 = x0 + fTexelLengthW;
+
+            sampler.SampleCorners(
+                (float) x0,
+                (float) x1,
+                (float) y0,
+                (float) y1,
+                signalBase.get());
+
+            double texelIMT[IMT_DIM];
+            ComputeIMTOnTexel(
+                signalBase.get(),
+                dwSignalDimension,
+                fTexelLengthW,
+                fTexelLengthH,
+                texelIMT);
 
-    DOUBLEVECTOR2 uv[3] = {};
-    for (size_t ii = 0; ii<3; ii++)
+            for (size_t kk = 0; kk < IMT_DIM; kk++)
+            {
+                pRow[(ii + 1) * IMT_DIM + kk] = pRow[ii * IMT_DIM + kk] + texelIMT[kk];
+            }
+        }
+
+        return S_OK;
+    }
+
+    static inline int64_t WrapTexelIndex(int64_t i, size_t uSize)
     {
-        uv[ii].x = pUV[ii].x;
-        uv[ii].y = pUV[ii].y;		
+        int64_t r = i % int64_t(uSize);
+        return r < 0 ? r + int64_t(uSize) : r;
     }
 
-    GetCoveredPixelsCount(
-        uv,
-        fTexelLengthW, 
-        fTexelLengthH, 
-        leftBottom, 
-        dwRowLineCount, 
-        dwColLineCount);
+    // Columns [dwBegin, dwEnd) of texel row dwRow of a face which lie entirely
+    // inside the face, and inside the texture if it does not wrap.
+    static void GetCoveredTexelRun(
+        const IMTTEXTUREDESC& texture,
+        double fTexelLengthW,
+        size_t dwRow,
+        size_t dwColCount,
+        double* rgvHorizonIntersection,
+        int64_t iTexelX,            // Texel column of the first column of the face
+        int64_t iTexelY,            // Texel row of dwRow
+        size_t& dwBegin,
+        size_t& dwEnd)
+    {
+        dwBegin = dwEnd = 0;
+
+        if (!texture.bWrapV && (iTexelY < 0 || iTexelY >= int64_t(texture.uHeight)))
+        {
+            return;
+        }
+
+        double minX0 = 0, maxX0 = 0, minX1 = 0, maxX1 = 0;
+        GetBoundOnLine(rgvHorizonIntersection + dwRow * 3, minX0, maxX0);
+        GetBoundOnLine(rgvHorizonIntersection + (dwRow + 1) * 3, minX1, maxX1);
 
-    std::unique_ptr<double[]> rgvHorizonIntersection(new (std::nothrow) double[3 * dwRowLineCount]);
-    std::unique_ptr<double[]> rgvVerticalIntersection(new (std::nothrow) double[3 * dwColLineCount]);
+        // The face is convex, so a texel is inside if its 4 corners are.
+        double fMin = std::max(minX0, minX1);
+        double fMax = std::min(maxX0, maxX1);
+        if (fMin >= fMax)
+        {
+            return;
+        }
 
-    if (!rgvHorizonIntersection || !rgvVerticalIntersection)
-    {
-        return E_OUTOFMEMORY;
+        double fLeft = iTexelX * fTexelLengthW;
+        double fBegin = ceil((fMin - fLeft) / fTexelLengthW);
+        double fEnd = floor((fMax - fLeft) / fTexelLengthW);
+
+        int64_t iBegin = std::max<int64_t>(0, int64_t(fBegin));
+        int64_t iEnd = std::min<int64_t>(int64_t(dwColCount), int64_t(fEnd));
+
+        if (!texture.bWrapU)
+        {
+            iBegin = std::max<int64_t>(iBegin, -iTexelX);
+            iEnd = std::min<int64_t>(iEnd, int64_t(texture.uWidth) - iTexelX);
+        }
+
+        if (iBegin < iEnd)
+        {
+            dwBegin = size_t(iBegin);
+            dwEnd = size_t(iEnd);
+        }
     }
 
-    if (FAILED(hr = ComputeAllIntersection(
-        uv, 
-        fTexelLengthW, 
-        fTexelLengthH, 
-        leftBottom, 
-        dwRowLineCount,
-        dwColLineCount, 
-        rgvVerticalIntersection.get(),
-        rgvHorizonIntersection.get())))
+    // Add the IMT of dwCount texels of texel row iTexelY, starting from texel
+    // column iTexelX, to IMTResult.
+    static void SumTexelRun(
+        const IMTTEXTUREDESC& texture,
+        int64_t iTexelX,
+        int64_t iTexelY,
+        size_t dwCount,
+        double IMTResult[])
     {
-        return hr;
+        const double* pRow = texture.pSummedArea
+            + size_t(WrapTexelIndex(iTexelY, texture.uHeight)) * (texture.uWidth + 1) * IMT_DIM;
+
+        auto dwCol = size_t(WrapTexelIndex(iTexelX, texture.uWidth));
+        while (dwCount > 0)
+        {
+            size_t dwRun = std::min(dwCount, texture.uWidth - dwCol);
+            for (size_t kk = 0; kk < IMT_DIM; kk++)
+            {
+                IMTResult[kk] += pRow[(dwCol + dwRun) * IMT_DIM + kk] - pRow[dwCol * IMT_DIM + kk];
+            }
+            dwCount -= dwRun;
+            dwCol = 0;
+        }
     }
 
-    double tempIMT[IMT_DIM];
-    double tempSumIMT[IMT_DIM];
+    // IMT of one face, integrated texel by texel over the signal of sampler.
+    template<class TSampler>
+    HRESULT IMTFromTexture(
+        const XMFLOAT3* pV3d,
+        const XMFLOAT2* pUV,
+        const IMTTEXTUREDESC& texture,
+        const TSampler& sampler,
+        FLOAT3* pfIMTArray)
+    {
+        HRESULT hr = S_OK;
+
+        uint32_t dwRowLineCount = 0;
+        uint32_t dwColLineCount = 0;
+
+        SetAllIMTValue(
+            *pfIMTArray, 0);
+
+        float f3dArea = fabsf(Cal3DTriangleArea(
+            pV3d, pV3d+1, pV3d+2));
+
+        float f2dArea = fabsf(Cal2DTriangleArea(
+            pUV, pUV+1, pUV+2));
+
+        if (IsInZeroRange2(f3dArea) || IsInZeroRange2(f2dArea))
+        {
+            return S_OK;
+        }
+
+        DOUBLEVECTOR2 leftBottom = {0.0, 0.0};
+
+        double fTexelLengthW = (1.0 / texture.uWidth);
+        double fTexelLengthH = (1.0 / texture.uHeight);
+
+        DOUBLEVECTOR2 uv[3] = {};
+        for (size_t ii = 0; ii<3; ii++)
+        {
+            uv[ii].x = pUV[ii].x;
+            uv[ii].y = pUV[ii].y;		
+        }
+
+        GetCoveredPixelsCount(
+            uv,
+            fTexelLengthW, 
+            fTexelLengthH, 
+            leftBottom, 
+            dwRowLineCount, 
+            dwColLineCount);
+
+        std::unique_ptr<double[]> rgvHorizonIntersection(new (std::nothrow) double[3 * dwRowLineCount]);
+        std::unique_ptr<double[]> rgvVerticalIntersection(new (std::nothrow) double[3 * dwColLineCount]);
+
+        if (!rgvHorizonIntersection || !rgvVerticalIntersection)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        if (FAILED(hr = ComputeAllIntersection(
+            uv, 
+            fTexelLengthW, 
+            fTexelLengthH, 
+            leftBottom, 
+            dwRowLineCount,
+            dwColLineCount, 
+            rgvVerticalIntersection.get(),
+            rgvHorizonIntersection.get())))
+        {
+            return hr;
+        }
+
+        std::unique_ptr<float[]> signalBase(new (std::nothrow) float[sampler.GetSignalDimension() * 4]);
+        if (!signalBase)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        double tempIMT[IMT_DIM];
+        double tempSumIMT[IMT_DIM];
     
-    memset(tempSumIMT, 0, sizeof(double)*IMT_DIM);
+        memset(tempSumIMT, 0, sizeof(double)*IMT_DIM);
 
-    double dTotal2DArea = 0;
-    double dPieceArea = 0;
-    for (size_t ii = 0; ii<dwRowLineCount - 1; ii++)
-    {
-        for (size_t jj = 0; jj<dwColLineCount - 1; jj++)
+        int64_t iTexelX = int64_t(floor(leftBottom.x / fTexelLengthW + 0.5));
+        int64_t iTexelY = int64_t(floor(leftBottom.y / fTexelLengthH + 0.5));
+
+        double dTotal2DArea = 0;
+        double dPieceArea = 0;
+        for (size_t ii = 0; ii<dwRowLineCount - 1; ii++)
         {
-            if (FAILED(hr = ComputeIMTOnPixel(
-                tempIMT, 
-                uv,
-                fTexelLengthW,
-                fTexelLengthH,
-                ii, 
-                rgvHorizonIntersection.get(),	
-                jj, 
-                rgvVerticalIntersection.get(),
-                leftBottom, 
-                uPrimitiveId,
-                dwSignalDimension,
-                pfnGetSignal,
-                lpTextureData,
-                dPieceArea)))
+            // Texels entirely covered by the face are summed from the table,
+            // only the ones on the boundary of the face are clipped.
+            size_t dwCoveredBegin = 0, dwCoveredEnd = 0;
+            if (texture.pSummedArea)
             {
-                return hr;
+                GetCoveredTexelRun(
+                    texture,
+                    fTexelLengthW,
+                    ii,
+                    dwColLineCount - 1,
+                    rgvHorizonIntersection.get(),
+                    iTexelX,
+                    iTexelY + int64_t(ii),
+                    dwCoveredBegin,
+                    dwCoveredEnd);
+
+                SumTexelRun(
+                    texture,
+                    iTexelX + int64_t(dwCoveredBegin),
+                    iTexelY + int64_t(ii),
+                    dwCoveredEnd - dwCoveredBegin,
+                    tempSumIMT);
+
+                dTotal2DArea += (dwCoveredEnd - dwCoveredBegin) * fTexelLengthW * fTexelLengthH;
             }
 
-            for (size_t kk = 0; kk<IMT_DIM; kk++)
+            for (size_t jj = 0; jj<dwColLineCount - 1; jj++)
             {
-                tempSumIMT[kk] += tempIMT[kk];
+                if (jj >= dwCoveredBegin && jj < dwCoveredEnd)
+                {
+                    jj = dwCoveredEnd - 1;
+                    continue;
+                }
+
+                if (FAILED(hr = ComputeIMTOnPixel(
+                    tempIMT, 
+                    uv,
+                    fTexelLengthW,
+                    fTexelLengthH,
+                    ii, 
+                    rgvHorizonIntersection.get(),	
+                    jj, 
+                    rgvVerticalIntersection.get(),
+                    leftBottom, 
+                    sampler,
+                    signalBase.get(),
+                    dPieceArea)))
+                {
+                    return hr;
+                }
+
+                for (size_t kk = 0; kk<IMT_DIM; kk++)
+                {
+                    tempSumIMT[kk] += tempIMT[kk];
+                }
+
+                dTotal2DArea += dPieceArea;
             }
+        }
+
+        DPF(3, "2d area by formal %f", f2dArea);
+        DPF(3, "integrated 2d area %f", float(dTotal2DArea));
 
-            dTotal2DArea += dPieceArea;
+        // 2. Standard face parameterizaion
+        for (size_t ii = 0; ii<IMT_DIM; ii++)
+        {
+            (*pfIMTArray)[ii] = static_cast<float>(tempSumIMT[ii]);
         }
+
+        ConvertToCanonicalIMT(
+            (*pfIMTArray),
+            (*pfIMTArray),
+            pV3d,
+            pUV);
+
+        for (size_t ii = 0; ii<IMT_DIM; ii++)
+        {
+            (*pfIMTArray)[ii] /= f3dArea;
+        }
+
+        return hr;
     }
+}
 
-    DPF(3, "2d area by formal %f", f2dArea);
-    DPF(3, "integrated 2d area %f", float(dTotal2DArea));
 
-    // 2. Standard face parameterizaion
-    for (size_t ii = 0; ii<IMT_DIM; ii++)
+namespace
+{
+    template<size_t FixedDimension, class TTexelReader, class TFunc>
+    HRESULT WithWrapModes(
+        const IMTTEXTUREDESC& texture,
+        size_t dwSignalDimension,
+        TFunc&& func)
     {
-        (*pfIMTArray)[ii] = static_cast<float>(tempSumIMT[ii]);
+        if (texture.bWrapU && texture.bWrapV)
+            return func(CTextureSampler<true, true, FixedDimension, TTexelReader>(texture, dwSignalDimension));
+        else if (texture.bWrapU)
+            return func(CTextureSampler<true, false, FixedDimension, TTexelReader>(texture, dwSignalDimension));
+        else if (texture.bWrapV)
+            return func(CTextureSampler<false, true, FixedDimension, TTexelReader>(texture, dwSignalDimension));
+        else
+            return func(CTextureSampler<false, false, FixedDimension, TTexelReader>(texture, dwSignalDimension));
     }
 
-    ConvertToCanonicalIMT(
-        (*pfIMTArray),
-        (*pfIMTArray),
-        pV3d,
-        pUV);
+    template<class TTexelReader, class TFunc>
+    HRESULT WithDimension(
+        const IMTTEXTUREDESC& texture,
+        size_t dwSignalDimension,
+        TFunc&& func)
+    {
+        if (dwSignalDimension == 4)
+        {
+            return WithWrapModes<4, TTexelReader>(texture, dwSignalDimension, func);
+        }
+        else
+        {
+            return WithWrapModes<0, TTexelReader>(texture, dwSignalDimension, func);
+        }
+    }
 
-    for (size_t ii = 0; ii<IMT_DIM; ii++)
+    // Call func with the sampler of texture specialized for its texel format,
+    // wrap modes and dwSignalDimension.
+    template<class TFunc>
+    HRESULT WithTextureSampler(
+        const IMTTEXTUREDESC& texture,
+        size_t dwSignalDimension,
+        TFunc&& func)
     {
-        (*pfIMTArray)[ii] /= f3dArea;
+        switch (texture.format)
+        {
+        case IMT_TEXEL_FLOAT:
+            return WithDimension<CFloatTexelReader>(texture, dwSignalDimension, func);
+
+        case IMT_TEXEL_HALF:
+            assert(dwSignalDimension <= 4);
+            return WithDimension<CHalfTexelReader>(texture, dwSignalDimension, func);
+
+        case IMT_TEXEL_UNORM8:
+            assert(dwSignalDimension <= 4);
+            return WithDimension<CUNorm8TexelReader>(texture, dwSignalDimension, func);
+
+        default:
+            return E_INVALIDARG;
+        }
     }
+}
 
-    return hr;
+
+//-------------------------------------------------------------------------------------
+HRESULT WINAPI
+Isochart::IMTFromTextureMapEx(
+    const XMFLOAT3* pV3d,	// [In] surface coordinates of face's vertices
+    const XMFLOAT2* pUV,	// [In] Texture coordinates of each vertices in the range of 0 to 1.0f
+    size_t dwSignalDimension,
+    const IMTTEXTUREDESC& texture,
+    FLOAT3* pfIMTArray)	// [Out] Result IMT
+{
+    return WithTextureSampler(
+        texture,
+        dwSignalDimension,
+        [&](const auto& sampler) -> HRESULT
+        {
+            return IMTFromTexture(pV3d, pUV, texture, sampler, pfIMTArray);
+        });
+}
+
+
+//-------------------------------------------------------------------------------------
+HRESULT WINAPI
+Isochart::IMTBuildSummedAreaTable(
+    const IMTTEXTUREDESC& texture,
+    size_t dwSignalDimension,
+    size_t dwWorkerCount,
+    double* pSummedArea)
+{
+    return WithTextureSampler(
+        texture,
+        dwSignalDimension,
+        [&](const auto& sampler) -> HRESULT
+        {
+            return ParallelFor(
+                texture.uHeight,
+                dwWorkerCount,
+                [&](size_t, size_t dwRow) -> HRESULT
+                {
+                    return BuildSummedAreaRow(
+                        texture,
+                        sampler,
+                        dwRow,
+                        pSummedArea + dwRow * (texture.uWidth + 1) * IMT_DIM);
+                });
+        });
 }
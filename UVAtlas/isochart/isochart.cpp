@@ -10,6 +10,7 @@
 #include "pch.h"
 #include "isochart.h"
 #include "isochartengine.h"
+#include "isochartstats.hpp"
 
 using namespace DirectX;
 using namespace Isochart;
@@ -311,7 +312,9 @@ HRESULT WINAPI Isochart::isochartpartition(
     LPISOCHARTCALLBACK pCallback,
     float Frequency,
     const uint32_t* pSplitHint,
-    DWORD dwOptions)
+    DWORD dwOptions,
+    CIsochartStats* pStats,
+    std::chrono::steady_clock::time_point Deadline)
 {
     unsigned int dwTotalStage = STAGE_TOTAL(Stage);
     unsigned int dwDoneStage = STAGE_DONE(Stage);
@@ -327,6 +330,7 @@ HRESULT WINAPI Isochart::isochartpartition(
     }
 
     HRESULT hr = S_OK;
+    HRESULT hrPartition = S_OK;
     float fMaxChartStretchOut = 0.0f;
     size_t dwChartNumberOut = 0;
 
@@ -343,9 +347,13 @@ HRESULT WINAPI Isochart::isochartpartition(
         }
     }
     pEngine->SetStage(dwTotalStage, dwDoneStage);
+    pEngine->SetStats(pStats);
+    pEngine->SetDeadline(Deadline);
 
     // 4. Initialize isochart engine
-    if (FAILED(hr = pEngine->Initialize(
+    {
+        CIsochartStageTimer timer(pStats, ISOCHART_STAGE_INIT);
+        hr = pEngine->Initialize(
             pVertexArray, 
             VertexCount, 
             VertexStride, 
@@ -355,14 +363,16 @@ HRESULT WINAPI Isochart::isochartpartition(
             pIMTArray, 
             pOriginalAjacency,
             pSplitHint,
-            dwOptions)))
+            dwOptions);
+    }
+    if (FAILED(hr))
     {
         goto LEnd;
     }				
     pEngine->SetStage(dwTotalStage, dwDoneStage+1);
         
-    // 5. Partition
-    if (FAILED(hr = pEngine->Partition(
+    // 5. Partition, S_FALSE if stopped by the deadline
+    if (FAILED(hr = hrPartition = pEngine->Partition(
             MaxChartNumber,
             Stretch,
             dwChartNumberOut,
@@ -379,6 +389,10 @@ HRESULT WINAPI Isochart::isochartpartition(
         pvVertexRemapArrayOut, 
         pvAttributeIDOut,
         pvAdjacencyOut);
+    if (SUCCEEDED(hr))
+    {
+        hr = hrPartition;
+    }
 
     pEngine->SetStage(dwTotalStage, dwDoneStage+1);
 LEnd:
@@ -28,6 +28,8 @@ namespace Isochart
 {
 typedef float FLOAT3[IMT_DIM]; // Used to define IMT matrix
 
+class CIsochartStats;
+
 // User-specified callback. Return E_FAIL to abort ongoing task
 typedef std::function<HRESULT __cdecl(float percentComplete)> LPISOCHARTCALLBACK;
 typedef std::function<HRESULT __cdecl(const DirectX::XMFLOAT2 *uv, size_t primitiveID, size_t signalDimension, void* userData, float* signalOut)> LPIMTSIGNALCALLBACK;
@@ -45,9 +47,34 @@ enum ISOCHARTOPTION
     _OPTION_ISOCHART_GEODESIC_FAST     = 0x01,  
 
     // all internal geodesic distance computation tries to use the new approach implemented in geodesicdist.lib (except IMT is specified), this is precise but slower
-    _OPTION_ISOCHART_GEODESIC_QUALITY  = 0x02   
+    _OPTION_ISOCHART_GEODESIC_QUALITY  = 0x02,
+
+    // barycentric parameterization is solved by conjugate gradient
+    _OPTION_ISOCHART_SOLVER_ITERATIVE  = 0x04,
+
+    // barycentric parameterization is solved by sparse Cholesky factorization. If neither solver
+    // option is given, the direct solver is used when the chart has at least
+    // BARYCENTRIC_DIRECT_SOLVER_MIN_DIMENSION interior vertices
+    _OPTION_ISOCHART_SOLVER_DIRECT     = 0x08,
+
+    // all internal geodesic distance computation uses the heat method (except IMT is specified), the cotangent
+    // Laplacian of each chart is factorized once, then each source costs two back-substitutions. this is nearly
+    // as precise as the quality option and scales to large meshes
+    _OPTION_ISOCHART_GEODESIC_HEAT     = 0x10,
+
+    // after the initial partition, split several charts with the largest stretch in each round
+    // instead of one, and only optimize the charts created by the split. Much faster when the
+    // result has many charts, but gives a different partition than splitting one by one.
+    _OPTION_ISOCHART_BATCH_SPLIT       = 0x20,
+
+    // bits 16-23 give the number of worker threads used to partition charts. 0 or 1 partitions
+    // serially on the calling thread, _OPTION_ISOCHART_WORKERS_AUTO uses one worker per hardware thread.
+    _OPTION_ISOCHART_WORKERS_AUTO      = 0x00FF0000
 };
-const DWORD _OPTIONMASK_ISOCHART_GEODESIC = _OPTION_ISOCHART_GEODESIC_FAST | _OPTION_ISOCHART_GEODESIC_QUALITY ;
+const DWORD _OPTIONMASK_ISOCHART_GEODESIC = _OPTION_ISOCHART_GEODESIC_FAST | _OPTION_ISOCHART_GEODESIC_QUALITY | _OPTION_ISOCHART_GEODESIC_HEAT ;
+const DWORD _OPTIONMASK_ISOCHART_SOLVER = _OPTION_ISOCHART_SOLVER_ITERATIVE | _OPTION_ISOCHART_SOLVER_DIRECT ;
+const DWORD _OPTIONMASK_ISOCHART_WORKERS = 0x00FF0000 ;
+const DWORD _OPTIONSHIFT_ISOCHART_WORKERS = 16 ;
 
 HRESULT WINAPI 
 isochart(
@@ -102,7 +129,9 @@ isochartpartition(
                                                                                       // CAN be splitted, set the that ajacency to -1.
                                                                                       // Usually, it's easier for user to specified the edge that CAN NOT be
                                                                                       // splitted, make sure to validate the input
-    _In_                                        DWORD dwOptions =_OPTION_ISOCHART_DEFAULT );
+    _In_                                        DWORD dwOptions =_OPTION_ISOCHART_DEFAULT,
+    _In_opt_                                    CIsochartStats* pStats = nullptr,
+    _In_                                        std::chrono::steady_clock::time_point Deadline = std::chrono::steady_clock::time_point::max() );
 
 
 // Class IIsochartEngine for the advanced usage
@@ -154,6 +183,15 @@ public:
     STDMETHOD(SetStage)(
         unsigned int TotalStageCount,
         unsigned int DoneStageCount) PURE;
+
+    // Collect statistics into pStats while partitioning, nullptr to stop.
+    STDMETHOD(SetStats)(
+        CIsochartStats* pStats) PURE;
+
+    // Stop splitting and merging charts after Deadline. Partition then returns
+    // S_FALSE if the stretch criterion has not been reached.
+    STDMETHOD(SetDeadline)(
+        std::chrono::steady_clock::time_point Deadline) PURE;
     
 
     STDMETHOD (ExportPartitionResult)(
@@ -196,14 +234,80 @@ IMTFromTextureMap(
     void* lpTextureData,            // Texture data, can be accessed by pfnGetSignal
     FLOAT3* pfIMTArray);            // [Out] Result IMT
 
+// Sub-triangle of a face split by IMTSplitFace, indexing its vertex list
+struct SUBFACE
+{
+    uint32_t dwVertIdx[3];
+    uint32_t dwDepth;
+};
+
+// Internal API, split a face the way IMTFromTextureMap does. Vertices of the
+// sub-triangles are appended to vertList, and the sub-triangles, indexing
+// vertList, are appended to subFaceList. The split only depends on the face,
+// so signal of many faces can be sampled at once afterwards.
+HRESULT WINAPI
+IMTSplitFace(
+    const DirectX::XMFLOAT3* pV3d,  // [In] surface coordinates of face's vertices
+    const DirectX::XMFLOAT2* pUV,   // [In] Texture coordinates of each vertices
+    size_t dwMaxSplitLevel,         // [In] Split into how many levels.
+    float fMinVertexUvIDistance,    // [In] smallest vertices distance in uv plane
+    std::vector<DirectX::XMFLOAT2>& vertList,   // [In/Out] Sub-triangle vertices
+    std::vector<SUBFACE>& subFaceList);         // [In/Out] Sub-triangles
+
+// Internal API, IMT of a face split by IMTSplitFace from the signal sampled
+// on the vertices of its sub-triangles.
+HRESULT WINAPI
+IMTFromSplitFace(
+    const DirectX::XMFLOAT3* pV3d,  // [In] surface coordinates of face's vertices
+    const DirectX::XMFLOAT2* pUV,   // [In] Texture coordinates of each vertices
+    const DirectX::XMFLOAT2* pVertList, // [In] Vertex list of IMTSplitFace
+    const SUBFACE* pSubFaces,       // [In] Sub-triangles of the face
+    size_t dwSubFaceCount,
+    const float* pfVertSignal,      // [In] dwSignalDimension FLOATs per vertex of pVertList
+    size_t dwSignalDimension,       // [In] Signal dimension
+    FLOAT3* pfIMTArray);            // [Out] Result IMT
+
+// Formats of texel channels of IMTTEXTUREDESC, converted to float when sampled
+enum IMTTEXELFORMAT
+{
+    IMT_TEXEL_FLOAT,
+    IMT_TEXEL_HALF,
+    IMT_TEXEL_UNORM8,               // Integer values 0 - 255 mapped to 0.0 - 1.0
+};
+
+// Texture sampled bilinearly by the built-in IMT sampler. Texel (x, y) is at
+// pTexels + y * uRowPitch + x * uTexelPitch bytes. Only texels around the
+// sampled faces are read, so pTexels can be a view of a memory mapped file.
+struct IMTTEXTUREDESC
+{
+    const void* pTexels;
+    size_t uWidth;
+    size_t uHeight;
+    size_t uRowPitch;               // Bytes between rows
+    size_t uTexelPitch;             // Bytes between texels
+    IMTTEXELFORMAT format;          // Converted formats have at most 4 channels
+    bool bWrapU;
+    bool bWrapV;
+    const double* pSummedArea;      // Optional, built by IMTBuildSummedAreaTable
+};
+
 HRESULT WINAPI
 IMTFromTextureMapEx(
     const DirectX::XMFLOAT3* pV3d,	// [In] surface coordinates of face's vertices
     const DirectX::XMFLOAT2* pUV,	// [In] Texture coordinates of each vertices in the range of 0 to 1.0f
-    size_t uPrimitiveId,            // [in] Primitive ID to pass to callback
-    size_t dwSignalDimension,
-    LPIMTSIGNALCALLBACK pfnGetSignal,
-    void* lpTextureData,
+    size_t dwSignalDimension,       // [In] Signal dimension
+    const IMTTEXTUREDESC& texture,  // [In] Texture to sample signal from
     FLOAT3* pfIMTArray);            // [Out] Result IMT
+
+// Internal API, build the summed-area table of the IMT of every texel along
+// texel rows, (uWidth + 1) * uHeight * IMT_DIM doubles. With it,
+// IMTFromTextureMapEx sums the texels entirely covered by a face in O(1) per
+// texel row instead of clipping them one by one.
+HRESULT WINAPI
+IMTBuildSummedAreaTable(
+    const IMTTEXTUREDESC& texture,  // [In] Texture, pSummedArea is ignored
+    size_t dwSignalDimension,       // [In] Signal dimension
+    size_t dwWorkerCount,           // [In] Number of threads building rows
+    double* pSummedArea);           // [Out] Summed-area table
     
 }
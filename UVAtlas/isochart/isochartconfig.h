@@ -49,6 +49,34 @@ const size_t MIN_LANDMARK_NUMBER = 25;
 // Using the geodesic distance to apply isomap.
 #define USING_COMBINED_DISTANCE_TO_PARAMETERIZE 0
 
+// Isomap only needs a few largest eigen pairs of the landmark matrix. When the
+// matrix has at least ISOMAP_ITERATIVE_EIGEN_MIN_DIMENSION rows, compute them by
+// Lanczos iteration instead of decomposing the whole matrix, which costs
+// O(n^3) time and O(n^2) memory. Set it to 0 to always decompose the whole matrix.
+const size_t ISOMAP_ITERATIVE_EIGEN_MIN_DIMENSION = 256;
+
+// Lanczos iteration stops when residual of each wanted eigen pair is less than
+// ISOMAP_ITERATIVE_EIGEN_TOLERANCE times the largest eigen value. If it doesn't
+// converge, the whole matrix is decomposed.
+const float ISOMAP_ITERATIVE_EIGEN_TOLERANCE = 1.0e-5f;
+
+// Barycentric parameterization of charts with at least 
+// BARYCENTRIC_DIRECT_SOLVER_MIN_DIMENSION interior vertices is solved by sparse
+// Cholesky factorization, which is shared by U and V. Smaller systems converge
+// quickly with conjugate gradient.
+const size_t BARYCENTRIC_DIRECT_SOLVER_MIN_DIMENSION = 1000;
+
+////////////////////////////////////////////////////////////////////
+//////////////////Batched Partition Configuration///////////////////////
+////////////////////////////////////////////////////////////////////
+
+// With _OPTION_ISOCHART_BATCH_SPLIT, each round splits
+// 1 + (1 - expected / current stretch) * BATCH_SPLIT_RATE * candidates
+// charts, at most BATCH_SPLIT_MAX_CHARTS. Far from the stretch criterion many
+// charts are split at once, close to it one at a time.
+const float BATCH_SPLIT_RATE = 0.25f;
+const size_t BATCH_SPLIT_MAX_CHARTS = 64;
+
 ////////////////////////////////////////////////////////////////////
 //////////////////IMT Configuration///////////////////////////////////
 ////////////////////////////////////////////////////////////////////
@@ -84,6 +112,11 @@ const size_t IMT_DIM = 6; // Piecewise linear imt
 // Don't check overlapping
 #define CHECK_OVER_LAPPING_BEFORE_OPT_INFINIT 1
 
+// Overlapping checks only test edges sharing cells of a uniform grid. The grid
+// is made coarser until each edge is in SEGMENT_GRID_MAX_CELLS_PER_SEGMENT
+// cells on average, so long edges don't take too much memory.
+const size_t SEGMENT_GRID_MAX_CELLS_PER_SEGMENT = 8;
+
 const float INFINITE_STRETCH = FLT_MAX;
 
 // 1 means :
@@ -12,10 +12,26 @@
 #include "isochartengine.h"
 #include "isochart.h"
 #include "isochartmesh.h"
+#include "workerpool.hpp"
+#include "isochartstats.hpp"
 
 using namespace DirectX;
 using namespace Isochart;
 
+namespace
+{
+    // A chart to be partitioned by a worker thread. path is the position of
+    // the chart in the partition tree: the order the root chart was taken
+    // from the current chart heap, followed by the child index at each level.
+    // Sorting parameterized charts by path makes the final chart list 
+    // independent of thread scheduling.
+    struct PARTITIONTASK
+    {
+        CIsochartMesh* pChart;
+        std::vector<uint32_t> path;
+    };
+}
+
 // Create instance of the class which implements the IIsochartEngine interface
 IIsochartEngine* IIsochartEngine::CreateIsochartEngine()
 {
@@ -139,6 +155,10 @@ HRESULT CIsochartEngine::Initialize(
         goto LEnd;
     }
 
+    // All threads except the calling one are spare before partitioning.
+    m_workerBudget.Reset(
+        GetIsochartWorkerCount(m_dwOptions, m_baseInfo.dwFaceCount) - 1);
+
     // 5. Internal initialization. Prepare the initial charts to be partitioned.
     if (FAILED(hr=ApplyInitEngine(
                     m_baseInfo, 
@@ -276,61 +296,19 @@ HRESULT CIsochartEngine::ParameterizeChartsInHeap(
     bool bFirstTime,
     size_t MaxChartNumber)
 {
-    // 3.1 If Any charts needed to be partitioned
-    while(!m_currentChartHeap.empty())
+    size_t dwWorkerCount = 
+        GetIsochartWorkerCount(m_dwOptions, m_baseInfo.dwFaceCount);
+    // 3.1 Partition charts needed to be partitioned. A single worker uses
+    // the same tasks, so the final chart list is in partition tree order for
+    // any worker count.
     {
-        DPF(1,"Processed charts number is : %zu", m_finalChartList.size()+m_currentChartHeap.size());
-        CIsochartMesh* pChart = m_currentChartHeap.cutTopData();
-        assert(pChart != 0);
-        _Analysis_assume_(pChart != 0);
-
-        // Process current chart, if it's needed to be partitioned again, 
-        // Just partition it.
-        HRESULT hr = pChart->Partition();
+        HRESULT hr = ParameterizeChartsInParallel(bFirstTime, dwWorkerCount);
         if (FAILED(hr))
         {
             return hr;
         }
-
-        // If current chart has been partitoned, just children add to heap to be
-        // processed later.
-        if (pChart->HasChildren())
-        {
-            if (FAILED(hr=AddChildrenToCurrentChartHeap(pChart)))
-            {
-                delete pChart;
-                return hr;
-            }
-            else
-            {
-                if (!pChart->IsInitChart())
-                {
-                    delete pChart;
-                }
-            }
-        }
-            
-        // If A right parameterization (with acceptable face overturn) 
-        // has been gotten, add current chart to final Chart List.
-        else 
-        {				
-            try
-            {
-                m_finalChartList.push_back(pChart);
-            }
-            catch (std::bad_alloc&)
-            {
-                delete pChart;
-                return E_OUTOFMEMORY;
-            }
-
-            if (bFirstTime)
-            {
-                if (FAILED(hr = m_callbackSchemer.UpdateCallbackAdapt(pChart->GetFaceNumber())))
-                    return hr;
-            }
-        }
-    }		
+        assert(m_currentChartHeap.empty());
+    }
 
     // 3.2 Update status
     if (bFirstTime)
@@ -357,6 +335,143 @@ HRESULT CIsochartEngine::ParameterizeChartsInHeap(
     return S_OK;	
 }
 
+// Partition all charts in current chart heap with dwWorkerCount threads. Each
+// Partition() is a task, children of a partitioned chart are spawned as new 
+// tasks. Charts need no more partition are appended to final chart list in
+// partition tree order.
+HRESULT CIsochartEngine::ParameterizeChartsInParallel(
+    bool bFirstTime,
+    size_t dwWorkerCount)
+{
+    DPF(1, "Partition %zu charts with %zu workers", m_currentChartHeap.size(), dwWorkerCount);
+
+    std::vector<PARTITIONTASK> tasks;
+    std::vector<PARTITIONTASK> finishedTasks;
+    std::vector<PARTITIONTASK> unfinishedTasks;
+    std::mutex finishedLock;
+
+    // Charts in returned tasks will be released by ReleaseCurrentCharts()
+    auto returnToHeap = [this](std::vector<PARTITIONTASK>& taskList)
+    {
+        for (auto& task : taskList)
+        {
+            if (!m_currentChartHeap.insertData(task.pChart, 0)
+                && !task.pChart->IsInitChart())
+            {
+                delete task.pChart;
+            }
+        }
+        taskList.clear();
+    };
+
+    // 1. Each chart in current heap is the root of a partition tree.
+    try
+    {
+        tasks.reserve(m_currentChartHeap.size());
+        while (!m_currentChartHeap.empty())
+        {
+            std::vector<uint32_t> path(1, static_cast<uint32_t>(tasks.size()));
+            tasks.push_back({ m_currentChartHeap.cutTopData(), std::move(path) });
+        }
+    }
+    catch (std::bad_alloc&)
+    {
+        returnToHeap(tasks);
+        return E_OUTOFMEMORY;
+    }
+
+    // 2. Partition charts. 
+    auto partitionChart = [&](size_t dwWorker, PARTITIONTASK& task, std::vector<PARTITIONTASK>& spawned) -> HRESULT
+    {
+        // The calling thread is not spare, other workers leave the budget
+        // while busy, so loops inside Partition() only use idle workers.
+        CWorkerLease lease(
+            m_workerBudget, (dwWorker != 0) ? m_workerBudget.Acquire(1) : 0);
+
+        CIsochartMesh* pChart = task.pChart;
+        HRESULT hr = pChart->Partition();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        // 2.1 Chart has been partitioned, children are new tasks.
+        if (pChart->HasChildren())
+        {
+            AddIsochartStatsCount(m_baseInfo.pStats, ISOCHART_COUNTER_CHARTS_SPLIT, 1);
+
+            std::vector<PARTITIONTASK> children;
+            try
+            {
+                children.reserve(pChart->GetChildrenCount());
+                for (uint32_t i = 0; i < pChart->GetChildrenCount(); i++)
+                {
+                    std::vector<uint32_t> path(task.path);
+                    path.push_back(i);
+                    children.push_back({ pChart->GetChild(i), std::move(path) });
+                }
+            }
+            catch (std::bad_alloc&)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            pChart->UnlinkAllChildren();
+            if (!pChart->IsInitChart())
+            {
+                delete pChart;
+            }
+            spawned.swap(children);
+            return S_OK;
+        }
+
+        // 2.2 A right parameterization has been gotten.
+        if (bFirstTime)
+        {
+            FAILURE_RETURN(
+                m_callbackSchemer.UpdateCallbackAdapt(pChart->GetFaceNumber()));
+        }
+
+        std::lock_guard<std::mutex> lock(finishedLock);
+        finishedTasks.push_back(std::move(task));
+        return S_OK;
+    };
+
+    HRESULT hr = RunWorkStealingTasks(
+        tasks,
+        dwWorkerCount,
+        partitionChart,
+        unfinishedTasks);
+
+    // 3. Add parameterized charts to final chart list in partition tree order.
+    std::sort(finishedTasks.begin(), finishedTasks.end(),
+        [](const PARTITIONTASK& a, const PARTITIONTASK& b)
+        {
+            return a.path < b.path;
+        });
+
+    try
+    {
+        m_finalChartList.reserve(m_finalChartList.size() + finishedTasks.size());
+    }
+    catch (std::bad_alloc&)
+    {
+        returnToHeap(finishedTasks);
+        returnToHeap(unfinishedTasks);
+        return E_OUTOFMEMORY;
+    }
+
+    for (auto& task : finishedTasks)
+    {
+        m_finalChartList.push_back(task.pChart);
+    }
+
+    // 4. On failure, charts not processed go back to heap to be released.
+    returnToHeap(unfinishedTasks);
+
+    return hr;
+}
+
 HRESULT CIsochartEngine::GenerateNewChartsToParameterize()
 {
     CIsochartMesh* pChartWithMaxL2Stretch  = nullptr;
@@ -388,6 +503,7 @@ HRESULT CIsochartEngine::GenerateNewChartsToParameterize()
     {
         if (pChartWithMaxL2Stretch->HasChildren())
         {
+            AddIsochartStatsCount(m_baseInfo.pStats, ISOCHART_COUNTER_CHARTS_SPLIT, 1);
             if (FAILED(
                 hr=AddChildrenToCurrentChartHeap(pChartWithMaxL2Stretch)))
             {
@@ -407,6 +523,151 @@ HRESULT CIsochartEngine::GenerateNewChartsToParameterize()
     return S_OK;
 }
 
+// Add charts of final chart list from dwFirstChart on to the candidates of 
+// batched split, keyed by the stretch GenerateNewChartsToParameterize() selects
+// charts by. Charts that can not be split further are not candidates.
+HRESULT CIsochartEngine::AddSplitCandidates(
+    CMaxHeap<float, CIsochartMesh*>& candidateHeap,
+    size_t dwFirstChart)
+{
+    for (size_t ii = dwFirstChart; ii < m_finalChartList.size(); ii++)
+    {
+        CIsochartMesh* pChart = m_finalChartList[ii];
+
+        float fStretch;
+        if (IsIMTSpecified())
+        {
+            if (IsInZeroRange(pChart->GetChart2DArea())
+                || IsInZeroRange(pChart->GetChart3DArea()))
+            {
+                continue;
+            }
+            fStretch = pChart->GetL2SquaredStretch() / pChart->GetChart3DArea();
+        }
+        else
+        {
+            if (pChart->GetL2SquaredStretch() == pChart->GetBaseL2SquaredStretch()
+                || pChart->GetFaceNumber() == 1)
+            {
+                continue;
+            }
+            fStretch = pChart->GetL2SquaredStretch();
+        }
+
+        if (!candidateHeap.insertData(pChart, fStretch))
+        {
+            return E_OUTOFMEMORY;
+        }
+    }
+    return S_OK;
+}
+
+// Split the dwSplitCount candidates with the largest stretch. Charts are
+// bipartitioned concurrently, then children are added to current chart heap
+// in the order the charts were taken from candidate heap, so result does not
+// depend on worker count.
+HRESULT CIsochartEngine::SplitLargestStretchCharts(
+    CMaxHeap<float, CIsochartMesh*>& candidateHeap,
+    size_t dwSplitCount)
+{
+    HRESULT hr = S_OK;
+
+    // 1. Take the candidates.
+    ISOCHARTMESH_ARRAY splitCharts;
+    try
+    {
+        splitCharts.reserve(dwSplitCount);
+        while (splitCharts.size() < dwSplitCount && !candidateHeap.empty())
+        {
+            splitCharts.push_back(candidateHeap.cutTopData());
+        }
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    DPF(1, "Split %zu charts of %zu", splitCharts.size(), m_finalChartList.size());
+
+    // 2. Bipartition. Loops inside Bipartition3D() only use the workers left.
+    {
+        CWorkerLease lease(
+            m_workerBudget,
+            m_workerBudget.TryAcquire(splitCharts.size() - 1));
+
+        FAILURE_RETURN(
+            ParallelFor(
+                splitCharts.size(),
+                lease.GetCount() + 1,
+                [&](size_t, size_t ii) -> HRESULT
+                {
+                    return splitCharts[ii]->Bipartition3D();
+                }));
+    }
+
+    // 3. Children replace the split charts. Final charts have no children
+    // except the ones just split. Charts not split stay final charts, but are
+    // no longer candidates.
+    m_finalChartList.erase(
+        std::remove_if(m_finalChartList.begin(), m_finalChartList.end(),
+            [](const CIsochartMesh* pChart)
+            {
+                return pChart->HasChildren();
+            }),
+        m_finalChartList.end());
+
+    for (size_t ii = 0; ii < splitCharts.size(); ii++)
+    {
+        CIsochartMesh* pChart = splitCharts[ii];
+        if (!pChart->HasChildren())
+        {
+            continue;
+        }
+
+        AddIsochartStatsCount(m_baseInfo.pStats, ISOCHART_COUNTER_CHARTS_SPLIT, 1);
+        if (FAILED(hr = AddChildrenToCurrentChartHeap(pChart)))
+        {
+            // Split charts are in no list anymore
+            for (size_t jj = ii; jj < splitCharts.size(); jj++)
+            {
+                if (splitCharts[jj]->HasChildren() && !splitCharts[jj]->IsInitChart())
+                {
+                    delete splitCharts[jj];
+                }
+            }
+            return hr;
+        }
+
+        if (!pChart->IsInitChart())
+        {
+            delete pChart;
+        }
+    }
+
+    return S_OK;
+}
+
+size_t CIsochartEngine::GetBatchSplitCount(
+    float fCurrAvgL2SquaredStretch,
+    size_t dwCandidateCount) const
+{
+    size_t dwSplitCount = 1;
+    if (fCurrAvgL2SquaredStretch > fExpectAvgL2SquaredStretch)
+    {
+        float fRemain = 1.0f - fExpectAvgL2SquaredStretch / fCurrAvgL2SquaredStretch;
+        dwSplitCount += static_cast<size_t>(
+            fRemain * BATCH_SPLIT_RATE * static_cast<float>(dwCandidateCount));
+    }
+    dwSplitCount = std::min(dwSplitCount, BATCH_SPLIT_MAX_CHARTS);
+
+    // Each split adds at least one chart, don't exceed the expected chart count
+    if (dwExpectChartCount > m_finalChartList.size())
+    {
+        dwSplitCount = std::min(dwSplitCount, dwExpectChartCount - m_finalChartList.size());
+    }
+    return dwSplitCount;
+}
+
 HRESULT CIsochartEngine::OptimizeParameterizedCharts(
     float Stretch,
     float& fFinalGeoAvgL2Stretch)
@@ -530,6 +791,7 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
     dwExpectChartCount = MaxChartNumber;
 
     // 3. Partition
+    CIsochartStageTimer partitionTimer(m_baseInfo.pStats, ISOCHART_STAGE_PARTITION);
     FAILURE_RETURN(InitializeCurrentChartHeap());
     float fCurrAvgL2SquaredStretch = INFINITE_STRETCH;
 
@@ -537,7 +799,17 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
 
     bool bCountParition = true;
     bool bHasSatisfiedNumber = false;
+    bool bDeadlinePassed = false;
     size_t dwLastChartNumber = 0;
+
+    // In batched mode, final charts that can still be split, and the number
+    // of final charts already optimized. Charts are only appended to final
+    // chart list, so the charts after dwOptimizedChartCount are new.
+    bool bBatchSplit = (m_dwOptions & _OPTION_ISOCHART_BATCH_SPLIT) != 0;
+    CMaxHeap<float, CIsochartMesh*> candidateHeap;
+    candidateHeap.SetManageMode(AUTOMATIC);
+    size_t dwOptimizedChartCount = 0;
+
     DPF(0, "Initial chart number %zu\n", m_currentChartHeap.size());
     do
     {
@@ -550,16 +822,45 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
 
         // 3.2 Optimize all charts with right parameterization
         // chart 2d area will be compted in this function
-        FAILURE_RETURN(
-        CIsochartMesh::OptimizeAllL2SquaredStretch(
-            m_finalChartList, 
-            false));
+        if (bBatchSplit)
+        {
+            ISOCHARTMESH_ARRAY newCharts;
+            try
+            {
+                newCharts.assign(
+                    m_finalChartList.cbegin() + static_cast<ptrdiff_t>(dwOptimizedChartCount),
+                    m_finalChartList.cend());
+            }
+            catch (std::bad_alloc&)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            FAILURE_RETURN(
+            CIsochartMesh::OptimizeAllL2SquaredStretch(
+                newCharts, 
+                false));
+        }
+        else
+        {
+            FAILURE_RETURN(
+            CIsochartMesh::OptimizeAllL2SquaredStretch(
+                m_finalChartList, 
+                false));
+        }
 
         // 3.3 
         // For geometric case, get current optical average L^2 Squared Stretch
         // For signal case, get max average L^2 Squared stretch around the 
         // Charts
         fCurrAvgL2SquaredStretch = GetCurrentStretchCriteria();
+
+        if (bBatchSplit)
+        {
+            FAILURE_RETURN(
+                AddSplitCandidates(candidateHeap, dwOptimizedChartCount));
+            dwOptimizedChartCount = m_finalChartList.size();
+        }
     
         if (dwExpectChartCount != 0)
         {
@@ -585,13 +886,31 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
 
          // 3.6 If we don't reach the expected stretch criteria,
          // Selete a canidate to parition and parameterize the children.
+         // After the deadline, keep the current charts instead.
         if (!CIsochartMesh::IsReachExpectedTotalAvgL2SqrStretch(
                 fCurrAvgL2SquaredStretch,
                 fExpectAvgL2SquaredStretch) 
             || m_finalChartList.size() < dwExpectChartCount)
         {
-            FAILURE_RETURN(
-                GenerateNewChartsToParameterize());
+            if (m_baseInfo.IsDeadlinePassed())
+            {
+                DPF(0, "Deadline passed, stop partitioning with %zu charts", m_finalChartList.size());
+                bDeadlinePassed = true;
+            }
+            else if (bBatchSplit && !candidateHeap.empty())
+            {
+                FAILURE_RETURN(
+                    SplitLargestStretchCharts(
+                        candidateHeap,
+                        GetBatchSplitCount(fCurrAvgL2SquaredStretch, candidateHeap.size())));
+                dwOptimizedChartCount = m_finalChartList.size();
+            }
+            else
+            {
+                FAILURE_RETURN(
+                    GenerateNewChartsToParameterize());
+                dwOptimizedChartCount = m_finalChartList.size();
+            }
         }
 
         // 3.7 Update status
@@ -608,6 +927,8 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
         FAILURE_RETURN(hr);
     }while(!m_currentChartHeap.empty());
 
+    partitionTimer.Stop();
+
     hr = m_callbackSchemer.FinishWorkAdapt();
     if ( FAILED(hr) )
         return hr;
@@ -619,12 +940,15 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
         dwLastChartNumber = m_finalChartList.size();
         m_callbackSchemer.InitCallBackAdapt((2 + m_finalChartList.size()), 0.20f, 0.80f);
 
-        if (FAILED(
+        {
+            CIsochartStageTimer timer(m_baseInfo.pStats, ISOCHART_STAGE_MERGE);
             hr = CIsochartMesh::MergeSmallCharts(
                     m_finalChartList,
                     dwExpectChartCount,
                     m_baseInfo,
-                    m_callbackSchemer)))
+                    m_callbackSchemer);
+        }
+        if (FAILED(hr))
         {
             return hr;
         }
@@ -636,8 +960,11 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
     }
 
     // 5. Optimize parameterized charts.
-    FAILURE_RETURN(
-        OptimizeParameterizedCharts(Stretch, fCurrAvgL2SquaredStretch));
+    {
+        CIsochartStageTimer timer(m_baseInfo.pStats, ISOCHART_STAGE_PARTITION);
+        FAILURE_RETURN(
+            OptimizeParameterizedCharts(Stretch, fCurrAvgL2SquaredStretch));
+    }
     
     // 6. Export current partition result by set the attribute id of each face 
     // in original mesh	
@@ -665,6 +992,12 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
         }
     }
 
+    // 7. Report that the stretch criterion was given up.
+    if (SUCCEEDED(hr) && bDeadlinePassed)
+    {
+        hr = S_FALSE;
+    }
+
     return hr;
 }
 
@@ -892,6 +1225,42 @@ HRESULT CIsochartEngine::SetStage(
 
 }
 
+HRESULT CIsochartEngine::SetStats(
+    CIsochartStats* pStats)
+{
+    HRESULT hr = S_OK;
+
+    // 1. Try to enter exclusive section
+    if (FAILED(hr = TryEnterExclusiveSection()))
+    {
+        return hr;
+    }
+
+    m_baseInfo.pStats = pStats;
+
+    LeaveExclusiveSection();
+
+    return hr;
+}
+
+HRESULT CIsochartEngine::SetDeadline(
+    std::chrono::steady_clock::time_point Deadline)
+{
+    HRESULT hr = S_OK;
+
+    // 1. Try to enter exclusive section
+    if (FAILED(hr = TryEnterExclusiveSection()))
+    {
+        return hr;
+    }
+
+    m_baseInfo.deadline = Deadline;
+
+    LeaveExclusiveSection();
+
+    return hr;
+}
+
 HRESULT CIsochartEngine::ExportPartitionResult(
     std::vector<UVAtlasVertex>* pvVertexArrayOut,
     std::vector<uint8_t>* pvFaceIndexArrayOut,
@@ -1120,8 +1489,7 @@ HRESULT CIsochartEngine::ApplyInitEngine(
         return hr;
     }
 
-    // 2. Separate unconnected charts from original mesh. For each chart, 
-    // Caculate Vertices importance
+    // 2. Separate unconnected charts from original mesh.
 
     m_callbackSchemer.InitCallBackAdapt(
         baseInfo.dwVertexCount*2+pRootChart->GetEdgeNumber(), 0.9f, 0.10f);
@@ -1170,8 +1538,6 @@ HRESULT CIsochartEngine::ApplyInitEngine(
         }
         else
         {
-            assert(pChart->IsImportanceCaculationDone()
-                || !bIsForPartition);
             try
             {
                 m_initChartList.push_back(pChart);
@@ -1186,6 +1552,26 @@ HRESULT CIsochartEngine::ApplyInitEngine(
         }
     }
 
+    // 3. Calculate vertex importance order of each initial chart. Charts
+    // partitioned or merged later inherit the order of their vertices, so
+    // each face is simplified only once. Initial charts share no vertex,
+    // their simplifications are independent.
+    if (bIsForPartition && !m_initChartList.empty())
+    {
+        CWorkerLease lease(
+            m_workerBudget,
+            m_workerBudget.TryAcquire(m_initChartList.size() - 1));
+
+        FAILURE_RETURN(
+            ParallelFor(
+                m_initChartList.size(),
+                lease.GetCount() + 1,
+                [&](size_t, size_t ii) -> HRESULT
+                {
+                    return m_initChartList[ii]->CalculateVertImportanceOrder();
+                }));
+    }
+
     DPF(3, "Old Vert Number is %zu, New Vert Number is %zu",
         baseInfo.dwVertexCount,
         dwTestVertexCount);
@@ -1712,7 +2098,11 @@ bool Isochart::CheckInitializeParameters(
     UNREFERENCED_PARAMETER(FaceCount);
     UNREFERENCED_PARAMETER(pIMTArray);
 
-    if ( (dwOptions & _OPTION_ISOCHART_GEODESIC_FAST) && (dwOptions & _OPTION_ISOCHART_GEODESIC_QUALITY) )
+    DWORD dwGeodesicOption = dwOptions & _OPTIONMASK_ISOCHART_GEODESIC ;
+    if ( dwGeodesicOption & (dwGeodesicOption - 1) )
+        return false ;
+
+    if ( (dwOptions & _OPTION_ISOCHART_SOLVER_ITERATIVE) && (dwOptions & _OPTION_ISOCHART_SOLVER_DIRECT) )
         return false ;
     
     // 1. Vertex buffer
@@ -14,6 +14,7 @@
 #include "basemeshinfo.h"
 #include "callbackschemer.h"
 #include "maxheap.hpp"
+#include "workerpool.hpp"
 
 
 namespace Isochart
@@ -67,6 +68,12 @@ public:
         unsigned int TotalStageCount,
         unsigned int DoneStageCount) override;
 
+    STDMETHODIMP SetStats(
+        CIsochartStats* pStats) override;
+
+    STDMETHODIMP SetDeadline(
+        std::chrono::steady_clock::time_point Deadline) override;
+
     STDMETHODIMP ExportPartitionResult(
         std::vector<DirectX::UVAtlasVertex>* pvVertexArrayOut,
         std::vector<uint8_t>* pvFaceIndexArrayOut,
@@ -128,8 +135,24 @@ private:
         bool bFirstTime,
         size_t MaxChartNumber);
 
+    HRESULT ParameterizeChartsInParallel(
+        bool bFirstTime,
+        size_t dwWorkerCount);
+
     HRESULT GenerateNewChartsToParameterize();
 
+    HRESULT AddSplitCandidates(
+        CMaxHeap<float, CIsochartMesh*>& candidateHeap,
+        size_t dwFirstChart);
+
+    HRESULT SplitLargestStretchCharts(
+        CMaxHeap<float, CIsochartMesh*>& candidateHeap,
+        size_t dwSplitCount);
+
+    size_t GetBatchSplitCount(
+        float fCurrAvgL2SquaredStretch,
+        size_t dwCandidateCount) const;
+
     HRESULT OptimizeParameterizedCharts(
         float Stretch,		
         float& fFinalGeoAvgL2Stretch);
@@ -242,6 +265,10 @@ private:
 
     DWORD m_dwOptions ;
 
+    // Worker threads not busy on partitioning charts, used by the parallel
+    // loops inside each chart.
+    mutable CWorkerBudget m_workerBudget;
+
     friend CIsochartMesh ;
  };
 
@@ -700,15 +700,11 @@ HRESULT CIsochartMesh::PrepareProcessing(
         return hr;
     }
 
+    // 2. Vertex importance of simple charts is calculated by the engine
+    // after all initial charts are prepared, see ApplyInitEngine()
     if (bIsForPartition)
     {
-        // 2. Calculate vertex importance in the simple chart
-        // using mesh simplify algorithm
-        if (SUCCEEDED(hr = CalculateVertImportanceOrder()))
-        {
-            m_bVertImportanceDone = true;
-            m_bIsInitChart = true;
-        }
+        m_bIsInitChart = true;
     }
 
     return hr;
@@ -1265,7 +1261,7 @@ HRESULT CIsochartMesh::IsomapParameterlization(
         goto LEnd;
     }
 
-    if (FAILED(hr = m_isoMap.ComputeLargestEigen(
+    if (FAILED(hr = ComputeIsoMapLargestEigen(
                         dwMaxEigenDimension,
                         dwCalculatedDimension)))
     {
@@ -1437,22 +1433,16 @@ void CIsochartMesh::ClearVerticesAdjacence()
     ISOCHARTVERTEX* pVertex = m_pVerts;
     for (size_t i=0; i<m_dwVertNumber; i++)
     {
-        pVertex->vertAdjacent.clear();
-        pVertex->edgeAdjacent.clear();
-        pVertex->faceAdjacent.clear();
+        pVertex->vertAdjacent = ISOCHARTADJACENCY();
+        pVertex->edgeAdjacent = ISOCHARTADJACENCY();
+        pVertex->faceAdjacent = ISOCHARTADJACENCY();
         pVertex++;
     }
-    return;
-}
 
-namespace
-{
-    // Internal structure Used in scanning all edges in a mesh.
-    struct EdgeTableItem
-    {
-        uint32_t dwPeerVert;
-        uint32_t dwEdgeIndex;
-    };
+    m_vertAdjacentIDs.clear();
+    m_faceAdjacentIDs.clear();
+    m_edgeAdjacentIDs.clear();
+    return;
 }
 
 //1. Find All Edges, specify the 3 edges of each face
@@ -1460,6 +1450,8 @@ namespace
 //(1) scan each face, check the 3 edges of each face
 //(2) if the edge is not in the edge table, create new edges and put it into edge table.
 //(3) to avoid put one edge twice, only store the edge whoes first vertex id is smaller than second
+// The adjacent faces and edges of all vertices are stored in two flat arrays,
+// each vertex gets a slice of them, so there is no allocation per vertex.
 
 // Note if  More than 2 faces share the same edge, it's a non-manifold mesh
 HRESULT CIsochartMesh::FindAllEdges(
@@ -1467,22 +1459,44 @@ HRESULT CIsochartMesh::FindAllEdges(
 {	
     ISOCHARTEDGE*  pEdge;
     ISOCHARTEDGE tempEdge;
-    EdgeTableItem tempEdgeTableItem;
 
     bIsManifold = false;
 
     m_dwEdgeNumber = 0;
     m_edges.clear();
 
-    std::unique_ptr<std::vector<EdgeTableItem>[]> pVertEdges( new (std::nothrow) std::vector<EdgeTableItem>[m_dwVertNumber] );
-    if ( !pVertEdges )
-    {
-        return E_OUTOFMEMORY;
-    }
-
     try
     {
+        // 1. Count adjacent faces of each vertex, then give each vertex its slice
+        m_faceAdjacentIDs.resize(m_dwFaceNumber * 3);
+
         ISOCHARTFACE* pTriangle = m_pFaces;
+        for (size_t i = 0; i<m_dwFaceNumber; i++)
+        {
+            for (size_t j=0; j<3; j++)
+            {
+                m_pVerts[pTriangle->dwVertexID[j]].faceAdjacent.dwCount++;
+            }
+            pTriangle++;
+        }
+
+        uint32_t* pFaceSlice = m_faceAdjacentIDs.data();
+        for (size_t i = 0; i<m_dwVertNumber; i++)
+        {
+            ISOCHARTADJACENCY& faceAdjacent = m_pVerts[i].faceAdjacent;
+            faceAdjacent.pIDs = pFaceSlice;
+            pFaceSlice += faceAdjacent.dwCount;
+            faceAdjacent.dwCount = 0;
+        }
+
+        // Edge table, the edges whose smaller vertex is v are linked from
+        // edgeTableHead[v] through edgeTableNext.
+        std::vector<uint32_t> edgeTableHead(m_dwVertNumber, INVALID_INDEX);
+        std::vector<uint32_t> edgeTableNext;
+        edgeTableNext.reserve(m_dwFaceNumber * 3 / 2 + 1);
+
+        // 2. Scan faces to find all edges.
+        pTriangle = m_pFaces;
         for (uint32_t i = 0; i<m_dwFaceNumber; i++)
         {
             uint32_t v1, v2;
@@ -1493,19 +1507,19 @@ HRESULT CIsochartMesh::FindAllEdges(
                 v1 = pTriangle->dwVertexID[j];
                 v2 = pTriangle->dwVertexID[(j+1)%3];
 
-                m_pVerts[v1].faceAdjacent.push_back(i);
+                ISOCHARTADJACENCY& faceAdjacent = m_pVerts[v1].faceAdjacent;
+                faceAdjacent.pIDs[faceAdjacent.dwCount++] = i;
                 if (v1 > v2)
                 {
                     std::swap(v1, v2);
                 }
 
-                auto& et = pVertEdges[v1];
-                size_t k;
-                for (k=0; k<et.size(); k++)
+                for (uint32_t k = edgeTableHead[v1]; k != INVALID_INDEX; k = edgeTableNext[k])
                 {
-                    if (et[k].dwPeerVert == v2)
+                    const ISOCHARTEDGE& edge = m_edges[k];
+                    if (std::max(edge.dwVertexID[0], edge.dwVertexID[1]) == v2)
                     {
-                        pEdge = &(m_edges[et[k].dwEdgeIndex]);
+                        pEdge = &(m_edges[k]);
                         break;
                     }
                 }
@@ -1523,9 +1537,8 @@ HRESULT CIsochartMesh::FindAllEdges(
 
                     m_edges.push_back(tempEdge);
                 
-                    tempEdgeTableItem.dwPeerVert = v2;
-                    tempEdgeTableItem.dwEdgeIndex = static_cast<uint32_t>(m_dwEdgeNumber);
-                    et.push_back(tempEdgeTableItem);
+                    edgeTableNext.push_back(edgeTableHead[v1]);
+                    edgeTableHead[v1] = static_cast<uint32_t>(m_dwEdgeNumber);
 
                     m_dwEdgeNumber++;
                     assert(m_dwEdgeNumber == m_edges.size());
@@ -1554,11 +1567,36 @@ HRESULT CIsochartMesh::FindAllEdges(
             pTriangle++;
         }
 
+        // 3. Adjacent edges of each vertex. Adjacent vertices are sorted into
+        // the same slices later, one for each edge.
+        m_edgeAdjacentIDs.resize(m_dwEdgeNumber * 2);
+        m_vertAdjacentIDs.resize(m_dwEdgeNumber * 2);
+
+        for (size_t i = 0; i < m_dwEdgeNumber; i++)
+        {
+            ISOCHARTEDGE &edge = m_edges[i];
+            m_pVerts[edge.dwVertexID[0]].edgeAdjacent.dwCount++;
+            m_pVerts[edge.dwVertexID[1]].edgeAdjacent.dwCount++;
+        }
+
+        size_t dwOffset = 0;
+        for (size_t i = 0; i<m_dwVertNumber; i++)
+        {
+            ISOCHARTVERTEX& vert = m_pVerts[i];
+            vert.edgeAdjacent.pIDs = m_edgeAdjacentIDs.data() + dwOffset;
+            vert.vertAdjacent.pIDs = m_vertAdjacentIDs.data() + dwOffset;
+            dwOffset += vert.edgeAdjacent.dwCount;
+            vert.edgeAdjacent.dwCount = 0;
+        }
+
         for (uint32_t i = 0; i < m_dwEdgeNumber; i++)
         {
             ISOCHARTEDGE &edge = m_edges[i];
-            m_pVerts[edge.dwVertexID[0]].edgeAdjacent.push_back(i);
-            m_pVerts[edge.dwVertexID[1]].edgeAdjacent.push_back(i);
+            for (size_t j = 0; j < 2; j++)
+            {
+                ISOCHARTADJACENCY& edgeAdjacent = m_pVerts[edge.dwVertexID[j]].edgeAdjacent;
+                edgeAdjacent.pIDs[edgeAdjacent.dwCount++] = i;
+            }
         }
     }
     catch (std::bad_alloc&)
@@ -1883,8 +1921,6 @@ HRESULT CIsochartMesh::SortAdjacentVertices(
                 continue;
             }
 
-            pVertex->vertAdjacent.reserve(dwEdgeNum);
-
             if (dwEdgeNum == dwFaceNum)// internal vertex
             {
                 bIsManifold = 
@@ -2045,7 +2081,7 @@ CIsochartMesh::SortAdjacentVerticesOfBoundaryVertex(
                 return false;
             }
 
-            pVertex->vertAdjacent.push_back(dwNextV);
+            pVertex->vertAdjacent.pIDs[pVertex->vertAdjacent.dwCount++] = dwNextV;
 
             if (pPreEdge)
             {
@@ -2127,7 +2163,7 @@ CIsochartMesh::SortAdjacentVerticesOfInternalVertex(
 
     try
     {
-        pVertex->vertAdjacent.push_back(dwNextV);
+        pVertex->vertAdjacent.pIDs[pVertex->vertAdjacent.dwCount++] = dwNextV;
 
         for (size_t j = 1; j < dwEdgeNum; j++)
         {
@@ -2201,7 +2237,7 @@ CIsochartMesh::SortAdjacentVerticesOfInternalVertex(
                 return false;
             }
 
-            pVertex->vertAdjacent.push_back(dwNextV);
+            pVertex->vertAdjacent.pIDs[pVertex->vertAdjacent.dwCount++] = dwNextV;
         }
     }
     catch (std::bad_alloc&)
@@ -3472,13 +3508,13 @@ HRESULT CIsochartMesh::CalculateVertImportanceOrder()
     DPF(3,"Calculate Importance order for each vertex...\n");
     HRESULT hr = S_OK;
     
+    m_bVertImportanceDone = true;
+
     if (m_dwFaceNumber == 0)
     {
         return S_OK;
     }
 
-    m_bVertImportanceDone = true;
-
     if (m_dwVertNumber < MIN_LANDMARK_NUMBER)
     {
         for (size_t i=0; i<m_dwVertNumber; i++)
@@ -3489,6 +3525,8 @@ HRESULT CIsochartMesh::CalculateVertImportanceOrder()
         return S_OK;
     }
 
+    CIsochartKernelTimer timer(m_baseInfo.pStats, ISOCHART_KERNEL_IMPORTANCE);
+
     CProgressiveMesh progressiveMesh(m_baseInfo, m_callbackSchemer);
 
     if (FAILED(hr = progressiveMesh.Initialize(*this)))
@@ -14,7 +14,9 @@
 #include "isochart.h"
 #include "isomap.h"
 #include "isochartengine.h"
+#include "isochartstats.hpp"
 #include "isochartutil.h"
+#include "segmentgrid.hpp"
 #include "sparsematrix.hpp"
 
 #include "geodesics/ExactOneToAll.h"
@@ -65,6 +67,22 @@ typedef std::vector<CIsochartMesh*> ISOCHARTMESH_ARRAY;
 ///////////////////////////////////////////////////////////////
 //////////Main Structures in CIsochartMesh/////////////////////////
 ///////////////////////////////////////////////////////////////
+
+// One vertex's slice of the adjacency arrays of its chart. The IDs are
+// stored in CSR form by CIsochartMesh::FindAllEdges and stay valid until
+// the chart's connection is rebuilt.
+struct ISOCHARTADJACENCY
+{
+    uint32_t* pIDs = nullptr;
+    uint32_t dwCount = 0;
+
+    size_t size() const { return dwCount; }
+    bool empty() const { return dwCount == 0; }
+    uint32_t& operator[](size_t i) const { assert(i < dwCount); return pIDs[i]; }
+    uint32_t* begin() const { return pIDs; }
+    uint32_t* end() const { return pIDs + dwCount; }
+};
+
 struct ISOCHARTVERTEX
 {
     uint32_t dwID;                  // Index in the vertex array of current mesh
@@ -73,20 +91,19 @@ struct ISOCHARTVERTEX
 
     DirectX::XMFLOAT2 uv;           //UV coordinate in texture map
 
-    bool bIsLandmark;               // Is this vertex a landmark
     uint32_t dwIndexInLandmarkList; // For landmark, indicate its index in landmark list
 
-    bool bIsBoundary;               // Is this vertex a boundary vertex
-
     int nImportanceOrder;           // Important order of this vertex
     float fGeodesicDistance;        //Using in Computing distance from this vertex to specified sourc
     float fDijikstraDistance;
-    float fSignalDistance;          // Signal distance
-
-    std::vector<uint32_t> vertAdjacent;// ID of vertices having edge between this vertex
-    std::vector<uint32_t> faceAdjacent;// ID of faces using this vertex
-    std::vector<uint32_t> edgeAdjacent;// ID of edges using this vertex
     uint32_t dwNextVertIDOnPath;    // The next vertex on the path to source.
+
+    bool bIsLandmark;               // Is this vertex a landmark
+    bool bIsBoundary;               // Is this vertex a boundary vertex
+
+    ISOCHARTADJACENCY vertAdjacent; // ID of vertices having edge between this vertex
+    ISOCHARTADJACENCY faceAdjacent; // ID of faces using this vertex
+    ISOCHARTADJACENCY edgeAdjacent; // ID of edges using this vertex
 };
 typedef std::vector<ISOCHARTVERTEX*> VERTEX_ARRAY;
 
@@ -116,6 +133,46 @@ struct ISOCHARTEDGE
 };
 typedef std::vector<ISOCHARTEDGE*> EDGE_ARRAY;
 
+// define the macro to 1 to use the exact algorithm, otherwise the fast approximate algorithm is employed
+#if _USE_EXACT_ALGORITHM
+typedef GeodesicDist::CExactOneToAll ONETOALLENGINE;
+#else
+typedef GeodesicDist::CApproximateOneToAll ONETOALLENGINE;
+#endif
+
+// Factorized linear equation sets of heat method geodesic distance. They only
+// depend on the chart, so they are built before the landmark distances are
+// computed and shared by all sources and workers.
+struct HEATGEODESICSOLVER
+{
+    CSparseCholeskySolver<double> heatFlow;     // M - t*Lc
+    CSparseCholeskySolver<double> poisson;      // -Lc + e*M
+};
+
+// Scratch buffers used to compute geodesic distance from one source vertex
+// to all vertices of a chart. Each thread owns a workspace, so distances
+// from several sources can be computed concurrently.
+struct GEODESICWORKSPACE
+{
+    std::unique_ptr<float[]> geodesicDistance;  // Geodesic distance to source, indexed by vertex ID
+    std::unique_ptr<float[]> signalDistance;    // Signal distance to source, indexed by vertex ID
+    std::unique_ptr<bool[]> vertProcessed;
+    std::unique_ptr<CMaxHeapItem<float, uint32_t>[]> heapItem;
+    CMaxHeap<float, uint32_t> heap;
+
+    // Only created when the new geodesic distance algorithm is used.
+    std::unique_ptr<ONETOALLENGINE> pOneToAllEngine;
+
+    // Only used when geodesic distance is computed by heat method.
+    const HEATGEODESICSOLVER* pHeatSolver;
+    CVector<double> heatSource;
+    CVector<double> heat;
+    CVector<double> divergence;
+    CVector<double> potential;
+
+    GEODESICWORKSPACE() : pHeatSolver(nullptr) {}
+};
+
 class CCallbackSchemer;
 class CIsoMap;
 
@@ -219,6 +276,8 @@ public:
     HRESULT PrepareProcessing(
         bool bIsForPartition);
 
+    HRESULT CalculateVertImportanceOrder();
+
     HRESULT Partition();
 
     HRESULT Bipartition3D();
@@ -494,12 +553,6 @@ private:
         uint32_t dwVertexID,
         std::vector<uint32_t>& dijkstraPath);
 
-    /////////////////////////////////////////////////////////////
-    ////////////////Calculatel Vertex Importance ////////////////////
-    /////////////////////////////////////////////////////////////
-
-    HRESULT CalculateVertImportanceOrder();
-
     /////////////////////////////////////////////////////////////
     ///////////////Isomap Processing Methods/////////////////////
     /////////////////////////////////////////////////////////////
@@ -526,8 +579,20 @@ private:
         std::vector<uint32_t>& vertList,
         const float* pfVertGeodesicDistance,
         float* pfGeodesicMatrix) const;
+
+    HRESULT ComputeIsoMapLargestEigen(
+        size_t dwSelectedDimension,
+        size_t& dwCalculatedDimension);
     
-    HRESULT InitOneToAllEngine() ;
+    bool IsNewGeodesicDistanceUsed(
+        bool bIsSignalDistance) const;
+
+    HRESULT InitOneToAllEngine(
+        ONETOALLENGINE& oneToAllEngine) const;
+
+    HRESULT InitGeodesicWorkspace(
+        GEODESICWORKSPACE& workspace,
+        bool bIsSignalDistance) const;
     
     HRESULT CalculateGeodesicDistance(
         std::vector<uint32_t>& vertList,
@@ -535,30 +600,45 @@ private:
         float* pfVertGeodesicDistance) const;
 
     void UpdateAdjacentVertexGeodistance(
-        ISOCHARTVERTEX* pCurrentVertex,
-        ISOCHARTVERTEX* pAdjacentVertex,
+        GEODESICWORKSPACE& workspace,
+        uint32_t dwCurrentVertID,
+        uint32_t dwAdjacentVertID,
         const ISOCHARTEDGE& edgeBetweenVertex,
-        bool* pbVertProcessed,
         bool bIsSignalDistance) const;
 
     HRESULT CalculateGeodesicDistanceToVertex(
+        GEODESICWORKSPACE& workspace,
         uint32_t dwSourceVertID,
         bool bIsSignalDistance,
         uint32_t* pdwFarestPeerVertID = nullptr) const;
 
     HRESULT CalculateGeodesicDistanceToVertexKS98(
+        GEODESICWORKSPACE& workspace,
         uint32_t dwSourceVertID,
         bool bIsSignalDistance,
         uint32_t* pdwFarestPeerVertID = nullptr) const;
     
     HRESULT CalculateGeodesicDistanceToVertexNewGeoDist(
+        GEODESICWORKSPACE& workspace,
         uint32_t dwSourceVertID,
-        uint32_t* pdwFarestPeerVertID = nullptr);
+        uint32_t* pdwFarestPeerVertID = nullptr) const;
+
+    bool IsHeatGeodesicDistanceUsed(
+        bool bIsSignalDistance) const;
+
+    HRESULT InitHeatGeodesicSolver(
+        std::unique_ptr<HEATGEODESICSOLVER>& pHeatSolver) const;
+
+    HRESULT CalculateGeodesicDistanceToVertexHeat(
+        GEODESICWORKSPACE& workspace,
+        uint32_t dwSourceVertID,
+        uint32_t* pdwFarestPeerVertID = nullptr) const;
 
     void CalculateGeodesicDistanceABC(
-        ISOCHARTVERTEX* pVertexA,
-        ISOCHARTVERTEX* pVertexB,
-        ISOCHARTVERTEX* pVertexC) const;
+        float* pfGeodesicDistance,
+        uint32_t dwVertIDA,
+        uint32_t dwVertIDB,
+        uint32_t dwVertIDC) const;
 
     void CombineGeodesicAndSignalDistance(
         float* pfSignalDistance,
@@ -1061,6 +1141,7 @@ private:
         ISOCHARTMESH_ARRAY& children,
         size_t dwExpectChartCount,
         size_t dwFaceNumber,
+        const CBaseMeshInfo& baseInfo,
         CCallbackSchemer& callbackSchemer);
 
     static void ReleaseAllNewCharts(
@@ -1080,6 +1161,18 @@ private:
         const CIsochartMesh* pChart2,
         CIsochartMesh** ppFinialChart);
 
+    static bool CanMergeSatisfyStretch(
+        const ISOCHARTMESH_ARRAY& chartList,
+        const CIsochartMesh* pChart1,
+        const CIsochartMesh* pChart2);
+
+    static HRESULT TryMergeAndParameterize(
+        ISOCHARTMESH_ARRAY& children,
+        const CIsochartMesh* pChart1,
+        const CIsochartMesh* pChart2,
+        CIsochartMesh** ppMergedChart,
+        bool& bTopoRejected);
+
     static HRESULT CollectSharedVerts(
         const CIsochartMesh* pChart1,
         const CIsochartMesh* pChart2,
@@ -1215,8 +1308,8 @@ private:
 
     HRESULT AddFaceWeight(
         uint32_t dwFaceID,
-        CSparseMatrix<double>& A,
-        CSparseMatrix<double>& M,
+        std::vector<CSparseMatrix<double>::Triplet>& A,
+        std::vector<CSparseMatrix<double>::Triplet>& M,
         uint32_t dwBaseVertId1,
         uint32_t dwBaseVertId2);
 
@@ -1284,6 +1377,12 @@ private:
     size_t m_dwEdgeNumber;
     std::vector<ISOCHARTEDGE> m_edges;
 
+    // Storage of ISOCHARTVERTEX::vertAdjacent, faceAdjacent and edgeAdjacent.
+    // vertAdjacent and edgeAdjacent of a vertex have the same offset and size.
+    std::vector<uint32_t> m_vertAdjacentIDs;
+    std::vector<uint32_t> m_faceAdjacentIDs;
+    std::vector<uint32_t> m_edgeAdjacentIDs;
+
     CIsochartMesh* m_pFather;// Indicating where the chart derives from
 
     float m_fBoxDiagLen;
@@ -1321,12 +1420,6 @@ private:
     bool m_bOrderedLandmark;
 
     bool m_bNeedToClean;
-
-    #if _USE_EXACT_ALGORITHM
-    GeodesicDist::CExactOneToAll m_ExactOneToAllEngine ;
-    #else
-    GeodesicDist::CApproximateOneToAll m_ApproximateOneToAllEngine ;
-    #endif
 };
 
 }
@@ -0,0 +1,240 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - isochartstats.hpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include "isochart.h"
+
+namespace Isochart
+{
+// Stages timed by wall time on the calling thread, in the order of the stage
+// time fields of DirectX::UVAtlasStats. Stages don't nest.
+enum ISOCHARTSTAGE
+{
+    ISOCHART_STAGE_INIT,
+    ISOCHART_STAGE_PARTITION,
+    ISOCHART_STAGE_MERGE,
+    ISOCHART_STAGE_PACK,
+    ISOCHART_STAGE_COUNT
+};
+
+// Kernels timed on the threads running them, in the order of the kernel time
+// fields of DirectX::UVAtlasStats. Kernels run inside stages.
+enum ISOCHARTKERNEL
+{
+    ISOCHART_KERNEL_IMPORTANCE,
+    ISOCHART_KERNEL_GEODESIC,
+    ISOCHART_KERNEL_EIGEN,
+    ISOCHART_KERNEL_STRETCH,
+    ISOCHART_KERNEL_COUNT
+};
+
+enum ISOCHARTCOUNTER
+{
+    ISOCHART_COUNTER_CHARTS_SPLIT,
+    ISOCHART_COUNTER_MERGE_ATTEMPTS,
+    ISOCHART_COUNTER_MERGE_FAILURES,
+    ISOCHART_COUNTER_MERGE_SIZE_REJECTS,
+    ISOCHART_COUNTER_MERGE_BOUND_REJECTS,
+    ISOCHART_COUNTER_MERGE_TOPO_REJECTS,
+    ISOCHART_COUNTER_CG_ITERATIONS,
+    ISOCHART_COUNTER_GEODESIC_RUNS,
+    ISOCHART_COUNTER_PACK_RESTARTS,
+    ISOCHART_COUNTER_COUNT
+};
+
+// Statistics collected while building an atlas. Every member can be updated
+// by several worker threads at once. Functions taking a CIsochartStats
+// pointer accept nullptr, then nothing is collected.
+class CIsochartStats
+{
+public:
+    CIsochartStats() : m_dwAllocatedBytes(0), m_dwPeakAllocatedBytes(0)
+    {
+        for (size_t i = 0; i < ISOCHART_STAGE_COUNT; i++)
+        {
+            m_stageTime[i] = 0;
+        }
+        for (size_t i = 0; i < ISOCHART_KERNEL_COUNT; i++)
+        {
+            m_kernelTime[i] = 0;
+        }
+        for (size_t i = 0; i < ISOCHART_COUNTER_COUNT; i++)
+        {
+            m_counter[i] = 0;
+        }
+    }
+
+    void AddTime(ISOCHARTSTAGE stage, std::chrono::steady_clock::duration elapsed)
+    {
+        m_stageTime[stage] += elapsed.count();
+    }
+
+    void AddTime(ISOCHARTKERNEL kernel, std::chrono::steady_clock::duration elapsed)
+    {
+        m_kernelTime[kernel] += elapsed.count();
+    }
+
+    void AddCount(ISOCHARTCOUNTER counter, size_t dwCount)
+    {
+        m_counter[counter] += dwCount;
+    }
+
+    void Allocate(size_t dwBytes)
+    {
+        size_t dwAllocated = (m_dwAllocatedBytes += dwBytes);
+        size_t dwPeak = m_dwPeakAllocatedBytes.load();
+        while (dwPeak < dwAllocated
+            && !m_dwPeakAllocatedBytes.compare_exchange_weak(dwPeak, dwAllocated))
+        {
+        }
+    }
+
+    void Release(size_t dwBytes)
+    {
+        m_dwAllocatedBytes -= dwBytes;
+    }
+
+    void Export(DirectX::UVAtlasStats& stats) const
+    {
+        double* pStageTimes[ISOCHART_STAGE_COUNT] =
+        {
+            &stats.initTime,
+            &stats.partitionTime,
+            &stats.mergeTime,
+            &stats.packTime
+        };
+        double* pKernelTimes[ISOCHART_KERNEL_COUNT] =
+        {
+            &stats.importanceCpuTime,
+            &stats.geodesicCpuTime,
+            &stats.eigenCpuTime,
+            &stats.stretchCpuTime
+        };
+        size_t* pCounters[ISOCHART_COUNTER_COUNT] =
+        {
+            &stats.chartsSplit,
+            &stats.mergeAttempts,
+            &stats.mergeFailures,
+            &stats.mergeSizeRejects,
+            &stats.mergeBoundRejects,
+            &stats.mergeTopoRejects,
+            &stats.cgIterations,
+            &stats.geodesicRuns,
+            &stats.packRestarts
+        };
+
+        for (size_t i = 0; i < ISOCHART_STAGE_COUNT; i++)
+        {
+            *pStageTimes[i] = std::chrono::duration<double>(
+                std::chrono::steady_clock::duration(m_stageTime[i].load())).count();
+        }
+        for (size_t i = 0; i < ISOCHART_KERNEL_COUNT; i++)
+        {
+            *pKernelTimes[i] = std::chrono::duration<double>(
+                std::chrono::steady_clock::duration(m_kernelTime[i].load())).count();
+        }
+        for (size_t i = 0; i < ISOCHART_COUNTER_COUNT; i++)
+        {
+            *pCounters[i] = m_counter[i].load();
+        }
+        stats.peakAllocatedBytes = m_dwPeakAllocatedBytes.load();
+    }
+
+private:
+    std::atomic<std::chrono::steady_clock::rep> m_stageTime[ISOCHART_STAGE_COUNT];
+    std::atomic<std::chrono::steady_clock::rep> m_kernelTime[ISOCHART_KERNEL_COUNT];
+    std::atomic<size_t> m_counter[ISOCHART_COUNTER_COUNT];
+    std::atomic<size_t> m_dwAllocatedBytes;
+    std::atomic<size_t> m_dwPeakAllocatedBytes;
+};
+
+inline void AddIsochartStatsCount(
+    CIsochartStats* pStats,
+    ISOCHARTCOUNTER counter,
+    size_t dwCount)
+{
+    if (pStats)
+    {
+        pStats->AddCount(counter, dwCount);
+    }
+}
+
+// Add the time spent in a scope to one stage or kernel. Stage timers are only
+// used on the calling thread, around scopes which don't overlap.
+template <class TTimed>
+class CIsochartTimer
+{
+public:
+    CIsochartTimer(CIsochartStats* pStats, TTimed timed)
+        : m_pStats(pStats), m_timed(timed)
+    {
+        if (m_pStats)
+        {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+    ~CIsochartTimer()
+    {
+        Stop();
+    }
+
+    // Add the time spent so far, the timer does nothing after.
+    void Stop()
+    {
+        if (m_pStats)
+        {
+            m_pStats->AddTime(m_timed, std::chrono::steady_clock::now() - m_start);
+            m_pStats = nullptr;
+        }
+    }
+
+private:
+    CIsochartTimer(const CIsochartTimer&) = delete;
+    CIsochartTimer& operator=(const CIsochartTimer&) = delete;
+
+    CIsochartStats* m_pStats;
+    TTimed m_timed;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+typedef CIsochartTimer<ISOCHARTSTAGE> CIsochartStageTimer;
+typedef CIsochartTimer<ISOCHARTKERNEL> CIsochartKernelTimer;
+
+// Count dwBytes as allocated while in scope. Only the large buffers, whose
+// size dominates memory use, are counted this way.
+class CIsochartStatsAllocation
+{
+public:
+    CIsochartStatsAllocation(CIsochartStats* pStats, size_t dwBytes)
+        : m_pStats(pStats), m_dwBytes(dwBytes)
+    {
+        if (m_pStats)
+        {
+            m_pStats->Allocate(m_dwBytes);
+        }
+    }
+    ~CIsochartStatsAllocation()
+    {
+        if (m_pStats)
+        {
+            m_pStats->Release(m_dwBytes);
+        }
+    }
+
+private:
+    CIsochartStatsAllocation(const CIsochartStatsAllocation&) = delete;
+    CIsochartStatsAllocation& operator=(const CIsochartStatsAllocation&) = delete;
+
+    CIsochartStats* m_pStats;
+    size_t m_dwBytes;
+};
+}
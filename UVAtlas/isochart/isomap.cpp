@@ -136,13 +136,6 @@ HRESULT CIsoMap::ComputeLargestEigen(
     assert(dwSelectedDimension <= m_dwMatrixDimension);
     _Analysis_assume_(dwSelectedDimension <= m_dwMatrixDimension);
 
-    std::unique_ptr<float[]> pfEigenValue( new (std::nothrow) float[m_dwMatrixDimension] );
-    std::unique_ptr<float[]> pfEigenVector( new (std::nothrow) float[m_dwMatrixDimension * m_dwMatrixDimension] );
-    if (!pfEigenValue || !pfEigenVector) 
-    {
-        return E_OUTOFMEMORY;
-    }
-    
     m_pfEigenValue = new (std::nothrow) float[dwSelectedDimension];
     m_pfEigenVector = new (std::nothrow) float[m_dwMatrixDimension * dwSelectedDimension];
 
@@ -151,19 +144,42 @@ HRESULT CIsoMap::ComputeLargestEigen(
         return E_OUTOFMEMORY;
     }
 
-    if (!CSymmetricMatrix<float>::GetEigen(
-        m_dwMatrixDimension, m_pfMatrixB, 
-        pfEigenValue.get(), pfEigenVector.get(), 
-        dwSelectedDimension))
+    // 1. For large matrix, only compute the selected eigen pairs.
+    bool bComputed = false;
+    if (ISOMAP_ITERATIVE_EIGEN_MIN_DIMENSION > 0
+        && m_dwMatrixDimension >= ISOMAP_ITERATIVE_EIGEN_MIN_DIMENSION)
     {
-        return E_OUTOFMEMORY;
+        bComputed = CSymmetricMatrix<float>::GetLargestEigen(
+            m_dwMatrixDimension, m_pfMatrixB,
+            m_pfEigenValue, m_pfEigenVector,
+            dwSelectedDimension,
+            ISOMAP_ITERATIVE_EIGEN_TOLERANCE);
     }
 
-    memcpy(m_pfEigenValue, pfEigenValue.get(), dwSelectedDimension * sizeof(float));
-    memcpy(
-        m_pfEigenVector, 
-        pfEigenVector.get(), 
-        m_dwMatrixDimension * dwSelectedDimension * sizeof(float));
+    // 2. Otherwise, decompose the whole matrix.
+    if (!bComputed)
+    {
+        std::unique_ptr<float[]> pfEigenValue( new (std::nothrow) float[m_dwMatrixDimension] );
+        std::unique_ptr<float[]> pfEigenVector( new (std::nothrow) float[m_dwMatrixDimension * m_dwMatrixDimension] );
+        if (!pfEigenValue || !pfEigenVector) 
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        if (!CSymmetricMatrix<float>::GetEigen(
+            m_dwMatrixDimension, m_pfMatrixB, 
+            pfEigenValue.get(), pfEigenVector.get(), 
+            dwSelectedDimension))
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        memcpy(m_pfEigenValue, pfEigenValue.get(), dwSelectedDimension * sizeof(float));
+        memcpy(
+            m_pfEigenVector, 
+            pfEigenVector.get(), 
+            m_dwMatrixDimension * dwSelectedDimension * sizeof(float));
+    }
 
     m_fSumOfEigenValue = 0;
     dwCalculatedDimension = 0;
@@ -40,6 +40,7 @@ namespace Isochart
         const float* GetEigenVector() const{ return m_pfEigenVector; }
         const float* GetAverageColumn() const{ return m_pfAvgSquaredDstColumn;}
         size_t GetCalculatedDimension() const{ return m_dwCalculatedDimension; }
+        size_t GetMatrixDimension() const{ return m_dwMatrixDimension; }
     private:
         size_t m_dwMatrixDimension;
         size_t  m_dwCalculatedDimension;
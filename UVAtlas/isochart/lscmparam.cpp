@@ -98,8 +98,8 @@ HRESULT CIsochartMesh::FindTwoFarestBoundaryVertices(
 //-------------------------------------------------------------------------------------
 HRESULT CIsochartMesh::AddFaceWeight(
     uint32_t dwFaceID,
-    CSparseMatrix<double>& A,
-    CSparseMatrix<double>& M,
+    std::vector<CSparseMatrix<double>::Triplet>& A,
+    std::vector<CSparseMatrix<double>::Triplet>& M,
     uint32_t dwBaseVertId1,
     uint32_t dwBaseVertId2)
 {
@@ -131,7 +131,7 @@ HRESULT CIsochartMesh::AddFaceWeight(
         return hr;
     }
 
-    CSparseMatrix<double>* pA = nullptr;
+    std::vector<CSparseMatrix<double>::Triplet>* pA = nullptr;
     for (size_t ii=0; ii<3; ii++)
     {
         ISOCHARTVERTEX& vert = m_pVerts[face.dwVertexID[ii]];
@@ -157,23 +157,17 @@ HRESULT CIsochartMesh::AddFaceWeight(
             pA = &A;
         }
 
-        if (!pA->setItem(dwFaceID, dwCol1, w_r/t))
+        try
         {
-            return E_OUTOFMEMORY;
+            pA->push_back(CSparseMatrix<double>::Triplet(dwFaceID, dwCol1, w_r/t));
+            pA->push_back(CSparseMatrix<double>::Triplet(dwFaceID, dwCol2, -w_i/t));
+            pA->push_back(CSparseMatrix<double>::Triplet(dwFaceID+m_dwFaceNumber, dwCol1, w_i/t));
+            pA->push_back(CSparseMatrix<double>::Triplet(dwFaceID+m_dwFaceNumber, dwCol2, w_r/t));
         }
-        if (!pA->setItem(dwFaceID, dwCol2, -w_i/t))
+        catch (std::bad_alloc&)
         {
             return E_OUTOFMEMORY;
         }
-
-        if (!pA->setItem(dwFaceID+m_dwFaceNumber, dwCol1, w_i/t))
-        {
-            return E_OUTOFMEMORY;
-        }		
-        if (!pA->setItem(dwFaceID+m_dwFaceNumber, dwCol2, w_r/t))
-        {
-            return E_OUTOFMEMORY;
-        }		
     }
     return hr;
 }
@@ -246,12 +240,14 @@ HRESULT CIsochartMesh::InitializeLSCMEquation(
     CSparseMatrix<double> orgA;
     CSparseMatrix<double> M;
     CVector<double> orgB;
+    std::vector<CSparseMatrix<double>::Triplet> orgATriplets;
+    std::vector<CSparseMatrix<double>::Triplet> MTriplets;
 
-    if (!orgA.resize(2*m_dwFaceNumber, (m_dwVertNumber-2)*2))
+    try
     {
-        return E_OUTOFMEMORY;
+        orgATriplets.reserve(12*m_dwFaceNumber);
     }
-    if (!M.resize(2*m_dwFaceNumber, 2*2))
+    catch (std::bad_alloc&)
     {
         return E_OUTOFMEMORY;
     }
@@ -259,7 +255,16 @@ HRESULT CIsochartMesh::InitializeLSCMEquation(
     for (uint32_t ii=0; ii<m_dwFaceNumber; ii++)
     {
         FAILURE_RETURN(
-            AddFaceWeight(ii, orgA, M, dwBaseVertId1, dwBaseVertId2));
+            AddFaceWeight(ii, orgATriplets, MTriplets, dwBaseVertId1, dwBaseVertId2));
+    }
+
+    if (!orgA.build(2*m_dwFaceNumber, (m_dwVertNumber-2)*2, orgATriplets))
+    {
+        return E_OUTOFMEMORY;
+    }
+    if (!M.build(2*m_dwFaceNumber, 2*2, MTriplets))
+    {
+        return E_OUTOFMEMORY;
     }
 
     // b = -M*u
@@ -330,6 +335,7 @@ HRESULT CIsochartMesh::LSCMParameterization(
     uint32_t dwBaseVertId1, dwBaseVertId2;
     CVector<double> U, X;
     CSparseMatrix<double> A;
+    CConjugateGradientSolver<double> solver;
     CVector<double> B;
     size_t nIterCount = 0;
 
@@ -354,14 +360,20 @@ HRESULT CIsochartMesh::LSCMParameterization(
             dwBaseVertId2));
 
     // 3. Solve the linear equation set
+    if (!solver.Init(A))
+    {
+        hr = E_OUTOFMEMORY;
+        goto LEnd;
+    }
+
     FAILURE_GOTO_END(
-        (false != CSparseMatrix<double>::ConjugateGradient(
+        (false != solver.Solve(
             X,
-            A,
             B,
             LSCM_MAX_ITERATION,
             static_cast<double>(1e-8),
             nIterCount) ? S_OK : E_FAIL));
+    AddIsochartStatsCount(m_baseInfo.pStats, ISOCHART_COUNTER_CG_ITERATIONS, nIterCount);
     if (nIterCount >= LSCM_MAX_ITERATION)
     {
         goto LEnd;
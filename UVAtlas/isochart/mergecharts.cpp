@@ -33,6 +33,14 @@ HRESULT CIsochartMesh::MergeSmallCharts(
     {
         return S_OK;
     }
+
+    // Merging only reduces the chart count, so it can be skipped once the
+    // deadline has passed unless a chart count was required.
+    if (dwExpectChartCount == 0 && baseInfo.IsDeadlinePassed())
+    {
+        DPF(0, "Deadline passed, skip merging charts");
+        return S_OK;
+    }
     HRESULT hr = S_OK;
 
     size_t dwFaceNumber = baseInfo.dwFaceCount;
@@ -62,6 +70,7 @@ HRESULT CIsochartMesh::MergeSmallCharts(
         children,
         dwExpectChartCount,
         dwFaceNumber,
+        baseInfo,
         callbackSchemer);
     if (FAILED(hr))
     {
@@ -187,6 +196,7 @@ HRESULT CIsochartMesh::PerformMerging(
     ISOCHARTMESH_ARRAY& children,
     size_t dwExpectChartCount,
     size_t dwFaceNumber,
+    const CBaseMeshInfo& baseInfo,
     CCallbackSchemer& callbackSchemer)
 {
     HRESULT hr = S_OK;
@@ -243,6 +253,13 @@ HRESULT CIsochartMesh::PerformMerging(
     // adjacent charts
     while(!heap.empty())
     {
+        // Charts not merged yet are kept as they are after the deadline
+        if (dwExpectChartCount == 0 && baseInfo.IsDeadlinePassed())
+        {
+            DPF(0, "Deadline passed, stop merging charts");
+            break;
+        }
+
         size_t dwDoneWork = dwLastReservedCharts - heap.size();
         if (0 == dwDoneWork)
         {
@@ -353,98 +370,173 @@ HRESULT CIsochartMesh::MergeAdjacentChart(
         }
     }
 
-    // 2 . Try to merge current chart to its adjacent charts.
-    uint32_t dwAdditionalChartID = INVALID_INDEX;
-
-    CIsochartMesh* pMergedChart = nullptr;
-    CIsochartMesh* pAddjacentChart = nullptr;
+    // 2. Collect the adjacent charts worth trying, in the order they are tried.
+    // Candidates are rejected by cheap tests first, only the remaining ones
+    // are merged and parameterized.
+    std::vector<uint32_t> candidates;
+    size_t dwSizeRejects = 0;
+    size_t dwBoundRejects = 0;
     size_t dwMaxFaceNumAfterMerging
         = std::max<size_t>(size_t(dwTotalFaceNumber * MAX_MERGE_RATIO),
         size_t(MAX_MERGE_FACE_NUMBER));
-
-    for (size_t i=0; i<dwAdjacentChartNumber; i++)
+    try
     {
-        uint32_t dwAdjacentChartID = adjacentChartList[i];
-
-        // 2.1. Don't try merage this chart, if its has failed to merage other charts
-        if (!pbMergeFlag[dwAdjacentChartID])
+        candidates.reserve(dwAdjacentChartNumber);
+        for (size_t i=0; i<dwAdjacentChartNumber; i++)
         {
-            continue;
-        }
+            uint32_t dwAdjacentChartID = adjacentChartList[i];
 
-        pAddjacentChart = children[dwAdjacentChartID];
-        if (!pAddjacentChart)
-        {
-            continue;
-        }
-        if (0 == pAddjacentChart->GetChart3DArea())
-        {
-            continue;
-        }
+            // 2.1. Don't try merage this chart, if its has failed to merage other charts
+            if (!pbMergeFlag[dwAdjacentChartID])
+            {
+                continue;
+            }
 
-        // 2.2. Don't try to get a very large chart
-        size_t dwMergedFaceNumber = pMainChart->GetFaceNumber() + pAddjacentChart->GetFaceNumber();
-        if (dwMergedFaceNumber > dwMaxFaceNumAfterMerging)
-        {
-            continue;
-        }
+            CIsochartMesh* pAddjacentChart = children[dwAdjacentChartID];
+            if (!pAddjacentChart)
+            {
+                continue;
+            }
+            if (0 == pAddjacentChart->GetChart3DArea())
+            {
+                continue;
+            }
 
-        // 2.3.  try to merge.
-        FAILURE_RETURN(
-            TryMergeChart(children, pMainChart, pAddjacentChart, &pMergedChart));
-        if (!pMergedChart)
-        {
-            continue;
-        }
+            // 2.2. Don't try to get a very large chart
+            size_t dwMergedFaceNumber = pMainChart->GetFaceNumber() + pAddjacentChart->GetFaceNumber();
+            if (dwMergedFaceNumber > dwMaxFaceNumAfterMerging)
+            {
+                dwSizeRejects++;
+                continue;
+            }
 
-        // 2.4 try to get right initial parameterization
-        bool bParameterSucceed = false;
-        if (FAILED(hr = pMergedChart->TryParameterize(bParameterSucceed)))
-        {
-            delete pMergedChart;
-            pMergedChart = nullptr;
-            return hr;
-        }
-        if (!bParameterSucceed)
-        {
-            delete pMergedChart;
-            pMergedChart = nullptr;
-            continue;
+            // 2.3. Don't try if the stretch can't be satisfied even without distortion
+            if (!CanMergeSatisfyStretch(children, pMainChart, pAddjacentChart))
+            {
+                dwBoundRejects++;
+                continue;
+            }
+
+            candidates.push_back(dwAdjacentChartID);
         }
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    // 3. Try to merge current chart to its adjacent charts. Merging with one
+    // candidate doesn't depend on the others, so when workers are idle, the
+    // following candidates are merged and parameterized speculatively at the
+    // same time. Results are checked in the original order and the first
+    // acceptable one is kept, so the result doesn't depend on worker count.
+    uint32_t dwAdditionalChartID = INVALID_INDEX;
+    CIsochartMesh* pMergedChart = nullptr;
+    size_t dwMergeAttempts = 0;
+    size_t dwTopoRejects = 0;
 
-        // 2.5 Check if the meraged chart also satisfied the stretch
-        bool bCanMerge = true;
-        if (FAILED(hr = CheckMerageResult(
-            children,
-            pMainChart,
-            pAddjacentChart,
-            pMergedChart,
-            bCanMerge)))
+    const CIsochartEngine& engine = pMainChart->m_IsochartEngine;
+    std::vector<CIsochartMesh*> batchCharts;
+    std::vector<uint8_t> batchTopoRejected;
+    size_t dwBatchStart = 0;
+    while (!pMergedChart && dwBatchStart < candidates.size())
+    {
+        size_t dwBatchSize = 0;
         {
-            delete pMergedChart;
-            pMergedChart = nullptr;
-            continue;
+            CWorkerLease lease(
+                engine.m_workerBudget,
+                engine.m_workerBudget.TryAcquire(candidates.size() - dwBatchStart - 1));
+            dwBatchSize = lease.GetCount() + 1;
+
+            try
+            {
+                batchCharts.assign(dwBatchSize, nullptr);
+                batchTopoRejected.assign(dwBatchSize, 0);
+            }
+            catch (std::bad_alloc&)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            // 3.1 Merge and parameterize the candidates of this batch
+            hr = ParallelFor(
+                dwBatchSize,
+                dwBatchSize,
+                [&](size_t, size_t ii) -> HRESULT
+                {
+                    bool bTopoRejected = false;
+                    HRESULT hrMerge = TryMergeAndParameterize(
+                        children,
+                        pMainChart,
+                        children[candidates[dwBatchStart + ii]],
+                        &batchCharts[ii],
+                        bTopoRejected);
+                    batchTopoRejected[ii] = bTopoRejected;
+                    return hrMerge;
+                });
         }
-        if (bCanMerge)
+        if (FAILED(hr))
         {
-            dwAdditionalChartID = dwAdjacentChartID;
-            break;
+            ReleaseAllNewCharts(batchCharts);
+            return hr;
         }
-        else
+
+        // 3.2 Check if the meraged chart also satisfied the stretch. Only
+        // candidates up to the accepted one are counted, as if they were
+        // tried one by one.
+        for (size_t ii = 0; ii < dwBatchSize && !pMergedChart; ii++)
         {
-            delete pMergedChart;
-            pMergedChart = nullptr;
+            dwMergeAttempts++;
+            if (batchTopoRejected[ii])
+            {
+                dwTopoRejects++;
+            }
+            if (!batchCharts[ii])
+            {
+                continue;
+            }
+
+            uint32_t dwAdjacentChartID = candidates[dwBatchStart + ii];
+            bool bCanMerge = false;
+            if (FAILED(hr = CheckMerageResult(
+                children,
+                pMainChart,
+                children[dwAdjacentChartID],
+                batchCharts[ii],
+                bCanMerge)))
+            {
+                ReleaseAllNewCharts(batchCharts);
+                return hr;
+            }
+            if (bCanMerge)
+            {
+                dwAdditionalChartID = dwAdjacentChartID;
+                pMergedChart = batchCharts[ii];
+                batchCharts[ii] = nullptr;
+            }
         }
+
+        // 3.3 Speculative results after the accepted one are not needed.
+        ReleaseAllNewCharts(batchCharts);
+        dwBatchStart += dwBatchSize;
     }
 
+    CIsochartStats* pStats = pMainChart->m_baseInfo.pStats;
+    AddIsochartStatsCount(pStats, ISOCHART_COUNTER_MERGE_SIZE_REJECTS, dwSizeRejects);
+    AddIsochartStatsCount(pStats, ISOCHART_COUNTER_MERGE_BOUND_REJECTS, dwBoundRejects);
+    AddIsochartStatsCount(pStats, ISOCHART_COUNTER_MERGE_TOPO_REJECTS, dwTopoRejects);
+    AddIsochartStatsCount(pStats, ISOCHART_COUNTER_MERGE_ATTEMPTS, dwMergeAttempts);
     if (!pMergedChart)
     {
+        AddIsochartStatsCount(pStats, ISOCHART_COUNTER_MERGE_FAILURES, dwMergeAttempts);
         pbMergeFlag[dwMainChartID] = false;
         bMerged = false;
         return S_OK;
     }
+    AddIsochartStatsCount(pStats, ISOCHART_COUNTER_MERGE_FAILURES, dwMergeAttempts - 1);
 
-    // 3. Adjust the adjacence of merged charts and other charts
+    // 4. Adjust the adjacence of merged charts and other charts
+    CIsochartMesh* pAddjacentChart = nullptr;
     for (size_t i=0; i<pMergedChart->m_adjacentChart.size(); i++)
     {
         pAddjacentChart = children[pMergedChart->m_adjacentChart[i]];
@@ -482,6 +574,113 @@ HRESULT CIsochartMesh::MergeAdjacentChart(
 }
 
 
+//-------------------------------------------------------------------------------------
+// Merge two charts, then parameterize and optimize the merged chart. The
+// merged chart is returned only if all steps succeed. bTopoRejected is set if
+// the merged chart isn't valid. Charts in children are not changed, so
+// candidates of one chart can be tried concurrently.
+HRESULT CIsochartMesh::TryMergeAndParameterize(
+    ISOCHARTMESH_ARRAY& children,
+    const CIsochartMesh* pChart1,
+    const CIsochartMesh* pChart2,
+    CIsochartMesh** ppMergedChart,
+    bool& bTopoRejected)
+{
+    assert(ppMergedChart != 0);
+    *ppMergedChart = nullptr;
+    bTopoRejected = false;
+
+    HRESULT hr = S_OK;
+    CIsochartMesh* pMergedChart = nullptr;
+
+    // 1. try to merge.
+    FAILURE_RETURN(
+        TryMergeChart(children, pChart1, pChart2, &pMergedChart));
+    if (!pMergedChart)
+    {
+        bTopoRejected = true;
+        return S_OK;
+    }
+
+    // 2. try to get right initial parameterization
+    bool bParameterSucceed = false;
+    if (FAILED(hr = pMergedChart->TryParameterize(bParameterSucceed)))
+    {
+        delete pMergedChart;
+        return hr;
+    }
+    if (!bParameterSucceed)
+    {
+        delete pMergedChart;
+        return S_OK;
+    }
+
+    // 3. Optimize stretch, the merged chart is given up if it fails
+    if (FAILED(pMergedChart->OptimizeChartL2Stretch(false)))
+    {
+        delete pMergedChart;
+        return S_OK;
+    }
+
+    *ppMergedChart = pMergedChart;
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Check if the stretch of all charts can satisfy the expected stretch after
+// merging pChart1 and pChart2, without parameterizing the merged chart.
+// For geometric stretch, each face has L2 squared stretch (s1^2+s2^2)/2 >= 
+// s1*s2 = 3D area / 2D area. By Cauchy-Schwarz, the chart's L2 stretch E and
+// 2D area a satisfy sqrt(E*a) >= 3D area, with equality if the chart is not
+// distorted. So if the stretch is too large with the 3D area of the merged
+// chart in place of sqrt(E*a), CheckMerageResult() would reject the merge.
+// Signal stretch has no such bound, then merging is always tried.
+bool CIsochartMesh::CanMergeSatisfyStretch(
+    const ISOCHARTMESH_ARRAY& chartList,
+    const CIsochartMesh* pChart1,
+    const CIsochartMesh* pChart2)
+{
+    if (pChart1->IsIMTSpecified())
+    {
+        return true;
+    }
+
+    // Same sum as CalOptimalAvgL2SquaredStretch()
+    const CBaseMeshInfo& baseInfo = pChart1->m_baseInfo;
+    bool bAllChartSatisfiedStretch = true;
+    float fSumSqrtEiiaii = 0;
+    for (size_t ii = 0; ii < chartList.size(); ii++)
+    {
+        const CIsochartMesh* pChart = chartList[ii];
+        if (!pChart || pChart == pChart1 || pChart == pChart2)
+        {
+            continue;
+        }
+
+        float fEii = pChart->m_fParamStretchL2;
+        float faii = pChart->m_fChart2DArea;
+        bAllChartSatisfiedStretch =
+            (bAllChartSatisfiedStretch && (fEii == faii));
+
+        fSumSqrtEiiaii += IsochartSqrtf(fEii * faii);
+    }
+
+    if (bAllChartSatisfiedStretch)
+    {
+        return true;
+    }
+
+    fSumSqrtEiiaii += pChart1->m_fChart3DArea + pChart2->m_fChart3DArea;
+    float fMinAvgStretch =
+        (fSumSqrtEiiaii/baseInfo.fMeshArea)*(fSumSqrtEiiaii/baseInfo.fMeshArea);
+
+    return IsReachExpectedTotalAvgL2SqrStretch(
+        fMinAvgStretch,
+        baseInfo.fExpectAvgL2SquaredStretch);
+}
+
+
 //-------------------------------------------------------------------------------------
 HRESULT CIsochartMesh::CheckMerageResult(
     ISOCHARTMESH_ARRAY &chartList,
@@ -491,13 +690,6 @@ HRESULT CIsochartMesh::CheckMerageResult(
     bool& bCanMerge)
 {
     assert(chartList.size() > 1);
-    HRESULT hr = S_OK;
-
-    if (FAILED(hr = pNewChart->OptimizeChartL2Stretch(false)))
-    {
-        delete pNewChart;
-        return hr;
-    }
 
     ISOCHARTMESH_ARRAY tempChartList;
     try
@@ -588,7 +780,7 @@ HRESULT CIsochartMesh::CalculateIsoParameterization()
         goto LEnd;
     }
 
-    if (FAILED(hr = m_isoMap.ComputeLargestEigen(2, dwCalculatedDimension)))
+    if (FAILED(hr = ComputeIsoMapLargestEigen(2, dwCalculatedDimension)))
     {
         goto LEnd;
     }
@@ -18,13 +18,6 @@ using namespace Isochart;
 using namespace GeodesicDist ;
 using namespace DirectX;
 
-// define the macro to 1 to use the exact algorithm, otherwise the fast approximate algorithm is employed    
-#if _USE_EXACT_ALGORITHM
-#define ONE_TO_ALL_ENGINE m_ExactOneToAllEngine
-#else
-#define ONE_TO_ALL_ENGINE m_ApproximateOneToAllEngine
-#endif
-
 namespace
 {
     // face number limit, below this limit, new geodesic algorithm is used, otherwise the old KS98 is used
@@ -137,22 +130,23 @@ HRESULT CIsochartMesh::CalculateLandmarkVertices(
 }
 
 // init structures used in CExactOneToAll or CApproximateOneToAll
-HRESULT CIsochartMesh::InitOneToAllEngine()
+HRESULT CIsochartMesh::InitOneToAllEngine(
+    ONETOALLENGINE& oneToAllEngine) const
 {
-    ONE_TO_ALL_ENGINE.m_VertexList.clear() ;
-    ONE_TO_ALL_ENGINE.m_EdgeList.clear() ;
-    ONE_TO_ALL_ENGINE.m_FaceList.clear() ;
+    oneToAllEngine.m_VertexList.clear() ;
+    oneToAllEngine.m_EdgeList.clear() ;
+    oneToAllEngine.m_FaceList.clear() ;
 
     try
     {
-        ONE_TO_ALL_ENGINE.m_VertexList.resize(m_dwVertNumber);
-        ONE_TO_ALL_ENGINE.m_EdgeList.resize(m_dwEdgeNumber);
-        ONE_TO_ALL_ENGINE.m_FaceList.resize(m_dwFaceNumber);
+        oneToAllEngine.m_VertexList.resize(m_dwVertNumber);
+        oneToAllEngine.m_EdgeList.resize(m_dwEdgeNumber);
+        oneToAllEngine.m_FaceList.resize(m_dwFaceNumber);
 
-        // init vertex list in ONE_TO_ALL_ENGINE
+        // init vertex list in oneToAllEngine
         for (size_t i = 0; i < m_dwVertNumber; ++i)
         {
-            Vertex &thisVertex = ONE_TO_ALL_ENGINE.m_VertexList[i];
+            Vertex &thisVertex = oneToAllEngine.m_VertexList[i];
 
             thisVertex.x = m_baseInfo.pVertPosition[m_pVerts[i].dwIDInRootMesh].x;
             thisVertex.y = m_baseInfo.pVertPosition[m_pVerts[i].dwIDInRootMesh].y;
@@ -160,20 +154,20 @@ HRESULT CIsochartMesh::InitOneToAllEngine()
             thisVertex.bBoundary = m_pVerts[i].bIsBoundary;
         }
 
-        // init edge list in ONE_TO_ALL_ENGINE
+        // init edge list in oneToAllEngine
         for (size_t i = 0; i < m_dwEdgeNumber; ++i)
         {
-            Edge &thisEdge = ONE_TO_ALL_ENGINE.m_EdgeList[i];
+            Edge &thisEdge = oneToAllEngine.m_EdgeList[i];
 
             thisEdge.dwVertexIdx0 = m_edges[i].dwVertexID[0];
-            thisEdge.pVertex0 = &ONE_TO_ALL_ENGINE.m_VertexList[thisEdge.dwVertexIdx0];
+            thisEdge.pVertex0 = &oneToAllEngine.m_VertexList[thisEdge.dwVertexIdx0];
             thisEdge.dwVertexIdx1 = m_edges[i].dwVertexID[1];
-            thisEdge.pVertex1 = &ONE_TO_ALL_ENGINE.m_VertexList[thisEdge.dwVertexIdx1];
+            thisEdge.pVertex1 = &oneToAllEngine.m_VertexList[thisEdge.dwVertexIdx1];
 
             thisEdge.dwAdjFaceIdx0 = m_edges[i].dwFaceID[0];
-            thisEdge.pAdjFace0 = &ONE_TO_ALL_ENGINE.m_FaceList[thisEdge.dwAdjFaceIdx0];
+            thisEdge.pAdjFace0 = &oneToAllEngine.m_FaceList[thisEdge.dwAdjFaceIdx0];
             thisEdge.dwAdjFaceIdx1 = m_edges[i].dwFaceID[1] == INVALID_FACE_ID ? FLAG_INVALIDDWORD : m_edges[i].dwFaceID[1];
-            thisEdge.pAdjFace1 = m_edges[i].dwFaceID[1] == INVALID_FACE_ID ? nullptr : &ONE_TO_ALL_ENGINE.m_FaceList[thisEdge.dwAdjFaceIdx1];
+            thisEdge.pAdjFace1 = m_edges[i].dwFaceID[1] == INVALID_FACE_ID ? nullptr : &oneToAllEngine.m_FaceList[thisEdge.dwAdjFaceIdx1];
 
             thisEdge.dEdgeLength = sqrt(SquredD3Dist(*thisEdge.pVertex0, *thisEdge.pVertex1));
 
@@ -181,24 +175,24 @@ HRESULT CIsochartMesh::InitOneToAllEngine()
             thisEdge.pVertex1->edgesAdj.push_back(&thisEdge);
         }
 
-        // init face list in ONE_TO_ALL_ENGINE
+        // init face list in oneToAllEngine
         for (size_t i = 0; i < m_dwFaceNumber; ++i)
         {
-            Face &thisFace = ONE_TO_ALL_ENGINE.m_FaceList[i];
+            Face &thisFace = oneToAllEngine.m_FaceList[i];
 
             thisFace.dwEdgeIdx0 = m_pFaces[i].dwEdgeID[0];
-            thisFace.pEdge0 = &ONE_TO_ALL_ENGINE.m_EdgeList[thisFace.dwEdgeIdx0];
+            thisFace.pEdge0 = &oneToAllEngine.m_EdgeList[thisFace.dwEdgeIdx0];
             thisFace.dwEdgeIdx1 = m_pFaces[i].dwEdgeID[1];
-            thisFace.pEdge1 = &ONE_TO_ALL_ENGINE.m_EdgeList[thisFace.dwEdgeIdx1];
+            thisFace.pEdge1 = &oneToAllEngine.m_EdgeList[thisFace.dwEdgeIdx1];
             thisFace.dwEdgeIdx2 = m_pFaces[i].dwEdgeID[2];
-            thisFace.pEdge2 = &ONE_TO_ALL_ENGINE.m_EdgeList[thisFace.dwEdgeIdx2];
+            thisFace.pEdge2 = &oneToAllEngine.m_EdgeList[thisFace.dwEdgeIdx2];
 
             thisFace.dwVertexIdx0 = m_pFaces[i].dwVertexID[0];
-            thisFace.pVertex0 = &ONE_TO_ALL_ENGINE.m_VertexList[thisFace.dwVertexIdx0];
+            thisFace.pVertex0 = &oneToAllEngine.m_VertexList[thisFace.dwVertexIdx0];
             thisFace.dwVertexIdx1 = m_pFaces[i].dwVertexID[1];
-            thisFace.pVertex1 = &ONE_TO_ALL_ENGINE.m_VertexList[thisFace.dwVertexIdx1];
+            thisFace.pVertex1 = &oneToAllEngine.m_VertexList[thisFace.dwVertexIdx1];
             thisFace.dwVertexIdx2 = m_pFaces[i].dwVertexID[2];
-            thisFace.pVertex2 = &ONE_TO_ALL_ENGINE.m_VertexList[thisFace.dwVertexIdx2];
+            thisFace.pVertex2 = &oneToAllEngine.m_VertexList[thisFace.dwVertexIdx2];
 
             thisFace.pVertex2->dAngle += ComputeAngleBetween2Lines(*thisFace.pVertex2, *thisFace.pVertex0, *thisFace.pVertex1);
             thisFace.pVertex1->dAngle += ComputeAngleBetween2Lines(*thisFace.pVertex1, *thisFace.pVertex0, *thisFace.pVertex2);
@@ -221,24 +215,11 @@ HRESULT CIsochartMesh::InitOneToAllEngine()
     return S_OK ;
 }
 
-// For each vertex in landmark list, compute geodesic distance from
-// this vertex to all other vertices in the same chart.
-HRESULT CIsochartMesh::CalculateGeodesicDistance(
-    std::vector<uint32_t>& vertList,
-    float* pfVertCombineDistance,
-    float* pfVertGeodesicDistance) const
+// Check whether the new geodesic distance algorithm is applied on this chart.
+bool CIsochartMesh::IsNewGeodesicDistanceUsed(
+    bool bIsSignalDistance) const
 {
-    if (vertList.empty())
-    {
-        return S_OK;
-    }
-    assert( !(!pfVertGeodesicDistance && !pfVertCombineDistance));
-
-    HRESULT hr = S_OK;
-    size_t dwVertLandNumber = static_cast<size_t>(vertList.size());
-    bool bIsSignalDistance = IsIMTSpecified();
-
-    if ( 
+    return
           (
              // if the geodesic algorithm selection field of the isochart option is DEFAULT, check whether suitable to apply the new algorithm
              (  
@@ -254,7 +235,7 @@ HRESULT CIsochartMesh::CalculateGeodesicDistance(
 
              // or the user forces to use the new algorithm 
              (
-                 m_IsochartEngine.m_dwOptions & _OPTION_ISOCHART_GEODESIC_QUALITY
+                 (m_IsochartEngine.m_dwOptions & _OPTION_ISOCHART_GEODESIC_QUALITY) != 0
              )
           ) 
           &&
@@ -264,62 +245,147 @@ HRESULT CIsochartMesh::CalculateGeodesicDistance(
               !bIsSignalDistance && 
               m_dwVertNumber > 0 && 
               m_dwFaceNumber > 0
-          )
-       )
+          );
+}
+
+// Allocate buffers to compute geodesic distance from one source vertex.
+HRESULT CIsochartMesh::InitGeodesicWorkspace(
+    GEODESICWORKSPACE& workspace,
+    bool bIsSignalDistance) const
+{
+    workspace.geodesicDistance.reset(new (std::nothrow) float[m_dwVertNumber]);
+    workspace.signalDistance.reset(new (std::nothrow) float[m_dwVertNumber]);
+    workspace.vertProcessed.reset(new (std::nothrow) bool[m_dwVertNumber]);
+    workspace.heapItem.reset(new (std::nothrow) CMaxHeapItem<float, uint32_t>[m_dwVertNumber]);
+    if (!workspace.geodesicDistance
+        || !workspace.signalDistance
+        || !workspace.vertProcessed
+        || !workspace.heapItem)
     {
-        const_cast<CIsochartMesh*>(this)->InitOneToAllEngine() ;
+        return E_OUTOFMEMORY;
     }
 
-    float* pfTempGeodesicDistance = nullptr;
-    if (!pfVertGeodesicDistance)
+    if (!workspace.heap.resize(m_dwVertNumber))
     {
-        pfTempGeodesicDistance = new (std::nothrow) float[dwVertLandNumber * m_dwVertNumber];
-        if (!pfTempGeodesicDistance)
-        {				
+        return E_OUTOFMEMORY;
+    }
+
+    if (IsNewGeodesicDistanceUsed(bIsSignalDistance))
+    {
+        workspace.pOneToAllEngine.reset(new (std::nothrow) ONETOALLENGINE);
+        if (!workspace.pOneToAllEngine)
+        {
             return E_OUTOFMEMORY;
         }
+        return InitOneToAllEngine(*workspace.pOneToAllEngine);
     }
-    else
+
+    return S_OK;
+}
+
+// For each vertex in landmark list, compute geodesic distance from
+// this vertex to all other vertices in the same chart.
+// Landmarks are processed concurrently by the spare workers of isochart
+// engine, each worker has its own workspace and fills the rows of its
+// landmarks, so the result doesn't depend on the worker count.
+HRESULT CIsochartMesh::CalculateGeodesicDistance(
+    std::vector<uint32_t>& vertList,
+    float* pfVertCombineDistance,
+    float* pfVertGeodesicDistance) const
+{
+    if (vertList.empty())
     {
-        pfTempGeodesicDistance = pfVertGeodesicDistance;
-    }	
+        return S_OK;
+    }
+    assert( !(!pfVertGeodesicDistance && !pfVertCombineDistance));
 
-    float *pCombineDistanceToOneLandmark = pfVertCombineDistance;
-    float *pGeodesicDstanceToOneLandmark = pfTempGeodesicDistance;
-    for (size_t i=0; i<dwVertLandNumber; i++)
+    HRESULT hr = S_OK;
+    size_t dwVertLandNumber = static_cast<size_t>(vertList.size());
+    bool bIsSignalDistance = IsIMTSpecified();
+    bool bCombineDistance = pfVertCombineDistance && bIsSignalDistance;
+
+    CIsochartKernelTimer timer(m_baseInfo.pStats, ISOCHART_KERNEL_GEODESIC);
+    CIsochartStatsAllocation allocation(
+        m_baseInfo.pStats,
+        dwVertLandNumber * m_dwVertNumber * sizeof(float) * (bCombineDistance ? 2 : 1));
+
+    std::unique_ptr<float[]> tempGeodesicDistance;
+    float* pfTempGeodesicDistance = pfVertGeodesicDistance;
+    if (!pfVertGeodesicDistance)
     {
-        if (FAILED(hr = CalculateGeodesicDistanceToVertex(
-                            vertList[i],
-                            bIsSignalDistance)))
+        tempGeodesicDistance.reset(new (std::nothrow) float[dwVertLandNumber * m_dwVertNumber]);
+        if (!tempGeodesicDistance)
         {
-            if (pfVertGeodesicDistance != pfTempGeodesicDistance)
-            {
-                delete []pfTempGeodesicDistance;
-            }		
-            return hr;
+            return E_OUTOFMEMORY;
         }
+        pfTempGeodesicDistance = tempGeodesicDistance.get();
+    }
+
+    // 1. Compute distance from each landmark. Workspaces are initialized by
+    // the worker using it, when it gets its first landmark. Heat method 
+    // solver is shared by all workers, so it is built before and released
+    // when all distances are computed.
+    std::unique_ptr<HEATGEODESICSOLVER> pHeatSolver;
+    if (IsHeatGeodesicDistanceUsed(bIsSignalDistance))
+    {
+        FAILURE_RETURN(InitHeatGeodesicSolver(pHeatSolver));
+    }
 
-        if (pfVertCombineDistance && bIsSignalDistance)
+    CWorkerLease lease(
+        m_IsochartEngine.m_workerBudget,
+        m_IsochartEngine.m_workerBudget.TryAcquire(dwVertLandNumber - 1));
+    size_t dwWorkerCount = lease.GetCount() + 1;
+
+    std::unique_ptr<GEODESICWORKSPACE[]> workspaces(
+        new (std::nothrow) GEODESICWORKSPACE[dwWorkerCount]);
+    if (!workspaces)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    hr = ParallelFor(
+        dwVertLandNumber,
+        dwWorkerCount,
+        [&](size_t dwWorker, size_t i) -> HRESULT
         {
-            for (size_t j=0; j<m_dwVertNumber; j++)
-            {				
-                pCombineDistanceToOneLandmark[j] = m_pVerts[j].fSignalDistance;
-                pGeodesicDstanceToOneLandmark[j] = m_pVerts[j].fGeodesicDistance;
+            HRESULT hr = S_OK;
+            GEODESICWORKSPACE& workspace = workspaces[dwWorker];
+            if (!workspace.geodesicDistance)
+            {
+                FAILURE_RETURN(
+                    InitGeodesicWorkspace(workspace, bIsSignalDistance));
+                workspace.pHeatSolver = pHeatSolver.get();
             }
-            pCombineDistanceToOneLandmark += m_dwVertNumber;
-            pGeodesicDstanceToOneLandmark += m_dwVertNumber;
-        }
-        else
-        {
-            for (size_t j=0; j<m_dwVertNumber; j++)
+
+            FAILURE_RETURN(
+                CalculateGeodesicDistanceToVertex(
+                    workspace,
+                    vertList[i],
+                    bIsSignalDistance));
+
+            memcpy(
+                pfTempGeodesicDistance + i*m_dwVertNumber,
+                workspace.geodesicDistance.get(),
+                sizeof(float)*m_dwVertNumber);
+
+            if (bCombineDistance)
             {
-                pGeodesicDstanceToOneLandmark[j] = m_pVerts[j].fGeodesicDistance;
+                memcpy(
+                    pfVertCombineDistance + i*m_dwVertNumber,
+                    workspace.signalDistance.get(),
+                    sizeof(float)*m_dwVertNumber);
             }
-            pGeodesicDstanceToOneLandmark += m_dwVertNumber;
-        }
+            return S_OK;
+        });
+    workspaces.reset();
+    pHeatSolver.reset();
+    if (FAILED(hr))
+    {
+        return hr;
     }
 
-    if (pfVertCombineDistance && bIsSignalDistance)
+    // 2. Combine the distances and make them symmetric between landmarks.
+    if (bCombineDistance)
     {
         CombineGeodesicAndSignalDistance(
             pfVertCombineDistance,
@@ -334,7 +400,7 @@ HRESULT CIsochartMesh::CalculateGeodesicDistance(
             uint32_t dwIndex1 = static_cast<uint32_t>( i*m_dwVertNumber + vertList[j]);
             uint32_t dwIndex2 = static_cast<uint32_t>( j*m_dwVertNumber + vertList[i]);
 
-            if (pfVertCombineDistance && bIsSignalDistance)
+            if (bCombineDistance)
             {
                 pfVertCombineDistance[dwIndex1]
                     = pfVertCombineDistance[dwIndex2]
@@ -354,11 +420,6 @@ HRESULT CIsochartMesh::CalculateGeodesicDistance(
         }
     }
 
-    if (pfVertGeodesicDistance != pfTempGeodesicDistance)
-    {	
-        delete []pfTempGeodesicDistance;
-    }
-    
     return S_OK;
 
 }
@@ -406,28 +467,28 @@ void CIsochartMesh::CombineGeodesicAndSignalDistance(
 }
 
 void CIsochartMesh::UpdateAdjacentVertexGeodistance(
-    ISOCHARTVERTEX* pCurrentVertex,
-    ISOCHARTVERTEX* pAdjacentVertex,
+    GEODESICWORKSPACE& workspace,
+    uint32_t dwCurrentVertID,
+    uint32_t dwAdjacentVertID,
     const ISOCHARTEDGE& edgeBetweenVertex,
-    bool* pbVertProcessed,
     bool bIsSignalDistance) const
 {
-    assert(pCurrentVertex != 0);
-    assert(pAdjacentVertex != 0);
-    assert(pbVertProcessed != 0);
+    float* pfGeodesicDistance = workspace.geodesicDistance.get();
+    float* pfSignalDistance = workspace.signalDistance.get();
+    const bool* pbVertProcessed = workspace.vertProcessed.get();
 
-    if (pAdjacentVertex->fGeodesicDistance
-        > (pCurrentVertex->fGeodesicDistance 
+    if (pfGeodesicDistance[dwAdjacentVertID]
+        > (pfGeodesicDistance[dwCurrentVertID] 
             + edgeBetweenVertex.fLength))
     {
-        pAdjacentVertex->fGeodesicDistance = 
-                (pCurrentVertex->fGeodesicDistance 
+        pfGeodesicDistance[dwAdjacentVertID] = 
+                (pfGeodesicDistance[dwCurrentVertID] 
                 + edgeBetweenVertex.fLength);
 
         if (bIsSignalDistance)
         {
-            pAdjacentVertex->fSignalDistance = 
-                pCurrentVertex->fSignalDistance
+            pfSignalDistance[dwAdjacentVertID] = 
+                pfSignalDistance[dwCurrentVertID]
                 + edgeBetweenVertex.fSignalLength;
         }
 
@@ -443,99 +504,93 @@ void CIsochartMesh::UpdateAdjacentVertexGeodistance(
 
         assert(!(k == 1 && edgeBetweenVertex.bIsBoundary));
 
-        ISOCHARTVERTEX* pOppositeVertex = m_pVerts + edgeBetweenVertex.dwOppositVertID[k];
+        uint32_t dwOppositeVertID = edgeBetweenVertex.dwOppositVertID[k];
 
-        if (pbVertProcessed[pOppositeVertex->dwID])
+        if (pbVertProcessed[dwOppositeVertID])
         {
-            if (pOppositeVertex->fGeodesicDistance >
-                pCurrentVertex->fGeodesicDistance)
+            if (pfGeodesicDistance[dwOppositeVertID] >
+                pfGeodesicDistance[dwCurrentVertID])
             {
                 CalculateGeodesicDistanceABC(
-                    pCurrentVertex,
-                    pOppositeVertex,
-                    pAdjacentVertex);
+                    pfGeodesicDistance,
+                    dwCurrentVertID,
+                    dwOppositeVertID,
+                    dwAdjacentVertID);
             }
             else
             {
                 CalculateGeodesicDistanceABC(
-                    pOppositeVertex,
-                    pCurrentVertex,	
-                    pAdjacentVertex);
+                    pfGeodesicDistance,
+                    dwOppositeVertID,
+                    dwCurrentVertID,	
+                    dwAdjacentVertID);
             }
         }
     }
 }
 
+// Compute geodesic distance from source vertex to all vertices of the chart,
+// result is stored in workspace.
 HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertex(
+    GEODESICWORKSPACE& workspace,
     uint32_t dwSourceVertID,
     bool bIsSignalDistance,
     uint32_t* pdwFarestPeerVertID) const
 {
+    AddIsochartStatsCount(m_baseInfo.pStats, ISOCHART_COUNTER_GEODESIC_RUNS, 1);
+
+    // Heat method replaces [KS98]. Without solver, chart can't be
+    // factorized and [KS98] distance is used.
+    if ( workspace.pHeatSolver && IsHeatGeodesicDistanceUsed(bIsSignalDistance) )
+    {
+        return CalculateGeodesicDistanceToVertexHeat( workspace, dwSourceVertID, pdwFarestPeerVertID ) ;
+    }
+
     HRESULT hr = 
-        CalculateGeodesicDistanceToVertexKS98( dwSourceVertID, bIsSignalDistance, pdwFarestPeerVertID ) ;
+        CalculateGeodesicDistanceToVertexKS98( workspace, dwSourceVertID, bIsSignalDistance, pdwFarestPeerVertID ) ;
     if ( FAILED(hr) )
         return hr ;
 
-    if ( 
-          (
-             // if the geodesic algorithm selection field of the isochart option is DEFAULT, check whether suitable to apply the new algorithm
-             (  
-                 (  
-                     (m_IsochartEngine.m_dwOptions & _OPTIONMASK_ISOCHART_GEODESIC) 
-                     == 
-                     (_OPTION_ISOCHART_DEFAULT & _OPTIONMASK_ISOCHART_GEODESIC)
-                 )
-                 &&
-                 (m_baseInfo.dwFaceCount < LIMIT_FACENUM_USENEWGEODIST)
-             ) 
-             ||
-
-             // or the user forces to use the new algorithm 
-             (
-                 m_IsochartEngine.m_dwOptions & _OPTION_ISOCHART_GEODESIC_QUALITY
-             )
-          ) 
-          &&
-          
-          // anyway, if IMT is specified, use the old geodesic distance algorithm, because currently the new geodesic distance algorithm does not support IMT
-          (          
-              !bIsSignalDistance && 
-              m_dwVertNumber > 0 && 
-              m_dwFaceNumber > 0
-          )
-       )
+    if ( IsNewGeodesicDistanceUsed(bIsSignalDistance) )
     {
-        hr = const_cast<CIsochartMesh*>(this)->CalculateGeodesicDistanceToVertexNewGeoDist( dwSourceVertID, pdwFarestPeerVertID ) ;
+        hr = CalculateGeodesicDistanceToVertexNewGeoDist( workspace, dwSourceVertID, pdwFarestPeerVertID ) ;
     }
 
     return hr ;
 }
 
 HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexNewGeoDist(
+    GEODESICWORKSPACE& workspace,
     uint32_t dwSourceVertID,
-    uint32_t* pdwFarestPeerVertID)
+    uint32_t* pdwFarestPeerVertID) const
 {
+    assert(workspace.pOneToAllEngine);
+    ONETOALLENGINE& oneToAllEngine = *workspace.pOneToAllEngine;
+
     try
     {
-        ONE_TO_ALL_ENGINE.SetSrcVertexIdx( dwSourceVertID ) ;    
-        ONE_TO_ALL_ENGINE.Run() ;
+        oneToAllEngine.SetSrcVertexIdx( dwSourceVertID ) ;    
+        oneToAllEngine.Run() ;
     }
     catch (std::bad_alloc&)
     {
         return E_OUTOFMEMORY;
     }
 
+    float* pfGeodesicDistance = workspace.geodesicDistance.get();
+    float* pfSignalDistance = workspace.signalDistance.get();
+
     uint32_t dwFarestVertID = 0;
     double dGeoFarest = 0.0 ;
     for (uint32_t i = 0; i < m_dwVertNumber; ++i)
     {
-        m_pVerts[i].fGeodesicDistance = m_pVerts[i].fSignalDistance = 
-            std::min(m_pVerts[i].fGeodesicDistance,
-                 (float)ONE_TO_ALL_ENGINE.m_VertexList[i].dGeoDistanceToSrc ) ;
+        pfGeodesicDistance[i] = pfSignalDistance[i] = 
+            std::min(pfGeodesicDistance[i],
+                 (float)oneToAllEngine.m_VertexList[i].dGeoDistanceToSrc ) ;
 
-        if ( m_pVerts[i].fGeodesicDistance > dGeoFarest )
+        if ( pfGeodesicDistance[i] > dGeoFarest )
         {
-            dGeoFarest = m_pVerts[i].fGeodesicDistance ;
+            dGeoFarest = pfGeodesicDistance[i] ;
             dwFarestVertID = i ;
         }
     }
@@ -550,42 +605,36 @@ HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexNewGeoDist(
 
 // See more detail in [KS98]
 HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
+    GEODESICWORKSPACE& workspace,
     uint32_t dwSourceVertID,
     bool bIsSignalDistance,
     uint32_t* pdwFarestPeerVertID) const
 {
     uint32_t dwFarestVertID = 0;
 
-    std::unique_ptr<bool[]> pbVertProcessed( new (std::nothrow) bool[m_dwVertNumber] );
-    std::unique_ptr<CMaxHeapItem<float, uint32_t> []> heapItem(new (std::nothrow) CMaxHeapItem<float, uint32_t>[m_dwVertNumber]);
-    if (!pbVertProcessed || !heapItem)
-    {
-        return E_OUTOFMEMORY;
-    }
-    memset(pbVertProcessed.get(), 0, sizeof(bool) * m_dwVertNumber);
+    float* pfGeodesicDistance = workspace.geodesicDistance.get();
+    float* pfSignalDistance = workspace.signalDistance.get();
+    bool* pbVertProcessed = workspace.vertProcessed.get();
+    auto pHeapItem = workspace.heapItem.get();
+    CMaxHeap<float, uint32_t>& heap = workspace.heap;
 
-    CMaxHeap<float, uint32_t> heap;
-    if (!heap.resize(m_dwVertNumber))
+    // Items are only left in heap when the last computation failed.
+    while (heap.cutTop())
     {
-        return E_OUTOFMEMORY;
     }
-
-    auto pHeapItem = heapItem.get();
+    memset(pbVertProcessed, 0, sizeof(bool) * m_dwVertNumber);
 
     // 1. Init the distance to source of each vertex
-    ISOCHARTVERTEX* pCurrentVertex = m_pVerts;
     for (size_t i=0; i<m_dwVertNumber; i++)
     {
-        pCurrentVertex->fGeodesicDistance = FLT_MAX;
-        pCurrentVertex->fSignalDistance = FLT_MAX;
-        pCurrentVertex++;
+        pfGeodesicDistance[i] = FLT_MAX;
+        pfSignalDistance[i] = FLT_MAX;
     }
 
     // 2. Init the source vertices
-    pCurrentVertex = m_pVerts + dwSourceVertID;
     pbVertProcessed[dwSourceVertID] = true;
-    pCurrentVertex->fGeodesicDistance = 0;
-    pCurrentVertex->fSignalDistance = 0;
+    pfGeodesicDistance[dwSourceVertID] = 0;
+    pfSignalDistance[dwSourceVertID] = 0;
 
     // 3. Init heap to prepare process of iteration.
     pHeapItem[dwSourceVertID].m_data = dwSourceVertID;
@@ -609,7 +658,7 @@ HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
             break;
         }
 
-        pCurrentVertex = m_pVerts + pTop->m_data;
+        const ISOCHARTVERTEX* pCurrentVertex = m_pVerts + pTop->m_data;
         pbVertProcessed[pCurrentVertex->dwID] = true;
         dwFarestVertID = pCurrentVertex->dwID;
 
@@ -634,11 +683,9 @@ HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
                 continue;
             }
 
-            ISOCHARTVERTEX* pAdjacentVertex = m_pVerts + dwAdjacentVertID;
-
             UpdateAdjacentVertexGeodistance(
-                pCurrentVertex, pAdjacentVertex,
-                edge, pbVertProcessed.get(), bIsSignalDistance);
+                workspace, pCurrentVertex->dwID, dwAdjacentVertID,
+                edge, bIsSignalDistance);
 
         }
 
@@ -651,17 +698,16 @@ HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
                 continue;
             }
 
-            ISOCHARTVERTEX* pAdjacentVertex = m_pVerts + dwAdjacentID;
             if (pHeapItem[dwAdjacentID].isItemInHeap())
             {
                 heap.update(pHeapItem+dwAdjacentID,
-                    -pAdjacentVertex->fGeodesicDistance);
+                    -pfGeodesicDistance[dwAdjacentID]);
             }
             else
             {
                 pHeapItem[dwAdjacentID].m_data = dwAdjacentID;
                 pHeapItem[dwAdjacentID].m_weight =
-                    -pAdjacentVertex->fGeodesicDistance;
+                    -pfGeodesicDistance[dwAdjacentID];
                 if (!heap.insert(pHeapItem+dwAdjacentID))
                 {
                     return E_OUTOFMEMORY;
@@ -679,17 +725,18 @@ HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
 }
 
 void CIsochartMesh::CalculateGeodesicDistanceABC(
-    ISOCHARTVERTEX* pVertexA,
-    ISOCHARTVERTEX* pVertexB,
-    ISOCHARTVERTEX* pVertexC) const
+    float* pfGeodesicDistance,
+    uint32_t dwVertIDA,
+    uint32_t dwVertIDB,
+    uint32_t dwVertIDC) const
 {
     XMVECTOR v[3];
-    float u = pVertexB->fGeodesicDistance - pVertexA->fGeodesicDistance;
-    v[0] = XMLoadFloat3(m_baseInfo.pVertPosition + pVertexB->dwIDInRootMesh)
-        - XMLoadFloat3(m_baseInfo.pVertPosition + pVertexC->dwIDInRootMesh);
+    float u = pfGeodesicDistance[dwVertIDB] - pfGeodesicDistance[dwVertIDA];
+    v[0] = XMLoadFloat3(m_baseInfo.pVertPosition + m_pVerts[dwVertIDB].dwIDInRootMesh)
+        - XMLoadFloat3(m_baseInfo.pVertPosition + m_pVerts[dwVertIDC].dwIDInRootMesh);
 
-    v[1] = XMLoadFloat3(m_baseInfo.pVertPosition + pVertexA->dwIDInRootMesh)
-        - XMLoadFloat3(m_baseInfo.pVertPosition + pVertexC->dwIDInRootMesh);
+    v[1] = XMLoadFloat3(m_baseInfo.pVertPosition + m_pVerts[dwVertIDA].dwIDInRootMesh)
+        - XMLoadFloat3(m_baseInfo.pVertPosition + m_pVerts[dwVertIDC].dwIDInRootMesh);
 
     float a = XMVectorGetX(XMVector3Length(v[0]));
     float b = XMVectorGetX(XMVector3Length(v[1]));
@@ -734,9 +781,9 @@ void CIsochartMesh::CalculateGeodesicDistanceABC(
         return;
     }
 
-    if (pVertexC->fGeodesicDistance > pVertexA->fGeodesicDistance + t)
+    if (pfGeodesicDistance[dwVertIDC] > pfGeodesicDistance[dwVertIDA] + t)
     {
-        pVertexC->fGeodesicDistance = pVertexA->fGeodesicDistance + t;
+        pfGeodesicDistance[dwVertIDC] = pfGeodesicDistance[dwVertIDA] + t;
     }
 
 
@@ -781,6 +828,25 @@ void CIsochartMesh::CalculateGeodesicMatrix(
     return;
 }
 
+// Compute the largest eigen pairs of the matrix m_isoMap is initialized with.
+// The matrix and the eigen vectors of the whole decomposition are counted in
+// the statistics, they are the largest buffers of isomap.
+HRESULT CIsochartMesh::ComputeIsoMapLargestEigen(
+    size_t dwSelectedDimension,
+    size_t& dwCalculatedDimension)
+{
+    size_t dwDimension = m_isoMap.GetMatrixDimension();
+
+    CIsochartKernelTimer timer(m_baseInfo.pStats, ISOCHART_KERNEL_EIGEN);
+    CIsochartStatsAllocation allocation(
+        m_baseInfo.pStats,
+        dwDimension * dwDimension * sizeof(float) * 2);
+
+    return m_isoMap.ComputeLargestEigen(
+        dwSelectedDimension,
+        dwCalculatedDimension);
+}
+
 // Compute n-dimension embeddings of all vertices which are not landmark, using
 // algorithm in section 4 of [Kun04]
 HRESULT CIsochartMesh::CalculateVertMappingCoord(
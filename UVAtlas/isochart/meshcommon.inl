@@ -110,11 +110,24 @@ inline HRESULT CIsochartMesh::IsParameterizationOverlapping(
 
     assert(!boundaryEdgeList.empty());
 
-    for (size_t i=0; i < boundaryEdgeList.size()-1; i++)
+    // Only test edges close to each other
+    CSegmentGrid grid;
+    HRESULT hr = grid.Init(
+        boundaryEdgeList.size(),
+        [&](size_t i, DirectX::XMFLOAT2& p0, DirectX::XMFLOAT2& p1)
+        {
+            p0 = pMesh->m_pVerts[boundaryEdgeList[i]->dwVertexID[0]].uv;
+            p1 = pMesh->m_pVerts[boundaryEdgeList[i]->dwVertexID[1]].uv;
+        });
+    if (FAILED(hr))
     {
-        pEdge1 = boundaryEdgeList[i];
-        for (size_t j=i+1; j<boundaryEdgeList.size(); j++)
+        return hr;
+    }
+
+    bIsOverlapping = grid.ForEachCandidatePair(
+        [&](size_t i, size_t j) -> bool
         {
+            pEdge1 = boundaryEdgeList[i];
             pEdge2 = boundaryEdgeList[j];
 
             // if two edges connect together, although they have
@@ -124,24 +137,17 @@ inline HRESULT CIsochartMesh::IsParameterizationOverlapping(
             ||pEdge1->dwVertexID[1] == pEdge2->dwVertexID[0]
             ||pEdge1->dwVertexID[1] == pEdge2->dwVertexID[1])
             {
-                continue;
+                return false;
             }
             // If two edges doesn't connect together, but have
             // intersection, overlapping occurs.
-            if (IsochartIsSegmentsIntersect(
+            return IsochartIsSegmentsIntersect(
                 pMesh->m_pVerts[pEdge1->dwVertexID[0]].uv,
                 pMesh->m_pVerts[pEdge1->dwVertexID[1]].uv,
                 pMesh->m_pVerts[pEdge2->dwVertexID[0]].uv,
-                pMesh->m_pVerts[pEdge2->dwVertexID[1]].uv))
-            {
-                bIsOverlapping = true;
-                return S_OK;
-            }
-            
-        }
-    }
+                pMesh->m_pVerts[pEdge2->dwVertexID[1]].uv);
+        });
 
-    bIsOverlapping = false;
     return S_OK;
 }
 
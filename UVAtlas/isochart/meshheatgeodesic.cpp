@@ -0,0 +1,373 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - meshheatgeodesic.cpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+/*
+    Notes:
+        Geodesic distance from a source vertex is computed by heat method:
+        (1) Integrate the heat flow du/dt = Lc*u from the source for a short
+            time t, by one backward Euler step (M - t*Lc)*u = delta.
+        (2) Evaluate the normalized vector field X = -grad(u)/|grad(u)|
+            on each face.
+        (3) Solve the Poisson equation Lc*phi = div(X). phi is the distance up
+            to a constant.
+        Lc is the cotangent Laplacian and M is the lumped mass matrix. Both
+        linear equation sets only depend on the chart, so they are factorized
+        once and each source costs two back-substitutions.
+
+    Reference:
+        This file implements algorithms in following papers:
+
+        [CWW13]: CRANE K., WEISCHEDEL C., WARDETZKY M.:
+        Geodesics in Heat: A New Approach to Computing Distance Based on Heat
+        Flow. ACM Transactions on Graphics 32(5) (2013)
+*/
+
+#include "pch.h"
+#include "isochartmesh.h"
+
+using namespace Isochart;
+using namespace DirectX;
+
+namespace
+{
+    // Time step of heat flow is HEAT_TIME_FACTOR times the squared average
+    // edge length. See section 3.2.4 of [CWW13]
+    const double HEAT_TIME_FACTOR = 1.0;
+
+    // Poisson equation only determines distance up to a constant. Adding
+    // POISSON_REGULARIZATION/t times mass matrix makes it positive definite.
+    const double POISSON_REGULARIZATION = 1e-8;
+
+    // Cotangent of degenerated angles are clamped to this value.
+    const double MAX_COTANGENT = 1e5;
+
+    struct DVECTOR3
+    {
+        double x, y, z;
+    };
+
+    inline DVECTOR3 Subtract(const DVECTOR3& a, const DVECTOR3& b)
+    {
+        DVECTOR3 r = { a.x - b.x, a.y - b.y, a.z - b.z };
+        return r;
+    }
+
+    inline double Dot(const DVECTOR3& a, const DVECTOR3& b)
+    {
+        return a.x*b.x + a.y*b.y + a.z*b.z;
+    }
+
+    inline DVECTOR3 Cross(const DVECTOR3& a, const DVECTOR3& b)
+    {
+        DVECTOR3 r = { a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x };
+        return r;
+    }
+
+    inline double Length(const DVECTOR3& a)
+    {
+        return sqrt(Dot(a, a));
+    }
+
+    // Corner positions, cotangent of each corner angle and area of one face.
+    struct FACEGEOMETRY
+    {
+        DVECTOR3 pos[3];
+        DVECTOR3 normal;
+        double cot[3];
+        double fArea;
+    };
+
+    // Return false for degenerated face.
+    bool GetFaceGeometry(
+        const XMFLOAT3* pVertPosition,
+        const ISOCHARTVERTEX* pVerts,
+        const ISOCHARTFACE& face,
+        FACEGEOMETRY& geometry)
+    {
+        for (size_t ii=0; ii<3; ii++)
+        {
+            const XMFLOAT3& pos =
+                pVertPosition[pVerts[face.dwVertexID[ii]].dwIDInRootMesh];
+            geometry.pos[ii].x = pos.x;
+            geometry.pos[ii].y = pos.y;
+            geometry.pos[ii].z = pos.z;
+        }
+
+        DVECTOR3 cross = Cross(
+            Subtract(geometry.pos[1], geometry.pos[0]),
+            Subtract(geometry.pos[2], geometry.pos[0]));
+        double fDoubleArea = Length(cross);
+        if (fDoubleArea <= 0)
+        {
+            return false;
+        }
+
+        geometry.fArea = fDoubleArea / 2;
+        geometry.normal.x = cross.x / fDoubleArea;
+        geometry.normal.y = cross.y / fDoubleArea;
+        geometry.normal.z = cross.z / fDoubleArea;
+
+        for (size_t ii=0; ii<3; ii++)
+        {
+            DVECTOR3 e1 = Subtract(geometry.pos[(ii+1)%3], geometry.pos[ii]);
+            DVECTOR3 e2 = Subtract(geometry.pos[(ii+2)%3], geometry.pos[ii]);
+            double fCot = Dot(e1, e2) / fDoubleArea;
+            geometry.cot[ii] =
+                std::max(-MAX_COTANGENT, std::min(MAX_COTANGENT, fCot));
+        }
+        return true;
+    }
+}
+
+// Check whether the heat method is applied on this chart.
+bool CIsochartMesh::IsHeatGeodesicDistanceUsed(
+    bool bIsSignalDistance) const
+{
+    // Like the new geodesic distance algorithm, heat method doesn't support
+    // IMT, signal distance always uses [KS98]
+    return
+        (m_IsochartEngine.m_dwOptions & _OPTION_ISOCHART_GEODESIC_HEAT) != 0
+        && !bIsSignalDistance
+        && m_dwVertNumber > 0
+        && m_dwFaceNumber > 0;
+}
+
+// Build and factorize the linear equation sets of heat method. If they can't
+// be factorized, for example the chart has degenerated faces, pHeatSolver is
+// left empty and [KS98] distance is used.
+HRESULT CIsochartMesh::InitHeatGeodesicSolver(
+    std::unique_ptr<HEATGEODESICSOLVER>& pHeatSolver) const
+{
+    pHeatSolver.reset();
+
+    std::unique_ptr<HEATGEODESICSOLVER> pSolver(new (std::nothrow) HEATGEODESICSOLVER);
+    if (!pSolver)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    std::vector<CSparseMatrix<double>::Triplet> stiffness;
+    std::vector<CSparseMatrix<double>::Triplet> triplets;
+    std::vector<double> mass;
+    CSparseMatrix<double> A;
+
+    try
+    {
+        stiffness.reserve(m_dwFaceNumber * 12);
+        mass.resize(m_dwVertNumber, 0);
+
+        // 1. Assemble stiffness matrix -Lc and lumped mass matrix M
+        for (size_t ii=0; ii<m_dwFaceNumber; ii++)
+        {
+            const ISOCHARTFACE& face = m_pFaces[ii];
+            FACEGEOMETRY geometry;
+            if (!GetFaceGeometry(
+                m_baseInfo.pVertPosition, m_pVerts, face, geometry))
+            {
+                continue;
+            }
+
+            for (size_t jj=0; jj<3; jj++)
+            {
+                // Edge opposite to corner jj
+                uint32_t dwVert1 = face.dwVertexID[(jj+1)%3];
+                uint32_t dwVert2 = face.dwVertexID[(jj+2)%3];
+                double fWeight = geometry.cot[jj] / 2;
+
+                stiffness.push_back(CSparseMatrix<double>::Triplet(dwVert1, dwVert1, fWeight));
+                stiffness.push_back(CSparseMatrix<double>::Triplet(dwVert2, dwVert2, fWeight));
+                stiffness.push_back(CSparseMatrix<double>::Triplet(dwVert1, dwVert2, -fWeight));
+                stiffness.push_back(CSparseMatrix<double>::Triplet(dwVert2, dwVert1, -fWeight));
+
+                mass[face.dwVertexID[jj]] += geometry.fArea / 3;
+            }
+        }
+
+        double fAverageEdgeLength = 0;
+        for (size_t ii=0; ii<m_dwEdgeNumber; ii++)
+        {
+            fAverageEdgeLength += m_edges[ii].fLength;
+        }
+        if (m_dwEdgeNumber > 0)
+        {
+            fAverageEdgeLength /= m_dwEdgeNumber;
+        }
+        double t = HEAT_TIME_FACTOR * fAverageEdgeLength * fAverageEdgeLength;
+        if (t <= 0)
+        {
+            return S_OK;
+        }
+
+        // 2. Heat flow, M - t*Lc
+        triplets.reserve(stiffness.size() + m_dwVertNumber);
+        for (size_t ii=0; ii<stiffness.size(); ii++)
+        {
+            triplets.push_back(CSparseMatrix<double>::Triplet(
+                stiffness[ii].rowIdx, stiffness[ii].colIdx, t * stiffness[ii].value));
+        }
+        for (size_t ii=0; ii<m_dwVertNumber; ii++)
+        {
+            triplets.push_back(CSparseMatrix<double>::Triplet(ii, ii, mass[ii]));
+        }
+        if (!A.build(m_dwVertNumber, m_dwVertNumber, triplets))
+        {
+            return E_OUTOFMEMORY;
+        }
+        if (!pSolver->heatFlow.Init(A))
+        {
+            DPF(1, "Heat flow of chart can't be factorized, use [KS98] distance");
+            return S_OK;
+        }
+
+        // 3. Poisson equation, -Lc + e*M
+        double fRegularization = POISSON_REGULARIZATION / t;
+        for (size_t ii=0; ii<m_dwVertNumber; ii++)
+        {
+            stiffness.push_back(
+                CSparseMatrix<double>::Triplet(ii, ii, fRegularization * mass[ii]));
+        }
+        if (!A.build(m_dwVertNumber, m_dwVertNumber, stiffness))
+        {
+            return E_OUTOFMEMORY;
+        }
+        if (!pSolver->poisson.Init(A))
+        {
+            DPF(1, "Laplacian of chart can't be factorized, use [KS98] distance");
+            return S_OK;
+        }
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    pHeatSolver = std::move(pSolver);
+    return S_OK;
+}
+
+// Compute geodesic distance from source vertex by heat method. The result
+// approximates the geodesic distance and can be smaller or larger than it.
+// Negative values near the source are clamped to 0.
+// See more detail in [CWW13]
+HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexHeat(
+    GEODESICWORKSPACE& workspace,
+    uint32_t dwSourceVertID,
+    uint32_t* pdwFarestPeerVertID) const
+{
+    const HEATGEODESICSOLVER* pSolver = workspace.pHeatSolver;
+    assert(pSolver);
+
+    CVector<double>& heatSource = workspace.heatSource;
+    CVector<double>& heat = workspace.heat;
+    CVector<double>& divergence = workspace.divergence;
+    CVector<double>& potential = workspace.potential;
+
+    try
+    {
+        heatSource.resize(m_dwVertNumber);
+        divergence.resize(m_dwVertNumber);
+    }
+    catch (std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    // 1. Heat flow from source
+    heatSource.setZero();
+    heatSource[dwSourceVertID] = 1;
+    if (!pSolver->heatFlow.Solve(heat, heatSource))
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    // 2. Divergence of normalized heat gradient.
+    divergence.setZero();
+    for (size_t ii=0; ii<m_dwFaceNumber; ii++)
+    {
+        const ISOCHARTFACE& face = m_pFaces[ii];
+        FACEGEOMETRY geometry;
+        if (!GetFaceGeometry(
+            m_baseInfo.pVertPosition, m_pVerts, face, geometry))
+        {
+            continue;
+        }
+
+        // 2.1 grad(u) = sum(u[i] * N x e[i]) / (2*Area), e[i] is the edge
+        // opposite to corner i.
+        DVECTOR3 gradient = { 0, 0, 0 };
+        for (size_t jj=0; jj<3; jj++)
+        {
+            DVECTOR3 edge = Subtract(
+                geometry.pos[(jj+2)%3], geometry.pos[(jj+1)%3]);
+            DVECTOR3 rotated = Cross(geometry.normal, edge);
+            double u = heat[face.dwVertexID[jj]];
+            gradient.x += u * rotated.x;
+            gradient.y += u * rotated.y;
+            gradient.z += u * rotated.z;
+        }
+
+        double fLength = Length(gradient);
+        if (fLength <= 0)
+        {
+            continue;
+        }
+        DVECTOR3 X = { -gradient.x/fLength, -gradient.y/fLength, -gradient.z/fLength };
+
+        // 2.2 div(X) at corner i is
+        // (cot(a1) * <e1, X> + cot(a2) * <e2, X>) / 2, e1 and e2 are edges
+        // leaving corner i, a1 and a2 are the angles opposite to them.
+        for (size_t jj=0; jj<3; jj++)
+        {
+            size_t k1 = (jj+1)%3;
+            size_t k2 = (jj+2)%3;
+            DVECTOR3 e1 = Subtract(geometry.pos[k1], geometry.pos[jj]);
+            DVECTOR3 e2 = Subtract(geometry.pos[k2], geometry.pos[jj]);
+
+            divergence[face.dwVertexID[jj]] +=
+                (geometry.cot[k2] * Dot(e1, X) + geometry.cot[k1] * Dot(e2, X)) / 2;
+        }
+    }
+
+    // 3. Recover distance, -Lc*phi = -div(X)
+    for (size_t ii=0; ii<m_dwVertNumber; ii++)
+    {
+        divergence[ii] = -divergence[ii];
+    }
+    if (!pSolver->poisson.Solve(potential, divergence))
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    float* pfGeodesicDistance = workspace.geodesicDistance.get();
+    float* pfSignalDistance = workspace.signalDistance.get();
+
+    uint32_t dwFarestVertID = 0;
+    float fGeoFarest = 0;
+    double fSourcePotential = potential[dwSourceVertID];
+    for (uint32_t i = 0; i < m_dwVertNumber; ++i)
+    {
+        float fDistance = static_cast<float>(
+            std::max(potential[i] - fSourcePotential, 0.0));
+
+        pfGeodesicDistance[i] = pfSignalDistance[i] = fDistance;
+
+        if (pfGeodesicDistance[i] > fGeoFarest)
+        {
+            fGeoFarest = pfGeodesicDistance[i];
+            dwFarestVertID = i;
+        }
+    }
+
+    if (pdwFarestPeerVertID)
+    {
+        *pdwFarestPeerVertID = dwFarestVertID;
+    }
+
+    return S_OK;
+}
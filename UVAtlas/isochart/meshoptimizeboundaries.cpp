@@ -1092,7 +1092,7 @@ HRESULT CIsochartMesh::CalculateLandmarkUV(
         return hr;
     }
 
-    hr = m_isoMap.ComputeLargestEigen(
+    hr = ComputeIsoMapLargestEigen(
         dwSelectPrimaryDimension,
         dwCalculatedPrimaryDimension);
     if (FAILED(hr))
@@ -39,6 +39,7 @@
 */
 
 #include "pch.h"
+#include <random>
 #include "isochartmesh.h"
 #include "UVAtlas.h"
 #include "maxheap.hpp"
@@ -257,12 +258,26 @@ HRESULT CIsochartMesh::OptimizeAllL2SquaredStretch(
         ISOCHARTMESH_ARRAY &chartList,
         bool bOptimizeSignal)
 {
-    HRESULT hr = S_OK;
-    for (size_t ii=0; ii<chartList.size(); ii++)
+    if (chartList.empty())
     {
-        FAILURE_RETURN(chartList[ii]->OptimizeChartL2Stretch(bOptimizeSignal));
+        return S_OK;
     }
-    return S_OK;
+
+    // Each chart only changes its own parameterization, so charts can be
+    // optimized by any idle workers. Random choices are seeded per vertex
+    // optimization, so result does not depend on worker count.
+    const CIsochartEngine& engine = chartList[0]->m_IsochartEngine;
+    CWorkerLease lease(
+        engine.m_workerBudget,
+        engine.m_workerBudget.TryAcquire(chartList.size() - 1));
+
+    return ParallelFor(
+        chartList.size(),
+        lease.GetCount() + 1,
+        [&](size_t, size_t ii) -> HRESULT
+        {
+            return chartList[ii]->OptimizeChartL2Stretch(bOptimizeSignal);
+        });
 }
 
 float CIsochartMesh::ComputeGeoAvgL2Stretch(
@@ -660,6 +675,8 @@ HRESULT CIsochartMesh::OptimizeChartL2Stretch(bool bOptimizeSignal)
         return S_OK;
     }
 
+    CIsochartKernelTimer timer(m_baseInfo.pStats, ISOCHART_KERNEL_STRETCH);
+
     CHARTOPTIMIZEINFO optimizeInfo;
     HRESULT hr = S_OK;
 
@@ -757,6 +774,8 @@ HRESULT CIsochartMesh::OptimizeChartL2Stretch(bool bOptimizeSignal)
 HRESULT CIsochartMesh::OptimizeGeoLnInfiniteStretch(
     bool& bSucceed)
 {
+    CIsochartKernelTimer timer(m_baseInfo.pStats, ISOCHART_KERNEL_STRETCH);
+
     CHARTOPTIMIZEINFO optimizeInfo;
 
     bSucceed = false;
@@ -1803,14 +1822,16 @@ bool CIsochartMesh::OptimizeVertexStretchAroundCenter(
     float fTempStretch = 0;
     XMFLOAT2 middle;
     // As the decription in [SSGH01], randomly moving vertex will have more
-    // chance to find the optimal position. To make consistent results, srand
-    // with a specified value 2
-    srand(2); 
+    // chance to find the optimal position. To make consistent results, seed
+    // with a specified value 2. A local generator keeps results consistent
+    // when charts are optimized on several threads.
+    std::minstd_rand randGenerator(2);
     size_t iteration = 0;
     while (iteration < optimizeInfo.dwRandOptOneVertTimes)
     {
         // 1. Get a new random position in the optimizing circle range
-        float fAngle = rand() * 2.f * XM_PI / RAND_MAX;
+        float fAngle = static_cast<float>(randGenerator()) * 2.f * XM_PI
+            / static_cast<float>(std::minstd_rand::max());
         vertInfo.end.x = 
             vertInfo.center.x + vertInfo.fRadius * cosf(fAngle);
         vertInfo.end.y = 
@@ -1193,25 +1193,41 @@ HRESULT CIsochartMesh::ProcessPlaneShape(
 
 // This function is used to check the result of ProcessPlaneLikeShape, if self overlapping
 // happened, just abandon the result generated by ProcessPlaneLikeShape
-static bool IsSelfOverlapping(
-       CIsochartMesh* pChart)
+static HRESULT IsSelfOverlapping(
+       CIsochartMesh* pChart,
+       bool& bIsOverlapping)
 {
+    bIsOverlapping = false;
+
     auto& edgeList1 = pChart->GetEdgesList();
     ISOCHARTVERTEX* pVertList1 = pChart->GetVertexBuffer();
 
     if (edgeList1.size() < 1)
     {
-        return false;
+        return S_OK;
     }
 
-    for (size_t jj=0; jj<edgeList1.size()-1; jj++)
+    // Only test edges close to each other
+    CSegmentGrid grid;
+    HRESULT hr = grid.Init(
+        edgeList1.size(),
+        [&](size_t jj, XMFLOAT2& p0, XMFLOAT2& p1)
+        {
+            p0 = pVertList1[edgeList1[jj].dwVertexID[0]].uv;
+            p1 = pVertList1[edgeList1[jj].dwVertexID[1]].uv;
+        });
+    if (FAILED(hr))
     {
-        ISOCHARTEDGE& edge1 = edgeList1[jj];
-        const XMFLOAT2& v1 = pVertList1[edge1.dwVertexID[0]].uv;
-        const XMFLOAT2& v2 = pVertList1[edge1.dwVertexID[1]].uv;
-        
-        for (size_t kk=jj+1; kk<edgeList1.size(); kk++)
+        return hr;
+    }
+
+    ISOCHARTFACE* pFaceList1 = pChart->GetFaceBuffer();
+    const CBaseMeshInfo& baseInfo = pChart->GetBaseMeshInfo();
+
+    bIsOverlapping = grid.ForEachCandidatePair(
+        [&](size_t jj, size_t kk) -> bool
         {
+            ISOCHARTEDGE& edge1 = edgeList1[jj];
             ISOCHARTEDGE& edge2 = edgeList1[kk];
 
             // If the 2 edges are adjacent, skip checking
@@ -1220,76 +1236,76 @@ static bool IsSelfOverlapping(
             ||edge1.dwVertexID[1] == edge2.dwVertexID[0]
             ||edge1.dwVertexID[1] == edge2.dwVertexID[1])
             {
-                continue;
+                return false;
             }
+            const XMFLOAT2& v1 = pVertList1[edge1.dwVertexID[0]].uv;
+            const XMFLOAT2& v2 = pVertList1[edge1.dwVertexID[1]].uv;
             const XMFLOAT2& v3 = pVertList1[edge2.dwVertexID[0]].uv;
             const XMFLOAT2& v4 = pVertList1[edge2.dwVertexID[1]].uv;
-            bool bIsIntersect = IsochartIsSegmentsIntersect(v1, v2, v3, v4);
+            if (!IsochartIsSegmentsIntersect(v1, v2, v3, v4))
+            {
+                return false;
+            }
 
-            if (bIsIntersect) 
-            {		
-                ISOCHARTFACE* pFaceList1 = pChart->GetFaceBuffer();
-                const CBaseMeshInfo& baseInfo = pChart->GetBaseMeshInfo();
-                
-                        uint32_t dwFaceRootID = 
-                            pFaceList1[edge1.dwFaceID[0]].dwIDInRootMesh;
-                        if (IsInZeroRange2(baseInfo.pfFaceAreaArray[dwFaceRootID]))
-                        {
-                            continue;
-                        }
-
-                        if (edge1.dwFaceID[1] != INVALID_FACE_ID)
-                        {
-                            dwFaceRootID = 
-                            pFaceList1[edge1.dwFaceID[1]].dwIDInRootMesh;
-                            if (IsInZeroRange2(baseInfo.pfFaceAreaArray[dwFaceRootID]))
-                            {
-                                continue;
-                            }
-                        }
-                        dwFaceRootID = 
-                            pFaceList1[edge2.dwFaceID[0]].dwIDInRootMesh;
-                        if (IsInZeroRange2(baseInfo.pfFaceAreaArray[dwFaceRootID]))
-                        {
-                            continue;
-                        }
-
-                        if (edge2.dwFaceID[1] != INVALID_FACE_ID)
-                        {
-                            dwFaceRootID = 
-                            pFaceList1[edge2.dwFaceID[1]].dwIDInRootMesh;
-                            if (IsInZeroRange2(baseInfo.pfFaceAreaArray[dwFaceRootID]))
-                            {
-                                continue;
-                            }
-                        }
-                
-                XMVECTOR vv1 = XMLoadFloat2(&v1);
-                XMVECTOR vv2 = XMLoadFloat2(&v2);
-                XMVECTOR vv3 = XMLoadFloat2(&v3);
-                XMVECTOR vv4 = XMLoadFloat2(&v4);
+            // Faces with zero area are not counted
+            uint32_t dwFaceRootID = 
+                pFaceList1[edge1.dwFaceID[0]].dwIDInRootMesh;
+            if (IsInZeroRange2(baseInfo.pfFaceAreaArray[dwFaceRootID]))
+            {
+                return false;
+            }
+
+            if (edge1.dwFaceID[1] != INVALID_FACE_ID)
+            {
+                dwFaceRootID = 
+                pFaceList1[edge1.dwFaceID[1]].dwIDInRootMesh;
+                if (IsInZeroRange2(baseInfo.pfFaceAreaArray[dwFaceRootID]))
+                {
+                    return false;
+                }
+            }
+            dwFaceRootID = 
+                pFaceList1[edge2.dwFaceID[0]].dwIDInRootMesh;
+            if (IsInZeroRange2(baseInfo.pfFaceAreaArray[dwFaceRootID]))
+            {
+                return false;
+            }
+
+            if (edge2.dwFaceID[1] != INVALID_FACE_ID)
+            {
+                dwFaceRootID = 
+                pFaceList1[edge2.dwFaceID[1]].dwIDInRootMesh;
+                if (IsInZeroRange2(baseInfo.pfFaceAreaArray[dwFaceRootID]))
+                {
+                    return false;
+                }
+            }
 
-                XMVECTOR vv5 = vv1 - vv3;
-                if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) continue;
+            // Edges touching at end points are not counted
+            XMVECTOR vv1 = XMLoadFloat2(&v1);
+            XMVECTOR vv2 = XMLoadFloat2(&v2);
+            XMVECTOR vv3 = XMLoadFloat2(&v3);
+            XMVECTOR vv4 = XMLoadFloat2(&v4);
 
-                vv5 = vv1 - vv4;
-                if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) continue;
+            XMVECTOR vv5 = vv1 - vv3;
+            if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) return false;
 
-                vv5 = vv2 - vv3;
-                if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) continue;
+            vv5 = vv1 - vv4;
+            if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) return false;
 
-                vv5 = vv2 - vv4;
-                if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) continue;
+            vv5 = vv2 - vv3;
+            if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) return false;
 
-                DPF(1, "(%f, %f) (%f, %f) --> (%f, %f) (%f, %f)",						
-                        v1.x, v1.y, v2.x, v2.y, v3.x, v3.y, v4.x, v4.y);
+            vv5 = vv2 - vv4;
+            if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) return false;
 
-                return true;
-            }
-        }
-    }
+            DPF(1, "(%f, %f) (%f, %f) --> (%f, %f) (%f, %f)",						
+                    v1.x, v1.y, v2.x, v2.y, v3.x, v3.y, v4.x, v4.y);
 
-    return false;
+            return true;
+        });
+
+    return S_OK;
 }
 
 
@@ -1544,7 +1560,7 @@ HRESULT CIsochartMesh::ProcessPlaneLikeShape(
 #if CHECK_OVER_LAPPING_BEFORE_OPT_INFINIT
     bool bIsOverlapping = false;
     
-    bIsOverlapping = IsSelfOverlapping(this);
+    FAILURE_RETURN(IsSelfOverlapping(this, bIsOverlapping));
     if (bIsOverlapping)
     {
         DPF(1, "Generate self overlapping chart when processing plane-like chart");
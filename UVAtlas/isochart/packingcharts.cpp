@@ -2018,19 +2018,28 @@ static void BruteForceFoldChecking(
         ISOCHARTVERTEX* pVertList1 = chartList[ii]->GetVertexBuffer();
         ISOCHARTFACE* pFaceList1 = chartList[ii]->GetFaceBuffer(); 
         
-        bool bFoundFold = false;
         if (edgeList1.size() < 1)
         {
             continue;
         }
-        for (size_t jj=0; jj<edgeList1.size()-1; jj++)
+
+        CSegmentGrid grid;
+        if (FAILED(grid.Init(
+            edgeList1.size(),
+            [&](size_t jj, XMFLOAT2& p0, XMFLOAT2& p1)
+            {
+                p0 = pVertList1[edgeList1[jj].dwVertexID[0]].uv;
+                p1 = pVertList1[edgeList1[jj].dwVertexID[1]].uv;
+            })))
         {
-            ISOCHARTEDGE& edge1 = edgeList1[jj];
-            const XMFLOAT2& v1 = pVertList1[edge1.dwVertexID[0]].uv;
-            const XMFLOAT2& v2 = pVertList1[edge1.dwVertexID[1]].uv;
-            
-            for (size_t kk = jj + 1; kk<edgeList1.size(); kk++)
+            return;
+        }
+
+        // Report the first fold found in each chart
+        grid.ForEachCandidatePair(
+            [&](size_t jj, size_t kk) -> bool
             {
+                ISOCHARTEDGE& edge1 = edgeList1[jj];
                 ISOCHARTEDGE& edge2 = edgeList1[kk];
 
                 if (edge1.dwVertexID[0] == edge2.dwVertexID[0]
@@ -2038,73 +2047,73 @@ static void BruteForceFoldChecking(
                 ||edge1.dwVertexID[1] == edge2.dwVertexID[0]
                 ||edge1.dwVertexID[1] == edge2.dwVertexID[1])
                 {
-                    continue;
+                    return false;
                 }
+                const XMFLOAT2& v1 = pVertList1[edge1.dwVertexID[0]].uv;
+                const XMFLOAT2& v2 = pVertList1[edge1.dwVertexID[1]].uv;
                 const XMFLOAT2& v3 = pVertList1[edge2.dwVertexID[0]].uv;
                 const XMFLOAT2& v4 = pVertList1[edge2.dwVertexID[1]].uv;
 
-                bool bIsIntersect = IsochartIsSegmentsIntersect(v1, v2, v3, v4);
-                if (bIsIntersect)
+                if (!IsochartIsSegmentsIntersect(v1, v2, v3, v4))
                 {
-                    XMVECTOR vv1 = XMLoadFloat2(&v1);
-                    XMVECTOR vv2 = XMLoadFloat2(&v2);
-                    XMVECTOR vv3 = XMLoadFloat2(&v3);
-                    XMVECTOR vv4 = XMLoadFloat2(&v4);
+                    return false;
+                }
 
-                    XMVECTOR vv5 = vv1 - vv3;
-                    if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) continue;
+                XMVECTOR vv1 = XMLoadFloat2(&v1);
+                XMVECTOR vv2 = XMLoadFloat2(&v2);
+                XMVECTOR vv3 = XMLoadFloat2(&v3);
+                XMVECTOR vv4 = XMLoadFloat2(&v4);
 
-                    vv5 = vv1 - vv4;
-                    if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) continue;
+                XMVECTOR vv5 = vv1 - vv3;
+                if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) return false;
 
-                    vv5 = vv2 - vv3;
-                    if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) continue;
+                vv5 = vv1 - vv4;
+                if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) return false;
 
-                    vv5 = vv2 - vv4;
-                    if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) continue;
+                vv5 = vv2 - vv3;
+                if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) return false;
 
-                    size_t dwFaceRootID =
-                        pFaceList1[edge1.dwFaceID[0]].dwIDInRootMesh;
-                    if (IsInZeroRange(baseInfo.pfFaceAreaArray[dwFaceRootID]))
-                    {
-                        continue;
-                    }
+                vv5 = vv2 - vv4;
+                if (IsInZeroRange(XMVectorGetX(XMVector2Length(vv5)))) return false;
 
-                    if (edge1.dwFaceID[1] != INVALID_FACE_ID)
-                    {
-                        dwFaceRootID = 
-                        pFaceList1[edge1.dwFaceID[1]].dwIDInRootMesh;
-                        if (IsInZeroRange(baseInfo.pfFaceAreaArray[dwFaceRootID]))
-                        {
-                            continue;
-                        }
-                    }
+                size_t dwFaceRootID =
+                    pFaceList1[edge1.dwFaceID[0]].dwIDInRootMesh;
+                if (IsInZeroRange(baseInfo.pfFaceAreaArray[dwFaceRootID]))
+                {
+                    return false;
+                }
+
+                if (edge1.dwFaceID[1] != INVALID_FACE_ID)
+                {
                     dwFaceRootID = 
-                        pFaceList1[edge2.dwFaceID[0]].dwIDInRootMesh;
+                    pFaceList1[edge1.dwFaceID[1]].dwIDInRootMesh;
                     if (IsInZeroRange(baseInfo.pfFaceAreaArray[dwFaceRootID]))
                     {
-                        continue;
+                        return false;
                     }
+                }
+                dwFaceRootID = 
+                    pFaceList1[edge2.dwFaceID[0]].dwIDInRootMesh;
+                if (IsInZeroRange(baseInfo.pfFaceAreaArray[dwFaceRootID]))
+                {
+                    return false;
+                }
 
-                    if (edge2.dwFaceID[1] != INVALID_FACE_ID)
-                    {
-                        dwFaceRootID = 
-                        pFaceList1[edge2.dwFaceID[1]].dwIDInRootMesh;
-                        if (IsInZeroRange(baseInfo.pfFaceAreaArray[dwFaceRootID]))
-                        {
-                            continue;
-                        }
-                    }
-                    if (!bFoundFold)
+                if (edge2.dwFaceID[1] != INVALID_FACE_ID)
+                {
+                    dwFaceRootID = 
+                    pFaceList1[edge2.dwFaceID[1]].dwIDInRootMesh;
+                    if (IsInZeroRange(baseInfo.pfFaceAreaArray[dwFaceRootID]))
                     {
-                        bFoundFold = true;
-                        DPF(0, "Found fold in chart %zu...", ii);
-                        DPF(0, "(%f, %f) (%f, %f) --> (%f, %f) (%f, %f)",
-                                v1.x, v1.y, v2.x, v2.y, v3.x, v3.y, v4.x, v4.y);
+                        return false;
                     }
                 }
-            }
-        }
+
+                DPF(0, "Found fold in chart %zu...", ii);
+                DPF(0, "(%f, %f) (%f, %f) --> (%f, %f) (%f, %f)",
+                        v1.x, v1.y, v2.x, v2.y, v3.x, v3.y, v4.x, v4.y);
+                return true;
+            });
     }
 }
 
@@ -2112,56 +2121,86 @@ static void BruteForceOverlappingChecking(
         ISOCHARTMESH_ARRAY& chartList)
 {
     if (chartList.size() < 1) return;
-    
-    for (size_t ii=0; ii<chartList.size()-1; ii++)
+
+    // Index the edges of all charts together, segment ii is edge
+    // edgeIndex[ii].second of chart edgeIndex[ii].first
+    std::vector<std::pair<uint32_t, uint32_t>> edgeIndex;
+    try
     {
-        auto& edgeList1 = chartList[ii]->GetEdgesList();
-        ISOCHARTVERTEX* pVertList1 = chartList[ii]->GetVertexBuffer();
+        for (size_t ii=0; ii<chartList.size(); ii++)
+        {
+            auto& edgeList = chartList[ii]->GetEdgesList();
+            for (size_t m=0; m<edgeList.size(); m++)
+            {
+                edgeIndex.emplace_back(static_cast<uint32_t>(ii), static_cast<uint32_t>(m));
+            }
+        }
+    }
+    catch (std::bad_alloc&)
+    {
+        return;
+    }
 
-        for (size_t jj=ii+1; jj<chartList.size(); jj++)
-        {           
-            auto& edgeList2 = chartList[jj]->GetEdgesList();
-            ISOCHARTVERTEX* pVertList2 = chartList[jj]->GetVertexBuffer();
+    CSegmentGrid grid;
+    if (FAILED(grid.Init(
+        edgeIndex.size(),
+        [&](size_t ii, XMFLOAT2& p0, XMFLOAT2& p1)
+        {
+            CIsochartMesh* pChart = chartList[edgeIndex[ii].first];
+            ISOCHARTEDGE& edge = pChart->GetEdgesList()[edgeIndex[ii].second];
+            p0 = pChart->GetVertexBuffer()[edge.dwVertexID[0]].uv;
+            p1 = pChart->GetVertexBuffer()[edge.dwVertexID[1]].uv;
+        })))
+    {
+        return;
+    }
 
-            for (size_t m=0; m<edgeList1.size(); m++)
+    // Boundary edges of each chart against all edges of the charts after it
+    grid.ForEachCandidatePair(
+        [&](size_t a, size_t b) -> bool
+        {
+            uint32_t ii = edgeIndex[a].first;
+            uint32_t jj = edgeIndex[b].first;
+            if (ii == jj)
             {
-                ISOCHARTEDGE& edge1 = edgeList1[m];
-                if (!edge1.bIsBoundary)
-                {
-                    continue;
-                }
-                const XMFLOAT2& v1 = pVertList1[edge1.dwVertexID[0]].uv;
-                const XMFLOAT2& v2 = pVertList1[edge1.dwVertexID[1]].uv;
-                for (size_t n=0; n<edgeList2.size(); n++)
-                {
-                    ISOCHARTEDGE& edge2 = edgeList2[n];
+                return false;
+            }
 
-                    const XMFLOAT2& v3 = pVertList2[edge2.dwVertexID[0]].uv;
-                    const XMFLOAT2& v4 = pVertList2[edge2.dwVertexID[1]].uv;
+            ISOCHARTEDGE& edge1 = chartList[ii]->GetEdgesList()[edgeIndex[a].second];
+            ISOCHARTEDGE& edge2 = chartList[jj]->GetEdgesList()[edgeIndex[b].second];
+            if (!edge1.bIsBoundary)
+            {
+                return false;
+            }
 
-                    bool bIsIntersect = IsochartIsSegmentsIntersect(v1, v2, v3, v4);
-                    if (bIsIntersect)
-                    {   
-                        DPF(0, "Found intersection...");
-                        DPF(0, "Edge 1 is %d-%d",
-                                pVertList1[edge1.dwVertexID[0]].dwIDInRootMesh,
-                                pVertList1[edge1.dwVertexID[1]].dwIDInRootMesh);
+            ISOCHARTVERTEX* pVertList1 = chartList[ii]->GetVertexBuffer();
+            ISOCHARTVERTEX* pVertList2 = chartList[jj]->GetVertexBuffer();
+            const XMFLOAT2& v1 = pVertList1[edge1.dwVertexID[0]].uv;
+            const XMFLOAT2& v2 = pVertList1[edge1.dwVertexID[1]].uv;
+            const XMFLOAT2& v3 = pVertList2[edge2.dwVertexID[0]].uv;
+            const XMFLOAT2& v4 = pVertList2[edge2.dwVertexID[1]].uv;
 
-                        DPF(0, "Edge 2 is %d-%d",
-                                pVertList2[edge2.dwVertexID[0]].dwIDInRootMesh,
-                                pVertList2[edge2.dwVertexID[1]].dwIDInRootMesh);
+            bool bIsIntersect = IsochartIsSegmentsIntersect(v1, v2, v3, v4);
+            if (bIsIntersect)
+            {   
+                DPF(0, "Found intersection...");
+                DPF(0, "Edge 1 is %d-%d",
+                        pVertList1[edge1.dwVertexID[0]].dwIDInRootMesh,
+                        pVertList1[edge1.dwVertexID[1]].dwIDInRootMesh);
 
-                        DPF(0, "Chart1 %zu, Chart2 %zu\n", ii, jj);
+                DPF(0, "Edge 2 is %d-%d",
+                        pVertList2[edge2.dwVertexID[0]].dwIDInRootMesh,
+                        pVertList2[edge2.dwVertexID[1]].dwIDInRootMesh);
 
-                        DPF(0, "(%f, %f) (%f, %f) --> (%f, %f) (%f, %f)",
-                            v1.x, v1.y, v2.x, v2.y, v3.x, v3.y, v4.x, v4.y);
+                DPF(0, "Chart1 %u, Chart2 %u\n", ii, jj);
 
-                        assert(!bIsIntersect);
-                    }
-                }
+                DPF(0, "(%f, %f) (%f, %f) --> (%f, %f) (%f, %f)",
+                    v1.x, v1.y, v2.x, v2.y, v3.x, v3.y, v4.x, v4.y);
+
+                assert(!bIsIntersect);
             }
-        }
-    }
+            return false;
+        });
 }
 #endif
 
@@ -2467,25 +2506,12 @@ void CIsochartMesh::AlignUVWithLongestAxis() const
 // Sort the charts in decreasing order by chart area.
 namespace
 {
-    int CompareChart(const void* chart1, const void* chart2)
+    bool CompareChart(const CIsochartMesh* pChart1, const CIsochartMesh* pChart2)
     {
-        const CIsochartMesh* pChart1 = *(const CIsochartMesh**) chart1;
-        const CIsochartMesh* pChart2 = *(const CIsochartMesh**) chart2;
-
         auto pPackingInfo1 = pChart1->GetPackingInfoBuffer();
         auto pPackingInfo2 = pChart2->GetPackingInfoBuffer();
 
-        float a = pPackingInfo1->fUVHeight[0] - pPackingInfo2->fUVHeight[0];
-
-        if (a > 0)
-        {
-            return -1;
-        }
-        if (a < 0)
-        {
-            return 1;
-        }
-        return 0;
+        return pPackingInfo1->fUVHeight[0] > pPackingInfo2->fUVHeight[0];
     }
 }
 
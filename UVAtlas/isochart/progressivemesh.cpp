@@ -1067,11 +1067,11 @@ HRESULT CProgressiveMesh::CreateProgressiveMesh(CIsochartMesh& mesh)
             m_pVertArray[i].nImportanceOrder = MUST_RESERVE;
 
             m_pVertArray[i].vertAdjacent.insert(m_pVertArray[i].vertAdjacent.end(),
-                                                pOrgVerts[i].vertAdjacent.cbegin(), pOrgVerts[i].vertAdjacent.cend());
+                                                pOrgVerts[i].vertAdjacent.begin(), pOrgVerts[i].vertAdjacent.end());
             m_pVertArray[i].faceAdjacent.insert(m_pVertArray[i].faceAdjacent.end(),
-                                                pOrgVerts[i].faceAdjacent.cbegin(), pOrgVerts[i].faceAdjacent.cend());
+                                                pOrgVerts[i].faceAdjacent.begin(), pOrgVerts[i].faceAdjacent.end());
             m_pVertArray[i].edgeAdjacent.insert(m_pVertArray[i].edgeAdjacent.end(),
-                                                pOrgVerts[i].edgeAdjacent.cbegin(), pOrgVerts[i].edgeAdjacent.cend());
+                                                pOrgVerts[i].edgeAdjacent.begin(), pOrgVerts[i].edgeAdjacent.end());
         }
     }
     catch (std::bad_alloc&)
@@ -0,0 +1,269 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - segmentgrid.hpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "isochartconfig.h"
+#include "isochartutil.h"
+
+namespace Isochart
+{
+// Uniform grid over 2D segments, used to find the pairs of segments that may
+// intersect without testing all pairs. Each segment is put into the cells its
+// bounding box covers. Bounding boxes are enlarged a little, so any pair
+// IsochartIsSegmentsIntersect() accepts is reported, even when it accepts
+// segments that are only close to each other.
+class CSegmentGrid
+{
+public:
+    CSegmentGrid() : m_dwCellCountX(0), m_dwCellCountY(0), m_fMinX(0), m_fMinY(0), m_fCellSizeX(1), m_fCellSizeY(1) {}
+
+    // getSegment(ii, p0, p1) gets the end points of segment ii.
+    template <class TGetSegment>
+    HRESULT Init(
+        size_t dwSegmentCount,
+        TGetSegment&& getSegment)
+    {
+        Clear();
+
+        try
+        {
+            m_bounds.resize(dwSegmentCount);
+        }
+        catch (std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        // Covers the tolerance of IsochartIsSegmentsIntersect(), relative to
+        // the coordinates to also cover rounding errors
+        const float fMarginRate = 4 * ISOCHART_ZERO_EPS;
+
+        // 1. Bounding box of each segment and of all segments
+        float fMaxX = -FLT_MAX;
+        float fMaxY = -FLT_MAX;
+        m_fMinX = FLT_MAX;
+        m_fMinY = FLT_MAX;
+        bool bFinite = true;
+        for (size_t ii = 0; ii < dwSegmentCount; ii++)
+        {
+            DirectX::XMFLOAT2 p0, p1;
+            getSegment(ii, p0, p1);
+
+            float fMargin = fMarginRate
+                * (1.0f + std::max(std::max(fabsf(p0.x), fabsf(p0.y)), std::max(fabsf(p1.x), fabsf(p1.y))));
+
+            SEGMENTBOUND& bound = m_bounds[ii];
+            bound.fMinX = std::min(p0.x, p1.x) - fMargin;
+            bound.fMinY = std::min(p0.y, p1.y) - fMargin;
+            bound.fMaxX = std::max(p0.x, p1.x) + fMargin;
+            bound.fMaxY = std::max(p0.y, p1.y) + fMargin;
+
+            bFinite = bFinite
+                && std::isfinite(bound.fMinX) && std::isfinite(bound.fMinY)
+                && std::isfinite(bound.fMaxX) && std::isfinite(bound.fMaxY);
+
+            m_fMinX = std::min(m_fMinX, bound.fMinX);
+            m_fMinY = std::min(m_fMinY, bound.fMinY);
+            fMaxX = std::max(fMaxX, bound.fMaxX);
+            fMaxY = std::max(fMaxY, bound.fMaxY);
+        }
+
+        // 2. About one cell per segment, square cells if the box allows. If
+        // coordinates are not finite, all segments go into one cell.
+        m_dwCellCountX = 1;
+        m_dwCellCountY = 1;
+        float fWidth = fMaxX - m_fMinX;
+        float fHeight = fMaxY - m_fMinY;
+        if (bFinite && dwSegmentCount > 1 && fWidth > 0 && fHeight > 0)
+        {
+            float fCellSize = sqrtf(fWidth * fHeight / static_cast<float>(dwSegmentCount));
+            m_dwCellCountX = std::min(
+                static_cast<size_t>(fWidth / fCellSize) + 1, dwSegmentCount);
+            m_dwCellCountY = std::min(
+                static_cast<size_t>(fHeight / fCellSize) + 1, dwSegmentCount);
+        }
+
+        // 3. Long segments cover many cells, make the grid coarser until the
+        // segments are in SEGMENT_GRID_MAX_CELLS_PER_SEGMENT cells on average
+        for (;;)
+        {
+            m_fCellSizeX = (fWidth > 0) ? fWidth / static_cast<float>(m_dwCellCountX) : 1.0f;
+            m_fCellSizeY = (fHeight > 0) ? fHeight / static_cast<float>(m_dwCellCountY) : 1.0f;
+
+            size_t dwCellReferences = 0;
+            for (size_t ii = 0; ii < dwSegmentCount; ii++)
+            {
+                SEGMENTBOUND& bound = m_bounds[ii];
+                GetCellRange(bound);
+                dwCellReferences +=
+                    (bound.dwMaxCellX - bound.dwMinCellX + 1) * (bound.dwMaxCellY - bound.dwMinCellY + 1);
+            }
+
+            if (dwCellReferences <= SEGMENT_GRID_MAX_CELLS_PER_SEGMENT * dwSegmentCount
+                || (m_dwCellCountX == 1 && m_dwCellCountY == 1))
+            {
+                break;
+            }
+            m_dwCellCountX = (m_dwCellCountX + 1) / 2;
+            m_dwCellCountY = (m_dwCellCountY + 1) / 2;
+        }
+
+        // 4. Put segments into cells, the segments of cell ii are
+        // m_cellSegments[m_cellStart[ii]] to m_cellSegments[m_cellStart[ii+1]-1]
+        try
+        {
+            m_cellStart.assign(m_dwCellCountX * m_dwCellCountY + 1, 0);
+
+            for (size_t ii = 0; ii < dwSegmentCount; ii++)
+            {
+                const SEGMENTBOUND& bound = m_bounds[ii];
+                for (size_t y = bound.dwMinCellY; y <= bound.dwMaxCellY; y++)
+                {
+                    for (size_t x = bound.dwMinCellX; x <= bound.dwMaxCellX; x++)
+                    {
+                        m_cellStart[y * m_dwCellCountX + x + 1]++;
+                    }
+                }
+            }
+            for (size_t ii = 1; ii < m_cellStart.size(); ii++)
+            {
+                m_cellStart[ii] += m_cellStart[ii - 1];
+            }
+
+            m_cellSegments.resize(m_cellStart.back());
+            std::vector<size_t> cellFill(m_cellStart.cbegin(), m_cellStart.cend() - 1);
+            for (size_t ii = 0; ii < dwSegmentCount; ii++)
+            {
+                const SEGMENTBOUND& bound = m_bounds[ii];
+                for (size_t y = bound.dwMinCellY; y <= bound.dwMaxCellY; y++)
+                {
+                    for (size_t x = bound.dwMinCellX; x <= bound.dwMaxCellX; x++)
+                    {
+                        m_cellSegments[cellFill[y * m_dwCellCountX + x]++] = static_cast<uint32_t>(ii);
+                    }
+                }
+            }
+        }
+        catch (std::bad_alloc&)
+        {
+            Clear();
+            return E_OUTOFMEMORY;
+        }
+
+        return S_OK;
+    }
+
+    // Call func(ii, jj) once for each pair of segments whose enlarged bounding
+    // boxes overlap, ii < jj. Stop and return true as soon as func returns true.
+    template <class TFunc>
+    bool ForEachCandidatePair(TFunc&& func) const
+    {
+        for (size_t y = 0; y < m_dwCellCountY; y++)
+        {
+            for (size_t x = 0; x < m_dwCellCountX; x++)
+            {
+                size_t dwCell = y * m_dwCellCountX + x;
+                for (size_t ii = m_cellStart[dwCell]; ii < m_cellStart[dwCell + 1]; ii++)
+                {
+                    uint32_t dwSegment1 = m_cellSegments[ii];
+                    const SEGMENTBOUND& bound1 = m_bounds[dwSegment1];
+
+                    for (size_t jj = ii + 1; jj < m_cellStart[dwCell + 1]; jj++)
+                    {
+                        uint32_t dwSegment2 = m_cellSegments[jj];
+                        const SEGMENTBOUND& bound2 = m_bounds[dwSegment2];
+
+                        if (bound1.fMinX > bound2.fMaxX || bound2.fMinX > bound1.fMaxX
+                            || bound1.fMinY > bound2.fMaxY || bound2.fMinY > bound1.fMaxY)
+                        {
+                            continue;
+                        }
+
+                        // A pair sharing several cells is only reported in
+                        // the first of them
+                        if (std::max(bound1.dwMinCellX, bound2.dwMinCellX) != x
+                            || std::max(bound1.dwMinCellY, bound2.dwMinCellY) != y)
+                        {
+                            continue;
+                        }
+
+                        // Segments are added to cells in increasing order
+                        assert(dwSegment1 < dwSegment2);
+                        if (func(dwSegment1, dwSegment2))
+                        {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    void Clear()
+    {
+        m_bounds.clear();
+        m_cellStart.clear();
+        m_cellSegments.clear();
+        m_dwCellCountX = 0;
+        m_dwCellCountY = 0;
+    }
+
+private:
+    struct SEGMENTBOUND
+    {
+        float fMinX, fMinY, fMaxX, fMaxY;
+        size_t dwMinCellX, dwMinCellY, dwMaxCellX, dwMaxCellY;
+    };
+
+    size_t GetCell(float fCoord, float fMin, float fCellSize, size_t dwCellCount) const
+    {
+        float fCell = (fCoord - fMin) / fCellSize;
+        if (!(fCell > 0))
+        {
+            return 0;
+        }
+        return std::min(static_cast<size_t>(fCell), dwCellCount - 1);
+    }
+
+    void GetCellRange(SEGMENTBOUND& bound) const
+    {
+        bound.dwMinCellX = GetCell(bound.fMinX, m_fMinX, m_fCellSizeX, m_dwCellCountX);
+        bound.dwMaxCellX = GetCell(bound.fMaxX, m_fMinX, m_fCellSizeX, m_dwCellCountX);
+        bound.dwMinCellY = GetCell(bound.fMinY, m_fMinY, m_fCellSizeY, m_dwCellCountY);
+        bound.dwMaxCellY = GetCell(bound.fMaxY, m_fMinY, m_fCellSizeY, m_dwCellCountY);
+
+        // Not finite coordinates
+        if (bound.dwMaxCellX < bound.dwMinCellX)
+        {
+            bound.dwMinCellX = 0;
+            bound.dwMaxCellX = m_dwCellCountX - 1;
+        }
+        if (bound.dwMaxCellY < bound.dwMinCellY)
+        {
+            bound.dwMinCellY = 0;
+            bound.dwMaxCellY = m_dwCellCountY - 1;
+        }
+    }
+
+    std::vector<SEGMENTBOUND> m_bounds;
+    std::vector<size_t> m_cellStart;
+    std::vector<uint32_t> m_cellSegments;
+    size_t m_dwCellCountX;
+    size_t m_dwCellCountY;
+    float m_fMinX;
+    float m_fMinY;
+    float m_fCellSizeX;
+    float m_fCellSizeY;
+};
+}
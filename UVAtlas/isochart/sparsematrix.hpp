@@ -130,6 +130,10 @@ namespace Isochart
             
     };
 
+    // Sparse matrix in compressed sparse row (CSR) format. The matrix is built
+    // from triplets once and is immutable afterwards. Column indices of each row
+    // are sorted, so items can be found by binary search and products access
+    // memory sequentially.
     template<class TYPE>
     class CSparseMatrix
     {
@@ -139,179 +143,132 @@ namespace Isochart
         typedef TYPE value_type;
 
         static const size_type NOT_IN_MATRIX = 0xffffffff;
-        class RowItem
+
+        // One item used to build the matrix.
+        class Triplet
         {
             public:
+                pos_type rowIdx;
                 pos_type colIdx;
                 value_type value;
             public:
-                RowItem()
-                {
-                    colIdx = NOT_IN_MATRIX;
-                    value = 0;
-                }
-                RowItem(pos_type _colIdx, value_type _value)
+                Triplet(pos_type _rowIdx, pos_type _colIdx, value_type _value)
                 {
+                    rowIdx = _rowIdx;
                     colIdx = _colIdx;
                     value = _value;
                 }
+
+                bool operator < (const Triplet& other) const
+                {
+                    return rowIdx < other.rowIdx 
+                        || (rowIdx == other.rowIdx && colIdx < other.colIdx);
+                }
         };
 
-        class Row
-        {
-            private:
-                std::vector<RowItem> m_items;
-            public:
-                void Clear() {m_items.clear();}
-                
-                size_type size() const {return m_items.size();}
-                
-                RowItem& operator [] (const pos_type col) {return m_items[col];}
-                const RowItem& operator [] (const pos_type col)const {return m_items[col];}
+        public:
+            CSparseMatrix() {m_colCount = 0;}
+            size_type rowCount() const { return m_rowStart.empty() ? 0 : m_rowStart.size() - 1; }
+            size_type colCount() const { return m_colCount; }
+            size_type itemCount() const { return m_values.size(); }
 
-                size_type insert(const pos_type _col, const value_type _value)
-                {
-                    size_type idx = index(_col);
-                    if (idx == NOT_IN_MATRIX)
-                    {
-                        idx = m_items.size();
-                        RowItem item(_col, _value);
+            // Items of row rowIdx are [rowBegin(rowIdx), rowEnd(rowIdx))
+            size_type rowBegin(pos_type rowIdx) const { return m_rowStart[rowIdx]; }
+            size_type rowEnd(pos_type rowIdx) const { return m_rowStart[rowIdx+1]; }
+            pos_type colIndex(size_type item) const { return m_colIdx[item]; }
+            value_type value(size_type item) const { return m_values[item]; }
 
-                        try
-                        {
-                            m_items.push_back(item);
-                        }
-                        catch (std::bad_alloc&)
-                        {
-                            return NOT_IN_MATRIX;
-                        }
-                    }
-                    else
-                    {
-                        RowItem& item = m_items[idx];
-                        item.value = _value;
-                    }
-                    return idx;
-                }
+            // Build matrix from triplets, triplets at the same position are 
+            // added together. triplets is sorted in place.
+            bool build(
+                size_type _rowCount, 
+                size_type _colCount, 
+                std::vector<Triplet>& triplets)
+            {
+                std::sort(triplets.begin(), triplets.end());
 
-                bool increase(const pos_type _col, const value_type delta)
+                size_type itemCount = 0;
+                for (size_type ii=0; ii<triplets.size(); ii++)
                 {
-                    size_type idx = index(_col);
-                    if (idx == NOT_IN_MATRIX)
-                    {
-                        try
-                        {
-                            RowItem item(_col, delta);
-                            m_items.push_back(item);
-                        }
-                        catch(std::bad_alloc&)
-                        {
-                            return false;
-                        }
-                    }
-                    else
+                    assert(triplets[ii].rowIdx < _rowCount && triplets[ii].colIdx < _colCount);
+                    if (ii == 0
+                        || triplets[ii].rowIdx != triplets[ii-1].rowIdx
+                        || triplets[ii].colIdx != triplets[ii-1].colIdx)
                     {
-                        RowItem& item = m_items[idx];
-                        item.value += delta;
+                        itemCount++;
                     }
-                    return true;
-                }				
+                }
 
-                value_type getCol(const pos_type _col)
+                if (!allocate(_rowCount, _colCount, itemCount))
                 {
-                    size_type idx = index(_col);
-                    if (idx == NOT_IN_MATRIX)
-                    {
-                        return 0;
-                    }
-                    else
-                    {
-                        RowItem& item = m_items[idx];
-                        return item.value;
-                    }
+                    return false;
                 }
 
-            private:
-                size_type index(const pos_type _colIdx)
+                size_type item = 0;
+                for (size_type ii=0; ii<triplets.size(); ii++)
                 {
-                    for (size_type i=0; i<size(); i++)
+                    const Triplet& triplet = triplets[ii];
+                    if (ii > 0 
+                        && triplet.rowIdx == triplets[ii-1].rowIdx
+                        && triplet.colIdx == triplets[ii-1].colIdx)
                     {
-                        if (m_items[i].colIdx == _colIdx)
-                        {
-                            return i;
-                        }
+                        m_values[item-1] += triplet.value;
+                        continue;
                     }
-                    return NOT_IN_MATRIX;
-                }
-
-        };
 
-        public:
-            CSparseMatrix() {m_colCount = 0;}
-            size_type rowCount() const { return m_rows.size(); }
-            size_type colCount() const { return m_colCount; }
-            bool resize(size_type _rowCount, size_type _colCount)
-            {
-                if (_rowCount == rowCount())
-                {
-                    m_colCount = _colCount;
-                    return true;
+                    m_colIdx[item] = triplet.colIdx;
+                    m_values[item] = triplet.value;
+                    item++;
+                    m_rowStart[triplet.rowIdx+1] = item;
                 }
 
-                try
+                // Rows without item end where the previous row ends.
+                for (size_type ii=0; ii<_rowCount; ii++)
                 {
-                    m_rows.resize(_rowCount);
-                }
-                catch (std::bad_alloc&)
-                {
-                    return false;
+                    if (m_rowStart[ii+1] < m_rowStart[ii])
+                    {
+                        m_rowStart[ii+1] = m_rowStart[ii];
+                    }
                 }
-                m_colCount = _colCount;
                 return true;
             }
-            
-            Row& getRow(pos_type rowIdx)
-            {
-                return m_rows[rowIdx];
-            }
 
-            const Row& getRow (pos_type rowIdx) const
-            {
-                return m_rows[rowIdx];
-            }
-            
-            bool setItem(pos_type rowIdx, pos_type colIdx, value_type value)
+            value_type getItem(pos_type rowIdx, pos_type colIdx) const
             {
                 assert(rowIdx < rowCount() && colIdx < colCount());
-                Row& row = getRow(rowIdx);
-                if (row.insert(colIdx, value) == NOT_IN_MATRIX)
+                auto itBegin = m_colIdx.cbegin() + rowBegin(rowIdx);
+                auto itEnd = m_colIdx.cbegin() + rowEnd(rowIdx);
+                auto it = std::lower_bound(itBegin, itEnd, colIdx);
+                if (it == itEnd || *it != colIdx)
                 {
-                    return false;
+                    return 0;
                 }
-                return true;
+                return m_values[it - m_colIdx.cbegin()];
             }
 
-            value_type getItem(pos_type rowIdx, pos_type colIdx)
-            {
-                assert(rowIdx < rowCount() && colIdx < colCount());
-                Row& row = getRow(rowIdx);
-                return row.getCol(colIdx);
-            }
-
-
-            bool increase(pos_type rowIdx, pos_type colIdx, value_type delta)
+        private:
+            bool allocate(
+                size_type _rowCount, 
+                size_type _colCount, 
+                size_type _itemCount)
             {
-                assert(rowIdx < rowCount() && colIdx < colCount());
-                Row& row = getRow(rowIdx);
-                if (!row.increase(colIdx, delta))
+                try
+                {
+                    m_rowStart.assign(_rowCount+1, 0);
+                    m_colIdx.resize(_itemCount);
+                    m_values.resize(_itemCount);
+                }
+                catch (std::bad_alloc&)
                 {
                     return false;
                 }
+                m_colCount = _colCount;
                 return true;
-
             }
-        private:
-            std::vector<Row> m_rows;
+
+            std::vector<size_type> m_rowStart;
+            std::vector<pos_type> m_colIdx;
+            std::vector<value_type> m_values;
             size_type m_colCount;
 
         public:
@@ -335,16 +292,12 @@ namespace Isochart
             
             for (size_type ii=0; ii<srcMat.rowCount(); ii++)
             {
-                destVec[ii] = 0;
-
-                const Row& row = srcMat.getRow(ii);
-
-                for (size_type jj=0; jj<row.size(); jj++)
+                T total = 0;
+                for (size_type jj=srcMat.rowBegin(ii); jj<srcMat.rowEnd(ii); jj++)
                 {
-                    const RowItem& item = row[jj];
-                    assert(item.colIdx < srcMat.colCount());
-                    destVec[ii] += item.value * srcVec[item.colIdx];
+                    total += srcMat.m_values[jj] * srcVec[srcMat.m_colIdx[jj]];
                 }
+                destVec[ii] = total;
             }
             return true;
         }
@@ -370,13 +323,53 @@ namespace Isochart
             destVec.setZero();
             for (size_type ii=0; ii<srcMat.rowCount(); ii++)
             {
-                const Row& row = srcMat.getRow(ii);
+                for (size_type jj=srcMat.rowBegin(ii); jj<srcMat.rowEnd(ii); jj++)
+                {
+                    destVec[srcMat.m_colIdx[jj]] += srcMat.m_values[jj] * srcVec[ii];
+                }
+            }
+            return true;
+        }
 
-                for (size_type jj=0; jj<row.size(); jj++)
+        // A' = A^T
+        template<class T>
+        static bool Transpose(
+            CSparseMatrix<T>&  destMat, 
+            const CSparseMatrix<T>& srcMat)
+        {
+            if (!destMat.allocate(srcMat.colCount(), srcMat.rowCount(), srcMat.itemCount()))
+            {
+                return false;
+            }
+
+            // Count items of each column, then place them row by row, so the
+            // column indices of destination are sorted.
+            for (size_type ii=0; ii<srcMat.itemCount(); ii++)
+            {
+                destMat.m_rowStart[srcMat.m_colIdx[ii]+1]++;
+            }
+            for (size_type ii=0; ii<destMat.rowCount(); ii++)
+            {
+                destMat.m_rowStart[ii+1] += destMat.m_rowStart[ii];
+            }
+
+            std::vector<size_type> next;
+            try
+            {
+                next.assign(destMat.m_rowStart.cbegin(), destMat.m_rowStart.cend()-1);
+            }
+            catch (std::bad_alloc&)
+            {
+                return false;
+            }
+
+            for (size_type ii=0; ii<srcMat.rowCount(); ii++)
+            {
+                for (size_type jj=srcMat.rowBegin(ii); jj<srcMat.rowEnd(ii); jj++)
                 {
-                    const RowItem& item = row[jj];
-                    assert(item.colIdx < srcMat.colCount());
-                    destVec[item.colIdx] += item.value * srcVec[ii];
+                    size_type item = next[srcMat.m_colIdx[jj]]++;
+                    destMat.m_colIdx[item] = ii;
+                    destMat.m_values[item] = srcMat.m_values[jj];
                 }
             }
             return true;
@@ -388,72 +381,126 @@ namespace Isochart
             CSparseMatrix<T>&  destMat, 
             const CSparseMatrix<T>& srcMat)
         {
-            if (!destMat.resize(srcMat.colCount(), srcMat.colCount()))
+            // Row ii of A^T*A is the sum of rows of A, weighted by column ii 
+            // of A, which is row ii of A^T.
+            CSparseMatrix<T> transMat;
+            if (!Transpose(transMat, srcMat))
             {
                 return false;
             }
 
-            for (size_type ii=0; ii<srcMat.rowCount(); ii++)
+            const size_type dwDimension = srcMat.colCount();
+            std::vector<T> rowValues;
+            std::vector<size_type> rowMark;
+            std::vector<pos_type> rowCols;
+            try
+            {
+                rowValues.assign(dwDimension, 0);
+                rowMark.assign(dwDimension, size_type(NOT_IN_MATRIX));
+                rowCols.reserve(dwDimension);
+                destMat.m_rowStart.assign(dwDimension+1, 0);
+                destMat.m_colIdx.clear();
+                destMat.m_values.clear();
+            }
+            catch (std::bad_alloc&)
             {
-                const Row& row = srcMat.getRow(ii);
+                return false;
+            }
+            destMat.m_colCount = dwDimension;
 
-                for (size_type jj=0; jj<row.size(); jj++)
+            for (size_type ii=0; ii<dwDimension; ii++)
+            {
+                rowCols.clear();
+                for (size_type jj=transMat.rowBegin(ii); jj<transMat.rowEnd(ii); jj++)
                 {
-                    const RowItem& item1 = row[jj];
-                    for (size_type kk=0; kk<row.size(); kk++)
+                    pos_type srcRow = transMat.m_colIdx[jj];
+                    T weight = transMat.m_values[jj];
+                    for (size_type kk=srcMat.rowBegin(srcRow); kk<srcMat.rowEnd(srcRow); kk++)
                     {
-                        const RowItem& item2 = row[kk];
-                        if (!destMat.increase(
-                            item1.colIdx,
-                            item2.colIdx,
-                            item1.value * item2.value))
+                        pos_type col = srcMat.m_colIdx[kk];
+                        if (rowMark[col] != ii)
                         {
-                            return false;
+                            rowMark[col] = ii;
+                            rowValues[col] = 0;
+                            rowCols.push_back(col);
                         }
+                        rowValues[col] += weight * srcMat.m_values[kk];
                     }
                 }
+
+                std::sort(rowCols.begin(), rowCols.end());
+                try
+                {
+                    for (size_type jj=0; jj<rowCols.size(); jj++)
+                    {
+                        destMat.m_colIdx.push_back(rowCols[jj]);
+                        destMat.m_values.push_back(rowValues[rowCols[jj]]);
+                    }
+                }
+                catch (std::bad_alloc&)
+                {
+                    return false;
+                }
+                destMat.m_rowStart[ii+1] = destMat.m_colIdx.size();
             }
         
             return true;
         }
+    };
 
-        // v' = (A^T*A)*v
-        template<class T>
-        static bool Mat_SYMM_MUL_Vec(
-            CVector<T>& destVec, 
-            const CSparseMatrix<T>& srcMat, 
-            const CVector<T>& srcVec)
+    // Jacobi preconditioned conjugate gradient method, solves A * X = B where
+    // A is symmetric positive definite. All work vectors are allocated by 
+    // Init(), then the same matrix can be solved for several right-hand sides
+    // without any allocation.
+    template<class TYPE>
+    class CConjugateGradientSolver
+    {
+    public:
+        typedef size_t size_type;
+        typedef TYPE value_type;
+
+        CConjugateGradientSolver() : m_pMatrix(nullptr) {}
+
+        bool Init(const CSparseMatrix<TYPE>& A)
         {
-            assert(srcMat.colCount() == srcVec.size());
+            assert(A.rowCount() == A.colCount());
+            size_type dwDimension = A.rowCount();
 
-            if (!destVec.resize(srcMat.colCount()))
+            try
             {
-                return false;
+                m_invDiagonal.resize(dwDimension);
+                m_R.resize(dwDimension);
+                m_Z.resize(dwDimension);
+                m_D.resize(dwDimension);
+                m_Q.resize(dwDimension);
             }
-
-            CVector<T> tempVec;
-            if (!Mat_Mul_Vec<T>(tempVec, srcMat, srcVec))
+            catch (std::bad_alloc&)
             {
                 return false;
             }
 
-            if (!Mat_Trans_Mul_Vec<T>(destVec, srcMat, tempVec))
+            for (size_type ii=0; ii<dwDimension; ii++)
             {
-                return false;
+                TYPE diagonal = A.getItem(ii, ii);
+                m_invDiagonal[ii] = (diagonal > 0) ? 1 / diagonal : 1;
             }
-            
+
+            m_pMatrix = &A;
             return true;
         }
 
-        template<class T>
-        static bool ConjugateGradient(
-            CVector<T>& X,
-            const CSparseMatrix<T>& A,
-            const CVector<T>& B,			
+        // Stop when |B - A*X| <= epsilon * |B - A*X0|, where X0 is the initial 
+        // value of X, or zero if X has wrong size.
+        bool Solve(
+            CVector<TYPE>& X,
+            const CVector<TYPE>& B,			
             size_type maxIteration,			
-            T epsilon,
+            TYPE epsilon,
             size_type& iter)
         {	
+            assert(m_pMatrix != 0);
+            const CSparseMatrix<TYPE>& A = *m_pMatrix;
+
             if (X.size() != A.colCount())
             {
                 try
@@ -467,88 +514,512 @@ namespace Isochart
                 X.setZero();
             }            
 
-            CVector<T> R, D, Q, tempV;
+            const size_type dwDimension = A.rowCount();
 
-            if (!Mat_Mul_Vec(R, A, X))
+            Residual(X, B);
+            TYPE deltaNew = 0;
+            TYPE rho = 0;
+            for (size_type ii=0; ii<dwDimension; ii++)
             {
-                return false;
+                m_Z[ii] = m_invDiagonal[ii] * m_R[ii];
+                m_D[ii] = m_Z[ii];
+                deltaNew += m_R[ii] * m_R[ii];
+                rho += m_R[ii] * m_Z[ii];
+            }
+
+            TYPE errBound = deltaNew*epsilon*epsilon;
+
+            iter = 0;
+            while(iter < maxIteration && deltaNew > errBound)
+            {
+                CSparseMatrix<TYPE>::Mat_Mul_Vec(m_Q, A, m_D);
+
+                TYPE dq = CVector<TYPE>::dot(m_D, m_Q);
+                if (dq <= 0)
+                {
+                    break;
+                }
+                TYPE a = rho / dq;
+
+                for (size_type ii=0; ii<dwDimension; ii++)
+                {
+                    X[ii] += a * m_D[ii];
+                }
+
+                // Recompute the residual periodically to remove accumulated
+                // rounding error.
+                if (iter%10 == 0)
+                {
+                    Residual(X, B);
+                }
+                else
+                {
+                    for (size_type ii=0; ii<dwDimension; ii++)
+                    {
+                        m_R[ii] -= a * m_Q[ii];
+                    }
+                }
+
+                deltaNew = 0;
+                TYPE rhoNew = 0;
+                for (size_type ii=0; ii<dwDimension; ii++)
+                {
+                    m_Z[ii] = m_invDiagonal[ii] * m_R[ii];
+                    deltaNew += m_R[ii] * m_R[ii];
+                    rhoNew += m_R[ii] * m_Z[ii];
+                }
+
+                TYPE b = rhoNew / rho;
+                rho = rhoNew;
+                for (size_type ii=0; ii<dwDimension; ii++)
+                {
+                    m_D[ii] = m_Z[ii] + b * m_D[ii];
+                }
+
+                iter++;
             }
-            if (!CVector<T>::subtract(R, B, R))
+            return true;
+        }
+
+    private:
+        // R = B - A * X
+        void Residual(
+            const CVector<TYPE>& X,
+            const CVector<TYPE>& B)
+        {
+            CSparseMatrix<TYPE>::Mat_Mul_Vec(m_R, *m_pMatrix, X);
+            for (size_type ii=0; ii<m_R.size(); ii++)
+            {
+                m_R[ii] = B[ii] - m_R[ii];
+            }
+        }
+
+        const CSparseMatrix<TYPE>* m_pMatrix;
+        CVector<TYPE> m_invDiagonal;
+        CVector<TYPE> m_R, m_Z, m_D, m_Q;
+    };
+
+    // Direct solver of symmetric positive definite sparse matrix by LDL^T
+    // factorization. Rows and columns are first reordered by minimum degree to
+    // reduce fill-in, then the factor is computed once and can be used to solve 
+    // any number of right-hand sides.
+    // See: T. A. Davis, "Algorithm 849: A Concise Sparse Cholesky Factorization
+    // Package", ACM Transactions on Mathematical Software 31(4), 2005
+    template<class TYPE>
+    class CSparseCholeskySolver
+    {
+    public:
+        typedef size_t size_type;
+        typedef TYPE value_type;
+
+        static const size_type NO_PARENT = size_type(-1);
+
+        CSparseCholeskySolver() {}
+
+        size_type factorItemCount() const { return m_LValue.size(); }
+
+        // Factorize P*A*P^T = L*D*L^T. A must store both the upper and lower 
+        // triangle. Return false if out of memory or A is not positive definite.
+        bool Init(const CSparseMatrix<TYPE>& A)
+        {
+            assert(A.rowCount() == A.colCount());
+
+            try
+            {
+                MinimumDegreeOrdering(A);
+                SymbolicFactorize(A);
+            }
+            catch (std::bad_alloc&)
             {
                 return false;
             }
-            if (!CVector<T>::assign(D, R))
+
+            return NumericFactorize(A);
+        }
+
+        // Solve doesn't change the solver, several threads can share one
+        // factorization.
+        bool Solve(
+            CVector<TYPE>& X,
+            const CVector<TYPE>& B) const
+        {
+            const size_type dwDimension = m_perm.size();
+            assert(B.size() == dwDimension);
+
+            std::vector<TYPE> Y;
+            try
+            {
+                X.resize(dwDimension);
+                Y.resize(dwDimension);
+            }
+            catch (std::bad_alloc&)
             {
                 return false;
             }
 
-            T deltaNew = CVector<T>::dot(R, R);
-            T deltaZero = deltaNew;
-            T deltaOld = 0;
+            for (size_type ii=0; ii<dwDimension; ii++)
+            {
+                Y[ii] = B[m_perm[ii]];
+            }
 
-            T errBound = deltaZero*epsilon*epsilon;
+            // L*Z = P*B
+            for (size_type jj=0; jj<dwDimension; jj++)
+            {
+                TYPE y = Y[jj];
+                for (size_type p=m_LColStart[jj]; p<m_LColStart[jj+1]; p++)
+                {
+                    Y[m_LRowIdx[p]] -= m_LValue[p] * y;
+                }
+            }
 
-            iter = 0;
-            while(iter < maxIteration && deltaNew > errBound)
+            // D*W = Z
+            for (size_type jj=0; jj<dwDimension; jj++)
+            {
+                Y[jj] /= m_D[jj];
+            }
+
+            // L^T*Y = W
+            for (size_type jj=dwDimension; jj-- > 0; )
             {
-                if (!Mat_Mul_Vec(Q, A, D))
+                TYPE y = Y[jj];
+                for (size_type p=m_LColStart[jj]; p<m_LColStart[jj+1]; p++)
                 {
-                    return false;
+                    y -= m_LValue[p] * Y[m_LRowIdx[p]];
                 }
+                Y[jj] = y;
+            }
 
-                T a = deltaNew / CVector<T>::dot(D, Q);
+            for (size_type ii=0; ii<dwDimension; ii++)
+            {
+                X[m_perm[ii]] = Y[ii];
+            }
+            return true;
+        }
+
+    private:
+        // Approximate minimum degree ordering on the quotient graph. Each 
+        // eliminated vertex becomes an element standing for the clique formed 
+        // by its neighbors, so the elimination graph never needs to be built 
+        // explicitly. Degrees are upper bounds computed as in AMD: 
+        // P. R. Amestoy, T. A. Davis, I. S. Duff, "An Approximate Minimum Degree
+        // Ordering Algorithm", SIAM J. Matrix Anal. Appl. 17(4), 1996
+        // Variables are kept in linked lists by degree, the ordering is 
+        // deterministic.
+        void MinimumDegreeOrdering(const CSparseMatrix<TYPE>& A)
+        {
+            enum { STATUS_VARIABLE, STATUS_ELEMENT, STATUS_ABSORBED };
+
+            const size_type dwDimension = A.rowCount();
+
+            std::vector<std::vector<size_type>> variables(dwDimension);
+            std::vector<std::vector<size_type>> elements(dwDimension);
+            std::vector<uint8_t> status(dwDimension, STATUS_VARIABLE);
+            std::vector<size_type> degree(dwDimension);
+            std::vector<size_type> mark(dwDimension, NO_PARENT);
+            std::vector<size_type> outside(dwDimension);
+            std::vector<size_type> outsideMark(dwDimension, NO_PARENT);
+            std::vector<size_type> degreeHead(dwDimension, NO_PARENT);
+            std::vector<size_type> degreeNext(dwDimension);
+            std::vector<size_type> degreePrev(dwDimension);
+            size_type dwMinDegree = 0;
 
-                if (!CVector<T>::scale(tempV, D, a))
+            auto insertDegree = [&](size_type dwVar)
+            {
+                size_type dwDegree = degree[dwVar];
+                degreePrev[dwVar] = NO_PARENT;
+                degreeNext[dwVar] = degreeHead[dwDegree];
+                if (degreeHead[dwDegree] != NO_PARENT)
                 {
-                    return false;
+                    degreePrev[degreeHead[dwDegree]] = dwVar;
+                }
+                degreeHead[dwDegree] = dwVar;
+            };
+
+            auto removeDegree = [&](size_type dwVar)
+            {
+                if (degreePrev[dwVar] != NO_PARENT)
+                {
+                    degreeNext[degreePrev[dwVar]] = degreeNext[dwVar];
                 }
-                if (!CVector<T>::addTogether(X, X, tempV))
+                else
                 {
-                    return false;	
+                    degreeHead[degree[dwVar]] = degreeNext[dwVar];
                 }
+                if (degreeNext[dwVar] != NO_PARENT)
+                {
+                    degreePrev[degreeNext[dwVar]] = degreePrev[dwVar];
+                }
+            };
 
-                if (iter%10 == 0)
+            m_perm.resize(dwDimension);
+            m_invPerm.resize(dwDimension);
+
+            for (size_type ii=0; ii<dwDimension; ii++)
+            {
+                for (size_type item=A.rowBegin(ii); item<A.rowEnd(ii); item++)
                 {
-                    if (!Mat_Mul_Vec(R, A, X))
+                    if (A.colIndex(item) != ii)
                     {
-                        return false;
+                        variables[ii].push_back(A.colIndex(item));
                     }
-                    if (!CVector<T>::subtract(R, B, R))
+                }
+                degree[ii] = variables[ii].size();
+            }
+            for (size_type ii=dwDimension; ii-- > 0; )
+            {
+                insertDegree(ii);
+            }
+
+            for (size_type kk=0; kk<dwDimension; kk++)
+            {
+                // 1. Select the variable with minimum degree
+                while (degreeHead[dwMinDegree] == NO_PARENT)
+                {
+                    dwMinDegree++;
+                }
+                size_type dwPivot = degreeHead[dwMinDegree];
+                removeDegree(dwPivot);
+
+                m_perm[kk] = dwPivot;
+                m_invPerm[dwPivot] = kk;
+
+                // 2. Variables adjacent to pivot form the new element. Elements 
+                // adjacent to pivot are absorbed by the new element.
+                std::vector<size_type>& newElement = elements[dwPivot];
+                std::vector<size_type> pivotElements;
+                pivotElements.swap(newElement);
+
+                mark[dwPivot] = kk;
+                for (size_type ii=0; ii<variables[dwPivot].size(); ii++)
+                {
+                    size_type dwVar = variables[dwPivot][ii];
+                    if (mark[dwVar] != kk)
                     {
-                        return false;
+                        mark[dwVar] = kk;
+                        newElement.push_back(dwVar);
                     }
                 }
-                else
+                for (size_type ii=0; ii<pivotElements.size(); ii++)
                 {
-                    if (!CVector<T>::scale(tempV, Q, a))
+                    size_type dwElement = pivotElements[ii];
+                    if (status[dwElement] != STATUS_ELEMENT)
                     {
-                        return false;
+                        continue;
                     }
-                    if (!CVector<T>::subtract(R, R, tempV))
+                    const std::vector<size_type>& elementVars = elements[dwElement];
+                    for (size_type jj=0; jj<elementVars.size(); jj++)
                     {
-                        return false;
+                        size_type dwVar = elementVars[jj];
+                        if (mark[dwVar] != kk)
+                        {
+                            mark[dwVar] = kk;
+                            newElement.push_back(dwVar);
+                        }
                     }
+                    status[dwElement] = STATUS_ABSORBED;
+                    std::vector<size_type>().swap(elements[dwElement]);
                 }
-                deltaOld = deltaNew;
+                status[dwPivot] = STATUS_ELEMENT;
+                std::vector<size_type>().swap(variables[dwPivot]);
 
-                deltaNew = CVector<T>::dot(R, R);
+                // 3. For each element adjacent to the new element, count its
+                // variables outside of the new element.
+                for (size_type ii=0; ii<newElement.size(); ii++)
+                {
+                    const std::vector<size_type>& varElements = elements[newElement[ii]];
+                    for (size_type jj=0; jj<varElements.size(); jj++)
+                    {
+                        size_type dwElement = varElements[jj];
+                        if (status[dwElement] != STATUS_ELEMENT)
+                        {
+                            continue;
+                        }
+                        if (outsideMark[dwElement] != kk)
+                        {
+                            outsideMark[dwElement] = kk;
+                            outside[dwElement] = elements[dwElement].size();
+                        }
+                        outside[dwElement]--;
+                    }
+                }
 
-                T b = deltaNew / deltaOld;
-                
-                if (!CVector<T>::scale(tempV, D, b))
+                // 4. Update adjacency and approximate degree of variables in the
+                // new element. Variables in the new element are reachable through
+                // it, so they are removed from adjacent variables. Elements 
+                // covered by the new element are absorbed.
+                const size_type dwNewElementSize = newElement.size();
+                for (size_type ii=0; ii<dwNewElementSize; ii++)
                 {
-                    return false;
+                    size_type dwVar = newElement[ii];
+                    size_type dwDegree = dwNewElementSize - 1;
+
+                    std::vector<size_type>& varElements = elements[dwVar];
+                    size_type dwCount = 0;
+                    for (size_type jj=0; jj<varElements.size(); jj++)
+                    {
+                        size_type dwElement = varElements[jj];
+                        if (status[dwElement] != STATUS_ELEMENT)
+                        {
+                            continue;
+                        }
+                        if (outside[dwElement] == 0)
+                        {
+                            status[dwElement] = STATUS_ABSORBED;
+                            std::vector<size_type>().swap(elements[dwElement]);
+                            continue;
+                        }
+                        dwDegree += outside[dwElement];
+                        varElements[dwCount++] = dwElement;
+                    }
+                    varElements.resize(dwCount);
+                    varElements.push_back(dwPivot);
+
+                    std::vector<size_type>& varVariables = variables[dwVar];
+                    dwCount = 0;
+                    for (size_type jj=0; jj<varVariables.size(); jj++)
+                    {
+                        if (mark[varVariables[jj]] != kk)
+                        {
+                            varVariables[dwCount++] = varVariables[jj];
+                        }
+                    }
+                    varVariables.resize(dwCount);
+                    dwDegree += dwCount;
+
+                    dwDegree = std::min(dwDegree, dwDimension - kk - 1);
+                    dwDegree = std::min(dwDegree, degree[dwVar] + dwNewElementSize);
+                    removeDegree(dwVar);
+                    degree[dwVar] = dwDegree;
+                    insertDegree(dwVar);
+                    dwMinDegree = std::min(dwMinDegree, dwDegree);
                 }
-                if (!CVector<T>::addTogether(D, R, tempV))
+            }
+        }
+
+        // Compute elimination tree and item count of each column of L
+        void SymbolicFactorize(const CSparseMatrix<TYPE>& A)
+        {
+            const size_type dwDimension = A.rowCount();
+
+            m_parent.resize(dwDimension);
+            m_flag.resize(dwDimension);
+            m_LItemCount.resize(dwDimension);
+            m_LColStart.resize(dwDimension+1);
+            m_D.resize(dwDimension);
+            m_Y.resize(dwDimension);
+            m_pattern.resize(dwDimension);
+
+            for (size_type kk=0; kk<dwDimension; kk++)
+            {
+                m_parent[kk] = NO_PARENT;
+                m_flag[kk] = kk;
+                m_LItemCount[kk] = 0;
+
+                size_type dwRow = m_perm[kk];
+                for (size_type item=A.rowBegin(dwRow); item<A.rowEnd(dwRow); item++)
                 {
-                    return false;
+                    // Follow path from ii to the root of the elimination tree,
+                    // stop at flagged vertex
+                    for (size_type ii = m_invPerm[A.colIndex(item)];
+                        ii < kk && m_flag[ii] != kk; 
+                        ii = m_parent[ii])
+                    {
+                        if (m_parent[ii] == NO_PARENT)
+                        {
+                            m_parent[ii] = kk;
+                        }
+                        m_LItemCount[ii]++;
+                        m_flag[ii] = kk;
+                    }
                 }
+            }
 
-                iter++;
+            m_LColStart[0] = 0;
+            for (size_type kk=0; kk<dwDimension; kk++)
+            {
+                m_LColStart[kk+1] = m_LColStart[kk] + m_LItemCount[kk];
+            }
+
+            m_LRowIdx.resize(m_LColStart[dwDimension]);
+            m_LValue.resize(m_LColStart[dwDimension]);
+        }
+
+        // Compute L and D row by row.
+        bool NumericFactorize(const CSparseMatrix<TYPE>& A)
+        {
+            const size_type dwDimension = A.rowCount();
+
+            for (size_type kk=0; kk<dwDimension; kk++)
+            {
+                // 1. Scatter row kk of P*A*P^T into Y and find nonzero pattern 
+                // of row kk of L in topological order.
+                m_Y[kk] = 0;
+                size_type top = dwDimension;
+                m_flag[kk] = kk;
+                m_LItemCount[kk] = 0;
+
+                size_type dwRow = m_perm[kk];
+                for (size_type item=A.rowBegin(dwRow); item<A.rowEnd(dwRow); item++)
+                {
+                    size_type ii = m_invPerm[A.colIndex(item)];
+                    if (ii > kk)
+                    {
+                        continue;
+                    }
+                    m_Y[ii] += A.value(item);
+
+                    size_type len = 0;
+                    for (; m_flag[ii] != kk; ii = m_parent[ii])
+                    {
+                        m_pattern[len++] = ii;
+                        m_flag[ii] = kk;
+                    }
+                    while (len > 0)
+                    {
+                        m_pattern[--top] = m_pattern[--len];
+                    }
+                }
+
+                // 2. Compute numerical values of row kk of L and D[kk]
+                m_D[kk] = m_Y[kk];
+                m_Y[kk] = 0;
+                for (; top<dwDimension; top++)
+                {
+                    size_type ii = m_pattern[top];
+                    TYPE y = m_Y[ii];
+                    m_Y[ii] = 0;
+
+                    size_type end = m_LColStart[ii] + m_LItemCount[ii];
+                    for (size_type p=m_LColStart[ii]; p<end; p++)
+                    {
+                        m_Y[m_LRowIdx[p]] -= m_LValue[p] * y;
+                    }
+
+                    TYPE l = y / m_D[ii];
+                    m_D[kk] -= l * y;
+                    m_LRowIdx[end] = kk;
+                    m_LValue[end] = l;
+                    m_LItemCount[ii]++;
+                }
+
+                if (!(m_D[kk] > 0))
+                {
+                    return false;
+                }
             }
             return true;
         }
-        
+
+        std::vector<size_type> m_perm;
+        std::vector<size_type> m_invPerm;
+        std::vector<size_type> m_parent;
+        std::vector<size_type> m_flag;
+        std::vector<size_type> m_pattern;
+        std::vector<size_type> m_LItemCount;
+        std::vector<size_type> m_LColStart;
+        std::vector<size_type> m_LRowIdx;
+        std::vector<TYPE> m_LValue;
+        std::vector<TYPE> m_D;
+        std::vector<TYPE> m_Y;
     };
 }
-
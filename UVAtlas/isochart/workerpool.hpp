@@ -0,0 +1,418 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - workerpool.hpp
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "isochart.h"
+
+namespace Isochart
+{
+// Decide how many worker threads a task should use. The count is stored in
+// the _OPTIONMASK_ISOCHART_WORKERS field of isochart options:
+//  0 or 1 - run serially on the calling thread.
+//  _OPTION_ISOCHART_WORKERS_AUTO - one worker per hardware thread.
+//  Others - the specified number of workers.
+// Never returns more workers than dwMaxUseful, and never returns 0.
+inline size_t GetIsochartWorkerCount(
+    DWORD dwOptions,
+    size_t dwMaxUseful)
+{
+    size_t dwWorkers =
+        (dwOptions & _OPTIONMASK_ISOCHART_WORKERS) >> _OPTIONSHIFT_ISOCHART_WORKERS;
+
+    if (dwWorkers == (_OPTION_ISOCHART_WORKERS_AUTO >> _OPTIONSHIFT_ISOCHART_WORKERS))
+    {
+        dwWorkers = std::thread::hardware_concurrency();
+    }
+
+    if (dwWorkers > dwMaxUseful)
+    {
+        dwWorkers = dwMaxUseful;
+    }
+
+    return (dwWorkers > 0) ? dwWorkers : 1;
+}
+
+// Run workerProc(dwWorker) on dwWorkerCount threads and wait for all of them,
+// the calling thread is worker 0. If the system can not create more threads,
+// continue with the workers already created.
+template <class TWorkerProc>
+void RunOnWorkerThreads(
+    size_t dwWorkerCount,
+    TWorkerProc& workerProc)
+{
+    std::vector<std::thread> threads;
+    try
+    {
+        threads.reserve(dwWorkerCount - 1);
+        for (size_t i = 1; i < dwWorkerCount; i++)
+        {
+            threads.emplace_back(workerProc, i);
+        }
+    }
+    catch (std::system_error&)
+    {
+    }
+    catch (std::bad_alloc&)
+    {
+    }
+
+    workerProc(0);
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+// Threads that nested parallel loops may start. A thread of an outer loop
+// acquires one worker while it processes a task, an inner loop only uses the
+// workers left, so nested loops never run more threads than the isochart
+// options allow.
+class CWorkerBudget
+{
+public:
+    CWorkerBudget() : m_nSpareWorkers(0) {}
+
+    void Reset(size_t dwSpareWorkers)
+    {
+        m_nSpareWorkers = static_cast<ptrdiff_t>(dwSpareWorkers);
+    }
+
+    // Acquire dwCount workers even if the budget is exhausted.
+    size_t Acquire(size_t dwCount)
+    {
+        m_nSpareWorkers -= static_cast<ptrdiff_t>(dwCount);
+        return dwCount;
+    }
+
+    // Acquire at most dwWanted workers, return the number acquired.
+    size_t TryAcquire(size_t dwWanted)
+    {
+        ptrdiff_t nSpare = m_nSpareWorkers.load();
+        ptrdiff_t nTake;
+        do
+        {
+            if (nSpare <= 0)
+            {
+                return 0;
+            }
+            nTake = std::min(nSpare, static_cast<ptrdiff_t>(dwWanted));
+        } while (!m_nSpareWorkers.compare_exchange_weak(nSpare, nSpare - nTake));
+
+        return static_cast<size_t>(nTake);
+    }
+
+    void Release(size_t dwCount)
+    {
+        m_nSpareWorkers += static_cast<ptrdiff_t>(dwCount);
+    }
+
+private:
+    std::atomic<ptrdiff_t> m_nSpareWorkers;
+};
+
+// Return workers acquired from a budget when going out of scope.
+class CWorkerLease
+{
+public:
+    CWorkerLease(CWorkerBudget& budget, size_t dwCount)
+        : m_budget(budget), m_dwCount(dwCount) {}
+    ~CWorkerLease()
+    {
+        m_budget.Release(m_dwCount);
+    }
+
+    size_t GetCount() const { return m_dwCount; }
+
+private:
+    CWorkerLease(const CWorkerLease&) = delete;
+    CWorkerLease& operator=(const CWorkerLease&) = delete;
+
+    CWorkerBudget& m_budget;
+    size_t m_dwCount;
+};
+
+// Run func(dwWorker, i) for each i in [0, dwCount) on dwWorkerCount threads:
+//  HRESULT func(size_t dwWorker, size_t i)
+// Indices are handed out dynamically, so results must not depend on which
+// worker processes an index. Workers stop taking new indices after the first
+// failure.
+template <class TFunc>
+HRESULT ParallelFor(
+    size_t dwCount,
+    size_t dwWorkerCount,
+    TFunc&& func)
+{
+    if (dwCount == 0)
+    {
+        return S_OK;
+    }
+
+    std::atomic<size_t> dwNextIndex(0);
+    std::atomic<HRESULT> hrResult(S_OK);
+
+    auto workerProc = [&](size_t dwWorker)
+    {
+        while (SUCCEEDED(hrResult.load()))
+        {
+            size_t i = dwNextIndex++;
+            if (i >= dwCount)
+            {
+                break;
+            }
+
+            HRESULT hr = S_OK;
+            try
+            {
+                hr = func(dwWorker, i);
+            }
+            catch (std::bad_alloc&)
+            {
+                hr = E_OUTOFMEMORY;
+            }
+
+            if (FAILED(hr))
+            {
+                HRESULT hrExpected = S_OK;
+                hrResult.compare_exchange_strong(hrExpected, hr);
+            }
+        }
+    };
+
+    RunOnWorkerThreads(
+        (dwWorkerCount < dwCount) ? dwWorkerCount : dwCount,
+        workerProc);
+
+    return hrResult.load();
+}
+
+// Task queue owned by one worker. The owner pushes and pops at the back, so it
+// keeps working on the most recently spawned (cache-hot) tasks. Idle workers
+// steal from the front, where the oldest and usually largest tasks are.
+template <class TTask>
+class CWorkStealingQueue
+{
+public:
+    void Push(TTask&& task)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_tasks.push_back(std::move(task));
+    }
+
+    bool Pop(TTask& task)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_tasks.empty())
+        {
+            return false;
+        }
+        task = std::move(m_tasks.back());
+        m_tasks.pop_back();
+        return true;
+    }
+
+    bool Steal(TTask& task)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_tasks.empty())
+        {
+            return false;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        return true;
+    }
+
+    void MoveAllTo(std::vector<TTask>& tasks)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        for (auto& task : m_tasks)
+        {
+            tasks.push_back(std::move(task));
+        }
+        m_tasks.clear();
+    }
+
+private:
+    std::mutex m_lock;
+    std::deque<TTask> m_tasks;
+};
+
+// Process tasks on dwWorkerCount threads, the calling thread is worker 0.
+// Processing a task may spawn new tasks:
+//  HRESULT process(size_t dwWorker, TTask& task, std::vector<TTask>& spawned)
+// Spawned tasks are queued on the worker that created them, other workers
+// steal them when they become idle.
+// When process() fails, it must leave the task owning its resources and
+// spawn nothing. The remaining workers stop as soon as their current task
+// completes. The failed task and all tasks never processed are moved to
+// unfinishedTasks so the caller can release them.
+template <class TTask, class TProcess>
+HRESULT RunWorkStealingTasks(
+    std::vector<TTask>& initialTasks,
+    size_t dwWorkerCount,
+    TProcess&& process,
+    std::vector<TTask>& unfinishedTasks)
+{
+    if (dwWorkerCount == 0)
+    {
+        dwWorkerCount = 1;
+    }
+
+    std::unique_ptr<CWorkStealingQueue<TTask>[]> queues(
+        new (std::nothrow) CWorkStealingQueue<TTask>[dwWorkerCount]);
+    if (!queues)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    std::atomic<size_t> dwPendingTasks(initialTasks.size());
+    std::atomic<HRESULT> hrResult(S_OK);
+    std::mutex unfinishedLock;
+
+    // 1. Deal initial tasks to workers in round-robin order.
+    size_t dwDealt = 0;
+    try
+    {
+        for (; dwDealt < initialTasks.size(); dwDealt++)
+        {
+            queues[dwDealt % dwWorkerCount].Push(std::move(initialTasks[dwDealt]));
+        }
+    }
+    catch (std::bad_alloc&)
+    {
+        try
+        {
+            for (size_t i = 0; i < dwWorkerCount; i++)
+            {
+                queues[i].MoveAllTo(unfinishedTasks);
+            }
+            for (; dwDealt < initialTasks.size(); dwDealt++)
+            {
+                unfinishedTasks.push_back(std::move(initialTasks[dwDealt]));
+            }
+        }
+        catch (std::bad_alloc&)
+        {
+        }
+        initialTasks.clear();
+        return E_OUTOFMEMORY;
+    }
+    initialTasks.clear();
+
+    auto workerProc = [&](size_t dwWorker)
+    {
+        std::vector<TTask> spawned;
+        TTask task;
+
+        while (dwPendingTasks.load() > 0 && SUCCEEDED(hrResult.load()))
+        {
+            // 2.1 Take a task, first from our own queue, then from others.
+            bool bGotTask = queues[dwWorker].Pop(task);
+            for (size_t i = 1; !bGotTask && i < dwWorkerCount; i++)
+            {
+                bGotTask = queues[(dwWorker + i) % dwWorkerCount].Steal(task);
+            }
+
+            if (!bGotTask)
+            {
+                // Other workers are still processing tasks which may spawn
+                // new ones.
+                std::this_thread::yield();
+                continue;
+            }
+
+            // 2.2 Process the task and queue its children.
+            spawned.clear();
+            HRESULT hr = S_OK;
+            try
+            {
+                hr = process(dwWorker, task, spawned);
+            }
+            catch (std::bad_alloc&)
+            {
+                hr = E_OUTOFMEMORY;
+            }
+
+            // A failed process() still owns the task. Once it succeeded, the
+            // task is consumed and only its children can be left unfinished.
+            bool bTaskConsumed = SUCCEEDED(hr);
+            size_t dwQueued = 0;
+            if (bTaskConsumed)
+            {
+                dwPendingTasks += spawned.size();
+                try
+                {
+                    for (; dwQueued < spawned.size(); dwQueued++)
+                    {
+                        queues[dwWorker].Push(std::move(spawned[dwQueued]));
+                    }
+                }
+                catch (std::bad_alloc&)
+                {
+                    hr = E_OUTOFMEMORY;
+                }
+            }
+
+            if (FAILED(hr))
+            {
+                HRESULT hrExpected = S_OK;
+                hrResult.compare_exchange_strong(hrExpected, hr);
+
+                std::lock_guard<std::mutex> lock(unfinishedLock);
+                try
+                {
+                    if (!bTaskConsumed)
+                    {
+                        unfinishedTasks.push_back(std::move(task));
+                    }
+                    for (; dwQueued < spawned.size(); dwQueued++)
+                    {
+                        unfinishedTasks.push_back(std::move(spawned[dwQueued]));
+                    }
+                }
+                catch (std::bad_alloc&)
+                {
+                }
+            }
+            dwPendingTasks--;
+        }
+    };
+
+    // 3. Start workers.
+    RunOnWorkerThreads(dwWorkerCount, workerProc);
+
+    // 4. Return the tasks left in queues because of failure.
+    if (FAILED(hrResult.load()))
+    {
+        try
+        {
+            for (size_t i = 0; i < dwWorkerCount; i++)
+            {
+                queues[i].MoveAllTo(unfinishedTasks);
+            }
+        }
+        catch (std::bad_alloc&)
+        {
+        }
+    }
+
+    return hrResult.load();
+}
+
+}
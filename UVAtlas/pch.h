@@ -65,12 +65,14 @@
 #include <string.h>
 
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <functional>
 #include <vector>
 #include <queue>
 
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
 
 #include "UVAtlas.h"
 
@@ -0,0 +1,1035 @@
+//--------------------------------------------------------------------------------------
+// File: UVAtlasBench.cpp
+//
+// UVAtlas performance benchmarks. Times the expensive kernels of the library and
+// UVAtlasCreate on procedurally generated meshes, and writes the results as JSON
+// so that builds can be compared.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "isochart.h"
+#include "isochartstats.hpp"
+#include "isochartutil.h"
+#include "SymmetricMatrix.hpp"
+#include "sparsematrix.hpp"
+#include "ExactOneToAll.h"
+#include "mathutils.h"
+
+using namespace DirectX;
+using namespace Isochart;
+
+namespace
+{
+    // Face counts of the meshes UVAtlasCreate is measured on
+    const size_t CORPUS_FACE_COUNTS[] = { 1000, 10000, 100000, 1000000, 2000000 };
+
+    // Arguments of UVAtlasCreate, the defaults of UVAtlasTool
+    const float BENCH_MAX_STRETCH = 0.16667f;
+    const size_t BENCH_ATLAS_SIZE = 1024;
+    const float BENCH_GUTTER = 2.f;
+
+    struct SMesh
+    {
+        std::vector<XMFLOAT3> positions;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> adjacency;
+
+        size_t FaceCount() const { return indices.size() / 3; }
+    };
+
+    struct SSettings
+    {
+        std::string filter;
+        size_t maxFaces;
+        size_t repeat;
+        DWORD options;
+    };
+
+    struct SResult
+    {
+        std::string name;
+        std::string mesh;
+        size_t faces;
+        std::vector<double> times;
+        std::vector<std::pair<std::string, double>> metrics;
+    };
+
+    typedef std::chrono::steady_clock BenchClock;
+
+    double SecondsSince(BenchClock::time_point start)
+    {
+        return std::chrono::duration<double>(BenchClock::now() - start).count();
+    }
+
+    // Deterministic pseudo random numbers in [0, 1), results must not depend on the platform
+    class CRandom
+    {
+    public:
+        explicit CRandom(uint32_t seed) : m_state(seed) {}
+
+        float Next()
+        {
+            m_state = m_state * 1664525u + 1013904223u;
+            return float(m_state >> 8) / float(1u << 24);
+        }
+
+    private:
+        uint32_t m_state;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Mesh generators
+    //----------------------------------------------------------------------------------
+
+    // adjacency[3 * face + i] is the face sharing the edge from vertex i to vertex i + 1
+    void GenerateAdjacency(SMesh& mesh)
+    {
+        size_t nFaces = mesh.FaceCount();
+
+        std::unordered_map<uint64_t, uint32_t> edgeMap;
+        edgeMap.reserve(nFaces * 3);
+        for (size_t face = 0; face < nFaces; ++face)
+        {
+            for (size_t i = 0; i < 3; ++i)
+            {
+                uint64_t v0 = mesh.indices[face * 3 + i];
+                uint64_t v1 = mesh.indices[face * 3 + (i + 1) % 3];
+                edgeMap[(v0 << 32) | v1] = static_cast<uint32_t>(face * 3 + i);
+            }
+        }
+
+        mesh.adjacency.assign(nFaces * 3, uint32_t(-1));
+        for (size_t face = 0; face < nFaces; ++face)
+        {
+            for (size_t i = 0; i < 3; ++i)
+            {
+                uint64_t v0 = mesh.indices[face * 3 + i];
+                uint64_t v1 = mesh.indices[face * 3 + (i + 1) % 3];
+                auto it = edgeMap.find((v1 << 32) | v0);
+                if (it != edgeMap.end())
+                {
+                    mesh.adjacency[face * 3 + i] = it->second / 3;
+                }
+            }
+        }
+    }
+
+    void AddQuad(SMesh& mesh, uint32_t v00, uint32_t v10, uint32_t v01, uint32_t v11)
+    {
+        uint32_t quad[6] = { v00, v10, v11, v00, v11, v01 };
+        mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+    }
+
+    // Icosahedron subdivided until the face count is closest to nFaces
+    void GenerateSphere(size_t nFaces, SMesh& mesh)
+    {
+        const float t = (1.f + sqrtf(5.f)) / 2.f;
+        const XMFLOAT3 icoVerts[12] =
+        {
+            XMFLOAT3(-1, t, 0), XMFLOAT3(1, t, 0), XMFLOAT3(-1, -t, 0), XMFLOAT3(1, -t, 0),
+            XMFLOAT3(0, -1, t), XMFLOAT3(0, 1, t), XMFLOAT3(0, -1, -t), XMFLOAT3(0, 1, -t),
+            XMFLOAT3(t, 0, -1), XMFLOAT3(t, 0, 1), XMFLOAT3(-t, 0, -1), XMFLOAT3(-t, 0, 1),
+        };
+        const uint32_t icoFaces[60] =
+        {
+            0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+            1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+            3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+            4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+        };
+
+        mesh.positions.assign(icoVerts, icoVerts + 12);
+        mesh.indices.assign(icoFaces, icoFaces + 60);
+
+        // Each level quadruples the faces
+        while (mesh.FaceCount() * 2 <= nFaces)
+        {
+            std::unordered_map<uint64_t, uint32_t> midpoints;
+            std::vector<uint32_t> indices;
+            indices.reserve(mesh.indices.size() * 4);
+
+            auto midpoint = [&](uint32_t v0, uint32_t v1) -> uint32_t
+            {
+                uint64_t key = (uint64_t(std::min(v0, v1)) << 32) | std::max(v0, v1);
+                auto it = midpoints.find(key);
+                if (it != midpoints.end())
+                {
+                    return it->second;
+                }
+
+                const XMFLOAT3& p0 = mesh.positions[v0];
+                const XMFLOAT3& p1 = mesh.positions[v1];
+                uint32_t v = static_cast<uint32_t>(mesh.positions.size());
+                mesh.positions.push_back(
+                    XMFLOAT3((p0.x + p1.x) / 2, (p0.y + p1.y) / 2, (p0.z + p1.z) / 2));
+                midpoints[key] = v;
+                return v;
+            };
+
+            for (size_t face = 0; face < mesh.FaceCount(); ++face)
+            {
+                uint32_t v0 = mesh.indices[face * 3];
+                uint32_t v1 = mesh.indices[face * 3 + 1];
+                uint32_t v2 = mesh.indices[face * 3 + 2];
+                uint32_t m01 = midpoint(v0, v1);
+                uint32_t m12 = midpoint(v1, v2);
+                uint32_t m20 = midpoint(v2, v0);
+
+                uint32_t sub[12] = { v0, m01, m20, v1, m12, m01, v2, m20, m12, m01, m12, m20 };
+                indices.insert(indices.end(), sub, sub + 12);
+            }
+            mesh.indices.swap(indices);
+        }
+
+        for (auto& p : mesh.positions)
+        {
+            XMStoreFloat3(&p, XMVector3Normalize(XMLoadFloat3(&p)));
+        }
+    }
+
+    void GenerateTorus(size_t nFaces, SMesh& mesh)
+    {
+        const float majorRadius = 1.f;
+        const float minorRadius = 0.3f;
+
+        // 2 * rings * segments faces, with twice as many rings as segments
+        uint32_t segments = std::max<uint32_t>(3, static_cast<uint32_t>(sqrt(nFaces / 4.0) + 0.5));
+        uint32_t rings = segments * 2;
+
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            float u = XM_2PI * float(i) / float(rings);
+            for (uint32_t j = 0; j < segments; ++j)
+            {
+                float v = XM_2PI * float(j) / float(segments);
+                float r = majorRadius + minorRadius * cosf(v);
+                mesh.positions.push_back(XMFLOAT3(r * cosf(u), r * sinf(u), minorRadius * sinf(v)));
+            }
+        }
+
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            uint32_t i1 = (i + 1) % rings;
+            for (uint32_t j = 0; j < segments; ++j)
+            {
+                uint32_t j1 = (j + 1) % segments;
+                AddQuad(mesh, i * segments + j, i1 * segments + j, i * segments + j1, i1 * segments + j1);
+            }
+        }
+    }
+
+    // Open grid displaced by waves and noise
+    void GenerateHeightField(size_t nFaces, SMesh& mesh)
+    {
+        uint32_t cells = std::max<uint32_t>(1, static_cast<uint32_t>(sqrt(nFaces / 2.0) + 0.5));
+
+        CRandom random(0x1234567u);
+        for (uint32_t i = 0; i <= cells; ++i)
+        {
+            float y = float(i) / float(cells);
+            for (uint32_t j = 0; j <= cells; ++j)
+            {
+                float x = float(j) / float(cells);
+                float z = 0.1f * sinf(x * 9.f) * cosf(y * 7.f)
+                    + 0.02f * (random.Next() - 0.5f);
+                mesh.positions.push_back(XMFLOAT3(x, y, z));
+            }
+        }
+
+        for (uint32_t i = 0; i < cells; ++i)
+        {
+            for (uint32_t j = 0; j < cells; ++j)
+            {
+                uint32_t v = i * (cells + 1) + j;
+                AddQuad(mesh, v, v + 1, v + cells + 1, v + cells + 2);
+            }
+        }
+    }
+
+    // Open tube 100 times longer than its radius
+    void GenerateThinCylinder(size_t nFaces, SMesh& mesh)
+    {
+        const uint32_t segments = 16;
+        const float radius = 0.01f;
+        const float length = 1.f;
+
+        uint32_t rings = std::max<uint32_t>(1, static_cast<uint32_t>(nFaces / (2 * segments)));
+
+        for (uint32_t i = 0; i <= rings; ++i)
+        {
+            float z = length * float(i) / float(rings);
+            for (uint32_t j = 0; j < segments; ++j)
+            {
+                float a = XM_2PI * float(j) / float(segments);
+                mesh.positions.push_back(XMFLOAT3(radius * cosf(a), radius * sinf(a), z));
+            }
+        }
+
+        for (uint32_t i = 0; i < rings; ++i)
+        {
+            for (uint32_t j = 0; j < segments; ++j)
+            {
+                uint32_t j1 = (j + 1) % segments;
+                AddQuad(mesh, i * segments + j, i * segments + j1, (i + 1) * segments + j, (i + 1) * segments + j1);
+            }
+        }
+    }
+
+    struct SMeshGenerator
+    {
+        const char* name;
+        void (*generate)(size_t nFaces, SMesh& mesh);
+    };
+
+    const SMeshGenerator MESH_GENERATORS[] =
+    {
+        { "sphere", GenerateSphere },
+        { "torus", GenerateTorus },
+        { "heightfield", GenerateHeightField },
+        { "thincylinder", GenerateThinCylinder },
+    };
+
+    void GenerateMesh(const SMeshGenerator& generator, size_t nFaces, SMesh& mesh)
+    {
+        mesh = SMesh();
+        generator.generate(nFaces, mesh);
+        GenerateAdjacency(mesh);
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Benchmark runner
+    //----------------------------------------------------------------------------------
+
+    class CBench
+    {
+    public:
+        explicit CBench(const SSettings& settings) : m_settings(settings) {}
+
+        bool IsEnabled(const std::string& name) const
+        {
+            return m_settings.filter.empty() || name.find(m_settings.filter) != std::string::npos;
+        }
+
+        const SSettings& GetSettings() const { return m_settings; }
+
+        // Time run() settings.repeat times. setup() is called before each run and
+        // isn't timed. Both return an HRESULT, the benchmark stops on failure.
+        template <class TSetup, class TRun>
+        HRESULT Run(
+            SResult& result,
+            TSetup&& setup,
+            TRun&& run)
+        {
+            for (size_t i = 0; i < m_settings.repeat; ++i)
+            {
+                HRESULT hr = setup();
+                if (FAILED(hr))
+                    return hr;
+
+                auto start = BenchClock::now();
+                hr = run();
+                double seconds = SecondsSince(start);
+                if (FAILED(hr))
+                    return hr;
+
+                result.times.push_back(seconds);
+            }
+            return S_OK;
+        }
+
+        void Report(SResult&& result, HRESULT hr)
+        {
+            if (FAILED(hr))
+            {
+                fprintf(stderr, "%s %s %zu faces failed (%08X)\n",
+                    result.name.c_str(), result.mesh.c_str(), result.faces, static_cast<unsigned int>(hr));
+                return;
+            }
+
+            fprintf(stderr, "%-20s %-14s %8zu faces %10.4f s\n",
+                result.name.c_str(), result.mesh.c_str(), result.faces, MinTime(result));
+            m_results.push_back(std::move(result));
+        }
+
+        void WriteJson(FILE* file) const;
+
+    private:
+        static double MinTime(const SResult& result)
+        {
+            return *std::min_element(result.times.cbegin(), result.times.cend());
+        }
+
+        SSettings m_settings;
+        std::vector<SResult> m_results;
+    };
+
+    void WriteJsonString(FILE* file, const std::string& str)
+    {
+        fputc('"', file);
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+            {
+                fputc('\\', file);
+            }
+            fputc(c, file);
+        }
+        fputc('"', file);
+    }
+
+    void CBench::WriteJson(FILE* file) const
+    {
+        fprintf(file, "{\n  \"context\": {\n");
+        fprintf(file, "    \"version\": %d,\n", UVATLAS_VERSION);
+#ifdef _DEBUG
+        fprintf(file, "    \"build\": \"debug\",\n");
+#else
+        fprintf(file, "    \"build\": \"release\",\n");
+#endif
+        fprintf(file, "    \"hardwareThreads\": %u,\n", std::thread::hardware_concurrency());
+        fprintf(file, "    \"options\": %lu,\n", static_cast<unsigned long>(m_settings.options));
+        fprintf(file, "    \"repeat\": %zu\n  },\n", m_settings.repeat);
+
+        fprintf(file, "  \"benchmarks\": [");
+        for (size_t i = 0; i < m_results.size(); ++i)
+        {
+            const SResult& result = m_results[i];
+
+            std::vector<double> sorted(result.times);
+            std::sort(sorted.begin(), sorted.end());
+            double total = 0;
+            for (double t : sorted)
+            {
+                total += t;
+            }
+
+            fprintf(file, "%s\n    {\n      \"name\": ", (i > 0) ? "," : "");
+            WriteJsonString(file, result.name);
+            fprintf(file, ",\n      \"mesh\": ");
+            WriteJsonString(file, result.mesh);
+            fprintf(file, ",\n      \"faces\": %zu,\n", result.faces);
+            fprintf(file, "      \"runs\": %zu,\n", sorted.size());
+            fprintf(file, "      \"minSeconds\": %.9g,\n", sorted.front());
+            fprintf(file, "      \"medianSeconds\": %.9g,\n", sorted[sorted.size() / 2]);
+            fprintf(file, "      \"meanSeconds\": %.9g", total / double(sorted.size()));
+            for (auto& metric : result.metrics)
+            {
+                fprintf(file, ",\n      ");
+                WriteJsonString(file, metric.first);
+                fprintf(file, ": %.9g", metric.second);
+            }
+            fprintf(file, "\n    }");
+        }
+        fprintf(file, "\n  ]\n}\n");
+    }
+
+    SResult MakeResult(const char* name, const std::string& mesh, size_t faces)
+    {
+        SResult result;
+        result.name = name;
+        result.mesh = mesh;
+        result.faces = faces;
+        return result;
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Microbenchmarks
+    //----------------------------------------------------------------------------------
+
+    // Builds the data structure of the exact geodesic algorithm the way
+    // CIsochartMesh::InitOneToAllEngine does for a chart.
+    void InitOneToAllEngine(const SMesh& mesh, GeodesicDist::CExactOneToAll& engine)
+    {
+        using namespace GeodesicDist;
+
+        size_t nFaces = mesh.FaceCount();
+        std::vector<uint32_t> faceEdges(nFaces * 3);
+
+        struct SEdge { uint32_t v0, v1, f0, f1; };
+        std::vector<SEdge> edges;
+        for (size_t face = 0; face < nFaces; ++face)
+        {
+            for (size_t i = 0; i < 3; ++i)
+            {
+                uint32_t adj = mesh.adjacency[face * 3 + i];
+                if (adj != uint32_t(-1) && adj < face)
+                {
+                    // Already added by the adjacent face
+                    for (size_t j = 0; j < 3; ++j)
+                    {
+                        if (mesh.adjacency[adj * 3 + j] == face)
+                        {
+                            faceEdges[face * 3 + i] = faceEdges[adj * 3 + j];
+                            edges[faceEdges[face * 3 + i]].f1 = static_cast<uint32_t>(face);
+                            break;
+                        }
+                    }
+                    continue;
+                }
+
+                faceEdges[face * 3 + i] = static_cast<uint32_t>(edges.size());
+                edges.push_back({ mesh.indices[face * 3 + i], mesh.indices[face * 3 + (i + 1) % 3],
+                    static_cast<uint32_t>(face), FLAG_INVALIDDWORD });
+            }
+        }
+
+        engine.m_VertexList.clear();
+        engine.m_EdgeList.clear();
+        engine.m_FaceList.clear();
+        engine.m_VertexList.resize(mesh.positions.size());
+        engine.m_EdgeList.resize(edges.size());
+        engine.m_FaceList.resize(nFaces);
+
+        for (size_t i = 0; i < mesh.positions.size(); ++i)
+        {
+            Vertex& vertex = engine.m_VertexList[i];
+            vertex.x = mesh.positions[i].x;
+            vertex.y = mesh.positions[i].y;
+            vertex.z = mesh.positions[i].z;
+        }
+
+        for (size_t i = 0; i < edges.size(); ++i)
+        {
+            Edge& edge = engine.m_EdgeList[i];
+            edge.dwVertexIdx0 = edges[i].v0;
+            edge.pVertex0 = &engine.m_VertexList[edge.dwVertexIdx0];
+            edge.dwVertexIdx1 = edges[i].v1;
+            edge.pVertex1 = &engine.m_VertexList[edge.dwVertexIdx1];
+            edge.dwAdjFaceIdx0 = edges[i].f0;
+            edge.pAdjFace0 = &engine.m_FaceList[edge.dwAdjFaceIdx0];
+            edge.dwAdjFaceIdx1 = edges[i].f1;
+            edge.pAdjFace1 = (edges[i].f1 == FLAG_INVALIDDWORD) ? nullptr : &engine.m_FaceList[edge.dwAdjFaceIdx1];
+            edge.dEdgeLength = sqrt(SquredD3Dist(*edge.pVertex0, *edge.pVertex1));
+
+            edge.pVertex0->edgesAdj.push_back(&edge);
+            edge.pVertex1->edgesAdj.push_back(&edge);
+            if (!edge.pAdjFace1)
+            {
+                edge.pVertex0->bBoundary = true;
+                edge.pVertex1->bBoundary = true;
+            }
+        }
+
+        for (size_t i = 0; i < nFaces; ++i)
+        {
+            Face& face = engine.m_FaceList[i];
+            face.dwEdgeIdx0 = faceEdges[i * 3];
+            face.pEdge0 = &engine.m_EdgeList[face.dwEdgeIdx0];
+            face.dwEdgeIdx1 = faceEdges[i * 3 + 1];
+            face.pEdge1 = &engine.m_EdgeList[face.dwEdgeIdx1];
+            face.dwEdgeIdx2 = faceEdges[i * 3 + 2];
+            face.pEdge2 = &engine.m_EdgeList[face.dwEdgeIdx2];
+
+            face.dwVertexIdx0 = mesh.indices[i * 3];
+            face.pVertex0 = &engine.m_VertexList[face.dwVertexIdx0];
+            face.dwVertexIdx1 = mesh.indices[i * 3 + 1];
+            face.pVertex1 = &engine.m_VertexList[face.dwVertexIdx1];
+            face.dwVertexIdx2 = mesh.indices[i * 3 + 2];
+            face.pVertex2 = &engine.m_VertexList[face.dwVertexIdx2];
+
+            face.pVertex2->dAngle += ComputeAngleBetween2Lines(*face.pVertex2, *face.pVertex0, *face.pVertex1);
+            face.pVertex1->dAngle += ComputeAngleBetween2Lines(*face.pVertex1, *face.pVertex0, *face.pVertex2);
+            face.pVertex0->dAngle += ComputeAngleBetween2Lines(*face.pVertex0, *face.pVertex1, *face.pVertex2);
+
+            face.pVertex0->bUsed = true;
+            face.pVertex1->bUsed = true;
+            face.pVertex2->bUsed = true;
+
+            face.pVertex0->facesAdj.push_back(&face);
+            face.pVertex1->facesAdj.push_back(&face);
+            face.pVertex2->facesAdj.push_back(&face);
+        }
+    }
+
+    // CExactOneToAll::Run from several sources of a sphere and a height field
+    void BenchExactGeodesic(CBench& bench)
+    {
+        const char* name = "exact_one_to_all";
+        const size_t SOURCES = 8;
+
+        if (!bench.IsEnabled(name))
+            return;
+
+        for (size_t meshType : { 0, 2 })
+        {
+            SMesh mesh;
+            GenerateMesh(MESH_GENERATORS[meshType], 5000, mesh);
+
+            std::unique_ptr<GeodesicDist::CExactOneToAll> engine(new GeodesicDist::CExactOneToAll);
+            InitOneToAllEngine(mesh, *engine);
+
+            SResult result = MakeResult(name, MESH_GENERATORS[meshType].name, mesh.FaceCount());
+            HRESULT hr = bench.Run(result,
+                [] { return S_OK; },
+                [&]
+                {
+                    for (size_t i = 0; i < SOURCES; ++i)
+                    {
+                        engine->SetSrcVertexIdx(static_cast<uint32_t>(i * mesh.positions.size() / SOURCES));
+                        engine->Run();
+                    }
+                    return S_OK;
+                });
+            result.metrics.emplace_back("sources", double(SOURCES));
+            bench.Report(std::move(result), hr);
+        }
+    }
+
+    // Runs the isochart engine up to the end of partitioning with the fast
+    // geodesic option, where every geodesic distance is computed by the [KS98]
+    // approach. The geodesic stage time is reported per geodesic run.
+    void BenchKS98Geodesic(CBench& bench)
+    {
+        const char* name = "geodesic_ks98";
+        if (!bench.IsEnabled(name))
+            return;
+
+        for (size_t nFaces : { 10000, 100000 })
+        {
+            if (nFaces > bench.GetSettings().maxFaces)
+                continue;
+
+            SMesh mesh;
+            GenerateMesh(MESH_GENERATORS[0], nFaces, mesh);
+
+            std::unique_ptr<CIsochartStats> stats;
+            SResult result = MakeResult(name, MESH_GENERATORS[0].name, mesh.FaceCount());
+            HRESULT hr = bench.Run(result,
+                [&]() -> HRESULT
+                {
+                    stats.reset(new (std::nothrow) CIsochartStats);
+                    return stats ? S_OK : E_OUTOFMEMORY;
+                },
+                [&]
+                {
+                    std::vector<UVAtlasVertex> vb;
+                    std::vector<uint8_t> ib;
+                    std::vector<uint32_t> remap, attributes, adjacency;
+                    return isochartpartition(mesh.positions.data(), mesh.positions.size(), sizeof(XMFLOAT3),
+                        DXGI_FORMAT_R32_UINT, mesh.indices.data(), mesh.FaceCount(), nullptr,
+                        0, BENCH_MAX_STRETCH, mesh.adjacency.data(),
+                        &vb, &ib, &remap, &attributes, &adjacency, nullptr, nullptr,
+                        MAKE_STAGE(1U, 0U, 1U), nullptr, 0.01f, nullptr,
+                        _OPTION_ISOCHART_GEODESIC_FAST, stats.get());
+                });
+            if (SUCCEEDED(hr))
+            {
+                UVAtlasStats out;
+                stats->Export(out);
+                result.metrics.emplace_back("geodesicRuns", double(out.geodesicRuns));
+                result.metrics.emplace_back("geodesicSeconds", out.geodesicCpuTime);
+                result.metrics.emplace_back("secondsPerRun",
+                    out.geodesicRuns ? out.geodesicCpuTime / double(out.geodesicRuns) : 0.0);
+            }
+            bench.Report(std::move(result), hr);
+        }
+    }
+
+    // CSymmetricMatrix::GetEigen of isomap sized matrices, the 10 largest eigen pairs
+    void BenchSymmetricEigen(CBench& bench)
+    {
+        const char* name = "symmetric_eigen";
+        const size_t EIGEN_DIMENSION = 10;
+
+        if (!bench.IsEnabled(name))
+            return;
+
+        for (size_t dwDimension : { 100, 200, 400 })
+        {
+            // Squared distances of random points, as isomap decomposes
+            CRandom random(static_cast<uint32_t>(dwDimension));
+            std::vector<XMFLOAT3> points(dwDimension);
+            for (auto& p : points)
+            {
+                p = XMFLOAT3(random.Next(), random.Next(), random.Next());
+            }
+
+            std::vector<float> matrix(dwDimension * dwDimension);
+            for (size_t i = 0; i < dwDimension; ++i)
+            {
+                for (size_t j = 0; j < dwDimension; ++j)
+                {
+                    float dx = points[i].x - points[j].x;
+                    float dy = points[i].y - points[j].y;
+                    float dz = points[i].z - points[j].z;
+                    matrix[i * dwDimension + j] = dx * dx + dy * dy + dz * dz;
+                }
+            }
+
+            // GetEigen uses the whole buffers as work space, like CIsoMap
+            std::vector<float> eigenValue(dwDimension);
+            std::vector<float> eigenVector(dwDimension * dwDimension);
+
+            SResult result = MakeResult(name, "matrix" + std::to_string(dwDimension), 0);
+            HRESULT hr = bench.Run(result,
+                [] { return S_OK; },
+                [&]
+                {
+                    return CSymmetricMatrix<float>::GetEigen(dwDimension, matrix.data(),
+                        eigenValue.data(), eigenVector.data(), EIGEN_DIMENSION) ? S_OK : E_FAIL;
+                });
+            result.metrics.emplace_back("dimension", double(dwDimension));
+            bench.Report(std::move(result), hr);
+        }
+    }
+
+    // CConjugateGradientSolver on the Laplacian of an n x n grid with fixed
+    // boundary, like barycentric parameterization of a square chart
+    void BenchConjugateGradient(CBench& bench)
+    {
+        const char* name = "conjugate_gradient";
+        const size_t MAX_ITERATION = 10000;
+
+        if (!bench.IsEnabled(name))
+            return;
+
+        for (size_t n : { 64, 128, 256 })
+        {
+            size_t dwDimension = n * n;
+            std::vector<CSparseMatrix<double>::Triplet> triplets;
+            CVector<double> B;
+            B.resize(dwDimension);
+            B.setZero();
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                for (size_t j = 0; j < n; ++j)
+                {
+                    size_t row = i * n + j;
+                    triplets.push_back(CSparseMatrix<double>::Triplet(row, row, 4.0));
+                    const ptrdiff_t di[4] = { -1, 1, 0, 0 };
+                    const ptrdiff_t dj[4] = { 0, 0, -1, 1 };
+                    for (size_t k = 0; k < 4; ++k)
+                    {
+                        ptrdiff_t ni = ptrdiff_t(i) + di[k];
+                        ptrdiff_t nj = ptrdiff_t(j) + dj[k];
+                        if (ni < 0 || nj < 0 || ni >= ptrdiff_t(n) || nj >= ptrdiff_t(n))
+                        {
+                            // Boundary value is the x coordinate
+                            B[row] += double(nj + 1) / double(n + 1);
+                        }
+                        else
+                        {
+                            triplets.push_back(CSparseMatrix<double>::Triplet(row, size_t(ni) * n + size_t(nj), -1.0));
+                        }
+                    }
+                }
+            }
+
+            CSparseMatrix<double> A;
+            CConjugateGradientSolver<double> solver;
+            if (!A.build(dwDimension, dwDimension, triplets) || !solver.Init(A))
+            {
+                bench.Report(MakeResult(name, "grid" + std::to_string(n), 0), E_OUTOFMEMORY);
+                continue;
+            }
+
+            CVector<double> X;
+            size_t iterations = 0;
+            SResult result = MakeResult(name, "grid" + std::to_string(n), 0);
+            HRESULT hr = bench.Run(result,
+                [&]
+                {
+                    X.clear();
+                    return S_OK;
+                },
+                [&]
+                {
+                    return solver.Solve(X, B, MAX_ITERATION, 1e-8, iterations) ? S_OK : E_FAIL;
+                });
+            result.metrics.emplace_back("dimension", double(dwDimension));
+            result.metrics.emplace_back("iterations", double(iterations));
+            bench.Report(std::move(result), hr);
+        }
+    }
+
+    // CIsochartMesh::PackingCharts through IIsochartEngine::Pack. The charts
+    // are partitioned again before each run, the packing isn't repeatable.
+    void BenchPackingCharts(CBench& bench)
+    {
+        const char* name = "packing_charts";
+        if (!bench.IsEnabled(name))
+            return;
+
+        for (size_t nFaces : { 10000, 100000 })
+        {
+            if (nFaces > bench.GetSettings().maxFaces)
+                continue;
+
+            SMesh mesh;
+            GenerateMesh(MESH_GENERATORS[1], nFaces, mesh);
+
+            std::vector<UVAtlasVertex> vertices(mesh.positions.size());
+            for (size_t i = 0; i < vertices.size(); ++i)
+            {
+                vertices[i].pos = mesh.positions[i];
+                vertices[i].uv = XMFLOAT2(0, 0);
+            }
+            std::vector<uint32_t> indices;
+
+            std::unique_ptr<IIsochartEngine, void(*)(IIsochartEngine*)> engine(
+                nullptr, IIsochartEngine::ReleaseIsochartEngine);
+
+            size_t chartCount = 0;
+            SResult result = MakeResult(name, MESH_GENERATORS[1].name, mesh.FaceCount());
+            HRESULT hr = bench.Run(result,
+                [&]() -> HRESULT
+                {
+                    engine.reset(IIsochartEngine::CreateIsochartEngine());
+                    if (!engine)
+                        return E_OUTOFMEMORY;
+
+                    HRESULT hr = engine->Initialize(vertices.data(), vertices.size(), sizeof(UVAtlasVertex),
+                        DXGI_FORMAT_R32_UINT, mesh.indices.data(), mesh.FaceCount(), nullptr,
+                        mesh.adjacency.data(), nullptr, _OPTION_ISOCHART_DEFAULT);
+                    if (FAILED(hr))
+                        return hr;
+
+                    float maxStretch = 0;
+                    indices = mesh.indices;
+                    return engine->Partition(0, BENCH_MAX_STRETCH, chartCount, maxStretch, nullptr);
+                },
+                [&]
+                {
+                    std::vector<UVAtlasVertex> vb;
+                    std::vector<uint8_t> ib;
+                    return engine->Pack(BENCH_ATLAS_SIZE, BENCH_ATLAS_SIZE, BENCH_GUTTER,
+                        indices.data(), &vb, &ib, nullptr, nullptr);
+                });
+            result.metrics.emplace_back("charts", double(chartCount));
+            bench.Report(std::move(result), hr);
+        }
+    }
+
+    // CUVAtlasRepacker::Repack through UVAtlasPack, of the result of UVAtlasPartition
+    void BenchRepack(CBench& bench)
+    {
+        const char* name = "repack";
+        if (!bench.IsEnabled(name))
+            return;
+
+        for (size_t nFaces : { 10000, 100000 })
+        {
+            if (nFaces > bench.GetSettings().maxFaces)
+                continue;
+
+            SMesh mesh;
+            GenerateMesh(MESH_GENERATORS[1], nFaces, mesh);
+
+            std::vector<UVAtlasVertex> vbPartitioned;
+            std::vector<uint8_t> ibPartitioned;
+            std::vector<uint32_t> partitionAdjacency;
+            size_t chartCount = 0;
+            HRESULT hr = UVAtlasPartition(mesh.positions.data(), mesh.positions.size(),
+                mesh.indices.data(), DXGI_FORMAT_R32_UINT, mesh.FaceCount(), 0, BENCH_MAX_STRETCH,
+                mesh.adjacency.data(), nullptr, nullptr, nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+                bench.GetSettings().options, vbPartitioned, ibPartitioned, nullptr, nullptr,
+                partitionAdjacency, nullptr, &chartCount);
+
+            std::vector<UVAtlasVertex> vb;
+            std::vector<uint8_t> ib;
+            SResult result = MakeResult(name, MESH_GENERATORS[1].name, mesh.FaceCount());
+            if (SUCCEEDED(hr))
+            {
+                hr = bench.Run(result,
+                    [&]
+                    {
+                        vb = vbPartitioned;
+                        ib = ibPartitioned;
+                        return S_OK;
+                    },
+                    [&]
+                    {
+                        return UVAtlasPack(vb, ib, DXGI_FORMAT_R32_UINT,
+                            BENCH_ATLAS_SIZE, BENCH_ATLAS_SIZE, BENCH_GUTTER, partitionAdjacency,
+                            nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY);
+                    });
+            }
+            result.metrics.emplace_back("charts", double(chartCount));
+            bench.Report(std::move(result), hr);
+        }
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // End to end
+    //----------------------------------------------------------------------------------
+
+    void BenchCreate(CBench& bench)
+    {
+        const char* name = "create";
+        if (!bench.IsEnabled(name))
+            return;
+
+        for (auto& generator : MESH_GENERATORS)
+        {
+            for (size_t nFaces : CORPUS_FACE_COUNTS)
+            {
+                if (nFaces > bench.GetSettings().maxFaces)
+                    continue;
+
+                SMesh mesh;
+                GenerateMesh(generator, nFaces, mesh);
+
+                UVAtlasStats stats = {};
+                float maxStretch = 0;
+                size_t chartCount = 0;
+                SResult result = MakeResult(name, generator.name, mesh.FaceCount());
+                HRESULT hr = bench.Run(result,
+                    [] { return S_OK; },
+                    [&]
+                    {
+                        std::vector<UVAtlasVertex> vb;
+                        std::vector<uint8_t> ib;
+                        return UVAtlasCreate(mesh.positions.data(), mesh.positions.size(),
+                            mesh.indices.data(), DXGI_FORMAT_R32_UINT, mesh.FaceCount(), 0, BENCH_MAX_STRETCH,
+                            BENCH_ATLAS_SIZE, BENCH_ATLAS_SIZE, BENCH_GUTTER, mesh.adjacency.data(),
+                            nullptr, nullptr, nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+                            bench.GetSettings().options, vb, ib, nullptr, nullptr,
+                            &maxStretch, &chartCount, &stats);
+                    });
+
+                // Stages of the last run
+                const std::pair<const char*, double> metrics[] =
+                {
+                    { "charts", double(chartCount) },
+                    { "maxStretch", maxStretch },
+                    { "initSeconds", stats.initTime },
+                    { "partitionSeconds", stats.partitionTime },
+                    { "mergeSeconds", stats.mergeTime },
+                    { "packSeconds", stats.packTime },
+                    { "importanceCpuSeconds", stats.importanceCpuTime },
+                    { "geodesicCpuSeconds", stats.geodesicCpuTime },
+                    { "eigenCpuSeconds", stats.eigenCpuTime },
+                    { "stretchCpuSeconds", stats.stretchCpuTime },
+                    { "chartsSplit", double(stats.chartsSplit) },
+                    { "mergeAttempts", double(stats.mergeAttempts) },
+                    { "mergeFailures", double(stats.mergeFailures) },
+                    { "mergeSizeRejects", double(stats.mergeSizeRejects) },
+                    { "mergeBoundRejects", double(stats.mergeBoundRejects) },
+                    { "mergeTopoRejects", double(stats.mergeTopoRejects) },
+                    { "cgIterations", double(stats.cgIterations) },
+                    { "geodesicRuns", double(stats.geodesicRuns) },
+                    { "packRestarts", double(stats.packRestarts) },
+                    { "peakAllocatedBytes", double(stats.peakAllocatedBytes) },
+                };
+                for (auto& metric : metrics)
+                {
+                    result.metrics.emplace_back(metric.first, metric.second);
+                }
+                bench.Report(std::move(result), hr);
+            }
+        }
+    }
+
+
+    //----------------------------------------------------------------------------------
+    void PrintUsage()
+    {
+        fprintf(stderr, "Usage: UVAtlasBench <options>\n\n");
+        fprintf(stderr, "   -o <filename>       write JSON results to file, default is stdout\n");
+        fprintf(stderr, "   -filter <name>      only run benchmarks whose name contains <name>\n");
+        fprintf(stderr, "   -maxfaces <count>   skip meshes larger than <count> faces (default %zu)\n",
+            CORPUS_FACE_COUNTS[std::size(CORPUS_FACE_COUNTS) - 1]);
+        fprintf(stderr, "   -repeat <count>     runs of each benchmark (default 3)\n");
+        fprintf(stderr, "   -j <count>          worker threads of UVAtlas, 0 for one per hardware thread\n");
+        fprintf(stderr, "\nBenchmarks: exact_one_to_all geodesic_ks98 symmetric_eigen conjugate_gradient\n");
+        fprintf(stderr, "            packing_charts repack create\n");
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Entry-point
+//--------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    SSettings settings;
+    settings.maxFaces = CORPUS_FACE_COUNTS[std::size(CORPUS_FACE_COUNTS) - 1];
+    settings.repeat = 3;
+    settings.options = UVATLAS_DEFAULT;
+
+    const char* outputFile = nullptr;
+
+    for (int iArg = 1; iArg < argc; ++iArg)
+    {
+        std::string arg = argv[iArg];
+        if (iArg + 1 >= argc)
+        {
+            PrintUsage();
+            return 1;
+        }
+
+        const char* value = argv[++iArg];
+        if (arg == "-o")
+        {
+            outputFile = value;
+        }
+        else if (arg == "-filter")
+        {
+            settings.filter = value;
+        }
+        else if (arg == "-maxfaces")
+        {
+            settings.maxFaces = strtoull(value, nullptr, 10);
+        }
+        else if (arg == "-repeat")
+        {
+            settings.repeat = std::max<size_t>(1, strtoull(value, nullptr, 10));
+        }
+        else if (arg == "-j")
+        {
+            unsigned long workers = strtoul(value, nullptr, 10);
+            settings.options = (workers == 0) ? DWORD(UVATLAS_WORKERS_AUTO) : UVATLAS_WORKERS(workers);
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    CBench bench(settings);
+
+    BenchExactGeodesic(bench);
+    BenchKS98Geodesic(bench);
+    BenchSymmetricEigen(bench);
+    BenchConjugateGradient(bench);
+    BenchPackingCharts(bench);
+    BenchRepack(bench);
+    BenchCreate(bench);
+
+    FILE* file = stdout;
+    if (outputFile)
+    {
+        file = fopen(outputFile, "w");
+        if (!file)
+        {
+            fprintf(stderr, "Failed to open %s\n", outputFile);
+            return 1;
+        }
+    }
+
+    bench.WriteJson(file);
+
+    if (file != stdout)
+    {
+        fclose(file);
+    }
+
+    return 0;
+}
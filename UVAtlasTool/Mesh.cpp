@@ -307,6 +307,49 @@ HRESULT Mesh::SetVertexData(_Inout_ DirectX::VBReader& reader, _In_ size_t nVert
 }
 
 
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT Mesh::SetIndexData(size_t nFaces, std::unique_ptr<uint32_t[]> indices)
+{
+    if (!nFaces || !indices)
+        return E_INVALIDARG;
+
+    if ((uint64_t(nFaces) * 3) >= UINT32_MAX)
+        return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+    mIndices = std::move(indices);
+    mAttributes.reset();
+    mnFaces = nFaces;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT Mesh::SetVertexData(
+    size_t nVerts,
+    std::unique_ptr<XMFLOAT3[]> positions,
+    std::unique_ptr<XMFLOAT3[]> normals,
+    std::unique_ptr<XMFLOAT2[]> texcoords)
+{
+    if (!nVerts || !positions)
+        return E_INVALIDARG;
+
+    // Release vertex data
+    mTangents.reset();
+    mBiTangents.reset();
+    mColors.reset();
+    mBlendIndices.reset();
+    mBlendWeights.reset();
+
+    mPositions = std::move(positions);
+    mNormals = std::move(normals);
+    mTexCoords = std::move(texcoords);
+    mnVerts = nVerts;
+
+    return S_OK;
+}
+
+
 //--------------------------------------------------------------------------------------
 _Use_decl_annotations_
 HRESULT Mesh::Validate(DWORD flags, std::wstring* msgs) const
@@ -44,6 +44,13 @@ public:
 
     HRESULT SetVertexData(_Inout_ DirectX::VBReader& reader, _In_ size_t nVerts);
 
+    // Takes ownership of already decoded arrays of nFaces * 3 indices and nVerts vertices
+    HRESULT SetIndexData(_In_ size_t nFaces, _In_ std::unique_ptr<uint32_t[]> indices);
+    HRESULT SetVertexData(_In_ size_t nVerts,
+        _In_ std::unique_ptr<DirectX::XMFLOAT3[]> positions,
+        _In_opt_ std::unique_ptr<DirectX::XMFLOAT3[]> normals,
+        _In_opt_ std::unique_ptr<DirectX::XMFLOAT2[]> texcoords);
+
     HRESULT Validate(_In_ DWORD flags, _In_opt_ std::wstring* msgs) const;
 
     HRESULT Clean(_In_ bool breakBowties = false);
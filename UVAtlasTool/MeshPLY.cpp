@@ -1,7 +1,7 @@
 //--------------------------------------------------------------------------------------
-// File: MeshOBJ.cpp
+// File: MeshPLY.cpp
 //
-// Helper code for loading Mesh data from Wavefront OBJ
+// Helper code for loading Mesh data from Stanford PLY
 //
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
@@ -19,13 +19,24 @@
 #define NOSERVICE
 #define NOHELP
 
-#include <unordered_map>
-#include <fstream>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
 #include <codecvt>
-#include <boost/algorithm/string.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <locale>
+#include <string>
+#include <string_view>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include <d3d11_1.h>
-#include <DirectXCollision.h>
 
 #include "Mesh.h"
 
@@ -51,281 +62,739 @@ namespace
         _wmakepath_s(texture, nullptr, nullptr, txfname, txext);
         return std::wstring(texture);
     }
-}
 
-template<class index_t>
-class PlyReader {
-public:
-    struct Vertex {
-        DirectX::XMFLOAT3 position;
-        DirectX::XMFLOAT3 normal;
-        DirectX::XMFLOAT2 textureCoordinate;
+    //----------------------------------------------------------------------------------
+    // Read-only view of a whole file, so the body is decoded without copying it first
+    class MappedFile
+    {
+    public:
+        MappedFile() noexcept : mData(nullptr), mSize(0) {}
+        ~MappedFile() { Close(); }
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator= (MappedFile const&) = delete;
+
+        HRESULT Open(_In_z_ const char* szFileName)
+        {
+            Close();
+
+#ifdef _WIN32
+            HANDLE hFile = CreateFileA(szFileName, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (hFile == INVALID_HANDLE_VALUE)
+                return HRESULT_FROM_WIN32(GetLastError());
+
+            LARGE_INTEGER fileSize = {};
+            if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart <= 0
+                || uint64_t(fileSize.QuadPart) > SIZE_MAX)
+            {
+                CloseHandle(hFile);
+                return E_FAIL;
+            }
+
+            HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(hFile);
+            if (!hMapping)
+                return HRESULT_FROM_WIN32(GetLastError());
+
+            mData = static_cast<const char*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(hMapping);
+            if (!mData)
+                return HRESULT_FROM_WIN32(GetLastError());
+
+            mSize = size_t(fileSize.QuadPart);
+#else
+            int fd = open(szFileName, O_RDONLY);
+            if (fd < 0)
+                return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+
+            struct stat fileStat;
+            if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+            {
+                close(fd);
+                return E_FAIL;
+            }
+
+            auto size = size_t(fileStat.st_size);
+            void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (data == MAP_FAILED)
+                return E_OUTOFMEMORY;
+
+            madvise(data, size, MADV_SEQUENTIAL);
+
+            mData = static_cast<const char*>(data);
+            mSize = size;
+#endif
+
+            return S_OK;
+        }
+
+        void Close()
+        {
+            if (mData)
+            {
+#ifdef _WIN32
+                UnmapViewOfFile(mData);
+#else
+                munmap(const_cast<char*>(mData), mSize);
+#endif
+            }
+
+            mData = nullptr;
+            mSize = 0;
+        }
+
+        const char* GetData() const { return mData; }
+        size_t GetSize() const { return mSize; }
+
+    private:
+        const char* mData;
+        size_t      mSize;
     };
 
-    PlyReader() noexcept : hasNormals(false), hasTexcoords(false) {}
+    //----------------------------------------------------------------------------------
+    // PLY header description
+    enum PLY_TYPE
+    {
+        PLY_NONE,
+        PLY_INT8,
+        PLY_UINT8,
+        PLY_INT16,
+        PLY_UINT16,
+        PLY_INT32,
+        PLY_UINT32,
+        PLY_FLOAT32,
+        PLY_FLOAT64,
+    };
 
-    HRESULT Load(_In_z_ const char* szFileName, bool ccw = true) {
-        Clear();
+    enum PLY_FORMAT
+    {
+        PLY_FORMAT_NONE,
+        PLY_FORMAT_ASCII,
+        PLY_FORMAT_BINARY_LE,
+        PLY_FORMAT_BINARY_BE,
+    };
 
-        static const size_t MAX_POLY = 64;
+    // Mesh data a vertex or face property is decoded into
+    enum PLY_CHANNEL
+    {
+        PLY_X,
+        PLY_Y,
+        PLY_Z,
+        PLY_NX,
+        PLY_NY,
+        PLY_NZ,
+        PLY_U,
+        PLY_V,
+        PLY_VERTEX_INDICES,
+        PLY_SKIP,
+    };
 
-        using namespace DirectX;
+    struct PlyProperty
+    {
+        PLY_TYPE    type;
+        PLY_TYPE    countType;  // PLY_NONE unless the property is a list
+        PLY_CHANNEL channel;
+    };
 
-        std::ifstream InFile(szFileName, std::ios_base::binary);
-        if (!InFile)
-            return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    struct PlyElement
+    {
+        std::string                 name;
+        size_t                      count;
+        std::vector<PlyProperty>    properties;
+    };
 
-        char fname[_MAX_FNAME] = {};
-        _splitpath_s(szFileName, nullptr, 0, nullptr, 0, fname, _MAX_FNAME, nullptr, 0);
+    PLY_TYPE GetPlyType(std::string_view name)
+    {
+        if (name == "char" || name == "int8")
+            return PLY_INT8;
+        if (name == "uchar" || name == "uint8")
+            return PLY_UINT8;
+        if (name == "short" || name == "int16")
+            return PLY_INT16;
+        if (name == "ushort" || name == "uint16")
+            return PLY_UINT16;
+        if (name == "int" || name == "int32")
+            return PLY_INT32;
+        if (name == "uint" || name == "uint32")
+            return PLY_UINT32;
+        if (name == "float" || name == "float32")
+            return PLY_FLOAT32;
+        if (name == "double" || name == "float64")
+            return PLY_FLOAT64;
+        return PLY_NONE;
+    }
 
-        name = fname;
+    bool IsIntegerPlyType(PLY_TYPE type)
+    {
+        return type != PLY_NONE && type != PLY_FLOAT32 && type != PLY_FLOAT64;
+    }
 
-        Material defmat;
+    PLY_CHANNEL GetVertexChannel(std::string_view name)
+    {
+        if (name == "x")
+            return PLY_X;
+        if (name == "y")
+            return PLY_Y;
+        if (name == "z")
+            return PLY_Z;
+        if (name == "nx")
+            return PLY_NX;
+        if (name == "ny")
+            return PLY_NY;
+        if (name == "nz")
+            return PLY_NZ;
+        if (name == "u" || name == "s" || name == "texture_u" || name == "texture_s")
+            return PLY_U;
+        if (name == "v" || name == "t" || name == "texture_v" || name == "texture_t")
+            return PLY_V;
+        return PLY_SKIP;
+    }
 
-        wcscpy_s(defmat.strName, L"default");
-        materials.emplace_back(defmat);
+    // Splits a header line at blanks
+    void SplitHeaderLine(std::string_view line, std::vector<std::string_view>& tokens)
+    {
+        tokens.clear();
 
-        std::string line;
-        std::getline(InFile, line);
-        if (line != "ply") {
-            return E_FAIL;
+        size_t pos = 0;
+        for (;;)
+        {
+            pos = line.find_first_not_of(" \t\r", pos);
+            if (pos == std::string_view::npos)
+                break;
+
+            size_t end = line.find_first_of(" \t\r", pos);
+            if (end == std::string_view::npos)
+                end = line.size();
+
+            tokens.push_back(line.substr(pos, end - pos));
+            pos = end;
         }
+    }
+
+    template<class T>
+    bool ParseNumber(std::string_view token, T& value)
+    {
+        const char* first = token.data();
+        const char* last = first + token.size();
+        if (first != last && *first == '+')
+            ++first;
 
-        std::getline(InFile, line);
-        bool is_ascii = true;
-        bool is_little_endian = true;
+        auto result = std::from_chars(first, last, value);
+        return result.ec == std::errc() && result.ptr == last;
+    }
+
+    // Floating-point std::from_chars is missing from the Visual Studio 2017
+    // standard library, floats are parsed by strtof from a terminated copy.
+    bool ParseNumber(std::string_view token, float& value)
+    {
+        char buffer[64];
+        std::string longToken;
+        const char* str = buffer;
+        if (token.size() < sizeof(buffer))
         {
-            std::vector<std::string> str_vec;
-            boost::algorithm::split(str_vec, line, boost::algorithm::is_any_of(" "));
-            if (str_vec.size() >= 2) {
-                if (str_vec[1] == "binary_little_endian") {
-                    is_ascii = false;
-                    is_little_endian = true;
-                } else if (str_vec[1] == "binary_big_endian") {
-                    is_ascii = false;
-                    is_little_endian = false;
-                } else {
-                    is_ascii = true;
-                }
-            } else {
-                return E_FAIL;
+            memcpy(buffer, token.data(), token.size());
+            buffer[token.size()] = 0;
+        }
+        else
+        {
+            longToken.assign(token.data(), token.size());
+            str = longToken.c_str();
+        }
+
+        errno = 0;
+        char* end = nullptr;
+        value = strtof(str, &end);
+        return !token.empty() && errno != ERANGE && end == str + token.size();
+    }
+
+    //----------------------------------------------------------------------------------
+    // Decodes binary PLY values in place, bSwap for big-endian files
+    template<bool bSwap>
+    class PlyBinaryReader
+    {
+    public:
+        PlyBinaryReader(const char* pBegin, const char* pEnd) noexcept : mPos(pBegin), mEnd(pEnd) {}
+
+        bool ReadFloat(PLY_TYPE type, float& value)
+        {
+            switch (type)
+            {
+            case PLY_INT8:      return LoadAs<int8_t>(value);
+            case PLY_UINT8:     return LoadAs<uint8_t>(value);
+            case PLY_INT16:     return LoadAs<int16_t>(value);
+            case PLY_UINT16:    return LoadAs<uint16_t>(value);
+            case PLY_INT32:     return LoadAs<int32_t>(value);
+            case PLY_UINT32:    return LoadAs<uint32_t>(value);
+            case PLY_FLOAT32:   return LoadAs<float>(value);
+            case PLY_FLOAT64:   return LoadAs<double>(value);
+            default:            return false;
             }
         }
-        // windows is little endian
-        if (!is_ascii && !is_little_endian) {
-            return E_FAIL;
+
+        bool ReadInteger(PLY_TYPE type, int64_t& value)
+        {
+            switch (type)
+            {
+            case PLY_INT8:      return LoadAs<int8_t>(value);
+            case PLY_UINT8:     return LoadAs<uint8_t>(value);
+            case PLY_INT16:     return LoadAs<int16_t>(value);
+            case PLY_UINT16:    return LoadAs<uint16_t>(value);
+            case PLY_INT32:     return LoadAs<int32_t>(value);
+            case PLY_UINT32:    return LoadAs<uint32_t>(value);
+            default:            return false;
+            }
+        }
+
+        bool Skip(PLY_TYPE type)
+        {
+            size_t size = 0;
+            switch (type)
+            {
+            case PLY_INT8:
+            case PLY_UINT8:     size = 1; break;
+            case PLY_INT16:
+            case PLY_UINT16:    size = 2; break;
+            case PLY_INT32:
+            case PLY_UINT32:
+            case PLY_FLOAT32:   size = 4; break;
+            case PLY_FLOAT64:   size = 8; break;
+            default:            return false;
+            }
+
+            if (size_t(mEnd - mPos) < size)
+                return false;
+
+            mPos += size;
+            return true;
+        }
+
+    private:
+        template<class T, class TValue>
+        bool LoadAs(TValue& value)
+        {
+            if (size_t(mEnd - mPos) < sizeof(T))
+                return false;
+
+            T data;
+            if (bSwap)
+            {
+                char bytes[sizeof(T)];
+                std::reverse_copy(mPos, mPos + sizeof(T), bytes);
+                memcpy(&data, bytes, sizeof(T));
+            }
+            else
+            {
+                memcpy(&data, mPos, sizeof(T));
+            }
+
+            mPos += sizeof(T);
+            value = static_cast<TValue>(data);
+            return true;
+        }
+
+        const char* mPos;
+        const char* mEnd;
+    };
+
+    // Decodes ASCII PLY values in place
+    class PlyAsciiReader
+    {
+    public:
+        PlyAsciiReader(const char* pBegin, const char* pEnd) noexcept : mPos(pBegin), mEnd(pEnd) {}
+
+        bool ReadFloat(PLY_TYPE, float& value)
+        {
+            std::string_view token;
+            return NextToken(token) && ParseNumber(token, value);
+        }
+
+        bool ReadInteger(PLY_TYPE, int64_t& value)
+        {
+            std::string_view token;
+            return NextToken(token) && ParseNumber(token, value);
+        }
+
+        bool Skip(PLY_TYPE)
+        {
+            std::string_view token;
+            return NextToken(token);
+        }
+
+    private:
+        static bool IsBlank(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
         }
 
-        std::vector<std::string> str_vec;
-        while (InFile.good()) {
-            std::getline(InFile, line);
-            boost::algorithm::split(str_vec, line, boost::algorithm::is_any_of(" "));
-            std::for_each(str_vec.begin(), str_vec.end(), [](std::string &str) {
-                str = boost::trim_copy(str);
-            });
+        bool NextToken(std::string_view& token)
+        {
+            while (mPos != mEnd && IsBlank(*mPos))
+                ++mPos;
+
+            const char* first = mPos;
+            while (mPos != mEnd && !IsBlank(*mPos))
+                ++mPos;
+
+            token = std::string_view(first, size_t(mPos - first));
+            return !token.empty();
+        }
+
+        const char* mPos;
+        const char* mEnd;
+    };
+}
 
-            if (str_vec.empty()) {
+class PlyReader {
+public:
+    PlyReader() noexcept : nVerts(0), nFaces(0), format(PLY_FORMAT_NONE) {}
+
+    HRESULT Load(_In_z_ const char* szFileName, bool ccw = true) {
+        Clear();
+
+        MappedFile file;
+        HRESULT hr = file.Open(szFileName);
+        if (FAILED(hr))
+            return hr;
+
+        char fname[_MAX_FNAME] = {};
+        _splitpath_s(szFileName, nullptr, 0, nullptr, 0, fname, _MAX_FNAME, nullptr, 0);
+
+        name = fname;
+
+        const char* pData = file.GetData();
+        const char* pEnd = pData + file.GetSize();
+
+        hr = LoadHeader(pData, pEnd);
+        if (FAILED(hr))
+            return hr;
+
+        // Allocate mesh data for the properties present
+        bool hasChannel[PLY_SKIP] = {};
+        for (auto& element : elements) {
+            if (element.name == "vertex") {
+                nVerts = element.count;
+            } else if (element.name == "face") {
+                nFaces = element.count;
+            } else {
                 continue;
             }
 
-            if (str_vec[0] == "end_header") {
-                break;
-            } else if (str_vec[0] == "comment") {
-                if (str_vec.size() > 2 && str_vec[1] == "TextureFile") {
-                    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-                    auto texture_file = converter.from_bytes(str_vec[2]);
-                    wcscpy_s(defmat.strTexture, texture_file.c_str());
-                }
-            } else if (str_vec[0] == "element") {
-                if (str_vec.size() > 2) {
-                    if (str_vec[1] == "vertex") {
-                        try {
-                            vertices.resize((size_t)std::stoi(str_vec[2]));
-                        } catch (const std::exception &) {
-                            return E_FAIL;
-                        }
-                    } else if (str_vec[1] == "face") {
-                        try {
-                            indices.resize((size_t)std::stoi(str_vec[2]) * 3);
-                        } catch (const std::exception &) {
-                            return E_FAIL;
-                        }
-                    }
-                }
-            } else if (str_vec[0] == "property") {
-                if (str_vec.back() == "nz") {
-                    hasNormals = true;
-                } else if (str_vec.back() == "v") {
-                    hasTexcoords = true;
+            for (auto& property : element.properties) {
+                if (property.channel != PLY_SKIP) {
+                    hasChannel[property.channel] = true;
                 }
             }
         }
 
-        if (vertices.empty()) {
+        if (!nVerts || !nFaces || !hasChannel[PLY_X] || !hasChannel[PLY_Y] || !hasChannel[PLY_Z]
+            || !hasChannel[PLY_VERTEX_INDICES]) {
             return E_FAIL;
         }
 
-        std::vector<char> read_buffer;
+        if (nVerts >= UINT32_MAX || (uint64_t(nFaces) * 3) >= UINT32_MAX) {
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+        }
+
+        positions.reset(new (std::nothrow) XMFLOAT3[nVerts]);
+        if (!positions)
+            return E_OUTOFMEMORY;
+
+        if (hasChannel[PLY_NX] && hasChannel[PLY_NY] && hasChannel[PLY_NZ]) {
+            normals.reset(new (std::nothrow) XMFLOAT3[nVerts]);
+            if (!normals)
+                return E_OUTOFMEMORY;
+        }
+
+        if (hasChannel[PLY_U] && hasChannel[PLY_V]) {
+            texcoords.reset(new (std::nothrow) XMFLOAT2[nVerts]);
+            if (!texcoords)
+                return E_OUTOFMEMORY;
+        }
+
+        indices.reset(new (std::nothrow) uint32_t[nFaces * 3]);
+        if (!indices)
+            return E_OUTOFMEMORY;
+
+        // Decode body
+        switch (format) {
+        case PLY_FORMAT_ASCII:
+        {
+            PlyAsciiReader reader(pData, pEnd);
+            hr = LoadElements(reader, elements, ccw);
+            break;
+        }
+
+        case PLY_FORMAT_BINARY_LE:
+        {
+            PlyBinaryReader<false> reader(pData, pEnd);
+            hr = LoadElements(reader, elements, ccw);
+            break;
+        }
+
+        case PLY_FORMAT_BINARY_BE:
+        {
+            PlyBinaryReader<true> reader(pData, pEnd);
+            hr = LoadElements(reader, elements, ccw);
+            break;
+        }
+
+        default:
+            hr = E_FAIL;
+            break;
+        }
+
+        if (FAILED(hr)) {
+            Clear();
+            return hr;
+        }
+
+        return S_OK;
+    }
+
+    // Parses the header, leaving pData at the start of the body
+    HRESULT LoadHeader(const char*& pData, const char* pEnd) {
+        format = PLY_FORMAT_NONE;
+        elements.clear();
+
+        std::vector<std::string_view> tokens;
+        bool endHeader = false;
+        for (size_t lineIndex = 0; !endHeader; ++lineIndex) {
+            if (pData == pEnd) {
+                return E_FAIL;
+            }
+
+            auto pEol = static_cast<const char*>(memchr(pData, '\n', size_t(pEnd - pData)));
+            if (!pEol) {
+                return E_FAIL;
+            }
+
+            std::string_view line(pData, size_t(pEol - pData));
+            pData = pEol + 1;
 
-        size_t vertex_data_size = 3 + (hasNormals ? 3 : 0) + (hasTexcoords ? 2 : 0);
-        if (is_ascii) {
-            for (auto &vertex : vertices) {
-                std::getline(InFile, line);
-                boost::algorithm::split(str_vec, line, boost::algorithm::is_any_of(" "));
-                if (str_vec.size() < vertex_data_size) {
+            SplitHeaderLine(line, tokens);
+            if (lineIndex == 0) {
+                if (tokens.size() != 1 || tokens[0] != "ply") {
                     return E_FAIL;
                 }
+                continue;
+            }
 
-                size_t i = 0;
-                try {
-                    vertex.position.x = std::stof(str_vec[i++]);
-                    vertex.position.y = std::stof(str_vec[i++]);
-                    vertex.position.z = std::stof(str_vec[i++]);
-                    if (hasNormals) {
-                        vertex.normal.x = std::stof(str_vec[i++]);
-                        vertex.normal.y = std::stof(str_vec[i++]);
-                        vertex.normal.z = std::stof(str_vec[i++]);
-                    }
-                    if (hasTexcoords) {
-                        vertex.textureCoordinate.x = std::stof(str_vec[i++]);
-                        vertex.textureCoordinate.y = std::stof(str_vec[i++]);
-                    }
-                } catch (const std::exception &) {
+            if (tokens.empty()) {
+                continue;
+            }
+
+            if (tokens[0] == "end_header") {
+                endHeader = true;
+            } else if (tokens[0] == "format") {
+                if (tokens.size() < 2) {
                     return E_FAIL;
                 }
-            }
-        } else {
-            read_buffer.resize(sizeof(float) * vertex_data_size * vertices.size());
-            InFile.read(read_buffer.data(), read_buffer.size());
-            for (size_t i_vertex = 0; i_vertex < vertices.size(); ++i_vertex) {
-                float *data = (float*)&read_buffer[sizeof(float) * vertex_data_size * i_vertex];
-                auto &vertex = vertices[i_vertex];
-                size_t i = 0;
-                vertex.position.x = data[i++];
-                vertex.position.y = data[i++];
-                vertex.position.z = data[i++];
-                if (hasNormals) {
-                    vertex.normal.x = data[i++];
-                    vertex.normal.y = data[i++];
-                    vertex.normal.z = data[i++];
+
+                if (tokens[1] == "ascii") {
+                    format = PLY_FORMAT_ASCII;
+                } else if (tokens[1] == "binary_little_endian") {
+                    format = PLY_FORMAT_BINARY_LE;
+                } else if (tokens[1] == "binary_big_endian") {
+                    format = PLY_FORMAT_BINARY_BE;
+                } else {
+                    return E_FAIL;
                 }
-                if (hasTexcoords) {
-                    vertex.textureCoordinate.x = data[i++];
-                    vertex.textureCoordinate.y = data[i++];
+            } else if (tokens[0] == "comment") {
+                if (tokens.size() > 2 && tokens[1] == "TextureFile") {
+                    std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+                    textureFile = converter.from_bytes(tokens[2].data(), tokens[2].data() + tokens[2].size());
+                }
+            } else if (tokens[0] == "element") {
+                PlyElement element;
+                if (tokens.size() < 3 || !ParseNumber(tokens[2], element.count)) {
+                    return E_FAIL;
                 }
-            }
-        }
 
-        for (size_t i_face = 0; i_face < indices.size() / 3; ++i_face) {
-            if (is_ascii) {
-                std::getline(InFile, line);
-                boost::algorithm::split(str_vec, line, boost::algorithm::is_any_of(" "));
-                if (str_vec.empty()) {
+                element.name = std::string(tokens[1]);
+                elements.emplace_back(std::move(element));
+            } else if (tokens[0] == "property") {
+                if (elements.empty()) {
                     return E_FAIL;
                 }
 
-                try {
-                    auto num_vertex = (size_t)std::stoi(str_vec[0]);
-                    if (num_vertex != 3 || str_vec.size() < 4) {
-                        return E_FAIL;
-                    }
+                auto& element = elements.back();
 
-                    for (size_t i = 0; i < 3; ++i) {
-                        indices[i_face * 3 + (ccw ? i : 2 - i)] = (index_t)std::stoi(str_vec[i + 1]);
+                PlyProperty property = {};
+                std::string_view propertyName;
+                if (tokens.size() >= 5 && tokens[1] == "list") {
+                    property.countType = GetPlyType(tokens[2]);
+                    property.type = GetPlyType(tokens[3]);
+                    propertyName = tokens[4];
+                    if (!IsIntegerPlyType(property.countType)) {
+                        return E_FAIL;
                     }
-                } catch (const std::exception &) {
+                } else if (tokens.size() >= 3) {
+                    property.countType = PLY_NONE;
+                    property.type = GetPlyType(tokens[1]);
+                    propertyName = tokens[2];
+                } else {
                     return E_FAIL;
                 }
-            } else {
-                uint8_t num_vertex = 0;
-                InFile.read((char*)&num_vertex, sizeof(uint8_t));
 
-                if (num_vertex != 3) {
+                if (property.type == PLY_NONE) {
                     return E_FAIL;
                 }
 
-                for (size_t i = 0; i < 3; ++i) {
-                    uint32_t index = 0;
-                    InFile.read((char*)&index, sizeof(uint32_t));
-                    indices[i_face * 3 + (ccw ? i : 2 - i)] = (index_t)index;
+                property.channel = PLY_SKIP;
+                if (element.name == "vertex" && property.countType == PLY_NONE) {
+                    property.channel = GetVertexChannel(propertyName);
+                } else if (element.name == "face" && property.countType != PLY_NONE
+                    && (propertyName == "vertex_indices" || propertyName == "vertex_index")) {
+                    if (!IsIntegerPlyType(property.type)) {
+                        return E_FAIL;
+                    }
+                    property.channel = PLY_VERTEX_INDICES;
                 }
-            }
-        }
-
-        // Cleanup
-        InFile.close();
 
-        std::vector<XMFLOAT3> positions(vertices.size());
-        for (size_t i = 0; i < vertices.size(); ++i) {
-            positions[i] = vertices[i].position;
+                element.properties.push_back(property);
+            }
         }
-        BoundingBox::CreateFromPoints(bounds, positions.size(), positions.data(), sizeof(XMFLOAT3));
 
         return S_OK;
     }
 
     void Clear() {
-        vertices.clear();
-        indices.clear();
-        attributes.clear();
-        materials.clear();
+        nVerts = nFaces = 0;
+        positions.reset();
+        normals.reset();
+        texcoords.reset();
+        indices.reset();
         name.clear();
-        hasNormals = false;
-        hasTexcoords = false;
+        textureFile.clear();
+        format = PLY_FORMAT_NONE;
+        elements.clear();
+    }
+
+    size_t                                  nVerts;
+    size_t                                  nFaces;
+    std::unique_ptr<DirectX::XMFLOAT3[]>    positions;
+    std::unique_ptr<DirectX::XMFLOAT3[]>    normals;
+    std::unique_ptr<DirectX::XMFLOAT2[]>    texcoords;
+    std::unique_ptr<uint32_t[]>             indices;
+
+    std::string                             name;
+    std::wstring                            textureFile;
+
+    PLY_FORMAT                              format;
+    std::vector<PlyElement>                 elements;
+
+private:
+    template<class TReader>
+    HRESULT LoadElements(TReader& reader, const std::vector<PlyElement>& elements, bool ccw) {
+        for (auto& element : elements) {
+            if (element.name == "vertex") {
+                float values[PLY_SKIP] = {};
+                for (size_t i = 0; i < element.count; ++i) {
+                    for (auto& property : element.properties) {
+                        if (property.channel == PLY_SKIP) {
+                            if (!SkipProperty(reader, property)) {
+                                return E_FAIL;
+                            }
+                        } else if (!reader.ReadFloat(property.type, values[property.channel])) {
+                            return E_FAIL;
+                        }
+                    }
 
-        bounds.Center.x = bounds.Center.y = bounds.Center.z = 0.f;
-        bounds.Extents.x = bounds.Extents.y = bounds.Extents.z = 0.f;
+                    positions[i] = XMFLOAT3(values[PLY_X], values[PLY_Y], values[PLY_Z]);
+                    if (normals) {
+                        normals[i] = XMFLOAT3(values[PLY_NX], values[PLY_NY], values[PLY_NZ]);
+                    }
+                    if (texcoords) {
+                        texcoords[i] = XMFLOAT2(values[PLY_U], values[PLY_V]);
+                    }
+                }
+            } else if (element.name == "face") {
+                for (size_t i = 0; i < element.count; ++i) {
+                    for (auto& property : element.properties) {
+                        if (property.channel != PLY_VERTEX_INDICES) {
+                            if (!SkipProperty(reader, property)) {
+                                return E_FAIL;
+                            }
+                            continue;
+                        }
+
+                        int64_t count = 0;
+                        if (!reader.ReadInteger(property.countType, count) || count != 3) {
+                            return E_FAIL;
+                        }
+
+                        for (size_t j = 0; j < 3; ++j) {
+                            int64_t index = 0;
+                            if (!reader.ReadInteger(property.type, index) || index < 0 || uint64_t(index) >= nVerts) {
+                                return E_FAIL;
+                            }
+                            indices[i * 3 + (ccw ? j : 2 - j)] = uint32_t(index);
+                        }
+                    }
+                }
+            } else {
+                for (size_t i = 0; i < element.count; ++i) {
+                    for (auto& property : element.properties) {
+                        if (!SkipProperty(reader, property)) {
+                            return E_FAIL;
+                        }
+                    }
+                }
+            }
+        }
+
+        return S_OK;
     }
 
-    struct Material {
-        DirectX::XMFLOAT3 vAmbient;
-        DirectX::XMFLOAT3 vDiffuse;
-        DirectX::XMFLOAT3 vSpecular;
-        DirectX::XMFLOAT3 vEmissive;
-        uint32_t nShininess;
-        float fAlpha;
-
-        bool bSpecular;
-        bool bEmissive;
-
-        wchar_t strName[MAX_PATH];
-        wchar_t strTexture[MAX_PATH];
-        wchar_t strNormalTexture[MAX_PATH];
-        wchar_t strSpecularTexture[MAX_PATH];
-        wchar_t strEmissiveTexture[MAX_PATH];
-        wchar_t strRMATexture[MAX_PATH];
-
-        Material() noexcept :
-            vAmbient(0.2f, 0.2f, 0.2f),
-            vDiffuse(0.8f, 0.8f, 0.8f),
-            vSpecular(1.0f, 1.0f, 1.0f),
-            vEmissive(0.f, 0.f, 0.f),
-            nShininess(0),
-            fAlpha(1.f),
-            bSpecular(false),
-            bEmissive(false),
-            strName{},
-            strTexture{},
-            strNormalTexture{},
-            strSpecularTexture{},
-            strEmissiveTexture{},
-            strRMATexture{}
-        {
+    template<class TReader>
+    static bool SkipProperty(TReader& reader, const PlyProperty& property) {
+        if (property.countType == PLY_NONE) {
+            return reader.Skip(property.type);
         }
-    };
 
-    std::vector<Vertex>     vertices;
-    std::vector<index_t>    indices;
-    std::vector<uint32_t>   attributes;
-    std::vector<Material>   materials;
+        int64_t count = 0;
+        if (!reader.ReadInteger(property.countType, count) || count < 0) {
+            return false;
+        }
 
-    std::string             name;
-    bool                    hasNormals;
-    bool                    hasTexcoords;
+        for (int64_t i = 0; i < count; ++i) {
+            if (!reader.Skip(property.type)) {
+                return false;
+            }
+        }
 
-    DirectX::BoundingBox    bounds;
+        return true;
+    }
 };
 
+HRESULT GetFaceCountFromPLY(const char* szFilename, size_t& nFaces)
+{
+    nFaces = 0;
+
+    MappedFile file;
+    HRESULT hr = file.Open(szFilename);
+    if (FAILED(hr))
+        return hr;
+
+    PlyReader plyReader;
+    const char* pData = file.GetData();
+    hr = plyReader.LoadHeader(pData, pData + file.GetSize());
+    if (FAILED(hr))
+        return hr;
+
+    for (auto& element : plyReader.elements)
+    {
+        if (element.name == "face")
+        {
+            nFaces = element.count;
+        }
+    }
+
+    return S_OK;
+}
+
 HRESULT LoadFromPLY(
     const char* szFilename,
     std::unique_ptr<Mesh>& inMesh,
@@ -333,7 +802,7 @@ HRESULT LoadFromPLY(
     bool ccw,
     bool dds)
 {
-    PlyReader<uint32_t> plyReader;
+    PlyReader plyReader;
     HRESULT hr = plyReader.Load(szFilename, ccw);
     if (FAILED(hr))
         return hr;
@@ -342,86 +811,28 @@ HRESULT LoadFromPLY(
     if (!inMesh)
         return E_OUTOFMEMORY;
 
-    if (plyReader.indices.empty() || plyReader.vertices.empty())
-        return E_FAIL;
-
-    hr = inMesh->SetIndexData(plyReader.indices.size() / 3, plyReader.indices.data(),
-        plyReader.attributes.empty() ? nullptr : plyReader.attributes.data());
-    if (FAILED(hr))
-        return hr;
-
-    static const D3D11_INPUT_ELEMENT_DESC s_vboLayout[] =
-    {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-    };
-
-    static const D3D11_INPUT_ELEMENT_DESC s_vboLayoutAlt[] =
-    {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-    };
-
-    const D3D11_INPUT_ELEMENT_DESC* layout = s_vboLayout;
-    size_t nDecl = _countof(s_vboLayout);
-
-    if (!plyReader.hasNormals && !plyReader.hasTexcoords)
-    {
-        nDecl = 1;
-    }
-    else if (plyReader.hasNormals && !plyReader.hasTexcoords)
-    {
-        nDecl = 2;
-    }
-    else if (!plyReader.hasNormals && plyReader.hasTexcoords)
-    {
-        layout = s_vboLayoutAlt;
-        nDecl = _countof(s_vboLayoutAlt);
-    }
-
-    VBReader vbr;
-    hr = vbr.Initialize(layout, nDecl);
+    hr = inMesh->SetIndexData(plyReader.nFaces, std::move(plyReader.indices));
     if (FAILED(hr))
         return hr;
 
-    hr = vbr.AddStream(plyReader.vertices.data(), plyReader.vertices.size(), 0, sizeof(PlyReader<uint32_t>::Vertex));
+    hr = inMesh->SetVertexData(plyReader.nVerts,
+        std::move(plyReader.positions),
+        std::move(plyReader.normals),
+        std::move(plyReader.texcoords));
     if (FAILED(hr))
         return hr;
 
-    hr = inMesh->SetVertexData(vbr, plyReader.vertices.size());
-    if (FAILED(hr))
-        return hr;
-
-    if (!plyReader.materials.empty())
-    {
-        inMaterial.clear();
-        inMaterial.reserve(plyReader.materials.size());
+    Mesh::Material mtl = {};
 
-        for (auto it = plyReader.materials.cbegin(); it != plyReader.materials.cend(); ++it)
-        {
-            Mesh::Material mtl = {};
-
-            mtl.name = it->strName;
-            mtl.specularPower = (it->bSpecular) ? float(it->nShininess) : 1.f;
-            mtl.alpha = it->fAlpha;
-            mtl.ambientColor = it->vAmbient;
-            mtl.diffuseColor = it->vDiffuse;
-            mtl.specularColor = (it->bSpecular) ? it->vSpecular : XMFLOAT3(0.f, 0.f, 0.f);
-            mtl.emissiveColor = (it->bEmissive) ? it->vEmissive : XMFLOAT3(0.f, 0.f, 0.f);
-
-            mtl.texture = ProcessTextureFileName(it->strTexture, dds);
-            mtl.normalTexture = ProcessTextureFileName(it->strNormalTexture, dds);
-            mtl.specularTexture = ProcessTextureFileName(it->strSpecularTexture, dds);
-            if (it->bEmissive)
-            {
-                mtl.emissiveTexture = ProcessTextureFileName(it->strEmissiveTexture, dds);
-            }
-            mtl.rmaTexture = ProcessTextureFileName(it->strRMATexture, dds);
+    mtl.name = L"default";
+    mtl.specularPower = 1.f;
+    mtl.alpha = 1.f;
+    mtl.ambientColor = XMFLOAT3(0.2f, 0.2f, 0.2f);
+    mtl.diffuseColor = XMFLOAT3(0.8f, 0.8f, 0.8f);
+    mtl.texture = ProcessTextureFileName(plyReader.textureFile.c_str(), dds);
 
-            inMaterial.push_back(mtl);
-        }
-    }
+    inMaterial.clear();
+    inMaterial.push_back(mtl);
 
     return S_OK;
 }
@@ -26,9 +26,14 @@
 #include <assert.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <list>
+#include <thread>
 
 #include <dxgiformat.h>
 
@@ -84,6 +89,9 @@ enum OPTIONS
     OPT_NOLOGO,
     OPT_FILELIST,
     OPT_REMAP,
+    OPT_JOBS,
+    OPT_TIME_BUDGET,
+    OPT_BATCH_SPLIT,
     OPT_MAX
 };
 
@@ -102,6 +110,35 @@ struct SConversion
     char szSrc[MAX_PATH];
 };
 
+// Options shared by all the input files
+struct SSettings
+{
+    DWORD64 dwOptions;
+    size_t maxCharts;
+    float maxStretch;
+    float gutter;
+    size_t width;
+    size_t height;
+    CHANNELS perVertex;
+    DWORD uvOptions;
+    const char* szTexFile;
+    const char* szOutputFile;
+    const char* szRemapFile;
+    size_t jobs;
+    float timeBudget;
+};
+
+// Statistics of one input file for the batch summary, times in milliseconds
+struct SFileReport
+{
+    size_t nFaces;
+    double loadTime;
+    double adjacencyTime;
+    double atlasTime;
+    double exportTime;
+    int result;
+};
+
 struct SValue
 {
     const char *pName;
@@ -161,6 +198,9 @@ const SValue g_pOptions [] =
     { "nologo",    OPT_NOLOGO },
     { "flist",     OPT_FILELIST },
     { "remap",     OPT_REMAP },
+    { "j",         OPT_JOBS },
+    { "budget",    OPT_TIME_BUDGET },
+    { "batch",     OPT_BATCH_SPLIT },
     { nullptr,      0 }
 };
 
@@ -249,6 +289,9 @@ namespace
         wprintf(L"   -nologo             suppress copyright message\n");
         wprintf(L"   -flist <filename>   use text file with a list of input files (one per line)\n");
         wprintf(L"   -remap <filename>   output vertex remap file\n");
+        wprintf(L"   -j <number>         number of files processed in parallel, 0 for one per core (def: 1)\n");
+        wprintf(L"   -budget <seconds>   stop partitioning each mesh after this time, 0 for no limit (def: 0)\n");
+        wprintf(L"   -batch              split several charts per partition round, faster on large meshes\n");
 
         wprintf(L"\n");
     }
@@ -269,431 +312,171 @@ namespace
 
         return S_OK;
     }
-}
-
-extern HRESULT LoadFromPLY(const char* szFilename, std::unique_ptr<Mesh>& inMesh, std::vector<Mesh::Material>& inMaterial, bool ccw, bool dds);
-
-//--------------------------------------------------------------------------------------
-// Entry-point
-//--------------------------------------------------------------------------------------
-#pragma prefast(disable : 28198, "Command-line tool, frees all memory on exit")
-
-int main(_In_ int argc, _In_z_count_(argc) char* argv[])
-{
-    // Parameters and defaults
-    size_t maxCharts = 0;
-    float maxStretch = 0.16667f;
-    float gutter = 2.f;
-    size_t width = 512;
-    size_t height = 512;
-    CHANNELS perVertex = CHANNEL_NONE;
-    DWORD uvOptions = UVATLAS_DEFAULT;
-
-    char szTexFile[MAX_PATH] = {};
-    char szOutputFile[MAX_PATH] = {};
-    char szRemapFile[MAX_PATH] = {};
 
-    HRESULT hr = S_OK;
 
-    // Process command line
-    DWORD64 dwOptions = 0;
-    std::list<SConversion> conversion;
+    //--------------------------------------------------------------------------------------
+    // Output of one worker. When several files are processed at once the text of each
+    // file is buffered and written out as a whole, so that their messages don't interleave.
+    std::mutex g_outputLock;
 
-    for (int iArg = 1; iArg < argc; iArg++)
+    class CLog
     {
-        char *pArg = argv[iArg];
-
-        if ('-' == pArg[0])
-        {
-            pArg++;
-            char *pValue;
+    public:
+        explicit CLog(bool buffered) noexcept : mBuffered(buffered) {}
 
-            for (pValue = pArg; *pValue && (':' != *pValue); pValue++);
-
-            if (*pValue)
-                *pValue++ = 0;
+        CLog(CLog const&) = delete;
+        CLog& operator= (CLog const&) = delete;
 
-            DWORD dwOption = LookupByName(pArg, g_pOptions);
+        void Print(_In_z_ _Printf_format_string_ const wchar_t* format, ...)
+        {
+            va_list args;
+            va_start(args, format);
 
-            if (!dwOption || (dwOptions & (DWORD64(1) << dwOption)))
+            if (!mBuffered)
             {
-                wprintf(L"ERROR: unknown command-line option '%s'\n\n", pArg);
-                PrintUsage();
-                return 1;
+                vwprintf(format, args);
+                fflush(stdout);
             }
-
-            dwOptions |= (DWORD64(1) << dwOption);
-
-            // Handle options with additional value parameter
-            switch (dwOption)
+            else
             {
-            case OPT_QUALITY:
-            case OPT_MAXCHARTS:
-            case OPT_MAXSTRETCH:
-            case OPT_GUTTER:
-            case OPT_WIDTH:
-            case OPT_HEIGHT:
-            case OPT_IMT_TEXFILE:
-            case OPT_IMT_VERTEX:
-            case OPT_OUTPUTFILE:
-            case OPT_FILELIST:
-            case OPT_REMAP:
-                if (!*pValue)
+                std::vector<wchar_t> buffer(256);
+                for (;;)
                 {
-                    if ((iArg + 1 >= argc))
+                    va_list argsCopy;
+                    va_copy(argsCopy, args);
+                    int length = vswprintf(buffer.data(), buffer.size(), format, argsCopy);
+                    va_end(argsCopy);
+
+                    if (length >= 0)
                     {
-                        wprintf(L"ERROR: missing value for command-line option '%s'\n\n", pArg);
-                        PrintUsage();
-                        return 1;
+                        mText.append(buffer.data(), size_t(length));
+                        break;
                     }
 
-                    iArg++;
-                    pValue = argv[iArg];
+                    if (buffer.size() >= 65536)
+                        break;
+
+                    buffer.resize(buffer.size() * 4);
                 }
-                break;
             }
 
-            switch (dwOption)
+            va_end(args);
+        }
+
+        void Flush()
+        {
+            if (!mText.empty())
             {
-            case OPT_QUALITY:
-                if (!_stricmp(pValue, "DEFAULT"))
-                {
-                    uvOptions = UVATLAS_DEFAULT;
-                }
-                else if (!_stricmp(pValue, "FAST"))
-                {
-                    uvOptions = UVATLAS_GEODESIC_FAST;
-                }
-                else if (!_stricmp(pValue, "QUALITY"))
-                {
-                    uvOptions = UVATLAS_GEODESIC_QUALITY;
-                }
-                else
-                {
-                    wprintf(L"Invalid value specified with -q (%s)\n", pValue);
-                    return 1;
-                }
-                break;
+                std::lock_guard<std::mutex> lock(g_outputLock);
+                fputws(mText.c_str(), stdout);
+                fflush(stdout);
+                mText.clear();
+            }
+        }
 
-            case OPT_MAXCHARTS:
-                if (sscanf(pValue, "%zu", &maxCharts) != 1)
-                {
-                    wprintf(L"Invalid value specified with -n (%s)\n", pValue);
-                    return 1;
-                }
-                break;
+    private:
+        bool            mBuffered;
+        std::wstring    mText;
+    };
+}
 
-            case OPT_MAXSTRETCH:
-                if (sscanf(pValue, "%f", &maxStretch) != 1
-                    || maxStretch < 0.f
-                    || maxStretch > 1.f)
-                {
-                    wprintf(L"Invalid value specified with -st (%s)\n", pValue);
-                    return 1;
-                }
-                break;
+extern HRESULT LoadFromPLY(const char* szFilename, std::unique_ptr<Mesh>& inMesh, std::vector<Mesh::Material>& inMaterial, bool ccw, bool dds);
+extern HRESULT GetFaceCountFromPLY(const char* szFilename, size_t& nFaces);
 
-            case OPT_GUTTER:
-                if (sscanf(pValue, "%f", &gutter) != 1
-                    || gutter < 0.f)
-                {
-                    wprintf(L"Invalid value specified with -g (%s)\n", pValue);
-                    return 1;
-                }
-                break;
+namespace
+{
+    double GetElapsedTime(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
 
-            case OPT_WIDTH:
-                if (sscanf(pValue, "%zu", &width) != 1)
-                {
-                    wprintf(L"Invalid value specified with -w (%s)\n", pValue);
-                    return 1;
-                }
-                break;
 
-            case OPT_HEIGHT:
-                if (sscanf(pValue, "%zu", &height) != 1)
-                {
-                    wprintf(L"Invalid value specified with -h (%s)\n", pValue);
-                    return 1;
-                }
-                break;
+    //--------------------------------------------------------------------------------------
+    // Converts one input file, returns the tool's exit code for it
+    //--------------------------------------------------------------------------------------
+    int ProcessFile(const SConversion& conv, const SSettings& settings, CLog& log, SFileReport& report)
+    {
+        DWORD64 dwOptions = settings.dwOptions;
+        HRESULT hr = S_OK;
 
-            case OPT_WEIGHT_BY_AREA:
-                if (dwOptions & (DWORD64(1) << OPT_WEIGHT_BY_EQUAL))
-                {
-                    wprintf(L"Can only use one of nn, na, or ne\n");
-                    return 1;
-                }
-                dwOptions |= (DWORD64(1) << OPT_NORMALS);
-                break;
+        // Progress is only shown when files are processed one at a time
+        std::function<HRESULT __cdecl(float percentComplete)> statusCallBack;
+        if (settings.jobs <= 1)
+        {
+            statusCallBack = UVAtlasCallback;
+        }
 
-            case OPT_WEIGHT_BY_EQUAL:
-                if (dwOptions & (DWORD64(1) << OPT_WEIGHT_BY_AREA))
-                {
-                    wprintf(L"Can only use one of nn, na, or ne\n");
-                    return 1;
-                }
-                dwOptions |= (DWORD64(1) << OPT_NORMALS);
-                break;
+        char ext[_MAX_EXT];
+        char fname[_MAX_FNAME];
+        _splitpath_s(conv.szSrc, nullptr, 0, nullptr, 0, fname, _MAX_FNAME, ext, _MAX_EXT);
 
-            case OPT_IMT_TEXFILE:
-                if (dwOptions & (DWORD64(1) << OPT_IMT_VERTEX))
-                {
-                    wprintf(L"Cannot use both if and iv at the same time\n");
-                    return 1;
-                }
+        log.Print(L"reading %s\n", conv.szSrc);
 
-                strcpy(szTexFile, pValue);
-                break;
+        auto stageStart = std::chrono::steady_clock::now();
 
-            case OPT_IMT_VERTEX:
-                if (dwOptions & (DWORD64(1) << OPT_IMT_TEXFILE))
-                {
-                    wprintf(L"Cannot use both if and iv at the same time\n");
-                    return 1;
-                }
+        std::unique_ptr<Mesh> inMesh;
+        std::vector<Mesh::Material> inMaterial;
+        hr = E_NOTIMPL;
+        if (_stricmp(ext, ".vbo") == 0)
+        {
+            log.Print(L"\nERROR: Importing VBO files not supported\n");
+            return 1;
+        }
+        else if (_stricmp(ext, ".sdkmesh") == 0)
+        {
+            log.Print(L"\nERROR: Importing SDKMESH files not supported\n");
+            return 1;
+        }
+        else if (_stricmp(ext, ".cmo") == 0)
+        {
+            log.Print(L"\nERROR: Importing Visual Studio CMO files not supported\n");
+            return 1;
+        }
+        else if (_stricmp(ext, ".x") == 0)
+        {
+            log.Print(L"\nERROR: Legacy Microsoft X files not supported\n");
+            return 1;
+        }
+        else if (_stricmp(ext, ".fbx") == 0)
+        {
+            log.Print(L"\nERROR: Autodesk FBX files not supported\n");
+            return 1;
+        }
+        else
+        {
+            hr = LoadFromPLY(conv.szSrc, inMesh, inMaterial,
+                (dwOptions & (1 << OPT_CLOCKWISE)) ? false : true,
+                (dwOptions & (1 << OPT_NODDS)) ? false : true);
+        }
+        if (FAILED(hr))
+        {
+            log.Print(L" FAILED (%08X)\n", hr);
+            return 1;
+        }
 
-                if (!_stricmp(pValue, "COLOR"))
-                {
-                    perVertex = CHANNEL_COLOR;
-                }
-                else if (!_stricmp(pValue, "NORMAL"))
-                {
-                    perVertex = CHANNEL_NORMAL;
-                }
-                else if (!_stricmp(pValue, "TEXCOORD"))
-                {
-                    perVertex = CHANNEL_TEXCOORD;
-                }
-                else
-                {
-                    wprintf(L"Invalid value specified with -iv (%s)\n", pValue);
-                    return 1;
-                }
-                break;
+        report.loadTime = GetElapsedTime(stageStart);
 
-            case OPT_OUTPUTFILE:
-                strcpy(szOutputFile, pValue);
-                break;
+        size_t nVerts = inMesh->GetVertexCount();
+        size_t nFaces = inMesh->GetFaceCount();
+        report.nFaces = nFaces;
 
-            case OPT_REMAP:
-                strcpy(szRemapFile, pValue);
-                break;
+        if (!nVerts || !nFaces)
+        {
+            log.Print(L"\nERROR: Invalid mesh\n");
+            return 1;
+        }
 
-            case OPT_TOPOLOGICAL_ADJ:
-                if (dwOptions & (DWORD64(1) << OPT_GEOMETRIC_ADJ))
-                {
-                    wprintf(L"Cannot use both ta and ga at the same time\n");
-                    return 1;
-                }
-                break;
+        assert(inMesh->GetPositionBuffer() != 0);
+        assert(inMesh->GetIndexBuffer() != 0);
 
-            case OPT_GEOMETRIC_ADJ:
-                if (dwOptions & (DWORD64(1) << OPT_TOPOLOGICAL_ADJ))
-                {
-                    wprintf(L"Cannot use both ta and ga at the same time\n");
-                    return 1;
-                }
-                break;
-
-            case OPT_SDKMESH:
-            case OPT_SDKMESH_V2:
-                if (dwOptions & ((DWORD64(1) << OPT_VBO) | (DWORD64(1) << OPT_CMO) | (DWORD64(1) << OPT_PLY)))
-                {
-                    wprintf(L"Can only use one of sdkmesh, cmo, vbo or ply\n");
-                    return 1;
-                }
-                if (dwOption == OPT_SDKMESH_V2)
-                {
-                    dwOptions |= (DWORD64(1) << OPT_SDKMESH);
-                }
-                break;
-
-            case OPT_CMO:
-                if (dwOptions & ((DWORD64(1) << OPT_VBO) | (DWORD64(1) << OPT_SDKMESH) | (DWORD64(1) << OPT_PLY)))
-                {
-                    wprintf(L"Can only use one of sdkmesh, cmo, vbo or ply\n");
-                    return 1;
-                }
-                break;
-
-            case OPT_VBO:
-                if (dwOptions & ((DWORD64(1) << OPT_SDKMESH) | (DWORD64(1) << OPT_CMO) | (DWORD64(1) << OPT_PLY)))
-                {
-                    wprintf(L"Can only use one of sdkmesh, cmo, vbo or ply\n");
-                    return 1;
-                }
-                break;
-
-            case OPT_PLY:
-                if (dwOption & ((DWORD64(1) << OPT_SDKMESH) | (DWORD64(1) << OPT_CMO) | (DWORD64(1) << OPT_VBO)))
-                {
-                    wprintf(L"Can only use one of sdkmesh, cmo, vbo or ply\n");
-                    return 1;
-                }
-                break;
-
-            case OPT_FILELIST:
-                {
-                    wprintf(L"ERROR: unknown command-line option '%s'\n\n", pArg);
-                    PrintUsage();
-                    return 1;
-                    // std::wifstream inFile(pValue);
-                    // if (!inFile)
-                    // {
-                    //     wprintf(L"Error opening -flist file %ls\n", pValue);
-                    //     return 1;
-                    // }
-                    // wchar_t fname[1024] = {};
-                    // for (;;)
-                    // {
-                    //     inFile >> fname;
-                    //     if (!inFile)
-                    //         break;
-
-                    //     if (*fname == L'#')
-                    //     {
-                    //         // Comment
-                    //     }
-                    //     else if (*fname == L'-')
-                    //     {
-                    //         wprintf(L"Command-line arguments not supported in -flist file\n");
-                    //         return 1;
-                    //     }
-                    //     else if (wcspbrk(fname, L"?*") != nullptr)
-                    //     {
-                    //         wprintf(L"Wildcards not supported in -flist file\n");
-                    //         return 1;
-                    //     }
-                    //     else
-                    //     {
-                    //         SConversion conv;
-                    //         wcscpy(conv.szSrc, fname);
-                    //         conversion.push_back(conv);
-                    //     }
-
-                    //     inFile.ignore(1000, '\n');
-                    // }
-                    // inFile.close();
-                }
-                break;
-            }
-        }
-        else if (strpbrk(pArg, "?*") != nullptr)
-        {
-            wprintf(L"ERROR: unknown command-line option '%s'\n\n", pArg);
-            PrintUsage();
-            return 1;
-            // size_t count = conversion.size();
-            // SearchForFiles(pArg, conversion, (dwOptions & (DWORD64(1) << OPT_RECURSIVE)) != 0);
-            // if (conversion.size() <= count)
-            // {
-            //     wprintf(L"No matching files found for %ls\n", pArg);
-            //     return 1;
-            // }
-        }
-        else
-        {
-            SConversion conv;
-            strcpy(conv.szSrc, pArg);
-
-            conversion.push_back(conv);
-        }
-    }
-
-    if (conversion.empty())
-    {
-        PrintUsage();
-        return 0;
-    }
-
-    if (*szOutputFile && conversion.size() > 1)
-    {
-        wprintf(L"Cannot use -o with multiple input files\n");
-        return 1;
-    }
-
-    if (*szRemapFile && conversion.size() > 1) {
-        wprintf(L"Cannot use -remap with multiple input files\n");
-        return 1;
-    }
-
-    if (~dwOptions & (DWORD64(1) << OPT_NOLOGO))
-        PrintLogo();
-
-    // Process files
-    for (auto pConv = conversion.begin(); pConv != conversion.end(); ++pConv)
-    {
-        char ext[_MAX_EXT];
-        char fname[_MAX_FNAME];
-        _splitpath_s(pConv->szSrc, nullptr, 0, nullptr, 0, fname, _MAX_FNAME, ext, _MAX_EXT);
-
-        if (pConv != conversion.begin())
-            wprintf(L"\n");
-
-        wprintf(L"reading %s\n", pConv->szSrc);
-        fflush(stdout);
-
-        std::unique_ptr<Mesh> inMesh;
-        std::vector<Mesh::Material> inMaterial;
-        hr = E_NOTIMPL;
-        if (_stricmp(ext, ".vbo") == 0)
-        {
-            wprintf(L"\nERROR: Importing VBO files not supported\n");
-            return 1;
-        }
-        else if (_stricmp(ext, ".sdkmesh") == 0)
-        {
-            wprintf(L"\nERROR: Importing SDKMESH files not supported\n");
-            return 1;
-        }
-        else if (_stricmp(ext, ".cmo") == 0)
-        {
-            wprintf(L"\nERROR: Importing Visual Studio CMO files not supported\n");
-            return 1;
-        }
-        else if (_stricmp(ext, ".x") == 0)
-        {
-            wprintf(L"\nERROR: Legacy Microsoft X files not supported\n");
-            return 1;
-        }
-        else if (_stricmp(ext, ".fbx") == 0)
-        {
-            wprintf(L"\nERROR: Autodesk FBX files not supported\n");
-            return 1;
-        }
-        else
-        {
-            hr = LoadFromPLY(pConv->szSrc, inMesh, inMaterial,
-                (dwOptions & (1 << OPT_CLOCKWISE)) ? false : true,
-                (dwOptions & (1 << OPT_NODDS)) ? false : true);
-        }
-        if (FAILED(hr))
-        {
-            wprintf(L" FAILED (%08X)\n", hr);
-            return 1;
-        }
-
-        size_t nVerts = inMesh->GetVertexCount();
-        size_t nFaces = inMesh->GetFaceCount();
-
-        if (!nVerts || !nFaces)
-        {
-            wprintf(L"\nERROR: Invalid mesh\n");
-            return 1;
-        }
-
-        assert(inMesh->GetPositionBuffer() != 0);
-        assert(inMesh->GetIndexBuffer() != 0);
-
-        wprintf(L"\n%zu vertices, %zu faces", nVerts, nFaces);
+        log.Print(L"\n%zu vertices, %zu faces", nVerts, nFaces);
 
         if (dwOptions & (DWORD64(1) << OPT_FLIPU))
         {
             hr = inMesh->InvertUTexCoord();
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed inverting u texcoord (%08X)\n", hr);
+                log.Print(L"\nERROR: Failed inverting u texcoord (%08X)\n", hr);
                 return 1;
             }
         }
@@ -703,7 +486,7 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
             hr = inMesh->InvertVTexCoord();
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed inverting v texcoord (%08X)\n", hr);
+                log.Print(L"\nERROR: Failed inverting v texcoord (%08X)\n", hr);
                 return 1;
             }
         }
@@ -713,12 +496,13 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
             hr = inMesh->ReverseHandedness();
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed reversing handedness (%08X)\n", hr);
+                log.Print(L"\nERROR: Failed reversing handedness (%08X)\n", hr);
                 return 1;
             }
         }
 
         // Prepare mesh for processing
+        stageStart = std::chrono::steady_clock::now();
         {
             // Adjacency
             float epsilon = (dwOptions & (DWORD64(1) << OPT_GEOMETRIC_ADJ)) ? 1e-5f : 0.f;
@@ -726,7 +510,7 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
             hr = inMesh->GenerateAdjacency(epsilon);
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed generating adjacency (%08X)\n", hr);
+                log.Print(L"\nERROR: Failed generating adjacency (%08X)\n", hr);
                 return 1;
             }
 
@@ -735,15 +519,15 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
             hr = inMesh->Validate(VALIDATE_BACKFACING | VALIDATE_BOWTIES, &msgs);
             if (!msgs.empty())
             {
-                wprintf(L"\nWARNING: \n");
-                wprintf(msgs.c_str());
+                log.Print(L"\nWARNING: \n");
+                log.Print(L"%ls", msgs.c_str());
             }
 
             // Clean
             hr = inMesh->Clean(true);
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed mesh clean (%08X)\n", hr);
+                log.Print(L"\nERROR: Failed mesh clean (%08X)\n", hr);
                 return 1;
             }
             else
@@ -751,12 +535,14 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
                 size_t nNewVerts = inMesh->GetVertexCount();
                 if (nVerts != nNewVerts)
                 {
-                    wprintf(L" [%zu vertex dups] ", nNewVerts - nVerts);
+                    log.Print(L" [%zu vertex dups] ", nNewVerts - nVerts);
                     nVerts = nNewVerts;
                 }
             }
         }
 
+        report.adjacencyTime = GetElapsedTime(stageStart);
+
         if (!inMesh->GetNormalBuffer())
         {
             dwOptions |= DWORD64(1) << OPT_NORMALS;
@@ -790,7 +576,7 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
             hr = inMesh->ComputeNormals(flags);
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed computing normals (flags:%1X, %08X)\n", flags, hr);
+                log.Print(L"\nERROR: Failed computing normals (flags:%1X, %08X)\n", flags, hr);
                 return 1;
             }
         }
@@ -800,103 +586,104 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
         {
             if (!inMesh->GetTexCoordBuffer())
             {
-                wprintf(L"\nERROR: Computing tangents/bi-tangents requires texture coordinates\n");
+                log.Print(L"\nERROR: Computing tangents/bi-tangents requires texture coordinates\n");
                 return 1;
             }
 
             hr = inMesh->ComputeTangentFrame((dwOptions & (DWORD64(1) << OPT_CTF)) ? true : false);
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed computing tangent frame (%08X)\n", hr);
+                log.Print(L"\nERROR: Failed computing tangent frame (%08X)\n", hr);
                 return 1;
             }
         }
 
         // Compute IMT
+        stageStart = std::chrono::steady_clock::now();
         std::unique_ptr<float[]> IMTData;
         if (dwOptions & ((DWORD64(1) << OPT_IMT_TEXFILE) | (DWORD64(1) << OPT_IMT_VERTEX)))
         {
             if (dwOptions & (DWORD64(1) << OPT_IMT_TEXFILE))
             {
                 hr = E_FAIL;
-//                 if (!inMesh->GetTexCoordBuffer())
-//                 {
-//                     wprintf(L"\nERROR: Computing IMT from texture requires texture coordinates\n");
-//                     return 1;
-//                 }
-
-//                 wchar_t txext[_MAX_EXT];
-//                 _wsplitpath_s(szTexFile, nullptr, nullptr, txext);
-
-//                 ScratchImage iimage;
-
-//                 if (_wcsicmp(txext, L".dds") == 0)
-//                 {
-//                     hr = LoadFromDDSFile(szTexFile, DDS_FLAGS_NONE, nullptr, iimage);
-//                 }
-//                 else if (_wcsicmp(ext, L".tga") == 0)
-//                 {
-//                     hr = LoadFromTGAFile(szTexFile, nullptr, iimage);
-//                 }
-//                 else if (_wcsicmp(ext, L".hdr") == 0)
-//                 {
-//                     hr = LoadFromHDRFile(szTexFile, nullptr, iimage);
-//                 }
-// #ifdef USE_OPENEXR
-//                 else if (_wcsicmp(ext, L".exr") == 0)
-//                 {
-//                     hr = LoadFromEXRFile(szTexFile, nullptr, iimage);
-//                 }
-// #endif
-//                 else
-//                 {
-//                     // hr = LoadFromWICFile(szTexFile, TEX_FILTER_DEFAULT, nullptr, iimage);
-//                     hr = E_FAIL;
-//                 }
-//                 if (FAILED(hr))
-//                 {
-//                     wprintf(L"\nWARNING: Failed to load texture for IMT (%08X):\n%ls\n", hr, szTexFile);
-//                 }
-//                 else
-//                 {
-//                     const Image* img = iimage.GetImage(0, 0, 0);
-
-//                     ScratchImage floatImage;
-//                     if (img->format != DXGI_FORMAT_R32G32B32A32_FLOAT)
-//                     {
-//                         hr = Convert(*iimage.GetImage(0, 0, 0), DXGI_FORMAT_R32G32B32A32_FLOAT, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, floatImage);
-//                         if (FAILED(hr))
-//                         {
-//                             img = nullptr;
-//                             wprintf(L"\nWARNING: Failed converting texture for IMT (%08X):\n%ls\n", hr, szTexFile);
-//                         }
-//                         else
-//                         {
-//                             img = floatImage.GetImage(0, 0, 0);
-//                         }
-//                     }
-
-//                     if (img)
-//                     {
-//                         wprintf(L"\nComputing IMT from file %ls...\n", szTexFile);
-//                         IMTData.reset(new (std::nothrow) float[nFaces * 3]);
-//                         if (!IMTData)
-//                         {
-//                             wprintf(L"\nERROR: out of memory\n");
-//                             return 1;
-//                         }
-
-//                         hr = UVAtlasComputeIMTFromTexture(inMesh->GetPositionBuffer(), inMesh->GetTexCoordBuffer(), nVerts,
-//                             inMesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, nFaces,
-//                             reinterpret_cast<const float*>(img->pixels), img->width, img->height,
-//                             UVATLAS_IMT_DEFAULT, UVAtlasCallback, IMTData.get());
-//                         if (FAILED(hr))
-//                         {
-//                             IMTData.reset();
-//                             wprintf(L"WARNING: Failed to compute IMT from texture (%08X):\n%ls\n", hr, szTexFile);
-//                         }
-//                     }
-//                 }
+    //                 if (!inMesh->GetTexCoordBuffer())
+    //                 {
+    //                     log.Print(L"\nERROR: Computing IMT from texture requires texture coordinates\n");
+    //                     return 1;
+    //                 }
+
+    //                 wchar_t txext[_MAX_EXT];
+    //                 _wsplitpath_s(settings.szTexFile, nullptr, nullptr, txext);
+
+    //                 ScratchImage iimage;
+
+    //                 if (_wcsicmp(txext, L".dds") == 0)
+    //                 {
+    //                     hr = LoadFromDDSFile(settings.szTexFile, DDS_FLAGS_NONE, nullptr, iimage);
+    //                 }
+    //                 else if (_wcsicmp(ext, L".tga") == 0)
+    //                 {
+    //                     hr = LoadFromTGAFile(settings.szTexFile, nullptr, iimage);
+    //                 }
+    //                 else if (_wcsicmp(ext, L".hdr") == 0)
+    //                 {
+    //                     hr = LoadFromHDRFile(settings.szTexFile, nullptr, iimage);
+    //                 }
+    // #ifdef USE_OPENEXR
+    //                 else if (_wcsicmp(ext, L".exr") == 0)
+    //                 {
+    //                     hr = LoadFromEXRFile(settings.szTexFile, nullptr, iimage);
+    //                 }
+    // #endif
+    //                 else
+    //                 {
+    //                     // hr = LoadFromWICFile(settings.szTexFile, TEX_FILTER_DEFAULT, nullptr, iimage);
+    //                     hr = E_FAIL;
+    //                 }
+    //                 if (FAILED(hr))
+    //                 {
+    //                     log.Print(L"\nWARNING: Failed to load texture for IMT (%08X):\n%ls\n", hr, settings.szTexFile);
+    //                 }
+    //                 else
+    //                 {
+    //                     const Image* img = iimage.GetImage(0, 0, 0);
+
+    //                     ScratchImage floatImage;
+    //                     if (img->format != DXGI_FORMAT_R32G32B32A32_FLOAT)
+    //                     {
+    //                         hr = Convert(*iimage.GetImage(0, 0, 0), DXGI_FORMAT_R32G32B32A32_FLOAT, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, floatImage);
+    //                         if (FAILED(hr))
+    //                         {
+    //                             img = nullptr;
+    //                             log.Print(L"\nWARNING: Failed converting texture for IMT (%08X):\n%ls\n", hr, settings.szTexFile);
+    //                         }
+    //                         else
+    //                         {
+    //                             img = floatImage.GetImage(0, 0, 0);
+    //                         }
+    //                     }
+
+    //                     if (img)
+    //                     {
+    //                         log.Print(L"\nComputing IMT from file %ls...\n", settings.szTexFile);
+    //                         IMTData.reset(new (std::nothrow) float[nFaces * 3]);
+    //                         if (!IMTData)
+    //                         {
+    //                             log.Print(L"\nERROR: out of memory\n");
+    //                             return 1;
+    //                         }
+
+    //                         hr = UVAtlasComputeIMTFromTexture(inMesh->GetPositionBuffer(), inMesh->GetTexCoordBuffer(), nVerts,
+    //                             inMesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, nFaces,
+    //                             reinterpret_cast<const float*>(img->pixels), img->width, img->height,
+    //                             UVATLAS_IMT_DEFAULT, statusCallBack, IMTData.get());
+    //                         if (FAILED(hr))
+    //                         {
+    //                             IMTData.reset();
+    //                             log.Print(L"WARNING: Failed to compute IMT from texture (%08X):\n%ls\n", hr, settings.szTexFile);
+    //                         }
+    //                     }
+    //                 }
             }
             else
             {
@@ -904,7 +691,7 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
                 const float* pSignal = nullptr;
                 size_t signalDim = 0;
                 size_t signalStride = 0;
-                switch (perVertex)
+                switch (settings.perVertex)
                 {
                 case CHANNEL_NORMAL:
                     szChannel = L"normals";
@@ -939,38 +726,38 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
 
                 if (!pSignal)
                 {
-                    wprintf(L"\nWARNING: Mesh does not have channel %ls for IMT\n", szChannel);
+                    log.Print(L"\nWARNING: Mesh does not have channel %ls for IMT\n", szChannel);
                 }
                 else
                 {
-                    wprintf(L"\nComputing IMT from %ls...\n", szChannel);
+                    log.Print(L"\nComputing IMT from %ls...\n", szChannel);
 
                     IMTData.reset(new (std::nothrow) float[nFaces * 3]);
                     if (!IMTData)
                     {
-                        wprintf(L"\nERROR: out of memory\n");
+                        log.Print(L"\nERROR: out of memory\n");
                         return 1;
                     }
 
                     hr = UVAtlasComputeIMTFromPerVertexSignal(inMesh->GetPositionBuffer(), nVerts,
                         inMesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, nFaces,
-                        pSignal, signalDim, signalStride, UVAtlasCallback, IMTData.get());
+                        pSignal, signalDim, signalStride, statusCallBack, IMTData.get());
 
                     if (FAILED(hr))
                     {
                         IMTData.reset();
-                        wprintf(L"WARNING: Failed to compute IMT from channel %ls (%08X)\n", szChannel, hr);
+                        log.Print(L"WARNING: Failed to compute IMT from channel %ls (%08X)\n", szChannel, hr);
                     }
                 }
             }
         }
         else
         {
-            wprintf(L"\n");
+            log.Print(L"\n");
         }
 
         // Perform UVAtlas isocharting
-        wprintf(L"Computing isochart atlas on mesh...\n");
+        log.Print(L"Computing isochart atlas on mesh...\n");
 
         std::vector<UVAtlasVertex> vb;
         std::vector<uint8_t> ib;
@@ -980,43 +767,51 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
         std::vector<uint32_t> vertexRemapArray;
         hr = UVAtlasCreate(inMesh->GetPositionBuffer(), nVerts,
             inMesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, nFaces,
-            maxCharts, maxStretch, width, height, gutter,
+            settings.maxCharts, settings.maxStretch, settings.width, settings.height, settings.gutter,
             inMesh->GetAdjacencyBuffer(), nullptr,
             IMTData.get(),
-            UVAtlasCallback, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
-            uvOptions, vb, ib,
+            statusCallBack, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+            settings.uvOptions, vb, ib,
             &facePartitioning,
             &vertexRemapArray,
-            &outStretch, &outCharts);
+            &outStretch, &outCharts,
+            nullptr, settings.timeBudget);
         if (FAILED(hr))
         {
             if (hr == HRESULT_FROM_WIN32(ERROR_INVALID_DATA))
             {
-                wprintf(L"\nERROR: Non-manifold mesh\n");
+                log.Print(L"\nERROR: Non-manifold mesh\n");
                 return 1;
             }
             else
             {
-                wprintf(L"\nERROR: Failed creating isocharts (%08X)\n", hr);
+                log.Print(L"\nERROR: Failed creating isocharts (%08X)\n", hr);
                 return 1;
             }
         }
 
-        wprintf(L"Output # of charts: %zu, resulting stretching %f, %zu verts\n", outCharts, outStretch, vb.size());
+        if (hr == S_FALSE)
+        {
+            log.Print(L"WARNING: Time budget expired before reaching the stretch target\n");
+        }
+
+        report.atlasTime = GetElapsedTime(stageStart);
+
+        log.Print(L"Output # of charts: %zu, resulting stretching %f, %zu verts\n", outCharts, outStretch, vb.size());
 
         assert((ib.size() / sizeof(uint32_t)) == (nFaces * 3));
         assert(facePartitioning.size() == nFaces);
         assert(vertexRemapArray.size() == vb.size());
 
-        if (*szRemapFile) {
-            std::ofstream fs(szRemapFile, std::ios::out | std::ios::binary);
+        if (*settings.szRemapFile) {
+            std::ofstream fs(settings.szRemapFile, std::ios::out | std::ios::binary);
             if (!fs.good()) {
-                wprintf(L" Failed opening remap file. ");
+                log.Print(L" Failed opening remap file. ");
                 return 1;
             }
             fs.write((char *)vertexRemapArray.data(), vertexRemapArray.size() * sizeof(uint32_t));
             if (!fs.good()) {
-                wprintf(L" Failed writing remap file. ");
+                log.Print(L" Failed writing remap file. ");
                 return 1;
             }
             fs.close();
@@ -1025,35 +820,35 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
         hr = inMesh->UpdateFaces(nFaces, reinterpret_cast<const uint32_t*>(ib.data()));
         if (FAILED(hr))
         {
-            wprintf(L"\nERROR: Failed applying atlas indices (%08X)\n", hr);
+            log.Print(L"\nERROR: Failed applying atlas indices (%08X)\n", hr);
             return 1;
         }
 
         hr = inMesh->VertexRemap(vertexRemapArray.data(), vertexRemapArray.size());
         if (FAILED(hr))
         {
-            wprintf(L"\nERROR: Failed applying atlas vertex remap (%08X)\n", hr);
+            log.Print(L"\nERROR: Failed applying atlas vertex remap (%08X)\n", hr);
             return 1;
         }
 
         nVerts = vb.size();
 
-#ifdef _DEBUG
+    #ifdef _DEBUG
         std::wstring msgs;
         hr = inMesh->Validate(VALIDATE_DEFAULT, &msgs);
         if (!msgs.empty())
         {
-            wprintf(L"\nWARNING: \n");
-            wprintf(msgs.c_str());
+            log.Print(L"\nWARNING: \n");
+            log.Print(L"%ls", msgs.c_str());
         }
-#endif
+    #endif
 
         // Copy isochart UVs into mesh
         {
             std::unique_ptr<XMFLOAT2[]> texcoord(new (std::nothrow) XMFLOAT2[nVerts]);
             if (!texcoord)
             {
-                wprintf(L"\nERROR: out of memory\n");
+                log.Print(L"\nERROR: out of memory\n");
                 return 1;
             }
 
@@ -1067,7 +862,7 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
             hr = inMesh->UpdateUVs(nVerts, texcoord.get());
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed to update with isochart UVs\n");
+                log.Print(L"\nERROR: Failed to update with isochart UVs\n");
                 return 1;
             }
         }
@@ -1099,7 +894,7 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
             std::unique_ptr<uint32_t[]> attr(new (std::nothrow) uint32_t[nFaces]);
             if (!attr)
             {
-                wprintf(L"\nERROR: out of memory\n");
+                log.Print(L"\nERROR: out of memory\n");
                 return 1;
             }
 
@@ -1112,7 +907,7 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
             hr = inMesh->UpdateAttributes(nFaces, attr.get());
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed applying atlas attributes (%08X)\n", hr);
+                log.Print(L"\nERROR: Failed applying atlas attributes (%08X)\n", hr);
                 return 1;
             }
         }
@@ -1122,22 +917,24 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
             hr = inMesh->ReverseWinding();
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed reversing winding (%08X)\n", hr);
+                log.Print(L"\nERROR: Failed reversing winding (%08X)\n", hr);
                 return 1;
             }
         }
 
         // Write results
-        wprintf(L"\n\t->\n");
+        stageStart = std::chrono::steady_clock::now();
+
+        log.Print(L"\n\t->\n");
 
         char outputPath[MAX_PATH] = {};
         char outputExt[_MAX_EXT] = {};
 
-        if (*szOutputFile)
+        if (*settings.szOutputFile)
         {
-            strcpy(outputPath, szOutputFile);
+            strcpy(outputPath, settings.szOutputFile);
 
-            _splitpath_s(szOutputFile, nullptr, 0, nullptr, 0, nullptr, 0, outputExt, _MAX_EXT);
+            _splitpath_s(settings.szOutputFile, nullptr, 0, nullptr, 0, nullptr, 0, outputExt, _MAX_EXT);
         }
         else
         {
@@ -1169,7 +966,7 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
             struct stat buffer;
             if (stat(outputPath, &buffer) == 0)
             {
-                wprintf(L"\nERROR: Output file already exists, use -y to overwrite:\n'%s'\n", outputPath);
+                log.Print(L"\nERROR: Output file already exists, use -y to overwrite:\n'%s'\n", outputPath);
                 return 1;
             }
         }
@@ -1178,39 +975,39 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
         {
             if (!inMesh->GetNormalBuffer() || !inMesh->GetTexCoordBuffer())
             {
-                wprintf(L"\nERROR: VBO requires position, normal, and texcoord\n");
+                log.Print(L"\nERROR: VBO requires position, normal, and texcoord\n");
                 return 1;
             }
 
             if (!inMesh->Is16BitIndexBuffer() || (dwOptions & (DWORD64(1) << OPT_FORCE_32BIT_IB)))
             {
-                wprintf(L"\nERROR: VBO only supports 16-bit indices\n");
+                log.Print(L"\nERROR: VBO only supports 16-bit indices\n");
                 return 1;
             }
 
-            wprintf(L"\nERROR: VBO files not supported\n");
+            log.Print(L"\nERROR: VBO files not supported\n");
             return 1;
         }
         else if (!_stricmp(outputExt, ".sdkmesh"))
         {
-            wprintf(L"\nERROR: SDKMESH files not supported\n");
+            log.Print(L"\nERROR: SDKMESH files not supported\n");
             return 1;
         }
         else if (!_stricmp(outputExt, ".cmo"))
         {
             if (!inMesh->GetNormalBuffer() || !inMesh->GetTexCoordBuffer() || !inMesh->GetTangentBuffer())
             {
-                wprintf(L"\nERROR: Visual Studio CMO requires position, normal, tangents, and texcoord\n");
+                log.Print(L"\nERROR: Visual Studio CMO requires position, normal, tangents, and texcoord\n");
                 return 1;
             }
 
             if (!inMesh->Is16BitIndexBuffer() || (dwOptions & (DWORD64(1) << OPT_FORCE_32BIT_IB)))
             {
-                wprintf(L"\nERROR: Visual Studio CMO only supports 16-bit indices\n");
+                log.Print(L"\nERROR: Visual Studio CMO only supports 16-bit indices\n");
                 return 1;
             }
 
-            wprintf(L"\nERROR: CMO files not supported\n");
+            log.Print(L"\nERROR: CMO files not supported\n");
             return 1;
         }
         else if (!_stricmp(outputExt, ".ply"))
@@ -1219,22 +1016,22 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
         }
         else if (!_stricmp(outputExt, ".x"))
         {
-            wprintf(L"\nERROR: Legacy Microsoft X files not supported\n");
+            log.Print(L"\nERROR: Legacy Microsoft X files not supported\n");
             return 1;
         }
         else
         {
-            wprintf(L"\nERROR: Unknown output file type '%s'\n", outputExt);
+            log.Print(L"\nERROR: Unknown output file type '%s'\n", outputExt);
             return 1;
         }
 
         if (FAILED(hr))
         {
-            wprintf(L"\nERROR: Failed write (%08X):-> '%s'\n", hr, outputPath);
+            log.Print(L"\nERROR: Failed write (%08X):-> '%s'\n", hr, outputPath);
             return 1;
         }
 
-        wprintf(L" %zu vertices, %zu faces written:\n'%s'\n", nVerts, nFaces, outputPath);
+        log.Print(L" %zu vertices, %zu faces written:\n'%s'\n", nVerts, nFaces, outputPath);
 
         // Write out UV mesh visualization
         if (dwOptions & (DWORD64(1) << OPT_UV_MESH))
@@ -1242,7 +1039,7 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
             hr = inMesh->VisualizeUVs();
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed to create UV visualization mesh\n");
+                log.Print(L"\nERROR: Failed to create UV visualization mesh\n");
                 return 1;
             }
 
@@ -1254,26 +1051,526 @@ int main(_In_ int argc, _In_z_count_(argc) char* argv[])
 
             if (!_stricmp(outputExt, ".vbo"))
             {
-                wprintf(L"\nERROR: VBO files not supported\n");
+                log.Print(L"\nERROR: VBO files not supported\n");
                 return 1;
             }
             else if (!_stricmp(outputExt, ".sdkmesh"))
             {
-                wprintf(L"\nERROR: SDKMESH files not supported\n");
+                log.Print(L"\nERROR: SDKMESH files not supported\n");
                 return 1;
             }
             else if (!_stricmp(outputExt, ".cmo"))
             {
-                wprintf(L"\nERROR: CMO files not supported\n");
+                log.Print(L"\nERROR: CMO files not supported\n");
                 return 1;
             }
             if (FAILED(hr))
             {
-                wprintf(L"\nERROR: Failed uv mesh write (%08X):-> '%s'\n", hr, outputPath);
+                log.Print(L"\nERROR: Failed uv mesh write (%08X):-> '%s'\n", hr, outputPath);
                 return 1;
             }
-            wprintf(L"uv mesh visualization '%s'\n", outputPath);
+            log.Print(L"uv mesh visualization '%s'\n", outputPath);
+        }
+
+        report.exportTime = GetElapsedTime(stageStart);
+
+        return 0;
+    }
+
+
+    //--------------------------------------------------------------------------------------
+    void PrintSummary(const std::vector<SConversion>& files, const std::vector<SFileReport>& reports, double totalTime)
+    {
+        wprintf(L"\n%10ls %10ls %10ls %10ls %10ls  %ls\n", L"faces", L"load ms", L"adj ms", L"atlas ms", L"export ms", L"file");
+
+        size_t failed = 0;
+        for (size_t j = 0; j < files.size(); ++j)
+        {
+            const SFileReport& report = reports[j];
+            if (report.result)
+            {
+                wprintf(L"%10zu %43ls  %s\n", report.nFaces, L"FAILED", files[j].szSrc);
+                ++failed;
+            }
+            else
+            {
+                wprintf(L"%10zu %10.1f %10.1f %10.1f %10.1f  %s\n", report.nFaces,
+                    report.loadTime, report.adjacencyTime, report.atlasTime, report.exportTime, files[j].szSrc);
+            }
         }
+
+        wprintf(L"%zu files, %zu failed, %.2f seconds\n", files.size(), failed, totalTime / 1000.0);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Entry-point
+//--------------------------------------------------------------------------------------
+#pragma prefast(disable : 28198, "Command-line tool, frees all memory on exit")
+
+int main(_In_ int argc, _In_z_count_(argc) char* argv[])
+{
+    // Parameters and defaults
+    size_t maxCharts = 0;
+    float maxStretch = 0.16667f;
+    float gutter = 2.f;
+    size_t width = 512;
+    size_t height = 512;
+    CHANNELS perVertex = CHANNEL_NONE;
+    DWORD uvOptions = UVATLAS_DEFAULT;
+    size_t jobs = 1;
+    float timeBudget = 0.f;
+
+    char szTexFile[MAX_PATH] = {};
+    char szOutputFile[MAX_PATH] = {};
+    char szRemapFile[MAX_PATH] = {};
+
+    // Process command line
+    DWORD64 dwOptions = 0;
+    std::list<SConversion> conversion;
+
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        char *pArg = argv[iArg];
+
+        if ('-' == pArg[0])
+        {
+            pArg++;
+            char *pValue;
+
+            for (pValue = pArg; *pValue && (':' != *pValue); pValue++);
+
+            if (*pValue)
+                *pValue++ = 0;
+
+            DWORD dwOption = LookupByName(pArg, g_pOptions);
+
+            if (!dwOption || (dwOptions & (DWORD64(1) << dwOption)))
+            {
+                wprintf(L"ERROR: unknown command-line option '%s'\n\n", pArg);
+                PrintUsage();
+                return 1;
+            }
+
+            dwOptions |= (DWORD64(1) << dwOption);
+
+            // Handle options with additional value parameter
+            switch (dwOption)
+            {
+            case OPT_QUALITY:
+            case OPT_MAXCHARTS:
+            case OPT_MAXSTRETCH:
+            case OPT_GUTTER:
+            case OPT_WIDTH:
+            case OPT_HEIGHT:
+            case OPT_IMT_TEXFILE:
+            case OPT_IMT_VERTEX:
+            case OPT_OUTPUTFILE:
+            case OPT_FILELIST:
+            case OPT_REMAP:
+            case OPT_JOBS:
+            case OPT_TIME_BUDGET:
+                if (!*pValue)
+                {
+                    if ((iArg + 1 >= argc))
+                    {
+                        wprintf(L"ERROR: missing value for command-line option '%s'\n\n", pArg);
+                        PrintUsage();
+                        return 1;
+                    }
+
+                    iArg++;
+                    pValue = argv[iArg];
+                }
+                break;
+            }
+
+            switch (dwOption)
+            {
+            case OPT_QUALITY:
+                if (!_stricmp(pValue, "DEFAULT"))
+                {
+                    uvOptions = UVATLAS_DEFAULT;
+                }
+                else if (!_stricmp(pValue, "FAST"))
+                {
+                    uvOptions = UVATLAS_GEODESIC_FAST;
+                }
+                else if (!_stricmp(pValue, "QUALITY"))
+                {
+                    uvOptions = UVATLAS_GEODESIC_QUALITY;
+                }
+                else
+                {
+                    wprintf(L"Invalid value specified with -q (%s)\n", pValue);
+                    return 1;
+                }
+                break;
+
+            case OPT_MAXCHARTS:
+                if (sscanf(pValue, "%zu", &maxCharts) != 1)
+                {
+                    wprintf(L"Invalid value specified with -n (%s)\n", pValue);
+                    return 1;
+                }
+                break;
+
+            case OPT_MAXSTRETCH:
+                if (sscanf(pValue, "%f", &maxStretch) != 1
+                    || maxStretch < 0.f
+                    || maxStretch > 1.f)
+                {
+                    wprintf(L"Invalid value specified with -st (%s)\n", pValue);
+                    return 1;
+                }
+                break;
+
+            case OPT_GUTTER:
+                if (sscanf(pValue, "%f", &gutter) != 1
+                    || gutter < 0.f)
+                {
+                    wprintf(L"Invalid value specified with -g (%s)\n", pValue);
+                    return 1;
+                }
+                break;
+
+            case OPT_WIDTH:
+                if (sscanf(pValue, "%zu", &width) != 1)
+                {
+                    wprintf(L"Invalid value specified with -w (%s)\n", pValue);
+                    return 1;
+                }
+                break;
+
+            case OPT_HEIGHT:
+                if (sscanf(pValue, "%zu", &height) != 1)
+                {
+                    wprintf(L"Invalid value specified with -h (%s)\n", pValue);
+                    return 1;
+                }
+                break;
+
+            case OPT_WEIGHT_BY_AREA:
+                if (dwOptions & (DWORD64(1) << OPT_WEIGHT_BY_EQUAL))
+                {
+                    wprintf(L"Can only use one of nn, na, or ne\n");
+                    return 1;
+                }
+                dwOptions |= (DWORD64(1) << OPT_NORMALS);
+                break;
+
+            case OPT_WEIGHT_BY_EQUAL:
+                if (dwOptions & (DWORD64(1) << OPT_WEIGHT_BY_AREA))
+                {
+                    wprintf(L"Can only use one of nn, na, or ne\n");
+                    return 1;
+                }
+                dwOptions |= (DWORD64(1) << OPT_NORMALS);
+                break;
+
+            case OPT_IMT_TEXFILE:
+                if (dwOptions & (DWORD64(1) << OPT_IMT_VERTEX))
+                {
+                    wprintf(L"Cannot use both if and iv at the same time\n");
+                    return 1;
+                }
+
+                strcpy(szTexFile, pValue);
+                break;
+
+            case OPT_IMT_VERTEX:
+                if (dwOptions & (DWORD64(1) << OPT_IMT_TEXFILE))
+                {
+                    wprintf(L"Cannot use both if and iv at the same time\n");
+                    return 1;
+                }
+
+                if (!_stricmp(pValue, "COLOR"))
+                {
+                    perVertex = CHANNEL_COLOR;
+                }
+                else if (!_stricmp(pValue, "NORMAL"))
+                {
+                    perVertex = CHANNEL_NORMAL;
+                }
+                else if (!_stricmp(pValue, "TEXCOORD"))
+                {
+                    perVertex = CHANNEL_TEXCOORD;
+                }
+                else
+                {
+                    wprintf(L"Invalid value specified with -iv (%s)\n", pValue);
+                    return 1;
+                }
+                break;
+
+            case OPT_OUTPUTFILE:
+                strcpy(szOutputFile, pValue);
+                break;
+
+            case OPT_REMAP:
+                strcpy(szRemapFile, pValue);
+                break;
+
+            case OPT_TOPOLOGICAL_ADJ:
+                if (dwOptions & (DWORD64(1) << OPT_GEOMETRIC_ADJ))
+                {
+                    wprintf(L"Cannot use both ta and ga at the same time\n");
+                    return 1;
+                }
+                break;
+
+            case OPT_GEOMETRIC_ADJ:
+                if (dwOptions & (DWORD64(1) << OPT_TOPOLOGICAL_ADJ))
+                {
+                    wprintf(L"Cannot use both ta and ga at the same time\n");
+                    return 1;
+                }
+                break;
+
+            case OPT_SDKMESH:
+            case OPT_SDKMESH_V2:
+                if (dwOptions & ((DWORD64(1) << OPT_VBO) | (DWORD64(1) << OPT_CMO) | (DWORD64(1) << OPT_PLY)))
+                {
+                    wprintf(L"Can only use one of sdkmesh, cmo, vbo or ply\n");
+                    return 1;
+                }
+                if (dwOption == OPT_SDKMESH_V2)
+                {
+                    dwOptions |= (DWORD64(1) << OPT_SDKMESH);
+                }
+                break;
+
+            case OPT_CMO:
+                if (dwOptions & ((DWORD64(1) << OPT_VBO) | (DWORD64(1) << OPT_SDKMESH) | (DWORD64(1) << OPT_PLY)))
+                {
+                    wprintf(L"Can only use one of sdkmesh, cmo, vbo or ply\n");
+                    return 1;
+                }
+                break;
+
+            case OPT_VBO:
+                if (dwOptions & ((DWORD64(1) << OPT_SDKMESH) | (DWORD64(1) << OPT_CMO) | (DWORD64(1) << OPT_PLY)))
+                {
+                    wprintf(L"Can only use one of sdkmesh, cmo, vbo or ply\n");
+                    return 1;
+                }
+                break;
+
+            case OPT_PLY:
+                if (dwOption & ((DWORD64(1) << OPT_SDKMESH) | (DWORD64(1) << OPT_CMO) | (DWORD64(1) << OPT_VBO)))
+                {
+                    wprintf(L"Can only use one of sdkmesh, cmo, vbo or ply\n");
+                    return 1;
+                }
+                break;
+
+            case OPT_FILELIST:
+                {
+                    std::ifstream inFile(pValue);
+                    if (!inFile)
+                    {
+                        wprintf(L"Error opening -flist file %s\n", pValue);
+                        return 1;
+                    }
+
+                    std::string fname;
+                    while (std::getline(inFile, fname))
+                    {
+                        size_t end = fname.find_last_not_of(" \t\r");
+                        fname.erase(end == std::string::npos ? 0 : end + 1);
+
+                        if (fname.empty() || fname[0] == '#')
+                        {
+                            // Comment
+                        }
+                        else if (fname[0] == '-')
+                        {
+                            wprintf(L"Command-line arguments not supported in -flist file\n");
+                            return 1;
+                        }
+                        else if (strpbrk(fname.c_str(), "?*") != nullptr)
+                        {
+                            wprintf(L"Wildcards not supported in -flist file\n");
+                            return 1;
+                        }
+                        else if (fname.size() >= MAX_PATH)
+                        {
+                            wprintf(L"Filename too long in -flist file (%s)\n", fname.c_str());
+                            return 1;
+                        }
+                        else
+                        {
+                            SConversion conv;
+                            strcpy(conv.szSrc, fname.c_str());
+                            conversion.push_back(conv);
+                        }
+                    }
+                }
+                break;
+
+            case OPT_JOBS:
+                if (sscanf(pValue, "%zu", &jobs) != 1)
+                {
+                    wprintf(L"Invalid value specified with -j (%s)\n", pValue);
+                    return 1;
+                }
+
+                if (!jobs)
+                {
+                    jobs = std::max(1u, std::thread::hardware_concurrency());
+                }
+                break;
+
+            case OPT_TIME_BUDGET:
+                if (sscanf(pValue, "%f", &timeBudget) != 1
+                    || timeBudget < 0.f)
+                {
+                    wprintf(L"Invalid value specified with -budget (%s)\n", pValue);
+                    return 1;
+                }
+                break;
+            }
+        }
+        else if (strpbrk(pArg, "?*") != nullptr)
+        {
+            wprintf(L"ERROR: unknown command-line option '%s'\n\n", pArg);
+            PrintUsage();
+            return 1;
+            // size_t count = conversion.size();
+            // SearchForFiles(pArg, conversion, (dwOptions & (DWORD64(1) << OPT_RECURSIVE)) != 0);
+            // if (conversion.size() <= count)
+            // {
+            //     wprintf(L"No matching files found for %ls\n", pArg);
+            //     return 1;
+            // }
+        }
+        else
+        {
+            SConversion conv;
+            strcpy(conv.szSrc, pArg);
+
+            conversion.push_back(conv);
+        }
+    }
+
+    if (conversion.empty())
+    {
+        PrintUsage();
+        return 0;
+    }
+
+    if (*szOutputFile && conversion.size() > 1)
+    {
+        wprintf(L"Cannot use -o with multiple input files\n");
+        return 1;
+    }
+
+    if (*szRemapFile && conversion.size() > 1) {
+        wprintf(L"Cannot use -remap with multiple input files\n");
+        return 1;
+    }
+
+    if (~dwOptions & (DWORD64(1) << OPT_NOLOGO))
+        PrintLogo();
+
+    SSettings settings = {};
+    settings.dwOptions = dwOptions;
+    settings.maxCharts = maxCharts;
+    settings.maxStretch = maxStretch;
+    settings.gutter = gutter;
+    settings.width = width;
+    settings.height = height;
+    settings.perVertex = perVertex;
+    if (dwOptions & (DWORD64(1) << OPT_BATCH_SPLIT))
+    {
+        uvOptions |= UVATLAS_BATCH_SPLIT;
+    }
+
+    settings.uvOptions = uvOptions;
+    settings.szTexFile = szTexFile;
+    settings.szOutputFile = szOutputFile;
+    settings.szRemapFile = szRemapFile;
+    settings.jobs = std::min(jobs, conversion.size());
+    settings.timeBudget = timeBudget;
+
+    std::vector<SConversion> files(conversion.cbegin(), conversion.cend());
+    std::vector<SFileReport> reports(files.size());
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    // Process files
+    if (settings.jobs <= 1)
+    {
+        CLog log(false);
+        for (size_t j = 0; j < files.size(); ++j)
+        {
+            if (j > 0)
+                wprintf(L"\n");
+
+            int result = ProcessFile(files[j], settings, log, reports[j]);
+            if (result)
+                return result;
+        }
+    }
+    else
+    {
+        // Largest meshes first, so that no big file is left running alone at the end
+        std::vector<size_t> order(files.size());
+        for (size_t j = 0; j < files.size(); ++j)
+        {
+            order[j] = j;
+
+            size_t nFaces = 0;
+            if (SUCCEEDED(GetFaceCountFromPLY(files[j].szSrc, nFaces)))
+            {
+                reports[j].nFaces = nFaces;
+            }
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            return reports[a].nFaces > reports[b].nFaces;
+        });
+
+        std::atomic<size_t> nextFile(0);
+        std::vector<std::thread> workers;
+        workers.reserve(settings.jobs);
+        for (size_t j = 0; j < settings.jobs; ++j)
+        {
+            workers.emplace_back([&]()
+            {
+                CLog log(true);
+                for (;;)
+                {
+                    size_t k = nextFile++;
+                    if (k >= order.size())
+                        break;
+
+                    SFileReport& report = reports[order[k]];
+                    report.result = ProcessFile(files[order[k]], settings, log, report);
+                    log.Print(L"\n");
+                    log.Flush();
+                }
+            });
+        }
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    if (files.size() > 1)
+    {
+        PrintSummary(files, reports, GetElapsedTime(startTime));
+    }
+
+    for (auto& report : reports)
+    {
+        if (report.result)
+            return report.result;
     }
 
     return 0;